@@ -16,10 +16,7 @@
 #include "rocksdb/options.h"
 #include "util/coding.h"
 
-#undef SNAPPY
-#undef ZLIB
-#undef BZIP2
-#undef LZ4
+// Codecs found by the platform detection are compiled in. ZSTD format isn't final yet, XPRESS is Windows only
 #undef ZSTD
 #undef XPRESS
 
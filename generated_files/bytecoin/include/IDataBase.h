@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include <system_error>
 
@@ -32,7 +33,13 @@ public:
 
   virtual std::error_code write(IWriteBatch& batch) = 0;
   virtual std::error_code writeSync(IWriteBatch& batch) = 0;
+  // Commits the writes held back to be committed together, if the data base groups them
+  virtual std::error_code flush() = 0;
 
   virtual std::error_code read(IReadBatch& batch) = 0;
+
+  // Read-only view of the data committed so far, later writes aren't seen through it and writes to it fail.
+  // The view may be read on another thread, it must not outlive the data base
+  virtual std::unique_ptr<IDataBase> createSnapshot() = 0;
 };
 }
@@ -139,6 +139,7 @@ BlockManager::BlockManager(System::Dispatcher& dispatcher, Logging::LoggerManage
 	m_consoleHandler.setHandler("set_log", boost::bind(&BlockManager::set_log, this, _1), "set_log <level> - Change current log level, <level> is a number 0-4");
 	m_consoleHandler.setHandler("bc_height", boost::bind(&BlockManager::show_blockchain_height, this, _1), "Show blockchain height");
 	m_consoleHandler.setHandler("push_block", boost::bind(&BlockManager::push_block, this, _1), "Push block Whit (< Account Number>  < Public Address>)");
+	m_consoleHandler.setHandler("push_blocks", boost::bind(&BlockManager::push_blocks, this, _1), "push_blocks <file> - Push blocks for all accounts of the file, one (<Account Number> <Public Address>) per line");
 	//m_consoleHandler.setHandler("print_list", boost::bind(&BlockManager::print_list, this, _1), "print list of all accoun and address");
 	m_consoleHandler.setHandler("find", boost::bind(&BlockManager::find_address, this, _1), "find address and hash < Account Number>  ");
 	//m_consoleHandler.setHandler("print_hash",boost::bind(&BlockManager::print_hash, this, _1), "print hash"); 
@@ -309,6 +310,62 @@ bool BlockManager::push_block(const std::vector<std::string> &args) {
 	return true;
 }
 
+bool BlockManager::push_blocks(const std::vector<std::string> &args) {
+	if (args.size() != 1) {
+		logger(INFO, WHITE) << "expected: push_blocks <file>" << std::endl;
+		return true;
+	}
+
+	std::ifstream file(args[0]);
+	if (!file) {
+		fail_msg_writer() << "failed to open file " << args[0];
+		return true;
+	}
+
+	std::vector<COMMAND_RPC_PUSHBLOCK::request> accounts;
+	std::string line;
+	while (std::getline(file, line)) {
+		std::istringstream lineStream(line);
+		COMMAND_RPC_PUSHBLOCK::request account;
+		if (lineStream >> account.AccountNumber >> account.AccountAddress) {
+			accounts.push_back(std::move(account));
+		}
+	}
+
+	size_t addedCount = 0;
+	for (size_t offset = 0; offset < accounts.size(); offset += COMMAND_RPC_PUSH_BLOCKS_MAX_COUNT) {
+		COMMAND_RPC_PUSHBLOCKS::request req;
+		COMMAND_RPC_PUSHBLOCKS::response res;
+		auto end = std::min(accounts.size(), offset + COMMAND_RPC_PUSH_BLOCKS_MAX_COUNT);
+		req.Accounts.assign(accounts.begin() + offset, accounts.begin() + end);
+
+		try {
+			HttpClient httpClient(m_dispatcher, m_daemon_host, m_daemon_port);
+
+			JsonRpc::invokeJsonRpcCommand(httpClient, "pushblocks", req, res);
+		}
+		catch (const ConnectException&) {
+			printConnectionError();
+			return true;
+		}
+		catch (const std::exception& e) {
+			fail_msg_writer() << "Failed to invoke rpc method: " << e.what();
+			return false;
+		}
+
+		for (const auto& account : res.Accounts) {
+			if (account.added) {
+				++addedCount;
+			} else {
+				logger(INFO, YELLOW) << account.AccountNumber << ": " << account.Status << ENDL;
+			}
+		}
+	}
+
+	logger(INFO, WHITE) << addedCount << " of " << accounts.size() << " accounts added" << ENDL;
+	return true;
+}
+
 bool CryptoNote::BlockManager::find_address(const std::vector<std::string>& args)
 {
 	if (args[0].size() != 10) {
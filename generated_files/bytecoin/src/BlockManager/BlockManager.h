@@ -52,6 +52,7 @@ namespace CryptoNote {
 		bool help(const std::vector<std::string> &args = std::vector<std::string>());
 		bool exit(const std::vector<std::string> &args);
 		bool push_block(const std::vector<std::string> &args);
+		bool push_blocks(const std::vector<std::string> &args);
 		bool find_address(const std::vector<std::string> &args);
 		bool print_list(const std::vector<std::string> &args);
 		bool show_blockchain_height(const std::vector<std::string> &args);
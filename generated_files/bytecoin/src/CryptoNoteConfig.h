@@ -20,6 +20,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <limits>
+#include <string>
 
 namespace CryptoNote {
 namespace parameters {
@@ -88,6 +89,7 @@ const uint32_t UPGRADE_HEIGHT_V2                                = 1;
 const uint32_t UPGRADE_HEIGHT_V3                                = 2;
 const uint32_t UPGRADE_HEIGHT_V4                                = 611164;
 const uint32_t UPGRADE_HEIGHT_V5                              =1417827;
+const uint32_t UPGRADE_HEIGHT_ACCOUNT_BLOCK_V2                  = static_cast<uint32_t>(-1); // Not scheduled yet
 const unsigned UPGRADE_VOTING_THRESHOLD                      = 90;               // percent
 const uint32_t UPGRADE_VOTING_WINDOW                         = EXPECTED_NUMBER_OF_BLOCKS_PER_DAY;  // blocks
 const uint32_t UPGRADE_WINDOW                                = EXPECTED_NUMBER_OF_BLOCKS_PER_DAY;  // blocks
@@ -114,13 +116,27 @@ const uint8_t  BLOCK_MAJOR_VERSION_5						 =  5;
 const uint8_t  BLOCK_MAJOR_VERSION_6						 =  6;
 const uint8_t  BLOCK_MINOR_VERSION_0                         =  0;
 const uint8_t  BLOCK_MINOR_VERSION_1                         =  1;
+// Account blocks are told apart by their minor version, it also selects how the account number is committed to by the long hash
+const uint8_t  ACCOUNT_BLOCK_MINOR_VERSION_1                 =  4;  // CryptoNight slow hash
+const uint8_t  ACCOUNT_BLOCK_MINOR_VERSION_2                 =  5;  // Keccak fast hash
+
+const size_t   ACCOUNT_NUMBER_SIZE                           =  10;
+const size_t   ACCOUNT_ADDRESS_SIZE                          =  95;
 
 const size_t   BLOCKS_IDS_SYNCHRONIZING_DEFAULT_COUNT        =  1000;  //by default, blocks ids count in synchronizing
 const size_t   BLOCKS_SYNCHRONIZING_DEFAULT_COUNT            =  100;   //by default, blocks count in blocks downloading
+const size_t   BLOCKS_SYNCHRONIZING_MAX_COUNT                =  1000;  //blocks count in blocks downloading, sized for each peer up to it
+const size_t   BLOCKS_SYNCHRONIZING_TARGET_RESPONSE_SIZE     =  2 * 1024 * 1024; //bytes, blocks count in a request to a peer is aimed at it
+const size_t   BLOCKS_DOWNLOAD_WINDOW_SIZE                   =  2000;  //blocks downloaded from all peers ahead of the ones added to the core
+const uint64_t BLOCKS_DOWNLOAD_STALL_TIMEOUT                 =  30 * 1000; //ms, blocks not received in time are requested from another peer
 const size_t   COMMAND_RPC_GET_BLOCKS_FAST_MAX_COUNT         =  1000;
+const size_t   COMMAND_RPC_GET_ACCOUNT_ADDRESSES_MAX_COUNT   =  1000;
+const size_t   COMMAND_RPC_PUSH_BLOCKS_MAX_COUNT             =  1000;
 
 const int      P2P_DEFAULT_PORT                              =  9921;
 const int      RPC_DEFAULT_PORT                              =  9971;
+const uint32_t RPC_LONG_POLL_TIMEOUT                         =  60;    // seconds, getblocktemplate long poll
+const uint32_t RPC_LONG_POLL_POOL_UPDATE_INTERVAL            =  10;    // seconds, min interval between pool driven template changes
 
 const size_t   P2P_LOCAL_WHITE_PEERLIST_LIMIT                =  1000;
 const size_t   P2P_LOCAL_GRAY_PEERLIST_LIMIT                 =  5000;
@@ -135,6 +151,14 @@ const uint32_t P2P_DEFAULT_CONNECTION_TIMEOUT                = 5000;          //
 const uint32_t P2P_DEFAULT_PING_CONNECTION_TIMEOUT           = 2000;          // 2 seconds
 const uint64_t P2P_DEFAULT_INVOKE_TIMEOUT                    = 60 * 2 * 1000; // 2 minutes
 const size_t   P2P_DEFAULT_HANDSHAKE_INVOKE_TIMEOUT          = 5000;          // 5 seconds
+const size_t   P2P_TRANSACTIONS_KNOWN_COUNT                  = 10000;         // hashes of transactions a peer has, they aren't announced to it
+const size_t   P2P_TRANSACTIONS_REQUESTED_MAX_COUNT          = 1000;          // transactions requested from a peer and not received yet
+const uint64_t P2P_TRANSACTIONS_REQUEST_TIMEOUT              = 10 * 1000;     // 10 seconds, then announced transactions are requested from another peer
+const size_t   P2P_TRANSACTIONS_REQUEST_MAX_ATTEMPTS         = 3;             // peers a transaction is requested from before it's given up
+const uint64_t P2P_COMPACT_BLOCK_TRANSACTIONS_TIMEOUT        = 5 * 1000;      // 5 seconds, then a compact block is downloaded by synchronization
+const size_t   P2P_TX_POOL_SKETCH_MIN_CELLS                  = 96;            // cells of the first pool sketch sent to a peer
+const size_t   P2P_TX_POOL_SKETCH_MAX_CELLS                  = 24 * 1024;     // larger pool differences are found by sending all pool hashes
+const size_t   P2P_TX_POOL_SKETCH_MAX_RETRIES                = 3;             // larger sketches sent after one isn't decoded, then all pool hashes are sent
 
 const uint32_t  P2P_FAILED_ADDR_FORGET_SECONDS                  = (60*60);     //1 hour
 const uint32_t  P2P_IP_BLOCKTIME                                 = (60*60*24);  //24 hour
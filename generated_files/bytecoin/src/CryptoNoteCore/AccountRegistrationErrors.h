@@ -0,0 +1,74 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <string>
+#include <system_error>
+
+namespace CryptoNote {
+namespace error {
+
+enum class AccountRegistrationErrorCode {
+  INVALID_ACCOUNT_NUMBER = 1,
+  INVALID_ACCOUNT_ADDRESS,
+  DUPLICATED_ACCOUNT_NUMBER,
+  ALREADY_REGISTERED
+};
+
+class AccountRegistrationErrorCategory : public std::error_category {
+public:
+  static AccountRegistrationErrorCategory INSTANCE;
+
+  virtual const char* name() const throw() {
+    return "AccountRegistrationErrorCategory";
+  }
+
+  virtual std::error_condition default_error_condition(int ev) const throw() {
+    return std::error_condition(ev, *this);
+  }
+
+  virtual std::string message(int ev) const {
+    AccountRegistrationErrorCode code = static_cast<AccountRegistrationErrorCode>(ev);
+
+    switch (code) {
+      case AccountRegistrationErrorCode::INVALID_ACCOUNT_NUMBER: return "Invalid account number";
+      case AccountRegistrationErrorCode::INVALID_ACCOUNT_ADDRESS: return "Invalid account address";
+      case AccountRegistrationErrorCode::DUPLICATED_ACCOUNT_NUMBER: return "Account number is duplicated in request";
+      case AccountRegistrationErrorCode::ALREADY_REGISTERED: return "Account number is already registered";
+      default: return "Unknown error";
+    }
+  }
+
+private:
+  AccountRegistrationErrorCategory() {
+  }
+};
+
+inline std::error_code make_error_code(CryptoNote::error::AccountRegistrationErrorCode e) {
+  return std::error_code(static_cast<int>(e), CryptoNote::error::AccountRegistrationErrorCategory::INSTANCE);
+}
+
+}
+}
+
+namespace std {
+
+template <>
+struct is_error_code_enum<CryptoNote::error::AccountRegistrationErrorCode>: public true_type {};
+
+}
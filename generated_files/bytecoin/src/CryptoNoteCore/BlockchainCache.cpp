@@ -95,6 +95,11 @@ void CachedBlockInfo::serialize(ISerializer& s) {
   s(alreadyGeneratedTransactions, "already_generated_transaction_count");
 }
 
+void AccountInfo::serialize(ISerializer& s) {
+  s(accountAddress, "account_address");
+  s(blockIndex, "block_index");
+}
+
 void OutputGlobalIndexesForAmount::serialize(ISerializer& s) {
   s(startIndex, "start_index");
   s(outputs, "outputs");
@@ -187,6 +192,9 @@ void BlockchainCache::doPushBlock(const CachedBlock& cachedBlock,
   assert(!hasBlock(blockInfo.blockHash));
 
   blockInfos.get<BlockIndexTag>().emplace_back(std::move(blockInfo));
+  if (difficultyWindow) {
+    difficultyWindow->pushBack(cachedBlock.getBlock().timestamp, cumulativeDifficulty);
+  }
 
   auto blockIndex = cachedBlock.getBlockIndex();
   assert(blockIndex == blockInfos.size() + startIndex - 1);
@@ -207,6 +215,10 @@ void BlockchainCache::doPushBlock(const CachedBlock& cachedBlock,
     pushTransaction(cachedTransaction, blockIndex, transactionBlockIndex++);
   }
 
+  if (cachedBlock.getTypeOfBlock() == ACCOUNT_BLOCK) {
+    accounts[cachedBlock.getBlock().accountNumber] = AccountInfo{cachedBlock.getBlock().accountAddress, blockIndex};
+  }
+
   storage->pushBlock(std::move(rawBlock));
 
   logger(Logging::DEBUGGING) << "Block " << cachedBlock.getBlockHash() << " successfully pushed";
@@ -255,6 +267,7 @@ std::unique_ptr<IBlockchainCache> BlockchainCache::split(uint32_t splitBlockInde
   assert(splitBlockIndex > startIndex);
   assert(splitBlockIndex <= getTopBlockIndex());
 
+  auto splitBlocksCount = getTopBlockIndex() + 1 - splitBlockIndex;
   std::unique_ptr<BlockchainStorage> newStorage = storage->splitStorage(splitBlockIndex - startIndex);
 
   std::unique_ptr<BlockchainCache> newCache(
@@ -266,6 +279,13 @@ std::unique_ptr<IBlockchainCache> BlockchainCache::split(uint32_t splitBlockInde
   splitTransactions(*newCache, splitBlockIndex);
   splitBlocks(*newCache, splitBlockIndex);
   splitKeyOutputsGlobalIndexes(*newCache, splitBlockIndex);
+  splitAccounts(*newCache, splitBlockIndex);
+
+  // The upper part keeps the top block, so it gets the window as is
+  if (difficultyWindow) {
+    newCache->difficultyWindow.reset(new DifficultyWindow(*difficultyWindow));
+    difficultyWindow->popBack(*this, splitBlocksCount);
+  }
 
   fixChildrenParent(newCache.get());
   newCache->children = children;
@@ -334,6 +354,19 @@ void BlockchainCache::splitKeyOutputsGlobalIndexes(BlockchainCache& newCache, ui
   logger(Logging::DEBUGGING) << "Key output global indexes split successfully completed";
 }
 
+void BlockchainCache::splitAccounts(BlockchainCache& newCache, uint32_t splitBlockIndex) {
+  for (auto it = accounts.begin(); it != accounts.end();) {
+    if (it->second.blockIndex >= splitBlockIndex) {
+      newCache.accounts.emplace(std::move(*it));
+      it = accounts.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  logger(Logging::DEBUGGING) << "Accounts split completed";
+}
+
 void BlockchainCache::addSpentKeyImage(const Crypto::KeyImage& keyImage, uint32_t blockIndex) {
   assert(!checkIfSpent(keyImage, blockIndex - 1)); //Changed from "assert(!checkIfSpent(keyImage, blockIndex));"
                                                    //to prevent fail when pushing block from DatabaseBlockchainCache.
@@ -788,6 +821,91 @@ ExtractOutputKeysResult BlockchainCache::extractKeyOutputKeys(uint64_t amount, u
   });
 }
 
+void BlockchainCache::extractKeyOutputKeys(uint32_t blockIndex, std::vector<KeyOutputKeysRequest>& requests) const {
+  std::vector<KeyOutputKeysRequest> parentRequests;
+  std::vector<size_t> parentRequestOwners;
+  std::vector<size_t> ownIndexesOffsets(requests.size());
+
+  for (size_t i = 0; i < requests.size(); ++i) {
+    auto& request = requests[i];
+    assert(std::is_sorted(request.globalIndexes.begin(), request.globalIndexes.end()));
+    request.publicKeys.clear();
+    request.result = ExtractOutputKeysResult::SUCCESS;
+
+    auto globalIndexesIterator = keyOutputsGlobalIndexes.find(request.amount);
+    if (globalIndexesIterator == keyOutputsGlobalIndexes.end() || blockIndex < startIndex) {
+      ownIndexesOffsets[i] = request.globalIndexes.size();
+    } else {
+      auto startGlobalIndex = globalIndexesIterator->second.startIndex;
+      ownIndexesOffsets[i] = std::distance(request.globalIndexes.begin(),
+                                           std::lower_bound(request.globalIndexes.begin(), request.globalIndexes.end(), startGlobalIndex));
+    }
+
+    if (ownIndexesOffsets[i] == 0) {
+      continue;
+    }
+
+    if (parent == nullptr) {
+      request.result = ExtractOutputKeysResult::INVALID_GLOBAL_INDEX;
+      continue;
+    }
+
+    KeyOutputKeysRequest parentRequest;
+    parentRequest.amount = request.amount;
+    parentRequest.globalIndexes.assign(request.globalIndexes.begin(), request.globalIndexes.begin() + ownIndexesOffsets[i]);
+    parentRequests.push_back(std::move(parentRequest));
+    parentRequestOwners.push_back(i);
+  }
+
+  if (!parentRequests.empty()) {
+    parent->extractKeyOutputKeys(blockIndex, parentRequests);
+    for (size_t i = 0; i < parentRequests.size(); ++i) {
+      auto& request = requests[parentRequestOwners[i]];
+      request.result = parentRequests[i].result;
+      request.publicKeys = std::move(parentRequests[i].publicKeys);
+    }
+  }
+
+  for (size_t i = 0; i < requests.size(); ++i) {
+    auto& request = requests[i];
+    if (request.result != ExtractOutputKeysResult::SUCCESS || ownIndexesOffsets[i] == request.globalIndexes.size()) {
+      continue;
+    }
+
+    auto ownIndexes = Common::ArrayView<uint32_t>(request.globalIndexes.data(), request.globalIndexes.size()).unhead(ownIndexesOffsets[i]);
+    request.result = extractKeyOutputKeys(request.amount, blockIndex, ownIndexes, request.publicKeys);
+  }
+}
+
+void BlockchainCache::getAccountAddresses(uint32_t blockIndex, std::vector<AccountAddressRequest>& requests) const {
+  std::vector<AccountAddressRequest> parentRequests;
+  std::vector<size_t> parentRequestOwners;
+
+  for (size_t i = 0; i < requests.size(); ++i) {
+    auto& request = requests[i];
+    auto it = accounts.find(request.accountNumber);
+    request.found = it != accounts.end() && it->second.blockIndex <= blockIndex;
+    if (request.found) {
+      request.accountAddress = it->second.accountAddress;
+      continue;
+    }
+
+    if (parent != nullptr) {
+      parentRequests.push_back(AccountAddressRequest{request.accountNumber, {}, false});
+      parentRequestOwners.push_back(i);
+    }
+  }
+
+  if (!parentRequests.empty()) {
+    parent->getAccountAddresses(std::min(blockIndex, startIndex - 1), parentRequests);
+    for (size_t i = 0; i < parentRequests.size(); ++i) {
+      auto& request = requests[parentRequestOwners[i]];
+      request.found = parentRequests[i].found;
+      request.accountAddress = std::move(parentRequests[i].accountAddress);
+    }
+  }
+}
+
 ExtractOutputKeysResult
 BlockchainCache::extractKeyOtputReferences(uint64_t amount, Common::ArrayView<uint32_t> globalIndexes,
                                            std::vector<std::pair<Crypto::Hash, size_t>>& outputReferences) const {
@@ -977,6 +1095,15 @@ Difficulty BlockchainCache::getDifficultyForNextBlock() const {
 Difficulty BlockchainCache::getDifficultyForNextBlock(uint32_t blockIndex) const {
   assert(blockIndex <= getTopBlockIndex());
   uint8_t nextBlockMajorVersion = getBlockMajorVersionForHeight(blockIndex+1);
+  if (blockIndex == getTopBlockIndex()) {
+    if (!difficultyWindow || difficultyWindow->getBlockMajorVersion() != nextBlockMajorVersion) {
+      difficultyWindow.reset(new DifficultyWindow(currency, nextBlockMajorVersion));
+      difficultyWindow->assign(*this, blockIndex);
+    }
+
+    return difficultyWindow->nextDifficulty();
+  }
+
   auto timestamps = getLastTimestamps(currency.difficultyBlocksCountByBlockVersion(nextBlockMajorVersion), blockIndex, skipGenesisBlock);
   auto commulativeDifficulties =
       getLastCumulativeDifficulties(currency.difficultyBlocksCountByBlockVersion(nextBlockMajorVersion), blockIndex, skipGenesisBlock);
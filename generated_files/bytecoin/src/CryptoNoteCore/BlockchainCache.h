@@ -32,6 +32,7 @@
 #include "Common/StringView.h"
 #include "Currency.h"
 #include "Difficulty.h"
+#include "DifficultyWindow.h"
 #include "IBlockchainCache.h"
 #include "CryptoNoteCore/UpgradeManager.h"
 
@@ -69,6 +70,13 @@ struct CachedBlockInfo {
   void serialize(ISerializer& s);
 };
 
+struct AccountInfo {
+  std::string accountAddress;
+  uint32_t blockIndex;
+
+  void serialize(ISerializer& s);
+};
+
 struct OutputGlobalIndexesForAmount {
   uint32_t startIndex = 0;
 
@@ -116,6 +124,8 @@ ExtractOutputKeysResult extractTransactionPublicKeys(uint64_t amount, Common::Ar
 ExtractOutputKeysResult extractTransactionPublicKeys(uint64_t amount, uint32_t blockIndex, Common::ArrayView<uint32_t> globalIndexes, std::vector<Crypto::PublicKey>& publicKeys) const override;
   ExtractOutputKeysResult extractKeyOutputKeys(uint64_t amount, Common::ArrayView<uint32_t> globalIndexes, std::vector<Crypto::PublicKey>& publicKeys) const override;
   ExtractOutputKeysResult extractKeyOutputKeys(uint64_t amount, uint32_t blockIndex, Common::ArrayView<uint32_t> globalIndexes, std::vector<Crypto::PublicKey>& publicKeys) const override;
+  void extractKeyOutputKeys(uint32_t blockIndex, std::vector<KeyOutputKeysRequest>& requests) const override;
+  void getAccountAddresses(uint32_t blockIndex, std::vector<AccountAddressRequest>& requests) const override;
 
   ExtractOutputKeysResult extractKeyOtputIndexes(uint64_t amount, Common::ArrayView<uint32_t> globalIndexes, std::vector<PackedOutIndex>& outIndexes) const override;
   ExtractOutputKeysResult extractKeyOtputReferences(uint64_t amount, Common::ArrayView<uint32_t> globalIndexes, std::vector<std::pair<Crypto::Hash, size_t>>& outputReferences) const override;
@@ -270,6 +280,7 @@ private:
   typedef std::map<uint64_t, OutputGlobalIndexesForAmount> OutputsGlobalIndexesContainer;
   typedef std::map<BlockIndex, std::vector<std::pair<Amount, GlobalOutputIndex>>> OutputSpentInBlock;
   typedef std::set<std::pair<Amount, GlobalOutputIndex>> SpentOutputsOnAmount;
+  typedef std::unordered_map<std::string, AccountInfo> AccountsContainer;
 
   const uint32_t CURRENT_SERIALIZATION_VERSION = 1;
   std::string filename;
@@ -284,7 +295,10 @@ private:
   BlockInfoContainer blockInfos;
   OutputsGlobalIndexesContainer keyOutputsGlobalIndexes;
   PaymentIdContainer paymentIds;
+  AccountsContainer accounts;
   std::unique_ptr<BlockchainStorage> storage;
+  // Built for the top block on the first difficulty request, then follows pushes and splits
+  mutable std::unique_ptr<DifficultyWindow> difficultyWindow;
 
   std::vector<IBlockchainCache*> children;
  
@@ -297,6 +311,7 @@ private:
   void splitTransactions(BlockchainCache& newCache, uint32_t splitBlockIndex);
   void splitBlocks(BlockchainCache& newCache, uint32_t splitBlockIndex);
   void splitKeyOutputsGlobalIndexes(BlockchainCache& newCache, uint32_t splitBlockIndex);
+  void splitAccounts(BlockchainCache& newCache, uint32_t splitBlockIndex);
   void removePaymentId(const Crypto::Hash& transactionHash, BlockchainCache& newCache);
 
   uint32_t insertKeyOutputToGlobalIndex(uint64_t amount, PackedOutIndex output, uint32_t blockIndex);
@@ -0,0 +1,64 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "BlockchainSnapshot.h"
+
+#include "BlockchainUtils.h"
+#include "CryptoNoteTools.h"
+
+namespace CryptoNote {
+
+BlockchainSnapshot::BlockchainSnapshot(const Currency& currency, std::unique_ptr<IBlockchainCache>&& rootSegment)
+    : currency(currency), rootSegment(std::move(rootSegment)) {
+}
+
+uint32_t BlockchainSnapshot::getTopBlockIndex() const {
+  return rootSegment->getTopBlockIndex();
+}
+
+bool BlockchainSnapshot::hasBlock(const Crypto::Hash& blockHash) const {
+  return rootSegment->hasBlock(blockHash);
+}
+
+bool BlockchainSnapshot::hasTransaction(const Crypto::Hash& transactionHash) const {
+  return rootSegment->hasTransaction(transactionHash);
+}
+
+BlockDetails BlockchainSnapshot::getBlockDetails(const Crypto::Hash& blockHash) const {
+  if (!rootSegment->hasBlock(blockHash)) {
+    throw std::runtime_error("Requested hash wasn't found in blockchain snapshot.");
+  }
+
+  uint32_t blockIndex = rootSegment->getBlockIndex(blockHash);
+  BlockTemplate blockTemplate;
+  if (!fromBinaryArray(blockTemplate, rootSegment->getBlockByIndex(blockIndex).block)) {
+    throw std::runtime_error("Couldn't deserialize BlockTemplate");
+  }
+
+  return Utils::getBlockDetails(currency, *rootSegment, blockIndex, blockHash, std::move(blockTemplate));
+}
+
+TransactionDetails BlockchainSnapshot::getTransactionDetails(const Crypto::Hash& transactionHash) const {
+  if (!rootSegment->hasTransaction(transactionHash)) {
+    throw std::runtime_error("Requested transaction wasn't found in blockchain snapshot.");
+  }
+
+  return Utils::getTransactionDetails(*rootSegment, transactionHash);
+}
+
+}
@@ -0,0 +1,49 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <memory>
+
+#include "BlockchainExplorerData.h"
+#include "Currency.h"
+#include "IBlockchainCache.h"
+
+namespace CryptoNote {
+
+// Main chain blocks committed to the DB when the snapshot was taken. Blocks added later, blocks of main chain
+// segments above the DB and alternative blocks aren't in it. The snapshot shares no state with Core, so it may be
+// queried on another thread while Core keeps adding blocks, by one thread at a time.
+class BlockchainSnapshot {
+public:
+  BlockchainSnapshot(const Currency& currency, std::unique_ptr<IBlockchainCache>&& rootSegment);
+
+  uint32_t getTopBlockIndex() const;
+  bool hasBlock(const Crypto::Hash& blockHash) const;
+  bool hasTransaction(const Crypto::Hash& transactionHash) const;
+
+  // Throw std::runtime_error if the block or the transaction isn't in the snapshot
+  BlockDetails getBlockDetails(const Crypto::Hash& blockHash) const;
+  TransactionDetails getTransactionDetails(const Crypto::Hash& transactionHash) const;
+
+private:
+  const Currency& currency;
+  std::unique_ptr<IBlockchainCache> rootSegment;
+};
+
+}
@@ -17,9 +17,101 @@
 
 #include "BlockchainUtils.h"
 
+#include <boost/utility/value_init.hpp>
+
+#include "Common/Math.h"
+#include "CryptoNoteFormatUtils.h"
+#include "Currency.h"
+#include "IBlockchainCache.h"
+#include "TransactionApi.h"
+
 namespace CryptoNote {
 namespace Utils {
 
+namespace {
+
+const UseGenesis addGenesisBlock = UseGenesis(true);
+
+void fillTransactionDetails(const IBlockchainCache& segment, const Transaction& rawTransaction, TransactionDetails& transactionDetails) {
+  std::unique_ptr<ITransaction> transaction = createTransaction(rawTransaction);
+
+  transactionDetails.unlockTime = transaction->getUnlockTime();
+
+  transactionDetails.totalOutputsAmount = transaction->getOutputTotalAmount();
+  transactionDetails.totalInputsAmount = transaction->getInputTotalAmount();
+
+  transactionDetails.mixin = 0;
+  for (size_t i = 0; i < transaction->getInputCount(); ++i) {
+    if (transaction->getInputType(i) != TransactionTypes::InputType::Key) {
+      continue;
+    }
+
+    KeyInput input;
+    transaction->getInput(i, input);
+    uint64_t currentMixin = input.outputIndexes.size();
+    if (currentMixin > transactionDetails.mixin) {
+      transactionDetails.mixin = currentMixin;
+    }
+  }
+
+  transactionDetails.paymentId = boost::value_initialized<Crypto::Hash>();
+  if (transaction->getPaymentId(transactionDetails.paymentId)) {
+    transactionDetails.hasPaymentId = true;
+  }
+  transactionDetails.extra.publicKey = transaction->getTransactionPublicKey();
+  transaction->getExtraNonce(transactionDetails.extra.nonce);
+
+  transactionDetails.signatures = rawTransaction.signatures;
+
+  transactionDetails.inputs.reserve(transaction->getInputCount());
+  for (size_t i = 0; i < transaction->getInputCount(); ++i) {
+    TransactionInputDetails txInDetails;
+
+    if (transaction->getInputType(i) == TransactionTypes::InputType::Generating) {
+      BaseInputDetails baseDetails;
+      baseDetails.input = boost::get<BaseInput>(rawTransaction.inputs[i]);
+      baseDetails.amount = transaction->getOutputTotalAmount();
+      txInDetails = baseDetails;
+    } else if (transaction->getInputType(i) == TransactionTypes::InputType::Key) {
+      KeyInputDetails txInToKeyDetails;
+      txInToKeyDetails.input = boost::get<KeyInput>(rawTransaction.inputs[i]);
+      std::vector<std::pair<Crypto::Hash, size_t>> outputReferences;
+      outputReferences.reserve(txInToKeyDetails.input.outputIndexes.size());
+      std::vector<uint32_t> globalIndexes = relativeOutputOffsetsToAbsolute(txInToKeyDetails.input.outputIndexes);
+      ExtractOutputKeysResult result = segment.extractKeyOtputReferences(txInToKeyDetails.input.amount, { globalIndexes.data(), globalIndexes.size() }, outputReferences);
+      assert(result == ExtractOutputKeysResult::SUCCESS);
+      assert(txInToKeyDetails.input.outputIndexes.size() == outputReferences.size());
+
+      txInToKeyDetails.mixin = txInToKeyDetails.input.outputIndexes.size();
+      txInToKeyDetails.output.number = outputReferences.back().second;
+      txInToKeyDetails.output.transactionHash = outputReferences.back().first;
+      txInDetails = txInToKeyDetails;
+    }
+
+    assert(!txInDetails.empty());
+    transactionDetails.inputs.push_back(std::move(txInDetails));
+  }
+
+  transactionDetails.outputs.reserve(transaction->getOutputCount());
+  std::vector<uint32_t> globalIndexes;
+  globalIndexes.reserve(transaction->getOutputCount());
+  if (!transactionDetails.inBlockchain || !segment.getTransactionGlobalIndexes(transactionDetails.hash, globalIndexes)) {
+    for (size_t i = 0; i < transaction->getOutputCount(); ++i) {
+      globalIndexes.push_back(0);
+    }
+  }
+
+  assert(transaction->getOutputCount() == globalIndexes.size());
+  for (size_t i = 0; i < transaction->getOutputCount(); ++i) {
+    TransactionOutputDetails txOutDetails;
+    txOutDetails.output = rawTransaction.outputs[i];
+    txOutDetails.globalIndex = globalIndexes[i];
+    transactionDetails.outputs.push_back(std::move(txOutDetails));
+  }
+}
+
+}
+
 bool restoreCachedTransactions(const std::vector<BinaryArray>& binaryTransactions,
                                std::vector<CachedTransaction>& transactions) {
   transactions.reserve(binaryTransactions.size());
@@ -36,5 +128,118 @@ bool restoreCachedTransactions(const std::vector<BinaryArray>& binaryTransaction
   return true;
 }
 
+BlockDetails getBlockDetails(const Currency& currency, const IBlockchainCache& segment, uint32_t blockIndex,
+                             const Crypto::Hash& blockHash, BlockTemplate&& blockTemplate) {
+  BlockDetails blockDetails;
+  blockDetails.majorVersion = blockTemplate.majorVersion;
+  blockDetails.minorVersion = blockTemplate.minorVersion;
+  blockDetails.timestamp = blockTemplate.timestamp;
+  blockDetails.prevBlockHash = blockTemplate.previousBlockHash;
+  blockDetails.nonce = blockTemplate.nonce;
+  blockDetails.hash = blockHash;
+
+  blockDetails.reward = 0;
+  for (const TransactionOutput& out : blockTemplate.baseTransaction.outputs) {
+    blockDetails.reward += out.amount;
+  }
+
+  blockDetails.index = blockIndex;
+  blockDetails.isAlternative = false;
+
+  auto difficulties = segment.getLastCumulativeDifficulties(2, blockIndex, addGenesisBlock);
+  blockDetails.difficulty = difficulties.size() == 2 ? difficulties[1] - difficulties[0] : difficulties[0];
+
+  std::vector<uint64_t> sizes = segment.getLastBlocksSizes(1, blockDetails.index, addGenesisBlock);
+  assert(sizes.size() == 1);
+  blockDetails.transactionsCumulativeSize = sizes.front();
+
+  uint64_t blockBlobSize = getObjectBinarySize(blockTemplate);
+  uint64_t coinbaseTransactionSize = getObjectBinarySize(blockTemplate.baseTransaction);
+  blockDetails.blockSize = blockBlobSize + blockDetails.transactionsCumulativeSize - coinbaseTransactionSize;
+
+  blockDetails.alreadyGeneratedCoins = segment.getAlreadyGeneratedCoins(blockDetails.index);
+  blockDetails.alreadyGeneratedTransactions = segment.getAlreadyGeneratedTransactions(blockDetails.index);
+
+  uint64_t prevBlockGeneratedCoins = 0;
+  blockDetails.sizeMedian = 0;
+  if (blockDetails.index > 0) {
+    auto lastBlocksSizes = segment.getLastBlocksSizes(currency.rewardBlocksWindow(), blockDetails.index - 1, addGenesisBlock);
+    blockDetails.sizeMedian = Common::medianValue(lastBlocksSizes);
+    prevBlockGeneratedCoins = segment.getAlreadyGeneratedCoins(blockDetails.index - 1);
+  }
+
+  int64_t emissionChange = 0;
+  bool result = currency.getBlockReward(blockDetails.majorVersion, blockDetails.sizeMedian, 0, prevBlockGeneratedCoins, 0, blockDetails.baseReward, emissionChange);
+  assert(result);
+
+  uint64_t currentReward = 0;
+  result = currency.getBlockReward(blockDetails.majorVersion, blockDetails.sizeMedian, blockDetails.transactionsCumulativeSize,
+                                   prevBlockGeneratedCoins, 0, currentReward, emissionChange);
+  assert(result);
+
+  if (blockDetails.baseReward == 0 && currentReward == 0) {
+    blockDetails.penalty = static_cast<double>(0);
+  } else {
+    assert(blockDetails.baseReward >= currentReward);
+    blockDetails.penalty = static_cast<double>(blockDetails.baseReward - currentReward) / static_cast<double>(blockDetails.baseReward);
+  }
+
+  blockDetails.transactions.reserve(blockTemplate.transactionHashes.size() + 1);
+  CachedTransaction cachedBaseTx(std::move(blockTemplate.baseTransaction));
+  blockDetails.transactions.push_back(getTransactionDetails(segment, cachedBaseTx.getTransactionHash()));
+
+  blockDetails.totalFeeAmount = 0;
+  for (const Crypto::Hash& transactionHash : blockTemplate.transactionHashes) {
+    blockDetails.transactions.push_back(getTransactionDetails(segment, transactionHash));
+    blockDetails.totalFeeAmount += blockDetails.transactions.back().fee;
+  }
+
+  return blockDetails;
+}
+
+TransactionDetails getTransactionDetails(const IBlockchainCache& segment, const Crypto::Hash& transactionHash) {
+  std::vector<Crypto::Hash> transactionsHashes;
+  std::vector<BinaryArray> rawTransactions;
+  std::vector<Crypto::Hash> missedTransactionsHashes;
+  transactionsHashes.push_back(transactionHash);
+
+  segment.getRawTransactions(transactionsHashes, rawTransactions, missedTransactionsHashes);
+  assert(missedTransactionsHashes.empty());
+  assert(rawTransactions.size() == 1);
+
+  std::vector<CachedTransaction> transactions;
+  restoreCachedTransactions(rawTransactions, transactions);
+  assert(transactions.size() == 1);
+
+  TransactionDetails transactionDetails;
+  transactionDetails.hash = transactionHash;
+  transactionDetails.inBlockchain = true;
+  transactionDetails.blockIndex = segment.getBlockIndexContainingTx(transactionHash);
+  transactionDetails.blockHash = segment.getBlockHash(transactionDetails.blockIndex);
+
+  auto timestamps = segment.getLastTimestamps(1, transactionDetails.blockIndex, addGenesisBlock);
+  assert(timestamps.size() == 1);
+  transactionDetails.timestamp = timestamps.back();
+
+  transactionDetails.size = transactions.back().getTransactionBinaryArray().size();
+  transactionDetails.fee = transactions.back().getTransactionFee();
+
+  fillTransactionDetails(segment, transactions.back().getTransaction(), transactionDetails);
+  return transactionDetails;
+}
+
+TransactionDetails getPoolTransactionDetails(const IBlockchainCache& segment, const CachedTransaction& transaction, uint64_t receiveTime) {
+  TransactionDetails transactionDetails;
+  transactionDetails.hash = transaction.getTransactionHash();
+  transactionDetails.inBlockchain = false;
+  transactionDetails.timestamp = receiveTime;
+
+  transactionDetails.size = transaction.getTransactionBinaryArray().size();
+  transactionDetails.fee = transaction.getTransactionFee();
+
+  fillTransactionDetails(segment, transaction.getTransaction(), transactionDetails);
+  return transactionDetails;
+}
+
 }
 }
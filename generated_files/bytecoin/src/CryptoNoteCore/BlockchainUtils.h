@@ -19,14 +19,27 @@
 
 #include <vector>
 
+#include "BlockchainExplorerData.h"
 #include "CachedTransaction.h"
 #include "CryptoNote.h"
 #include "CryptoNoteTools.h"
 
 namespace CryptoNote {
+
+class Currency;
+class IBlockchainCache;
+
 namespace Utils {
 
 bool restoreCachedTransactions(const std::vector<BinaryArray>& binaryTransactions, std::vector<CachedTransaction>& transactions);
 
+// The details read nothing but the segment and its parents. isAlternative is left false
+BlockDetails getBlockDetails(const Currency& currency, const IBlockchainCache& segment, uint32_t blockIndex,
+                             const Crypto::Hash& blockHash, BlockTemplate&& blockTemplate);
+// The transaction must be in the segment
+TransactionDetails getTransactionDetails(const IBlockchainCache& segment, const Crypto::Hash& transactionHash);
+// Details of a transaction not in the blockchain, its inputs are looked up in the segment
+TransactionDetails getPoolTransactionDetails(const IBlockchainCache& segment, const CachedTransaction& transaction, uint64_t receiveTime);
+
 } //namespace Utils
 } //namespace CryptoNote
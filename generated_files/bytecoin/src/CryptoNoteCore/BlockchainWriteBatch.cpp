@@ -106,6 +106,11 @@ BlockchainWriteBatch& BlockchainWriteBatch::insertKeyOutputInfo(IBlockchainCache
   return *this;
 }
 
+BlockchainWriteBatch& BlockchainWriteBatch::insertAccount(const std::string& accountNumber, const AccountInfo& accountInfo) {
+  rawDataToInsert.emplace_back(DB::serialize(DB::ACCOUNT_NUMBER_TO_ACCOUNT_INFO_PREFIX, accountNumber, accountInfo));
+  return *this;
+}
+
 BlockchainWriteBatch& BlockchainWriteBatch::removeSpentKeyImages(uint32_t blockIndex, const std::vector<Crypto::KeyImage>& spentKeyImages) {
   rawKeysToRemove.reserve(rawKeysToRemove.size() + spentKeyImages.size() + 1);
   rawKeysToRemove.emplace_back(DB::serializeKey(DB::BLOCK_INDEX_TO_KEY_IMAGE_PREFIX, blockIndex));
@@ -176,6 +181,11 @@ BlockchainWriteBatch&BlockchainWriteBatch::removeKeyOutputInfo(IBlockchainCache:
   return *this;
 }
 
+BlockchainWriteBatch& BlockchainWriteBatch::removeAccount(const std::string& accountNumber) {
+  rawKeysToRemove.emplace_back(DB::serializeKey(DB::ACCOUNT_NUMBER_TO_ACCOUNT_INFO_PREFIX, accountNumber));
+  return *this;
+}
+
 std::vector<std::pair<std::string, std::string>> BlockchainWriteBatch::extractRawDataToInsert() {
   return std::move(rawDataToInsert);
 }
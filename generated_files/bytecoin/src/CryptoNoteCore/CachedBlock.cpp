@@ -99,7 +99,13 @@ const Crypto::Hash& CachedBlock::getBlockLongHash(cn_context& cryptoContext) con
 		   std::string str = block.accountNumber;
 		   std::vector<uint8_t> vec(str.begin(), str.end());
 			blockHash = CryptoNote::getObjectHash(vec);
-			cn_slow_hash(cryptoContext, vec.data(), vec.size(), blockLongHash.get());
+			// Account blocks carry no proof of work, since ACCOUNT_BLOCK_MINOR_VERSION_2 the commitment doesn't pay for a scratchpad either
+			if (block.minorVersion >= ACCOUNT_BLOCK_MINOR_VERSION_2) {
+				cn_fast_hash(vec.data(), vec.size(), blockLongHash.get());
+			}
+			else {
+				cn_slow_hash(cryptoContext, vec.data(), vec.size(), blockLongHash.get());
+			}
 		}
 	}
 
@@ -29,6 +29,7 @@
 #include "BlockchainCache.h"
 #include "BlockchainStorage.h"
 #include "BlockchainUtils.h"
+#include "CryptoNoteCore/AccountRegistrationErrors.h"
 #include "CryptoNoteCore/ITimeProvider.h"
 #include "CryptoNoteCore/CoreErrors.h"
 #include "CryptoNoteCore/MemoryBlockchainStorage.h"
@@ -188,13 +189,38 @@ uint32_t findCommonRoot(IMainChainStorage& storage, IBlockchainCache& rootSegmen
 
 const std::chrono::seconds OUTDATED_TRANSACTION_POLLING_INTERVAL = std::chrono::seconds(60);
 
+void appendKeyOutputKeysRequests(const Transaction& transaction, std::vector<KeyOutputKeysRequest>& requests) {
+  for (const auto& input : transaction.inputs) {
+    if (input.type() != typeid(KeyInput)) {
+      continue;
+    }
+
+    const KeyInput& in = boost::get<KeyInput>(input);
+    KeyOutputKeysRequest request;
+    request.amount = in.amount;
+    request.result = ExtractOutputKeysResult::INVALID_GLOBAL_INDEX;
+    if (!in.outputIndexes.empty()) {
+      request.globalIndexes.resize(in.outputIndexes.size());
+      request.globalIndexes[0] = in.outputIndexes[0];
+      for (size_t i = 1; i < in.outputIndexes.size(); ++i) {
+        request.globalIndexes[i] = request.globalIndexes[i - 1] + in.outputIndexes[i];
+      }
+    }
+
+    requests.push_back(std::move(request));
+  }
+}
+
 }
 
 Core::Core(const Currency& currency, Logging::ILogger& logger, Checkpoints&& checkpoints, System::Dispatcher& dispatcher,
-           std::unique_ptr<IBlockchainCacheFactory>&& blockchainCacheFactory, std::unique_ptr<IMainChainStorage>&& mainchainStorage)
+           std::unique_ptr<IBlockchainCacheFactory>&& blockchainCacheFactory, std::unique_ptr<IMainChainStorage>&& mainchainStorage,
+           const CoreConfig& coreConfig)
     : currency(currency), dispatcher(dispatcher), contextGroup(dispatcher), logger(logger, "Core"), checkpoints(std::move(checkpoints)),
       upgradeManager(new UpgradeManager()), blockchainCacheFactory(std::move(blockchainCacheFactory)),
-      mainChainStorage(std::move(mainchainStorage)), initialized(false) {
+      mainChainStorage(std::move(mainchainStorage)), initialized(false),
+      ringSignatureVerifier(coreConfig.getSignatureVerificationThreadsCount()), ringSignatureCache(coreConfig.getSignatureCacheSize()),
+      rawBlockCache(static_cast<size_t>(coreConfig.getBlockCacheSize())) {
 
   upgradeManager->addMajorBlockVersion(BLOCK_MAJOR_VERSION_2, currency.upgradeHeight(BLOCK_MAJOR_VERSION_2));
   upgradeManager->addMajorBlockVersion(BLOCK_MAJOR_VERSION_3, currency.upgradeHeight(BLOCK_MAJOR_VERSION_3));
@@ -327,7 +353,7 @@ std::vector<RawBlock> Core::getBlocks(uint32_t minIndex, uint32_t count) const {
       if (cache->getTopBlockIndex() >= maxIndex) {
         auto minChainIndex = std::max(minIndex, cache->getStartBlockIndex());
         for (; minChainIndex <= maxIndex; --maxIndex) {
-          blocks.emplace_back(cache->getBlockByIndex(maxIndex));
+          blocks.emplace_back(getRawBlock(cache, maxIndex));
           if (maxIndex == 0) {
             break;
           }
@@ -351,6 +377,12 @@ void Core::getBlocks(const std::vector<Crypto::Hash>& blockHashes, std::vector<R
   throwIfNotInitialized();
 
   for (const auto& hash : blockHashes) {
+    auto cachedBlock = rawBlockCache.find(hash);
+    if (cachedBlock) {
+      blocks.push_back(*cachedBlock);
+      continue;
+    }
+
     IBlockchainCache* blockchainSegment = findSegmentContainingBlock(hash);
     if (blockchainSegment == nullptr) {
       missedHashes.push_back(hash);
@@ -358,7 +390,7 @@ void Core::getBlocks(const std::vector<Crypto::Hash>& blockHashes, std::vector<R
       uint32_t blockIndex = blockchainSegment->getBlockIndex(hash);
       assert(blockIndex <= blockchainSegment->getTopBlockIndex());
 
-      blocks.push_back(blockchainSegment->getBlockByIndex(blockIndex));
+      blocks.push_back(getRawBlock(blockchainSegment, blockIndex));
     }
   }
 }
@@ -511,21 +543,12 @@ Difficulty Core::getBlockDifficulty(uint32_t blockIndex) const {
   return difficulties[0];
 }
 
-// TODO: just use mainChain->getDifficultyForNextBlock() ?
 Difficulty Core::getDifficultyForNextBlock() const {
   throwIfNotInitialized();
   IBlockchainCache* mainChain = chainsLeaves[0];
 
-  uint32_t topBlockIndex = mainChain->getTopBlockIndex();
-
-  uint8_t nextBlockMajorVersion = getBlockMajorVersionForHeight(topBlockIndex);
-
-  size_t blocksCount = std::min(static_cast<size_t>(topBlockIndex), currency.difficultyBlocksCountByBlockVersion(nextBlockMajorVersion));
-
-  auto timestamps = mainChain->getLastTimestamps(blocksCount);
-  auto difficulties = mainChain->getLastCumulativeDifficulties(blocksCount);
-
-  return currency.nextDifficulty(nextBlockMajorVersion, topBlockIndex, timestamps, difficulties);
+  // Same window the block will be validated against, kept incrementally by the segment
+  return mainChain->getDifficultyForNextBlock();
 }
 
 std::vector<Crypto::Hash> Core::findBlockchainSupplement(const std::vector<Crypto::Hash>& remoteBlockIds,
@@ -542,6 +565,14 @@ std::vector<Crypto::Hash> Core::findBlockchainSupplement(const std::vector<Crypt
 }
 
 std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlock) {
+  return addBlock(cachedBlock, std::move(rawBlock), nullptr);
+}
+
+std::error_code Core::addBlock(const CachedBlock& cachedBlock, std::vector<CachedTransaction>&& transactions, RawBlock&& rawBlock) {
+  return addBlock(cachedBlock, std::move(rawBlock), &transactions);
+}
+
+std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlock, std::vector<CachedTransaction>* preparedTransactions) {
   throwIfNotInitialized();
   logger(Logging::DEBUGGING) << "Request to add block came for block " << cachedBlock.getBlockHash();
 
@@ -563,7 +594,14 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
 
   std::vector<CachedTransaction> transactions;
   uint64_t cumulativeSize = 0;
-  if (!extractTransactions(rawBlock.transactions, transactions, cumulativeSize)) {
+  if (preparedTransactions != nullptr) {
+    assert(preparedTransactions->size() == rawBlock.transactions.size());
+    transactions = std::move(*preparedTransactions);
+    for (const auto& rawTransaction : rawBlock.transactions) {
+      assert(rawTransaction.size() <= currency.maxTxSize());
+      cumulativeSize += rawTransaction.size();
+    }
+  } else if (!extractTransactions(rawBlock.transactions, transactions, cumulativeSize)) {
     logger(Logging::WARNING) << "Couldn't deserialize raw block transactions in block " << cachedBlock.getBlockHash();
     return error::AddBlockErrorCode::DESERIALIZATION_FAILED;
   }
@@ -602,18 +640,74 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
     return error::BlockValidationError::DIFFICULTY_OVERHEAD;
   }
 
+  // Semantic checks are cheap, a block failing them doesn't cost the read of its ring members
   uint64_t cumulativeFee = 0;
   for (const auto& transaction : transactions) {
     uint64_t fee = 0;
-    auto transactionValidationResult = validateTransaction(transaction, validatorState, cache, fee, previousBlockIndex);
-    if (transactionValidationResult) {
-      logger(Logging::DEBUGGING) << "Failed to validate transaction " << transaction.getTransactionHash() << ": " << transactionValidationResult.message();
-      return transactionValidationResult;
+    auto semanticValidationResult = validateTransactionSemantic(transaction.getTransaction(), fee, previousBlockIndex);
+    if (semanticValidationResult) {
+      logger(Logging::DEBUGGING) << "Failed to validate transaction " << transaction.getTransactionHash() << ": " << semanticValidationResult.message();
+      return semanticValidationResult;
     }
 
     cumulativeFee += fee;
   }
 
+  // Key images and outputs are validated sequentially, ring signatures are collected and checked in parallel afterwards.
+  // Every signature collected before the first sequential failure precedes it, so the earliest failed signature wins.
+  // Ring members of all inputs of the block are read at once
+  std::vector<KeyOutputKeysRequest> outputKeysRequests;
+  std::vector<size_t> firstOutputKeysRequests;
+  firstOutputKeysRequests.reserve(transactions.size());
+  bool checkRingMembers = !checkpoints.isInCheckpointZone(previousBlockIndex + 1);
+  for (const auto& transaction : transactions) {
+    firstOutputKeysRequests.push_back(outputKeysRequests.size());
+    if (checkRingMembers) {
+      appendKeyOutputKeysRequests(transaction.getTransaction(), outputKeysRequests);
+    }
+  }
+
+  if (!outputKeysRequests.empty()) {
+    cache->extractKeyOutputKeys(previousBlockIndex, outputKeysRequests);
+  }
+
+  std::vector<RingSignatureCheck> signatureChecks;
+  std::error_code transactionValidationResult;
+  size_t failedTransactionIndex = transactions.size();
+  for (size_t i = 0; i < transactions.size(); ++i) {
+    auto firstTransactionCheck = signatureChecks.size();
+    transactionValidationResult = validateTransactionInputs(transactions[i], validatorState, cache, previousBlockIndex, &signatureChecks,
+                                                            checkRingMembers ? outputKeysRequests.data() + firstOutputKeysRequests[i] : nullptr);
+    for (auto j = firstTransactionCheck; j < signatureChecks.size(); ++j) {
+      signatureChecks[j].transactionIndex = i;
+    }
+
+    if (transactionValidationResult) {
+      failedTransactionIndex = i;
+      break;
+    }
+  }
+
+  // Most transactions were checked on pool admission already
+  signatureChecks.erase(std::remove_if(signatureChecks.begin(), signatureChecks.end(),
+    [this](const RingSignatureCheck& check) { return ringSignatureCache.contains(check); }), signatureChecks.end());
+
+  auto failedSignatureIndex = ringSignatureVerifier.verify(signatureChecks);
+  if (failedSignatureIndex != signatureChecks.size()) {
+    failedTransactionIndex = signatureChecks[failedSignatureIndex].transactionIndex;
+    transactionValidationResult = error::TransactionValidationError::INPUT_INVALID_SIGNATURES;
+  } else if (!transactionValidationResult) {
+    // Keeps them for transactions returning to the pool after a chain switch
+    for (const auto& check : signatureChecks) {
+      ringSignatureCache.insert(check);
+    }
+  }
+
+  if (transactionValidationResult) {
+    logger(Logging::DEBUGGING) << "Failed to validate transaction " << transactions[failedTransactionIndex].getTransactionHash() << ": " << transactionValidationResult.message();
+    return transactionValidationResult;
+  }
+
   uint64_t reward = 0;
   int64_t emissionChange = 0;
   auto alreadyGeneratedCoins = cache->getAlreadyGeneratedCoins(previousBlockIndex);
@@ -784,6 +878,8 @@ void Core::actualizePoolTransactionsLite(const TransactionValidatorState& valida
 void Core::switchMainChainStorage(uint32_t splitBlockIndex, IBlockchainCache& newChain) {
   assert(mainChainStorage->getBlockCount() > splitBlockIndex);
 
+  rawBlockCache.removeFrom(splitBlockIndex);
+
   auto blocksToPop = mainChainStorage->getBlockCount() - splitBlockIndex;
   for (size_t i = 0; i < blocksToPop; ++i) {
     mainChainStorage->popBlock();
@@ -991,6 +1087,17 @@ std::vector<Crypto::Hash> Core::getPoolTransactionHashes() const {
   return transactionPool->getTransactionHashes();
 }
 
+bool Core::getPoolTransaction(const Crypto::Hash& transactionHash, BinaryArray& transaction) const {
+  throwIfNotInitialized();
+
+  if (!transactionPool->checkIfTransactionPresent(transactionHash)) {
+    return false;
+  }
+
+  transaction = transactionPool->getTransaction(transactionHash).getTransactionBinaryArray();
+  return true;
+}
+
 bool Core::getPoolChanges(const Crypto::Hash& lastBlockHash, const std::vector<Crypto::Hash>& knownHashes,
                           std::vector<BinaryArray>& addedTransactions,
                           std::vector<Crypto::Hash>& deletedTransactions) const {
@@ -1246,17 +1353,36 @@ bool Core::extractTransactions(const std::vector<BinaryArray>& rawTransactions,
 
 std::error_code Core::validateTransaction(const CachedTransaction& cachedTransaction, TransactionValidatorState& state,
                                           IBlockchainCache* cache, uint64_t& fee, uint32_t blockIndex) {
-  // TransactionValidatorState currentState;
-  const auto& transaction = cachedTransaction.getTransaction();
+  auto error = validateTransactionSemantic(cachedTransaction.getTransaction(), fee, blockIndex);
+  if (error != error::TransactionValidationError::VALIDATION_SUCCESS) {
+    return error;
+  }
+
+  return validateTransactionInputs(cachedTransaction, state, cache, blockIndex, nullptr, nullptr);
+}
+
+std::error_code Core::validateTransactionSemantic(const Transaction& transaction, uint64_t& fee, uint32_t blockIndex) {
 uint8_t blockMajorVersion = getBlockMajorVersionForHeight(blockIndex);
 auto error_mixin = validateMixin(transaction, blockMajorVersion);
 if (error_mixin != error::TransactionValidationError::VALIDATION_SUCCESS) {
   return error_mixin;
 }
 
-auto error = validateSemantic(transaction, fee, blockIndex);
-  if (error != error::TransactionValidationError::VALIDATION_SUCCESS) {
-    return error;
+  return validateSemantic(transaction, fee, blockIndex);
+}
+
+std::error_code Core::validateTransactionInputs(const CachedTransaction& cachedTransaction, TransactionValidatorState& state,
+                                                IBlockchainCache* cache, uint32_t blockIndex,
+                                                std::vector<RingSignatureCheck>* deferredSignatureChecks, KeyOutputKeysRequest* prefetchedOutputKeys) {
+  const auto& transaction = cachedTransaction.getTransaction();
+  bool checkRingMembers = !checkpoints.isInCheckpointZone(blockIndex + 1);
+  std::vector<KeyOutputKeysRequest> outputKeysRequests;
+  if (checkRingMembers && prefetchedOutputKeys == nullptr) {
+    appendKeyOutputKeysRequests(transaction, outputKeysRequests);
+    if (!outputKeysRequests.empty()) {
+      cache->extractKeyOutputKeys(blockIndex, outputKeysRequests);
+      prefetchedOutputKeys = outputKeysRequests.data();
+    }
   }
 
   size_t inputIndex = 0;
@@ -1267,36 +1393,41 @@ auto error = validateSemantic(transaction, fee, blockIndex);
         return error::TransactionValidationError::INPUT_KEYIMAGE_ALREADY_SPENT;
       }
 
-      if (!checkpoints.isInCheckpointZone(blockIndex + 1)) {
+      if (checkRingMembers) {
         if (cache->checkIfSpent(in.keyImage, blockIndex)) {
           return error::TransactionValidationError::INPUT_KEYIMAGE_ALREADY_SPENT;
         }
 
-        std::vector<PublicKey> outputKeys;
         assert(!in.outputIndexes.empty());
+        assert(prefetchedOutputKeys != nullptr);
+        auto& outputKeys = *prefetchedOutputKeys++;
+        assert(outputKeys.amount == in.amount);
 
-        std::vector<uint32_t> globalIndexes(in.outputIndexes.size());
-        globalIndexes[0] = in.outputIndexes[0];
-        for (size_t i = 1; i < in.outputIndexes.size(); ++i) {
-          globalIndexes[i] = globalIndexes[i - 1] + in.outputIndexes[i];
-        }
-
-        auto result = cache->extractKeyOutputKeys(in.amount, blockIndex, {globalIndexes.data(), globalIndexes.size()}, outputKeys);
-        if (result == ExtractOutputKeysResult::INVALID_GLOBAL_INDEX) {
+        if (outputKeys.result == ExtractOutputKeysResult::INVALID_GLOBAL_INDEX) {
           return error::TransactionValidationError::INPUT_INVALID_GLOBAL_INDEX;
         }
 
-        if (result == ExtractOutputKeysResult::OUTPUT_LOCKED) {
+        if (outputKeys.result == ExtractOutputKeysResult::OUTPUT_LOCKED) {
           return error::TransactionValidationError::INPUT_SPEND_LOCKED_OUT;
         }
 
-        std::vector<const Crypto::PublicKey*> outputKeyPointers;
-        outputKeyPointers.reserve(outputKeys.size());
-        std::for_each(outputKeys.begin(), outputKeys.end(), [&outputKeyPointers] (const Crypto::PublicKey& key) { outputKeyPointers.push_back(&key); });
-        if (!Crypto::check_ring_signature(cachedTransaction.getTransactionPrefixHash(), in.keyImage, outputKeyPointers.data(),
-                                          outputKeyPointers.size(), transaction.signatures[inputIndex].data(),
-                                          blockIndex > parameters::KEY_IMAGE_CHECKING_BLOCK_INDEX)) {
-          return error::TransactionValidationError::INPUT_INVALID_SIGNATURES;
+        RingSignatureCheck signatureCheck;
+        signatureCheck.prefixHash = cachedTransaction.getTransactionPrefixHash();
+        signatureCheck.keyImage = in.keyImage;
+        signatureCheck.outputKeys = std::move(outputKeys.publicKeys);
+        signatureCheck.signatures = &transaction.signatures[inputIndex];
+        signatureCheck.checkKeyImage = blockIndex > parameters::KEY_IMAGE_CHECKING_BLOCK_INDEX;
+        signatureCheck.transactionIndex = 0;
+        signatureCheck.inputIndex = inputIndex;
+
+        if (deferredSignatureChecks != nullptr) {
+          deferredSignatureChecks->push_back(std::move(signatureCheck));
+        } else if (!ringSignatureCache.contains(signatureCheck)) {
+          if (!checkRingSignature(signatureCheck)) {
+            return error::TransactionValidationError::INPUT_INVALID_SIGNATURES;
+          }
+
+          ringSignatureCache.insert(signatureCheck);
         }
       }
 
@@ -1501,7 +1632,12 @@ std::error_code Core::validateBlock(const CachedBlock& cachedBlock, IBlockchainC
 			minerReward += output.amount;
 		}
 	}
-	else {}
+	else if (cachedBlock.getTypeOfBlock() == ACCOUNT_BLOCK) {
+		// only the hash commitment of a scheduled version is accepted, older account blocks carry any minor version
+		if (cachedBlock.getBlock().minorVersion > getAccountBlockMinorVersionForHeight(cachedBlock.getBlockIndex())) {
+			return error::BlockValidationError::WRONG_VERSION;
+		}
+	}
   return error::BlockValidationError::VALIDATION_SUCCESS;
 }
 
@@ -1513,6 +1649,107 @@ const Currency& Core::getCurrency() const {
   return currency;
 }
 
+void Core::getAccountAddresses(std::vector<AccountAddressRequest>& requests) const {
+  throwIfNotInitialized();
+  assert(!chainsLeaves.empty());
+
+  chainsLeaves[0]->getAccountAddresses(chainsLeaves[0]->getTopBlockIndex(), requests);
+}
+
+std::vector<RawBlock> Core::addAccountBlocks(std::vector<AccountRegistration>& registrations) {
+  throwIfNotInitialized();
+
+  // Checks of single registrations don't depend on the chain and run in parallel
+  WorkerPool workers(ringSignatureVerifier.getThreadsCount());
+  workers.run(registrations.size(), [this, &registrations](size_t index, size_t) {
+    auto& registration = registrations[index];
+    AccountPublicAddress address;
+    if (registration.accountNumber.size() != ACCOUNT_NUMBER_SIZE) {
+      registration.result = error::AccountRegistrationErrorCode::INVALID_ACCOUNT_NUMBER;
+    } else if (registration.accountAddress.size() != ACCOUNT_ADDRESS_SIZE || !currency.parseAccountAddressString(registration.accountAddress, address)) {
+      registration.result = error::AccountRegistrationErrorCode::INVALID_ACCOUNT_ADDRESS;
+    } else {
+      registration.result = std::error_code();
+    }
+
+    return true;
+  });
+
+  std::unordered_set<std::string> requestedNumbers;
+  std::vector<AccountAddressRequest> registeredRequests;
+  std::vector<size_t> registeredRequestOwners;
+  for (size_t i = 0; i < registrations.size(); ++i) {
+    auto& registration = registrations[i];
+    if (registration.result) {
+      continue;
+    }
+
+    if (!requestedNumbers.insert(registration.accountNumber).second) {
+      registration.result = error::AccountRegistrationErrorCode::DUPLICATED_ACCOUNT_NUMBER;
+      continue;
+    }
+
+    registeredRequests.push_back(AccountAddressRequest{registration.accountNumber, {}, false});
+    registeredRequestOwners.push_back(i);
+  }
+
+  getAccountAddresses(registeredRequests);
+  for (size_t i = 0; i < registeredRequests.size(); ++i) {
+    if (registeredRequests[i].found) {
+      registrations[registeredRequestOwners[i]].result = error::AccountRegistrationErrorCode::ALREADY_REGISTERED;
+    }
+  }
+
+  // Every block is built on the previous one, so blocks are validated and added one by one,
+  // each of them is written to the DB before the next one is added
+  std::vector<RawBlock> addedBlocks;
+  for (auto& registration : registrations) {
+    if (registration.result) {
+      continue;
+    }
+
+    BlockTemplate block = makeAccountBlock(registration.accountNumber, registration.accountAddress);
+    RawBlock rawBlock{toBinaryArray(block), {}};
+    RawBlock addedBlock = rawBlock;
+    registration.result = addBlock(CachedBlock(block), std::move(rawBlock));
+    if (registration.result == error::AddBlockErrorCode::ADDED_TO_MAIN) {
+      addedBlocks.push_back(std::move(addedBlock));
+    } else {
+      logger(Logging::WARNING) << "Failed to add account block for account " << registration.accountNumber << ": " << registration.result.message();
+    }
+  }
+
+  return addedBlocks;
+}
+
+BlockTemplate Core::makeAccountBlock(const std::string& accountNumber, const std::string& accountAddress) const {
+  throwIfNotInitialized();
+
+  BaseInput input;
+  input.blockIndex = getTopBlockIndex() + 1;
+
+  BlockTemplate block = boost::value_initialized<BlockTemplate>();
+  block.baseTransaction.version = 1;
+  block.baseTransaction.inputs.push_back(input);
+  block.typeBlock = ACCOUNT_BLOCK;
+  block.previousBlockHash = getTopBlockHash();
+  block.parentBlock.transactionCount = 1;
+  block.majorVersion = BLOCK_MAJOR_VERSION_5;
+  block.minorVersion = getAccountBlockMinorVersionForHeight(input.blockIndex);
+  block.accountNumber = accountNumber;
+  block.accountAddress = accountAddress;
+  block.timestamp = getAdjustedTime();
+  return block;
+}
+
+const RingSignatureCache& Core::getRingSignatureCache() const {
+  return ringSignatureCache;
+}
+
+const RawBlockCache& Core::getRawBlockCache() const {
+  return rawBlockCache;
+}
+
 void Core::save() {
   throwIfNotInitialized();
 
@@ -1619,6 +1856,7 @@ void Core::cutSegment(IBlockchainCache& segment, uint32_t startIndex) {
   }
 
   logger(Logging::INFO) << "Cutting root segment from index " << startIndex;
+  rawBlockCache.removeFrom(startIndex);
   auto childCache = segment.split(startIndex);
   segment.deleteChild(childCache.get());
 }
@@ -1670,13 +1908,25 @@ IBlockchainCache* Core::findAlternativeSegmentContainingBlock(uint32_t blockInde
 }
 
 BlockTemplate Core::restoreBlockTemplate(IBlockchainCache* blockchainCache, uint32_t blockIndex) const {
-  RawBlock rawBlock = blockchainCache->getBlockByIndex(blockIndex);
+  bool mainChain = mainChainSet.count(blockchainCache) != 0;
+  if (mainChain) {
+    auto cachedTemplate = rawBlockCache.findTemplate(blockIndex);
+    if (cachedTemplate) {
+      return *cachedTemplate;
+    }
+  }
+
+  RawBlock rawBlock = getRawBlock(blockchainCache, blockIndex);
 
   BlockTemplate block;
   if (!fromBinaryArray(block, rawBlock.block)) {
     throw std::runtime_error("Coulnd't deserialize BlockTemplate");
   }
 
+  if (mainChain) {
+    rawBlockCache.insertTemplate(blockIndex, block);
+  }
+
   return block;
 }
 
@@ -1704,7 +1954,21 @@ std::vector<Crypto::Hash> Core::doBuildSparseChain(const Crypto::Hash& blockHash
 RawBlock Core::getRawBlock(IBlockchainCache* segment, uint32_t blockIndex) const {
   assert(blockIndex >= segment->getStartBlockIndex() && blockIndex <= segment->getTopBlockIndex());
 
-  return segment->getBlockByIndex(blockIndex);
+  //only main chain blocks are cached, an index may be taken by several alternative blocks
+  bool mainChain = mainChainSet.count(segment) != 0;
+  if (mainChain) {
+    auto cachedBlock = rawBlockCache.find(blockIndex);
+    if (cachedBlock) {
+      return *cachedBlock;
+    }
+  }
+
+  RawBlock rawBlock = segment->getBlockByIndex(blockIndex);
+  if (mainChain) {
+    rawBlockCache.insert(blockIndex, segment->getBlockHash(blockIndex), rawBlock);
+  }
+
+  return rawBlock;
 }
 
 //TODO: decompose these two methods
@@ -1831,6 +2095,10 @@ uint8_t Core::getBlockMajorVersionForHeight(uint32_t height) const {
   return upgradeManager->getBlockMajorVersion(height);
 }
 
+uint8_t Core::getAccountBlockMinorVersionForHeight(uint32_t height) const {
+  return currency.accountBlockMinorVersion(height);
+}
+
 size_t Core::calculateCumulativeBlocksizeLimit(uint32_t height) const {
   uint8_t nextBlockMajorVersion = getBlockMajorVersionForHeight(height);
   size_t nextBlockGrantedFullRewardZone = currency.blockGrantedFullRewardZoneByBlockVersion(nextBlockMajorVersion);
@@ -1857,13 +2125,18 @@ void Core::fillBlockTemplate(BlockTemplate& block, size_t medianSize, size_t max
 
   TransactionSpentInputsChecker spentInputsChecker;
 
-  std::vector<CachedTransaction> poolTransactions = transactionPool->getPoolTransactions();
-  for (auto it = poolTransactions.rbegin(); it != poolTransactions.rend() && it->getTransactionFee() == 0; ++it) {
-    const CachedTransaction& transaction = *it;
+  // Pool is kept ordered by fee per byte, so the template is its prefix that fits into the block.
+  // Walking stops as soon as even the smallest pool transaction can't fit anymore.
+  const size_t minTransactionSize = transactionPool->getMinTransactionSize();
+
+  transactionPool->forEachTransactionReversed([&](const CachedTransaction& transaction) {
+    if (transaction.getTransactionFee() != 0 || currency.fusionTxMaxSize() < transactionsSize + minTransactionSize) {
+      return false;
+    }
 
     auto transactionBlobSize = transaction.getTransactionBinaryArray().size();
     if (currency.fusionTxMaxSize() < transactionsSize + transactionBlobSize) {
-      continue;
+      return true;
     }
 
     if (!spentInputsChecker.haveSpentInputs(transaction.getTransaction())) {
@@ -1871,13 +2144,19 @@ void Core::fillBlockTemplate(BlockTemplate& block, size_t medianSize, size_t max
       transactionsSize += transactionBlobSize;
       logger(Logging::TRACE) << "Fusion transaction " << transaction.getTransactionHash() << " included to block template";
     }
-  }
 
-  for (const auto& cachedTransaction : poolTransactions) {
-    size_t blockSizeLimit = (cachedTransaction.getTransactionFee() == 0) ? medianSize : maxTotalSize;
+    return true;
+  });
+
+  const size_t maxBlockSizeLimit = std::max(medianSize, maxTotalSize);
+  transactionPool->forEachTransaction([&](const CachedTransaction& cachedTransaction) {
+    if (maxBlockSizeLimit < transactionsSize + minTransactionSize) {
+      return false;
+    }
 
+    size_t blockSizeLimit = (cachedTransaction.getTransactionFee() == 0) ? medianSize : maxTotalSize;
     if (blockSizeLimit < transactionsSize + cachedTransaction.getTransactionBinaryArray().size()) {
-      continue;
+      return true;
     }
 
     if (!spentInputsChecker.haveSpentInputs(cachedTransaction.getTransaction())) {
@@ -1888,7 +2167,9 @@ void Core::fillBlockTemplate(BlockTemplate& block, size_t medianSize, size_t max
     } else {
       logger(Logging::TRACE) << "Transaction " << cachedTransaction.getTransactionHash() << " is failed to include to block template";
     }
-  }
+
+    return true;
+  });
 }
 
 void Core::deleteAlternativeChains() {
@@ -1996,71 +2277,9 @@ BlockDetails Core::getBlockDetails(const Crypto::Hash& blockHash) const {
   }
 
   uint32_t blockIndex = segment->getBlockIndex(blockHash);
-  BlockTemplate blockTemplate = restoreBlockTemplate(segment, blockIndex);
-  
-  BlockDetails blockDetails;
-  blockDetails.majorVersion = blockTemplate.majorVersion;
-  blockDetails.minorVersion = blockTemplate.minorVersion;
-  blockDetails.timestamp = blockTemplate.timestamp;
-  blockDetails.prevBlockHash = blockTemplate.previousBlockHash;
-  blockDetails.nonce = blockTemplate.nonce;
-  blockDetails.hash = blockHash;
-
-  blockDetails.reward = 0;
-  for (const TransactionOutput& out : blockTemplate.baseTransaction.outputs) {
-    blockDetails.reward += out.amount;
-  }
-
-  blockDetails.index = blockIndex;
+  BlockDetails blockDetails = Utils::getBlockDetails(currency, *segment, blockIndex, blockHash, restoreBlockTemplate(segment, blockIndex));
   blockDetails.isAlternative = mainChainSet.count(segment) == 0;
 
-  blockDetails.difficulty = getBlockDifficulty(blockIndex);
-
-  std::vector<uint64_t> sizes = segment->getLastBlocksSizes(1, blockDetails.index, addGenesisBlock);
-  assert(sizes.size() == 1);
-  blockDetails.transactionsCumulativeSize = sizes.front();
-
-  uint64_t blockBlobSize = getObjectBinarySize(blockTemplate);
-  uint64_t coinbaseTransactionSize = getObjectBinarySize(blockTemplate.baseTransaction);
-  blockDetails.blockSize = blockBlobSize + blockDetails.transactionsCumulativeSize - coinbaseTransactionSize;
-
-  blockDetails.alreadyGeneratedCoins = segment->getAlreadyGeneratedCoins(blockDetails.index);
-  blockDetails.alreadyGeneratedTransactions = segment->getAlreadyGeneratedTransactions(blockDetails.index);
-
-  uint64_t prevBlockGeneratedCoins = 0;
-  blockDetails.sizeMedian = 0;
-  if (blockDetails.index > 0) {
-    auto lastBlocksSizes = segment->getLastBlocksSizes(currency.rewardBlocksWindow(), blockDetails.index - 1, addGenesisBlock);
-    blockDetails.sizeMedian = Common::medianValue(lastBlocksSizes);
-    prevBlockGeneratedCoins = segment->getAlreadyGeneratedCoins(blockDetails.index - 1);
-  }
-
-  int64_t emissionChange = 0;
-  bool result = currency.getBlockReward(blockDetails.majorVersion, blockDetails.sizeMedian, 0, prevBlockGeneratedCoins, 0, blockDetails.baseReward, emissionChange);
-  assert(result);
-
-  uint64_t currentReward = 0;
-  result = currency.getBlockReward(blockDetails.majorVersion, blockDetails.sizeMedian, blockDetails.transactionsCumulativeSize,
-                                   prevBlockGeneratedCoins, 0, currentReward, emissionChange);
-  assert(result);
-
-  if (blockDetails.baseReward == 0 && currentReward == 0) {
-    blockDetails.penalty = static_cast<double>(0);
-  } else {
-    assert(blockDetails.baseReward >= currentReward);
-    blockDetails.penalty = static_cast<double>(blockDetails.baseReward - currentReward) / static_cast<double>(blockDetails.baseReward);
-  }
-
-  blockDetails.transactions.reserve(blockTemplate.transactionHashes.size() + 1);
-  CachedTransaction cachedBaseTx(std::move(blockTemplate.baseTransaction));
-  blockDetails.transactions.push_back(getTransactionDetails(cachedBaseTx.getTransactionHash(), segment, false));
-
-  blockDetails.totalFeeAmount = 0;
-  for (const Crypto::Hash& transactionHash : blockTemplate.transactionHashes) {
-    blockDetails.transactions.push_back(getTransactionDetails(transactionHash, segment, false));
-    blockDetails.totalFeeAmount += blockDetails.transactions.back().fee;
-  }
-
   return blockDetails;
 }
 
@@ -2068,137 +2287,27 @@ TransactionDetails Core::getTransactionDetails(const Crypto::Hash& transactionHa
   throwIfNotInitialized();
 
   IBlockchainCache* segment = findSegmentContainingTransaction(transactionHash);
-  bool foundInPool = transactionPool->checkIfTransactionPresent(transactionHash);
-  if (segment == nullptr && !foundInPool) {
-    throw std::runtime_error("Requested transaction wasn't found.");
-  }
-
-  return getTransactionDetails(transactionHash, segment, foundInPool);
-}
-
-TransactionDetails Core::getTransactionDetails(const Crypto::Hash& transactionHash, IBlockchainCache* segment, bool foundInPool) const {
-  assert((segment != nullptr) != foundInPool);
-  if (segment == nullptr) {
-    segment = chainsLeaves[0];
-  }
-
-  std::unique_ptr<ITransaction> transaction;
-  Transaction rawTransaction;
-  TransactionDetails transactionDetails;
-  if (!foundInPool) {
-    std::vector<Crypto::Hash> transactionsHashes;
-    std::vector<BinaryArray> rawTransactions;
-    std::vector<Crypto::Hash> missedTransactionsHashes;
-    transactionsHashes.push_back(transactionHash);
-
-    segment->getRawTransactions(transactionsHashes, rawTransactions, missedTransactionsHashes);
-    assert(missedTransactionsHashes.empty());
-    assert(rawTransactions.size() == 1);
-
-    std::vector<CachedTransaction> transactions;
-    Utils::restoreCachedTransactions(rawTransactions, transactions);
-    assert(transactions.size() == 1);
-
-    transactionDetails.inBlockchain = true;
-    transactionDetails.blockIndex = segment->getBlockIndexContainingTx(transactionHash);
-    transactionDetails.blockHash = segment->getBlockHash(transactionDetails.blockIndex);
-
-    auto timestamps = segment->getLastTimestamps(1, transactionDetails.blockIndex, addGenesisBlock);
-    assert(timestamps.size() == 1);
-    transactionDetails.timestamp = timestamps.back();
-
-    transactionDetails.size = transactions.back().getTransactionBinaryArray().size();
-    transactionDetails.fee = transactions.back().getTransactionFee();
-
-    rawTransaction = transactions.back().getTransaction();
-    transaction = createTransaction(rawTransaction);
-  } else {
-    transactionDetails.inBlockchain = false;
-    transactionDetails.timestamp = transactionPool->getTransactionReceiveTime(transactionHash);
-
-    transactionDetails.size = transactionPool->getTransaction(transactionHash).getTransactionBinaryArray().size();
-    transactionDetails.fee = transactionPool->getTransaction(transactionHash).getTransactionFee();
-
-    rawTransaction = transactionPool->getTransaction(transactionHash).getTransaction();
-    transaction = createTransaction(rawTransaction);
+  if (segment != nullptr) {
+    return Utils::getTransactionDetails(*segment, transactionHash);
   }
 
-  transactionDetails.hash = transactionHash;
-  transactionDetails.unlockTime = transaction->getUnlockTime();
-
-  transactionDetails.totalOutputsAmount = transaction->getOutputTotalAmount();
-  transactionDetails.totalInputsAmount = transaction->getInputTotalAmount();
-
-  transactionDetails.mixin = 0;
-  for (size_t i = 0; i < transaction->getInputCount(); ++i) {
-    if (transaction->getInputType(i) != TransactionTypes::InputType::Key) {
-      continue;
-    }
-
-    KeyInput input;
-    transaction->getInput(i, input);
-    uint64_t currentMixin = input.outputIndexes.size();
-    if (currentMixin > transactionDetails.mixin) {
-      transactionDetails.mixin = currentMixin;
-    }
-  }
-
-  transactionDetails.paymentId = boost::value_initialized<Crypto::Hash>();
-  if (transaction->getPaymentId(transactionDetails.paymentId)) {
-    transactionDetails.hasPaymentId = true;
+  if (!transactionPool->checkIfTransactionPresent(transactionHash)) {
+    throw std::runtime_error("Requested transaction wasn't found.");
   }
-  transactionDetails.extra.publicKey = transaction->getTransactionPublicKey();
-  transaction->getExtraNonce(transactionDetails.extra.nonce);
-  
-  transactionDetails.signatures = rawTransaction.signatures;
-
-  transactionDetails.inputs.reserve(transaction->getInputCount());
-  for (size_t i = 0; i < transaction->getInputCount(); ++i) {
-    TransactionInputDetails txInDetails;
-
-    if (transaction->getInputType(i) == TransactionTypes::InputType::Generating) {
-      BaseInputDetails baseDetails;
-      baseDetails.input = boost::get<BaseInput>(rawTransaction.inputs[i]);
-      baseDetails.amount = transaction->getOutputTotalAmount();
-      txInDetails = baseDetails;
-    } else if (transaction->getInputType(i) == TransactionTypes::InputType::Key) {
-      KeyInputDetails txInToKeyDetails;
-      txInToKeyDetails.input = boost::get<KeyInput>(rawTransaction.inputs[i]);
-      std::vector<std::pair<Crypto::Hash, size_t>> outputReferences;
-      outputReferences.reserve(txInToKeyDetails.input.outputIndexes.size());
-      std::vector<uint32_t> globalIndexes = relativeOutputOffsetsToAbsolute(txInToKeyDetails.input.outputIndexes);
-      ExtractOutputKeysResult result = segment->extractKeyOtputReferences(txInToKeyDetails.input.amount, { globalIndexes.data(), globalIndexes.size() }, outputReferences);
-      assert(result == ExtractOutputKeysResult::SUCCESS);
-      assert(txInToKeyDetails.input.outputIndexes.size() == outputReferences.size());
-
-      txInToKeyDetails.mixin = txInToKeyDetails.input.outputIndexes.size();
-      txInToKeyDetails.output.number = outputReferences.back().second;
-      txInToKeyDetails.output.transactionHash = outputReferences.back().first;
-      txInDetails = txInToKeyDetails;
-    }
 
-    assert(!txInDetails.empty());
-    transactionDetails.inputs.push_back(std::move(txInDetails));
-  }
+  return Utils::getPoolTransactionDetails(*chainsLeaves[0], transactionPool->getTransaction(transactionHash),
+                                          transactionPool->getTransactionReceiveTime(transactionHash));
+}
 
-  transactionDetails.outputs.reserve(transaction->getOutputCount());
-  std::vector<uint32_t> globalIndexes;
-  globalIndexes.reserve(transaction->getOutputCount());
-  if (!transactionDetails.inBlockchain || !getTransactionGlobalIndexes(transactionDetails.hash, globalIndexes)) {
-    for (size_t i = 0; i < transaction->getOutputCount(); ++i) {
-      globalIndexes.push_back(0);
-    }
-  }
+std::unique_ptr<BlockchainSnapshot> Core::createSnapshot() const {
+  throwIfNotInitialized();
 
-  assert(transaction->getOutputCount() == globalIndexes.size());
-  for (size_t i = 0; i < transaction->getOutputCount(); ++i) {
-    TransactionOutputDetails txOutDetails;
-    txOutDetails.output = rawTransaction.outputs[i];
-    txOutDetails.globalIndex = globalIndexes[i];
-    transactionDetails.outputs.push_back(std::move(txOutDetails));
+  std::unique_ptr<IBlockchainCache> rootSegment = blockchainCacheFactory->createRootBlockchainCacheSnapshot(currency);
+  if (!rootSegment) {
+    return nullptr;
   }
 
-  return transactionDetails;
+  return std::unique_ptr<BlockchainSnapshot>(new BlockchainSnapshot(currency, std::move(rootSegment)));
 }
 
 std::vector<Crypto::Hash> Core::getAlternativeBlockHashesByIndex(uint32_t blockIndex) const {
@@ -20,10 +20,12 @@
 #include <unordered_map>
 #include "BlockchainCache.h"
 #include "BlockchainMessages.h"
+#include "BlockchainSnapshot.h"
 #include "CachedBlock.h"
 #include "CachedTransaction.h"
 #include "Currency.h"
 #include "Checkpoints.h"
+#include "CoreConfig.h"
 #include "IBlockchainCache.h"
 #include "IBlockchainCacheFactory.h"
 #include "ICore.h"
@@ -34,6 +36,9 @@
 #include "IUpgradeManager.h"
 #include <Logging/LoggerMessage.h>
 #include "MessageQueue.h"
+#include "RawBlockCache.h"
+#include "RingSignatureCache.h"
+#include "RingSignatureVerifier.h"
 #include "TransactionValidatiorState.h"
 #include "SwappedVector.h"
 
@@ -43,10 +48,18 @@
 
 namespace CryptoNote {
 
+// Account for Core::addAccountBlocks, result is filled by the core
+struct AccountRegistration {
+  std::string accountNumber;
+  std::string accountAddress;
+  std::error_code result;
+};
+
 class Core : public ICore, public ICoreInformation {
 public:
   Core(const Currency& currency, Logging::ILogger& logger, Checkpoints&& checkpoints, System::Dispatcher& dispatcher,
-       std::unique_ptr<IBlockchainCacheFactory>&& blockchainCacheFactory, std::unique_ptr<IMainChainStorage>&& mainChainStorage);
+       std::unique_ptr<IBlockchainCacheFactory>&& blockchainCacheFactory, std::unique_ptr<IMainChainStorage>&& mainChainStorage,
+       const CoreConfig& coreConfig = CoreConfig());
   virtual ~Core();
 
   virtual bool addMessageQueue(MessageQueue<BlockchainMessage>&  messageQueue) override;
@@ -80,10 +93,20 @@ virtual void extractKeyOutputKeys(const uint64_t amount, const std::vector<uint3
   virtual Difficulty getDifficultyForNextBlock() const override;
 
   virtual std::error_code addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlock) override;
+  virtual std::error_code addBlock(const CachedBlock& cachedBlock, std::vector<CachedTransaction>&& transactions, RawBlock&& rawBlock) override;
   virtual std::error_code addBlock(RawBlock&& rawBlock) override;
 
   virtual std::error_code submitBlock(BinaryArray&& rawBlockTemplate) override;
   bool pushBlock(const std::string& address,const  std::string& account);
+  // Resolves account numbers registered by account blocks of the main chain with one index lookup per segment
+  void getAccountAddresses(std::vector<AccountAddressRequest>& requests) const;
+  // Checks registrations in parallel and adds an account block on top of the main chain for each valid one,
+  // the blocks are validated and written one by one. Returns added blocks in chain order
+  std::vector<RawBlock> addAccountBlocks(std::vector<AccountRegistration>& registrations);
+  // Account block on top of the main chain
+  BlockTemplate makeAccountBlock(const std::string& accountNumber, const std::string& accountAddress) const;
+  // Minor version of new account blocks at the given index, newer ones are rejected
+  uint8_t getAccountBlockMinorVersionForHeight(uint32_t height) const;
 
   virtual bool getTransactionGlobalIndexes(const Crypto::Hash& transactionHash, std::vector<uint32_t>& globalIndexes) const override;
   virtual bool getRandomOutputs(uint64_t amount, uint16_t count, std::vector<uint32_t>& globalIndexes, std::vector<Crypto::PublicKey>& publicKeys) const override;
@@ -91,6 +114,7 @@ virtual void extractKeyOutputKeys(const uint64_t amount, const std::vector<uint3
   virtual bool addTransactionToPool(const BinaryArray& transactionBinaryArray) override;
 
   virtual std::vector<Crypto::Hash> getPoolTransactionHashes() const override;
+  virtual bool getPoolTransaction(const Crypto::Hash& transactionHash, BinaryArray& transaction) const override;
   virtual bool getPoolChanges(const Crypto::Hash& lastBlockHash, const std::vector<Crypto::Hash>& knownHashes, std::vector<BinaryArray>& addedTransactions,
     std::vector<Crypto::Hash>& deletedTransactions) const override;
   virtual bool getPoolChangesLite(const Crypto::Hash& lastBlockHash, const std::vector<Crypto::Hash>& knownHashes, std::vector<TransactionPrefixInfo>& addedTransactions,
@@ -109,6 +133,8 @@ virtual void extractKeyOutputKeys(const uint64_t amount, const std::vector<uint3
   virtual std::vector<Transaction> getPoolTransactions() const override;
 
   const Currency& getCurrency() const;
+  const RingSignatureCache& getRingSignatureCache() const;
+  const RawBlockCache& getRawBlockCache() const;
 
   virtual void save() override;
   virtual void load() override;
@@ -119,6 +145,10 @@ virtual void extractKeyOutputKeys(const uint64_t amount, const std::vector<uint3
   virtual std::vector<Crypto::Hash> getBlockHashesByTimestamps(uint64_t timestampBegin, size_t secondsCount) const override;
   virtual std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const override;
 
+  // Snapshot of the main chain blocks committed to the DB, to be queried off the dispatcher thread.
+  // Returns nullptr if the blockchain storage has no snapshots
+  std::unique_ptr<BlockchainSnapshot> createSnapshot() const;
+
 private:
   const Currency& currency;
   System::Dispatcher& dispatcher;
@@ -138,16 +168,28 @@ private:
   std::unique_ptr<IBlockchainCacheFactory> blockchainCacheFactory;
   std::unique_ptr<IMainChainStorage> mainChainStorage;
   bool initialized;
+  RingSignatureVerifier ringSignatureVerifier;
+  RingSignatureCache ringSignatureCache;
+  mutable RawBlockCache rawBlockCache;
 
   size_t blockMedianSize;
 
   void throwIfNotInitialized() const;
+  // If preparedTransactions is null, transactions are extracted from rawBlock
+  std::error_code addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlock, std::vector<CachedTransaction>* preparedTransactions);
   bool extractTransactions(const std::vector<BinaryArray>& rawTransactions, std::vector<CachedTransaction>& transactions, uint64_t& cumulativeSize);
 
 bool f_getMixin(const Transaction& transaction, uint64_t& mixin);
 std::error_code validateMixin(const Transaction& transaction, uint8_t majorBlockVersion);
   std::error_code validateSemantic(const Transaction& transaction, uint64_t& fee, uint32_t blockIndex);
   std::error_code validateTransaction(const CachedTransaction& transaction, TransactionValidatorState& state, IBlockchainCache* cache, uint64_t& fee, uint32_t blockIndex);
+  // Checks that don't read the blockchain: mixin and semantic checks
+  std::error_code validateTransactionSemantic(const Transaction& transaction, uint64_t& fee, uint32_t blockIndex);
+  // Checks of key images and ring members, the semantic checks must have passed.
+  // If deferredSignatureChecks isn't null ring signatures are collected there instead of being checked in place.
+  // prefetchedOutputKeys, if not null, points to the ring members of the first key input, the rest follow in input order
+  std::error_code validateTransactionInputs(const CachedTransaction& transaction, TransactionValidatorState& state, IBlockchainCache* cache, uint32_t blockIndex,
+                                            std::vector<RingSignatureCheck>* deferredSignatureChecks, KeyOutputKeysRequest* prefetchedOutputKeys);
   
   uint32_t findBlockchainSupplement(const std::vector<Crypto::Hash>& remoteBlockIds) const;
   std::vector<Crypto::Hash> getBlockHashes(uint32_t startBlockIndex, uint32_t maxCount) const;
@@ -185,7 +227,6 @@ std::error_code validateMixin(const Transaction& transaction, uint8_t majorBlock
   void deleteLeaf(size_t leafIndex);
   void mergeMainChainSegments();
   void mergeSegments(IBlockchainCache* acceptingSegment, IBlockchainCache* segment);
-  TransactionDetails getTransactionDetails(const Crypto::Hash& transactionHash, IBlockchainCache* segment, bool foundInPool) const;
   void notifyOnSuccess(error::AddBlockErrorCode opResult, uint32_t previousBlockIndex, const CachedBlock& cachedBlock,
                        const IBlockchainCache& cache);
   void copyTransactionsToPool(IBlockchainCache* alt);
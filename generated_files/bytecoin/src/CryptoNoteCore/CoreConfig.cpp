@@ -0,0 +1,132 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "CoreConfig.h"
+
+#include "Common/CommandLine.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const uint16_t DEFAULT_SIGNATURE_VERIFICATION_THREADS_COUNT = 0;
+const uint32_t DEFAULT_SIGNATURE_CACHE_SIZE = 100000;
+const uint16_t DEFAULT_PROOF_OF_WORK_THREADS_COUNT = 0;
+const char BLOCKS_STORAGE_FILE[] = "file";
+const char BLOCKS_STORAGE_DATABASE[] = "db";
+const uint64_t DEFAULT_BLOCK_CACHE_MB_SIZE = 64;
+const uint64_t MEGABYTE = 1024 * 1024;
+
+const command_line::arg_descriptor<uint16_t> argSignatureVerificationThreadsCount = { "verification-threads",
+  "Number of threads used to check ring signatures of incoming blocks, 0 - use all available cores", DEFAULT_SIGNATURE_VERIFICATION_THREADS_COUNT};
+const command_line::arg_descriptor<uint32_t> argSignatureCacheSize = { "signature-cache-size",
+  "Number of verified ring signatures remembered to skip checking them again when a pool transaction arrives in a block, 0 - disable", DEFAULT_SIGNATURE_CACHE_SIZE};
+const command_line::arg_descriptor<uint16_t> argProofOfWorkThreadsCount = { "pow-threads",
+  "Number of threads used to compute proof of work hashes of downloaded blocks, 0 - use all available cores", DEFAULT_PROOF_OF_WORK_THREADS_COUNT};
+const command_line::arg_descriptor<std::string> argBlocksStorage = { "blocks-storage",
+  "Where main chain blocks are stored: file - in blocks.bin next to the DB, db - only in the DB", BLOCKS_STORAGE_FILE};
+const command_line::arg_descriptor<uint64_t> argBlockCacheSize = { "block-cache-size",
+  "Size of the cache of blocks recently sent to peers and RPC clients in megabytes, 0 - disable", DEFAULT_BLOCK_CACHE_MB_SIZE};
+
+} //namespace
+
+void CoreConfig::initOptions(boost::program_options::options_description& desc) {
+  command_line::add_arg(desc, argSignatureVerificationThreadsCount);
+  command_line::add_arg(desc, argSignatureCacheSize);
+  command_line::add_arg(desc, argProofOfWorkThreadsCount);
+  command_line::add_arg(desc, argBlocksStorage);
+  command_line::add_arg(desc, argBlockCacheSize);
+}
+
+CoreConfig::CoreConfig() :
+  signatureVerificationThreadsCount(DEFAULT_SIGNATURE_VERIFICATION_THREADS_COUNT),
+  signatureCacheSize(DEFAULT_SIGNATURE_CACHE_SIZE),
+  proofOfWorkThreadsCount(DEFAULT_PROOF_OF_WORK_THREADS_COUNT),
+  blocksStorage(BlocksStorage::FILE),
+  blockCacheSize(DEFAULT_BLOCK_CACHE_MB_SIZE * MEGABYTE) {
+}
+
+bool CoreConfig::init(const boost::program_options::variables_map& vm) {
+  if (vm.count(argSignatureVerificationThreadsCount.name) != 0 && !vm[argSignatureVerificationThreadsCount.name].defaulted()) {
+    signatureVerificationThreadsCount = command_line::get_arg(vm, argSignatureVerificationThreadsCount);
+  }
+
+  if (vm.count(argSignatureCacheSize.name) != 0 && !vm[argSignatureCacheSize.name].defaulted()) {
+    signatureCacheSize = command_line::get_arg(vm, argSignatureCacheSize);
+  }
+
+  if (vm.count(argProofOfWorkThreadsCount.name) != 0 && !vm[argProofOfWorkThreadsCount.name].defaulted()) {
+    proofOfWorkThreadsCount = command_line::get_arg(vm, argProofOfWorkThreadsCount);
+  }
+
+  if (vm.count(argBlocksStorage.name) != 0 && !vm[argBlocksStorage.name].defaulted()) {
+    std::string storage = command_line::get_arg(vm, argBlocksStorage);
+    if (storage == BLOCKS_STORAGE_FILE) {
+      blocksStorage = BlocksStorage::FILE;
+    } else if (storage == BLOCKS_STORAGE_DATABASE) {
+      blocksStorage = BlocksStorage::DATABASE;
+    } else {
+      return false;
+    }
+  }
+
+  if (vm.count(argBlockCacheSize.name) != 0 && !vm[argBlockCacheSize.name].defaulted()) {
+    blockCacheSize = command_line::get_arg(vm, argBlockCacheSize) * MEGABYTE;
+  }
+
+  return true;
+}
+
+uint16_t CoreConfig::getSignatureVerificationThreadsCount() const {
+  return signatureVerificationThreadsCount;
+}
+
+uint32_t CoreConfig::getSignatureCacheSize() const {
+  return signatureCacheSize;
+}
+
+uint16_t CoreConfig::getProofOfWorkThreadsCount() const {
+  return proofOfWorkThreadsCount;
+}
+
+CoreConfig::BlocksStorage CoreConfig::getBlocksStorage() const {
+  return blocksStorage;
+}
+
+uint64_t CoreConfig::getBlockCacheSize() const {
+  return blockCacheSize;
+}
+
+void CoreConfig::setSignatureVerificationThreadsCount(uint16_t threadsCount) {
+  signatureVerificationThreadsCount = threadsCount;
+}
+
+void CoreConfig::setSignatureCacheSize(uint32_t size) {
+  signatureCacheSize = size;
+}
+
+void CoreConfig::setProofOfWorkThreadsCount(uint16_t threadsCount) {
+  proofOfWorkThreadsCount = threadsCount;
+}
+
+void CoreConfig::setBlocksStorage(BlocksStorage storage) {
+  blocksStorage = storage;
+}
+
+void CoreConfig::setBlockCacheSize(uint64_t size) {
+  blockCacheSize = size;
+}
@@ -0,0 +1,58 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+
+#include <boost/program_options.hpp>
+
+namespace CryptoNote {
+
+class CoreConfig {
+public:
+  enum class BlocksStorage {
+    FILE, //blocks.bin and its index file, next to the DB
+    DATABASE //raw blocks already kept in the DB, no separate files
+  };
+
+
+  CoreConfig();
+  static void initOptions(boost::program_options::options_description& desc);
+  bool init(const boost::program_options::variables_map& vm);
+
+  uint16_t getSignatureVerificationThreadsCount() const; //0 means hardware concurrency
+  uint32_t getSignatureCacheSize() const; //0 disables the cache
+  uint16_t getProofOfWorkThreadsCount() const; //0 means hardware concurrency
+  BlocksStorage getBlocksStorage() const;
+  uint64_t getBlockCacheSize() const; //in bytes, 0 disables the cache
+
+  void setSignatureVerificationThreadsCount(uint16_t threadsCount);
+  void setSignatureCacheSize(uint32_t size);
+  void setProofOfWorkThreadsCount(uint16_t threadsCount);
+  void setBlocksStorage(BlocksStorage storage);
+  void setBlockCacheSize(uint64_t size);
+
+private:
+  uint16_t signatureVerificationThreadsCount;
+  uint32_t signatureCacheSize;
+  uint16_t proofOfWorkThreadsCount;
+  BlocksStorage blocksStorage;
+  uint64_t blockCacheSize;
+};
+
+} //namespace CryptoNote
@@ -177,6 +177,11 @@ return m_upgradeHeightV4;
   }
 }
 
+uint8_t Currency::accountBlockMinorVersion(uint32_t blockIndex) const {
+  // the same as major versions, the new version starts after the upgrade height
+  return blockIndex > m_upgradeHeightAccountBlockV2 ? ACCOUNT_BLOCK_MINOR_VERSION_2 : ACCOUNT_BLOCK_MINOR_VERSION_1;
+}
+
 bool Currency::getBlockReward(uint8_t blockMajorVersion, size_t medianSize, size_t currentBlockSize, uint64_t alreadyGeneratedCoins,
   uint64_t fee, uint64_t& reward, int64_t& emissionChange) const {
   assert(alreadyGeneratedCoins <= m_moneySupply);
@@ -625,13 +630,17 @@ Difficulty Currency::nextDifficulty(uint8_t version, uint32_t blockIndex, std::v
   Difficulty totalWork = cumulativeDifficulties[cutEnd - 1] - cumulativeDifficulties[cutBegin];
   assert(totalWork > 0);
 
+  return difficultyForWork(totalWork, timeSpan);  // with version
+}
+
+Difficulty Currency::difficultyForWork(Difficulty totalWork, uint64_t timeSpan) const {
   uint64_t low, high;
   low = mul128(totalWork, m_difficultyTarget, &high);
   if (high != 0 || std::numeric_limits<uint64_t>::max() - low < (timeSpan - 1)) {
     return 0;
   }
 
-  return (low + timeSpan - 1) / timeSpan;  // with version
+  return (low + timeSpan - 1) / timeSpan;
 }
 
 bool Currency::checkProofOfWorkV1(Crypto::cn_context& context, const CachedBlock& block, Difficulty currentDifficulty) const {
@@ -750,6 +759,7 @@ m_upgradeHeightV2(currency.m_upgradeHeightV2),
 m_upgradeHeightV3(currency.m_upgradeHeightV3),
 m_upgradeHeightV4(currency.m_upgradeHeightV4),
 m_upgradeHeightV5(currency.m_upgradeHeightV5),
+m_upgradeHeightAccountBlockV2(currency.m_upgradeHeightAccountBlockV2),
 m_upgradeVotingThreshold(currency.m_upgradeVotingThreshold),
 m_upgradeVotingWindow(currency.m_upgradeVotingWindow),
 m_upgradeWindow(currency.m_upgradeWindow),
@@ -820,6 +830,7 @@ fusionTxMaxSize(parameters::MAX_TRANSACTION_SIZE_LIMIT * 30 / 100);
   upgradeHeightV3(parameters::UPGRADE_HEIGHT_V3);
 upgradeHeightV4(parameters::UPGRADE_HEIGHT_V4);
 upgradeHeightV5(parameters::UPGRADE_HEIGHT_V5);
+  upgradeHeightAccountBlockV2(parameters::UPGRADE_HEIGHT_ACCOUNT_BLOCK_V2);
   upgradeVotingThreshold(parameters::UPGRADE_VOTING_THRESHOLD);
   upgradeVotingWindow(parameters::UPGRADE_VOTING_WINDOW);
   upgradeWindow(parameters::UPGRADE_WINDOW);
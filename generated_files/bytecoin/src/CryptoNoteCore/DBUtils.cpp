@@ -17,6 +17,18 @@
 
 #include "DBUtils.h"
 
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <stdexcept>
+#include <unordered_set>
+
+#include "CachedBlock.h"
+#include "CryptoNoteTools.h"
+#include "DatabaseCacheData.h"
+#include "Serialization/KVBinaryCommon.h"
+#include "Serialization/KVBinaryInputStreamSerializer.h"
+
 namespace {
   const std::string RAW_BLOCK_NAME = "raw_block";
   const std::string RAW_TXS_NAME = "raw_txs";
@@ -24,20 +36,157 @@ namespace {
 
 namespace CryptoNote {
 namespace DB {
+  namespace {
+    const std::string* const INDEX_PREFIXES[] = {
+      &BLOCK_INDEX_TO_KEY_IMAGE_PREFIX,
+      &BLOCK_INDEX_TO_TX_HASHES_PREFIX,
+      &BLOCK_INDEX_TO_TRANSACTION_INFO_PREFIX,
+      &BLOCK_INDEX_TO_RAW_BLOCK_PREFIX,
+      &BLOCK_HASH_TO_BLOCK_INDEX_PREFIX,
+      &BLOCK_INDEX_TO_BLOCK_INFO_PREFIX,
+      &KEY_IMAGE_TO_BLOCK_INDEX_PREFIX,
+      &BLOCK_INDEX_TO_BLOCK_HASH_PREFIX,
+      &TRANSACTION_HASH_TO_TRANSACTION_INFO_PREFIX,
+      &KEY_OUTPUT_AMOUNT_PREFIX,
+      &CLOSEST_TIMESTAMP_BLOCK_INDEX_PREFIX,
+      &PAYMENT_ID_TO_TX_HASH_PREFIX,
+      &TIMESTAMP_TO_BLOCKHASHES_PREFIX,
+      &KEY_OUTPUT_AMOUNTS_COUNT_PREFIX,
+      &KEY_OUTPUT_KEY_PREFIX,
+      &ACCOUNT_NUMBER_TO_ACCOUNT_INFO_PREFIX
+    };
+  }
+
   std::string serialize(const RawBlock& value, const std::string& name) {
-    std::stringstream ss;
-    Common::StdOutputStream stream(ss);
+    std::string serialized;
+    Common::StringOutputStream stream(serialized);
     CryptoNote::BinaryOutputStreamSerializer serializer(stream);
     
     serializer(const_cast<RawBlock&>(value).block, RAW_BLOCK_NAME);
     serializer(const_cast<RawBlock&>(value).transactions, RAW_TXS_NAME);
 
-    return ss.str();
+    return serialized;
+  }
+
+  char getKeyPrefix(const std::string& rawKey) {
+    if (rawKey.empty()) {
+      return 0;
+    }
+
+    auto it = std::find_if(std::begin(INDEX_PREFIXES), std::end(INDEX_PREFIXES), [&rawKey] (const std::string* prefix) {
+      return (*prefix)[0] == rawKey[0];
+    });
+
+    return it != std::end(INDEX_PREFIXES) ? rawKey[0] : 0;
+  }
+
+  namespace {
+    // Versions before 4 stored keys as KV binary documents of (prefix, key) and values as KV binary documents too
+    template <class Value>
+    bool deserializeKVBinary(const std::string& serialized, Value& value, const std::string& name) {
+      try {
+        Common::MemoryInputStream stream(serialized.data(), serialized.size());
+        KVBinaryInputStreamSerializer serializer(stream);
+        return serializer(value, name);
+      } catch (std::exception&) {
+        return false;
+      }
+    }
+
+    // after the header and the count of root fields, a key document has the name of its only root field, the index prefix.
+    // Checked before the document is parsed, each record is tried against every index
+    const size_t KV_BINARY_KEY_PREFIX_OFFSET = sizeof(KVBinaryStorageBlockHeader) + 2;
+
+    template <class Key>
+    bool deserializeKVBinaryKey(const std::string& rawKey, const std::string& keyPrefix, Key& key) {
+      if (rawKey.size() <= KV_BINARY_KEY_PREFIX_OFFSET || rawKey[KV_BINARY_KEY_PREFIX_OFFSET - 1] != 1 ||
+        rawKey[KV_BINARY_KEY_PREFIX_OFFSET] != keyPrefix[0]) {
+        return false;
+      }
+
+      std::pair<std::string, Key> prefixedKey;
+      if (!deserializeKVBinary(rawKey, prefixedKey, keyPrefix) || prefixedKey.first != keyPrefix) {
+        return false;
+      }
+
+      key = std::move(prefixedKey.second);
+      return true;
+    }
+
+    template <class Key, class Value>
+    bool convertKVBinaryRecord(const std::string& keyPrefix, const std::string& rawKey, const std::string& rawValue,
+      std::vector<std::pair<std::string, std::string>>& records) {
+      Key key;
+      if (!deserializeKVBinaryKey(rawKey, keyPrefix, key)) {
+        return false;
+      }
+
+      Value value;
+      if (!deserializeKVBinary(rawValue, value, keyPrefix)) {
+        throw std::runtime_error("Can't read DB record of index " + keyPrefix);
+      }
+
+      records.emplace_back(serialize(keyPrefix, key, value));
+      return true;
+    }
+
+    // raw blocks were in binary format already. Version 2 had no account numbers index, it's filled from account blocks
+    bool convertRawBlockRecord(uint32_t schemeVersion, const std::string& rawKey, const std::string& rawValue,
+      std::vector<std::pair<std::string, std::string>>& records) {
+      uint32_t blockIndex;
+      if (!deserializeKVBinaryKey(rawKey, BLOCK_INDEX_TO_RAW_BLOCK_PREFIX, blockIndex)) {
+        return false;
+      }
+
+      records.emplace_back(serializeKey(BLOCK_INDEX_TO_RAW_BLOCK_PREFIX, blockIndex), rawValue);
+      if (schemeVersion < 3) {
+        RawBlock rawBlock;
+        BlockTemplate block;
+        deserialize(rawValue, rawBlock, BLOCK_INDEX_TO_RAW_BLOCK_PREFIX);
+        if (!fromBinaryArray(block, rawBlock.block)) {
+          throw std::runtime_error("Can't read block " + std::to_string(blockIndex) + " of DB");
+        }
+
+        if (CachedBlock(block).getTypeOfBlock() == ACCOUNT_BLOCK) {
+          records.emplace_back(serialize(ACCOUNT_NUMBER_TO_ACCOUNT_INFO_PREFIX, block.accountNumber, AccountInfo{ block.accountAddress, blockIndex }));
+        }
+      }
+
+      return true;
+    }
+  }
+
+  bool convertRecord(uint32_t schemeVersion, const std::string& rawKey, const std::string& rawValue,
+    std::vector<std::pair<std::string, std::string>>& records) {
+    assert(schemeVersion >= FIRST_CONVERTIBLE_SCHEME_VERSION && schemeVersion < SCHEME_VERSION);
+
+    typedef std::pair<IBlockchainCache::Amount, IBlockchainCache::GlobalOutputIndex> AmountOutput;
+
+    // counters are kept in the same indexes under named keys, they are tried after keys of the same KV type
+    return
+      convertKVBinaryRecord<uint32_t, std::unordered_set<Crypto::KeyImage>>(BLOCK_INDEX_TO_KEY_IMAGE_PREFIX, rawKey, rawValue, records) ||
+      convertKVBinaryRecord<uint32_t, std::vector<Crypto::Hash>>(BLOCK_INDEX_TO_TX_HASHES_PREFIX, rawKey, rawValue, records) ||
+      convertRawBlockRecord(schemeVersion, rawKey, rawValue, records) ||
+      convertKVBinaryRecord<Crypto::Hash, uint32_t>(BLOCK_HASH_TO_BLOCK_INDEX_PREFIX, rawKey, rawValue, records) ||
+      convertKVBinaryRecord<uint32_t, CachedBlockInfo>(BLOCK_INDEX_TO_BLOCK_INFO_PREFIX, rawKey, rawValue, records) ||
+      convertKVBinaryRecord<Crypto::KeyImage, uint32_t>(KEY_IMAGE_TO_BLOCK_INDEX_PREFIX, rawKey, rawValue, records) ||
+      convertKVBinaryRecord<std::string, uint32_t>(BLOCK_INDEX_TO_BLOCK_HASH_PREFIX, rawKey, rawValue, records) ||
+      convertKVBinaryRecord<Crypto::Hash, ExtendedTransactionInfo>(TRANSACTION_HASH_TO_TRANSACTION_INFO_PREFIX, rawKey, rawValue, records) ||
+      convertKVBinaryRecord<std::string, uint64_t>(TRANSACTION_HASH_TO_TRANSACTION_INFO_PREFIX, rawKey, rawValue, records) ||
+      convertKVBinaryRecord<IBlockchainCache::Amount, uint32_t>(KEY_OUTPUT_AMOUNT_PREFIX, rawKey, rawValue, records) ||
+      convertKVBinaryRecord<AmountOutput, PackedOutIndex>(KEY_OUTPUT_AMOUNT_PREFIX, rawKey, rawValue, records) ||
+      convertKVBinaryRecord<uint64_t, uint32_t>(CLOSEST_TIMESTAMP_BLOCK_INDEX_PREFIX, rawKey, rawValue, records) ||
+      convertKVBinaryRecord<Crypto::Hash, uint32_t>(PAYMENT_ID_TO_TX_HASH_PREFIX, rawKey, rawValue, records) ||
+      convertKVBinaryRecord<std::pair<Crypto::Hash, uint32_t>, Crypto::Hash>(PAYMENT_ID_TO_TX_HASH_PREFIX, rawKey, rawValue, records) ||
+      convertKVBinaryRecord<uint64_t, std::vector<Crypto::Hash>>(TIMESTAMP_TO_BLOCKHASHES_PREFIX, rawKey, rawValue, records) ||
+      convertKVBinaryRecord<std::string, uint32_t>(KEY_OUTPUT_AMOUNTS_COUNT_PREFIX, rawKey, rawValue, records) ||
+      convertKVBinaryRecord<uint32_t, IBlockchainCache::Amount>(KEY_OUTPUT_AMOUNTS_COUNT_PREFIX, rawKey, rawValue, records) ||
+      convertKVBinaryRecord<AmountOutput, KeyOutputInfo>(KEY_OUTPUT_KEY_PREFIX, rawKey, rawValue, records) ||
+      convertKVBinaryRecord<std::string, AccountInfo>(ACCOUNT_NUMBER_TO_ACCOUNT_INFO_PREFIX, rawKey, rawValue, records);
   }
 
   void deserialize(const std::string& serialized, RawBlock& value, const std::string& name) {
-    std::stringstream ss(serialized);
-    Common::StdInputStream stream(ss);
+    Common::MemoryInputStream stream(serialized.data(), serialized.size());
     CryptoNote::BinaryInputStreamSerializer serializer(stream);
     serializer(value.block, RAW_BLOCK_NAME);
     serializer(value.transactions, RAW_TXS_NAME);
@@ -18,15 +18,16 @@
 #pragma once
 
 #include <string>
-#include <sstream>
+#include <type_traits>
+#include <vector>
 
-#include "Common/StdOutputStream.h"
-#include "Serialization/KVBinaryOutputStreamSerializer.h"
+#include "Common/MemoryInputStream.h"
+#include "Common/StringOutputStream.h"
+#include "Serialization/BinaryInputStreamSerializer.h"
+#include "Serialization/BinaryOutputStreamSerializer.h"
 #include "Serialization/SerializationOverloads.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 #include "CryptoNoteCore/CryptoNoteSerialization.h"
-#include "Common/StdInputStream.h"
-#include "Serialization/KVBinaryInputStreamSerializer.h"
 
 namespace CryptoNote {
 namespace DB {
@@ -61,35 +62,87 @@ namespace DB {
 
   const std::string KEY_OUTPUT_KEY_PREFIX = "j";
 
+  const std::string ACCOUNT_NUMBER_TO_ACCOUNT_INFO_PREFIX = "k";
+
+  // written as is, not under an index prefix
+  const std::string SCHEME_VERSION_KEY = "db_scheme_version";
+
+  // 3: account numbers index
+  // 4: keys are fixed width big-endian fields after the index prefix, values are in binary serialization format
+  const uint32_t SCHEME_VERSION = 4;
+  // records of this version and later ones can be converted to the current scheme in place
+  const uint32_t FIRST_CONVERTIBLE_SCHEME_VERSION = 2;
+
+  // Converts a record written by an older scheme version into records of the current one.
+  // Returns false if it isn't an index record of that version, throws if it is one, but can't be read
+  bool convertRecord(uint32_t schemeVersion, const std::string& rawKey, const std::string& rawValue,
+    std::vector<std::pair<std::string, std::string>>& records);
+
+  // Values are in binary serialization format, the name is ignored
   template <class Value>
   std::string serialize(const Value& value, const std::string& name) {
-    CryptoNote::KVBinaryOutputStreamSerializer serializer;
-    std::stringstream ss;
-    Common::StdOutputStream stream(ss);
-
+    std::string serialized;
+    Common::StringOutputStream stream(serialized);
+    CryptoNote::BinaryOutputStreamSerializer serializer(stream);
     serializer(const_cast<Value&>(value), name);
-    serializer.dump(stream);
 
-    return ss.str();
+    return serialized;
   }
 
   std::string serialize(const RawBlock& value, const std::string& name);
 
-  template <class Key, class Value>
-  std::pair<std::string, std::string> serialize(const std::string& keyPrefix, const Key& key, const Value& value) {
-    return{ DB::serialize(std::make_pair(keyPrefix, key), keyPrefix), DB::serialize(value, keyPrefix) };
+  // Prefix of a key made by serializeKey, 0 for keys written as is, like the scheme version.
+  // Keys written as is must not start with an index prefix
+  char getKeyPrefix(const std::string& rawKey);
+
+  // Keys are the index prefix followed by fixed width fields. Numbers are big-endian,
+  // so keys of an index sort in the order of their numbers
+  template <class Number>
+  typename std::enable_if<std::is_integral<Number>::value && std::is_unsigned<Number>::value>::type
+  appendKey(std::string& rawKey, Number key) {
+    for (size_t i = sizeof(key); i > 0; --i) {
+      rawKey.push_back(static_cast<char>(key >> (8 * (i - 1))));
+    }
+  }
+
+  inline void appendKey(std::string& rawKey, const Crypto::Hash& key) {
+    rawKey.append(reinterpret_cast<const char*>(key.data), sizeof(key.data));
+  }
+
+  inline void appendKey(std::string& rawKey, const Crypto::KeyImage& key) {
+    rawKey.append(reinterpret_cast<const char*>(key.data), sizeof(key.data));
+  }
+
+  // the only field of variable width, used for named keys and account numbers
+  inline void appendKey(std::string& rawKey, const std::string& key) {
+    rawKey.append(key);
+  }
+
+  template <class First, class Second>
+  void appendKey(std::string& rawKey, const std::pair<First, Second>& key) {
+    appendKey(rawKey, key.first);
+    appendKey(rawKey, key.second);
   }
 
   template <class Key>
   std::string serializeKey(const std::string& keyPrefix, const Key& key) {
-    return DB::serialize(std::make_pair(keyPrefix, key), keyPrefix);
+    std::string rawKey;
+    rawKey.reserve(keyPrefix.size() + sizeof(Key));
+    rawKey.append(keyPrefix);
+    appendKey(rawKey, key);
+
+    return rawKey;
+  }
+
+  template <class Key, class Value>
+  std::pair<std::string, std::string> serialize(const std::string& keyPrefix, const Key& key, const Value& value) {
+    return{ DB::serializeKey(keyPrefix, key), DB::serialize(value, keyPrefix) };
   }
 
   template <class Value>
   void deserialize(const std::string& serialized, Value& value, const std::string& name) {
-    std::stringstream ss(serialized);
-    Common::StdInputStream stream(ss);
-    CryptoNote::KVBinaryInputStreamSerializer serializer(stream);
+    Common::MemoryInputStream stream(serialized.data(), serialized.size());
+    CryptoNote::BinaryInputStreamSerializer serializer(stream);
     serializer(value, name);
   }
 
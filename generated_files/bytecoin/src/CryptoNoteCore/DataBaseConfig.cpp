@@ -17,6 +17,10 @@
 
 #include "DataBaseConfig.h"
 
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
 #include <boost/utility/value_init.hpp>
 
 #include <Common/Util.h>
@@ -24,6 +28,7 @@
 #include "Common/StringTools.h"
 #include "crypto/crypto.h"
 #include "CryptoNoteConfig.h"
+#include "RocksDBWrapper.h"
 
 using namespace CryptoNote;
 
@@ -33,13 +38,71 @@ const uint64_t WRITE_BUFFER_MB_DEFAULT_SIZE = 256;
 const uint64_t READ_BUFFER_MB_DEFAULT_SIZE = 10;
 const uint32_t DEFAULT_MAX_OPEN_FILES = 100;
 const uint16_t DEFAULT_BACKGROUND_THREADS_COUNT = 2;
+// almost every spent check misses, 16 bits per key keep false positives below 0.1%
+const uint32_t DEFAULT_KEY_IMAGES_BLOOM_FILTER_BITS_PER_KEY = 16;
+const uint64_t DEFAULT_SPENT_KEY_IMAGES_FILTER_MB_SIZE = 0;
+const uint32_t DEFAULT_WRITE_GROUP_SIZE = 1;
 
 const uint64_t MEGABYTE = 1024 * 1024;
+const uint64_t KILOBYTE = 1024;
+
+const std::string LEVEL_COMPACTION = "level";
+const std::string UNIVERSAL_COMPACTION = "universal";
+
+const std::string NO_COMPRESSION = "none";
+
+const std::string COMPRESSION_NAMES[] = { NO_COMPRESSION, "snappy", "zlib", "bzip2", "lz4", "lz4hc" };
+
+const DataBaseColumnFamilyConfig DEFAULT_COLUMN_FAMILY_CONFIGS[] = {
+  { 64 * KILOBYTE, 20, 0, false, { DataBaseCompression::NONE } },  // BLOBS
+  { 4 * KILOBYTE, 50, 10, false, { DataBaseCompression::NONE } },  // LOOKUPS
+  { 16 * KILOBYTE, 30, 0, false, { DataBaseCompression::NONE } }   // RECORDS
+};
+
+struct ColumnFamilyArgs {
+  command_line::arg_descriptor<uint64_t> blockSize;
+  command_line::arg_descriptor<uint32_t> readCacheShare;
+  command_line::arg_descriptor<uint32_t> bloomFilterBitsPerKey;
+  command_line::arg_descriptor<std::string> compaction;
+  command_line::arg_descriptor<std::string> compression;
+};
+
+const ColumnFamilyArgs columnFamilyArgs[] = {
+  {
+    { "db-blobs-block-size", "Block size of raw blocks and other blob indexes in kilobytes", 64 },
+    { "db-blobs-read-cache-share", "Percent of the read cache used by blob indexes", 20 },
+    { "db-blobs-bloom-bits", "Bloom filter bits per key of blob indexes, 0 disables the filter", 0 },
+    { "db-blobs-compaction", "Compaction of blob indexes: level or universal", LEVEL_COMPACTION },
+    { "db-blobs-compression", "Compression of blob indexes by level, comma separated none, snappy, zlib, bzip2, lz4 or lz4hc, codecs missing in the build are rejected. The last one is used for all deeper levels", NO_COMPRESSION }
+  },
+  {
+    { "db-lookups-block-size", "Block size of key image, transaction, block hash and payment id indexes in kilobytes", 4 },
+    { "db-lookups-read-cache-share", "Percent of the read cache used by lookup indexes", 50 },
+    { "db-lookups-bloom-bits", "Bloom filter bits per key of lookup indexes, 0 disables the filter", 10 },
+    { "db-lookups-compaction", "Compaction of lookup indexes: level or universal", LEVEL_COMPACTION },
+    { "db-lookups-compression", "Compression of lookup indexes by level, comma separated none, snappy, zlib, bzip2, lz4 or lz4hc, codecs missing in the build are rejected. The last one is used for all deeper levels", NO_COMPRESSION }
+  },
+  {
+    { "db-records-block-size", "Block size of output, block info and counter indexes in kilobytes", 16 },
+    { "db-records-read-cache-share", "Percent of the read cache used by record indexes", 30 },
+    { "db-records-bloom-bits", "Bloom filter bits per key of record indexes, 0 disables the filter", 0 },
+    { "db-records-compaction", "Compaction of record indexes: level or universal", LEVEL_COMPACTION },
+    { "db-records-compression", "Compression of record indexes by level, comma separated none, snappy, zlib, bzip2, lz4 or lz4hc, codecs missing in the build are rejected. The last one is used for all deeper levels", NO_COMPRESSION }
+  }
+};
+
+static_assert(sizeof(DEFAULT_COLUMN_FAMILY_CONFIGS) / sizeof(DEFAULT_COLUMN_FAMILY_CONFIGS[0]) == static_cast<size_t>(DataBaseAccessPattern::COUNT),
+  "Every access pattern must have default column family config");
+static_assert(sizeof(columnFamilyArgs) / sizeof(columnFamilyArgs[0]) == static_cast<size_t>(DataBaseAccessPattern::COUNT),
+  "Every access pattern must have column family options");
 
 const command_line::arg_descriptor<uint16_t>    argBackgroundThreadsCount = { "db-threads", "Nuber of background threads used for compaction and flush", DEFAULT_BACKGROUND_THREADS_COUNT};
 const command_line::arg_descriptor<uint32_t>    argMaxOpenFiles = { "db-max-open-files", "Number of open files that can be used by the DB", DEFAULT_MAX_OPEN_FILES};
 const command_line::arg_descriptor<uint64_t>    argWriteBufferSize = { "db-write-buffer-size", "Size of data base write buffer in megabytes", WRITE_BUFFER_MB_DEFAULT_SIZE};
 const command_line::arg_descriptor<uint64_t>    argReadCacheSize = { "db-read-cache-size", "Size of data base read cache in megabytes", READ_BUFFER_MB_DEFAULT_SIZE};
+const command_line::arg_descriptor<uint32_t>    argKeyImagesBloomFilterBitsPerKey = { "db-key-images-bloom-bits", "Bloom filter bits per key of spent key images index, 0 disables the filter", DEFAULT_KEY_IMAGES_BLOOM_FILTER_BITS_PER_KEY};
+const command_line::arg_descriptor<uint64_t>    argSpentKeyImagesFilterSize = { "db-spent-key-images-filter-size", "Size of in-memory filter of spent key images in megabytes, 0 disables the filter", DEFAULT_SPENT_KEY_IMAGES_FILTER_MB_SIZE};
+const command_line::arg_descriptor<uint32_t>    argWriteGroupSize = { "db-write-group-size", "Number of block writes committed to data base at once during sync, 1 commits every write", DEFAULT_WRITE_GROUP_SIZE};
 
 } //namespace
 
@@ -48,6 +111,17 @@ void DataBaseConfig::initOptions(boost::program_options::options_description& de
   command_line::add_arg(desc, argMaxOpenFiles);
   command_line::add_arg(desc, argWriteBufferSize);
   command_line::add_arg(desc, argReadCacheSize);
+  command_line::add_arg(desc, argKeyImagesBloomFilterBitsPerKey);
+  command_line::add_arg(desc, argSpentKeyImagesFilterSize);
+  command_line::add_arg(desc, argWriteGroupSize);
+
+  for (const ColumnFamilyArgs& args : columnFamilyArgs) {
+    command_line::add_arg(desc, args.blockSize);
+    command_line::add_arg(desc, args.readCacheShare);
+    command_line::add_arg(desc, args.bloomFilterBitsPerKey);
+    command_line::add_arg(desc, args.compaction);
+    command_line::add_arg(desc, args.compression);
+  }
 }
 
 DataBaseConfig::DataBaseConfig() :
@@ -56,7 +130,11 @@ DataBaseConfig::DataBaseConfig() :
   maxOpenFiles(DEFAULT_MAX_OPEN_FILES),
   writeBufferSize(WRITE_BUFFER_MB_DEFAULT_SIZE * MEGABYTE),
   readCacheSize(READ_BUFFER_MB_DEFAULT_SIZE * MEGABYTE),
-  testnet(false) {
+  testnet(false),
+  keyImagesBloomFilterBitsPerKey(DEFAULT_KEY_IMAGES_BLOOM_FILTER_BITS_PER_KEY),
+  spentKeyImagesFilterSize(DEFAULT_SPENT_KEY_IMAGES_FILTER_MB_SIZE * MEGABYTE),
+  writeGroupSize(DEFAULT_WRITE_GROUP_SIZE) {
+  std::copy(std::begin(DEFAULT_COLUMN_FAMILY_CONFIGS), std::end(DEFAULT_COLUMN_FAMILY_CONFIGS), std::begin(columnFamilyConfigs));
 }
 
 bool DataBaseConfig::init(const boost::program_options::variables_map& vm) {
@@ -76,15 +154,112 @@ bool DataBaseConfig::init(const boost::program_options::variables_map& vm) {
     readCacheSize = command_line::get_arg(vm, argReadCacheSize) * MEGABYTE;
   }
 
+  if (vm.count(argKeyImagesBloomFilterBitsPerKey.name) != 0 && !vm[argKeyImagesBloomFilterBitsPerKey.name].defaulted()) {
+    keyImagesBloomFilterBitsPerKey = command_line::get_arg(vm, argKeyImagesBloomFilterBitsPerKey);
+  }
+
+  if (vm.count(argSpentKeyImagesFilterSize.name) != 0 && !vm[argSpentKeyImagesFilterSize.name].defaulted()) {
+    spentKeyImagesFilterSize = command_line::get_arg(vm, argSpentKeyImagesFilterSize) * MEGABYTE;
+  }
+
+  if (vm.count(argWriteGroupSize.name) != 0 && (!vm[argWriteGroupSize.name].defaulted() || writeGroupSize == 0)) {
+    writeGroupSize = std::max<uint32_t>(command_line::get_arg(vm, argWriteGroupSize), 1);
+  }
+
   if (vm.count(command_line::arg_data_dir.name) != 0 && (!vm[command_line::arg_data_dir.name].defaulted() || dataDir == Tools::getDefaultDataDirectory())) {
     dataDir = command_line::get_arg(vm, command_line::arg_data_dir);
   }
 
+  uint32_t readCacheShares = 0;
+  for (size_t i = 0; i < static_cast<size_t>(DataBaseAccessPattern::COUNT); ++i) {
+    const ColumnFamilyArgs& args = columnFamilyArgs[i];
+    DataBaseColumnFamilyConfig& config = columnFamilyConfigs[i];
+
+    if (vm.count(args.blockSize.name) != 0 && !vm[args.blockSize.name].defaulted()) {
+      config.blockSize = command_line::get_arg(vm, args.blockSize) * KILOBYTE;
+    }
+
+    if (vm.count(args.readCacheShare.name) != 0 && !vm[args.readCacheShare.name].defaulted()) {
+      config.readCacheShare = command_line::get_arg(vm, args.readCacheShare);
+    }
+
+    if (vm.count(args.bloomFilterBitsPerKey.name) != 0 && !vm[args.bloomFilterBitsPerKey.name].defaulted()) {
+      config.bloomFilterBitsPerKey = command_line::get_arg(vm, args.bloomFilterBitsPerKey);
+    }
+
+    if (vm.count(args.compaction.name) != 0 && !vm[args.compaction.name].defaulted()) {
+      std::string compaction = command_line::get_arg(vm, args.compaction);
+      if (compaction != LEVEL_COMPACTION && compaction != UNIVERSAL_COMPACTION) {
+        return false;
+      }
+
+      config.universalCompaction = compaction == UNIVERSAL_COMPACTION;
+    }
+
+    if (vm.count(args.compression.name) != 0 && !vm[args.compression.name].defaulted()) {
+      if (!parseCompressionPerLevel(command_line::get_arg(vm, args.compression), config.compressionPerLevel)) {
+        return false;
+      }
+
+      // a DB with a codec missing in the build fails to open
+      if (!std::all_of(config.compressionPerLevel.begin(), config.compressionPerLevel.end(), RocksDBWrapper::isCompressionSupported)) {
+        return false;
+      }
+    }
+
+    if (config.blockSize == 0) {
+      return false;
+    }
+
+    readCacheShares += config.readCacheShare;
+  }
+
+  if (readCacheShares > 100) {
+    return false;
+  }
+
   configFolderDefaulted = vm[command_line::arg_data_dir.name].defaulted();
 
   return true;
 }
 
+bool DataBaseConfig::parseCompressionPerLevel(const std::string& str, std::vector<DataBaseCompression>& compressionPerLevel) {
+  std::vector<DataBaseCompression> result;
+  size_t begin = 0;
+  for (;;) {
+    size_t end = str.find(',', begin);
+    std::string name = str.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+
+    auto it = std::find(std::begin(COMPRESSION_NAMES), std::end(COMPRESSION_NAMES), name);
+    if (it == std::end(COMPRESSION_NAMES)) {
+      return false;
+    }
+
+    result.push_back(static_cast<DataBaseCompression>(std::distance(std::begin(COMPRESSION_NAMES), it)));
+    if (end == std::string::npos) {
+      break;
+    }
+
+    begin = end + 1;
+  }
+
+  compressionPerLevel = std::move(result);
+  return true;
+}
+
+std::string DataBaseConfig::compressionPerLevelToString(const std::vector<DataBaseCompression>& compressionPerLevel) {
+  std::string result;
+  for (DataBaseCompression compression : compressionPerLevel) {
+    if (!result.empty()) {
+      result += ',';
+    }
+
+    result += COMPRESSION_NAMES[static_cast<size_t>(compression)];
+  }
+
+  return result;
+}
+
 bool DataBaseConfig::isConfigFolderDefaulted() const {
   return configFolderDefaulted;
 }
@@ -113,6 +288,23 @@ bool DataBaseConfig::getTestnet() const {
   return testnet;
 }
 
+const DataBaseColumnFamilyConfig& DataBaseConfig::getColumnFamilyConfig(DataBaseAccessPattern pattern) const {
+  assert(pattern < DataBaseAccessPattern::COUNT);
+  return columnFamilyConfigs[static_cast<size_t>(pattern)];
+}
+
+uint32_t DataBaseConfig::getKeyImagesBloomFilterBitsPerKey() const {
+  return keyImagesBloomFilterBitsPerKey;
+}
+
+uint64_t DataBaseConfig::getSpentKeyImagesFilterSize() const {
+  return spentKeyImagesFilterSize;
+}
+
+uint32_t DataBaseConfig::getWriteGroupSize() const {
+  return writeGroupSize;
+}
+
 void DataBaseConfig::setConfigFolderDefaulted(bool defaulted) {
   configFolderDefaulted = defaulted;
 }
@@ -140,3 +332,20 @@ void DataBaseConfig::setReadCacheSize(uint64_t readCacheSize) {
 void DataBaseConfig::setTestnet(bool testnet) {
   this->testnet = testnet;
 }
+
+void DataBaseConfig::setColumnFamilyConfig(DataBaseAccessPattern pattern, const DataBaseColumnFamilyConfig& config) {
+  assert(pattern < DataBaseAccessPattern::COUNT);
+  columnFamilyConfigs[static_cast<size_t>(pattern)] = config;
+}
+
+void DataBaseConfig::setKeyImagesBloomFilterBitsPerKey(uint32_t bitsPerKey) {
+  keyImagesBloomFilterBitsPerKey = bitsPerKey;
+}
+
+void DataBaseConfig::setSpentKeyImagesFilterSize(uint64_t spentKeyImagesFilterSize) {
+  this->spentKeyImagesFilterSize = spentKeyImagesFilterSize;
+}
+
+void DataBaseConfig::setWriteGroupSize(uint32_t writeGroupSize) {
+  this->writeGroupSize = writeGroupSize;
+}
@@ -25,12 +25,44 @@
 
 namespace CryptoNote {
 
+// Access pattern of an index, every column family is tuned by the pattern of its index
+enum class DataBaseAccessPattern {
+  BLOBS,   // large values appended by block index, lookups hit
+  LOOKUPS, // point lookups by hash which usually miss
+  RECORDS, // small records and counters
+  COUNT
+};
+
+// Compression of table blocks, RocksDB build may lack libraries of some of them.
+// ZSTD isn't here, its RocksDB format isn't final yet
+enum class DataBaseCompression : uint8_t {
+  NONE,
+  SNAPPY,
+  ZLIB,
+  BZIP2,
+  LZ4,
+  LZ4HC
+};
+
+const uint8_t DATA_BASE_COMPRESSIONS_COUNT = static_cast<uint8_t>(DataBaseCompression::LZ4HC) + 1;
+
+struct DataBaseColumnFamilyConfig {
+  uint64_t blockSize; //Bytes
+  uint32_t readCacheShare; //Percent of the read cache
+  uint32_t bloomFilterBitsPerKey; //0 disables the filter
+  bool universalCompaction;
+  std::vector<DataBaseCompression> compressionPerLevel; //The last one is used for all deeper levels
+};
+
 class DataBaseConfig {
 public:
   DataBaseConfig();
   static void initOptions(boost::program_options::options_description& desc);
   bool init(const boost::program_options::variables_map& vm);
 
+  static bool parseCompressionPerLevel(const std::string& str, std::vector<DataBaseCompression>& compressionPerLevel);
+  static std::string compressionPerLevelToString(const std::vector<DataBaseCompression>& compressionPerLevel);
+
   bool isConfigFolderDefaulted() const;
   std::string getDataDir() const;
   uint16_t getBackgroundThreadsCount() const;
@@ -38,6 +70,10 @@ public:
   uint64_t getWriteBufferSize() const; //Bytes
   uint64_t getReadCacheSize() const; //Bytes
   bool getTestnet() const;
+  const DataBaseColumnFamilyConfig& getColumnFamilyConfig(DataBaseAccessPattern pattern) const;
+  uint32_t getKeyImagesBloomFilterBitsPerKey() const;
+  uint64_t getSpentKeyImagesFilterSize() const; //Bytes
+  uint32_t getWriteGroupSize() const;
 
   void setConfigFolderDefaulted(bool defaulted);
   void setDataDir(const std::string& dataDir);
@@ -46,6 +82,10 @@ public:
   void setWriteBufferSize(uint64_t writeBufferSize); //Bytes
   void setReadCacheSize(uint64_t readCacheSize); //Bytes
   void setTestnet(bool testnet);
+  void setColumnFamilyConfig(DataBaseAccessPattern pattern, const DataBaseColumnFamilyConfig& config);
+  void setKeyImagesBloomFilterBitsPerKey(uint32_t bitsPerKey);
+  void setSpentKeyImagesFilterSize(uint64_t spentKeyImagesFilterSize); //Bytes
+  void setWriteGroupSize(uint32_t writeGroupSize);
 
 private:
   bool configFolderDefaulted;
@@ -55,5 +95,9 @@ private:
   uint64_t writeBufferSize;
   uint64_t readCacheSize;
   bool testnet;
+  DataBaseColumnFamilyConfig columnFamilyConfigs[static_cast<size_t>(DataBaseAccessPattern::COUNT)];
+  uint32_t keyImagesBloomFilterBitsPerKey;
+  uint64_t spentKeyImagesFilterSize;
+  uint32_t writeGroupSize;
 };
 } //namespace CryptoNote
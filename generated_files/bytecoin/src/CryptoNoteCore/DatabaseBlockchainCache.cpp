@@ -17,6 +17,7 @@
 
 #include <CryptoNoteCore/DatabaseBlockchainCache.h>
 
+#include <chrono>
 #include <ctime>
 #include <cstdlib>
 
@@ -31,6 +32,7 @@
 #include <CryptoNoteCore/BlockchainStorage.h>
 #include <CryptoNoteCore/CryptoNoteTools.h>
 #include <CryptoNoteCore/CryptoNoteBasicImpl.h>
+#include "CryptoNoteCore/DBUtils.h"
 #include "CryptoNoteCore/TransactionExtra.h"
 
 namespace CryptoNote {
@@ -372,14 +374,12 @@ void cutTail(std::deque<CachedBlockInfo>& cache, size_t count) {
   cache.erase(std::next(cache.begin(), cache.size() - count), cache.end());
 }
 
-const std::string DB_VERSION_KEY = "db_scheme_version";
-
 class DatabaseVersionReadBatch: public IReadBatch {
 public:
   virtual ~DatabaseVersionReadBatch() {}
 
   virtual std::vector<std::string> getRawKeys() const override {
-    return {DB_VERSION_KEY};
+    return {DB::SCHEME_VERSION_KEY};
   }
 
   virtual void submitRawResult(const std::vector<std::string>& values, const std::vector<bool>& resultStates) override {
@@ -407,7 +407,7 @@ public:
   virtual ~DatabaseVersionWriteBatch() {}
 
   virtual std::vector<std::pair<std::string, std::string> > extractRawDataToInsert() override {
-    return {make_pair(DB_VERSION_KEY, std::to_string(schemeVersion))};
+    return {make_pair(DB::SCHEME_VERSION_KEY, std::to_string(schemeVersion))};
   }
 
   virtual std::vector<std::string> extractRawKeysToRemove() override {
@@ -418,7 +418,12 @@ private:
   uint32_t schemeVersion;
 };
 
-const uint32_t CURRENT_DB_SCHEME_VERSION = 2;
+const uint32_t SPENT_KEY_IMAGES_FILTER_LOAD_BATCH_SIZE = 1000; //Blocks
+// the filter gives more than 1% of false positives with less bits per key image
+const uint64_t SPENT_KEY_IMAGES_FILTER_MIN_BITS_PER_KEY_IMAGE = 10;
+
+// older blocks come from sync, their writes are left to the DB to commit in groups
+const uint64_t SYNC_BLOCK_AGE = ONE_DAY_SECONDS;
 
 }
 
@@ -428,7 +433,8 @@ struct DatabaseBlockchainCache::ExtendedPushedBlockInfo {
 };
 
 
-DatabaseBlockchainCache::DatabaseBlockchainCache(const Currency& curr, IDataBase& dataBase, IBlockchainCacheFactory& blockchainCacheFactory, Logging::ILogger& _logger)
+DatabaseBlockchainCache::DatabaseBlockchainCache(const Currency& curr, IDataBase& dataBase, IBlockchainCacheFactory& blockchainCacheFactory, Logging::ILogger& _logger,
+                                                 uint64_t spentKeyImagesFilterSize)
     : currency(curr), database(dataBase), blockchainCacheFactory(blockchainCacheFactory), logger(_logger, "DatabaseBlockchainCache") {
   DatabaseVersionReadBatch readBatch;
   auto ec = database.read(readBatch);
@@ -438,9 +444,9 @@ DatabaseBlockchainCache::DatabaseBlockchainCache(const Currency& curr, IDataBase
 
   auto version = readBatch.getDbSchemeVersion();
   if (!version) {
-    logger(Logging::DEBUGGING) << "DB scheme version not found, writing: " << CURRENT_DB_SCHEME_VERSION;
+    logger(Logging::DEBUGGING) << "DB scheme version not found, writing: " << DB::SCHEME_VERSION;
 
-    DatabaseVersionWriteBatch writeBatch(CURRENT_DB_SCHEME_VERSION);
+    DatabaseVersionWriteBatch writeBatch(DB::SCHEME_VERSION);
     auto writeError = database.write(writeBatch);
     if (writeError) {
       throw std::system_error(writeError);
@@ -453,6 +459,10 @@ DatabaseBlockchainCache::DatabaseBlockchainCache(const Currency& curr, IDataBase
     logger(Logging::DEBUGGING) << "top block index is nill, add genesis block";
     addGenesisBlock(CachedBlock (currency.genesisBlock()));
   }
+
+  if (spentKeyImagesFilterSize != 0) {
+    loadSpentKeyImagesFilter(spentKeyImagesFilterSize);
+  }
 }
 
 bool DatabaseBlockchainCache::checkDBSchemeVersion(IDataBase& database, Logging::ILogger& _logger) {
@@ -468,17 +478,49 @@ bool DatabaseBlockchainCache::checkDBSchemeVersion(IDataBase& database, Logging:
   if (!version) {
     //DB scheme version not found. Looks like it was just created.
     return true;
-  } else if (*version < CURRENT_DB_SCHEME_VERSION) {
-    logger(Logging::WARNING) << "DB scheme version is less than expected. Expected version " << CURRENT_DB_SCHEME_VERSION << ". Actual version " << *version << ". DB will be destroyed and recreated from blocks.bin file.";
+  } else if (*version < DB::SCHEME_VERSION) {
+    logger(Logging::WARNING) << "DB scheme version is less than expected. Expected version " << DB::SCHEME_VERSION << ". Actual version " << *version << ". DB will be destroyed and recreated from blocks.bin file.";
     return false;
-  } else if (*version > CURRENT_DB_SCHEME_VERSION) {
-    logger(Logging::ERROR) << "DB scheme version is greater than expected. Expected version " << CURRENT_DB_SCHEME_VERSION << ". Actual version " << *version << ". Please update your software.";
+  } else if (*version > DB::SCHEME_VERSION) {
+    logger(Logging::ERROR) << "DB scheme version is greater than expected. Expected version " << DB::SCHEME_VERSION << ". Actual version " << *version << ". Please update your software.";
     throw std::runtime_error("DB scheme version is greater than expected");
   } else {
     return true;
   }
 }
 
+void DatabaseBlockchainCache::loadSpentKeyImagesFilter(uint64_t size) {
+  logger(Logging::INFO) << "Loading spent key images filter...";
+  auto start = std::chrono::steady_clock::now();
+
+  spentKeyImagesFilter.reset(new SpentKeyImagesFilter(size));
+  uint32_t topIndex = getTopBlockIndex();
+  for (uint32_t batchStart = 0; batchStart <= topIndex; batchStart += SPENT_KEY_IMAGES_FILTER_LOAD_BATCH_SIZE) {
+    uint32_t batchEnd = std::min(topIndex, batchStart + SPENT_KEY_IMAGES_FILTER_LOAD_BATCH_SIZE - 1);
+
+    BlockchainReadBatch batch;
+    for (uint32_t blockIndex = batchStart; blockIndex <= batchEnd; ++blockIndex) {
+      batch.requestSpentKeyImagesByBlock(blockIndex);
+    }
+
+    auto result = readDatabase(batch);
+    for (const auto& blockKeyImages : result.getSpentKeyImagesByBlock()) {
+      for (const auto& keyImage : blockKeyImages.second) {
+        spentKeyImagesFilter->add(keyImage);
+      }
+    }
+  }
+
+  auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+  logger(Logging::INFO) << "Spent key images filter loaded, " << spentKeyImagesFilter->getKeyImagesCount() << " key images, "
+                        << duration.count() << " ms";
+
+  if (spentKeyImagesFilter->getSize() * 8 < spentKeyImagesFilter->getKeyImagesCount() * SPENT_KEY_IMAGES_FILTER_MIN_BITS_PER_KEY_IMAGE) {
+    logger(Logging::WARNING) << "Spent key images filter is too small for " << spentKeyImagesFilter->getKeyImagesCount()
+                             << " key images, increase its size to make spent checks faster";
+  }
+}
+
 void DatabaseBlockchainCache::deleteClosestTimestampBlockIndex(BlockchainWriteBatch& writeBatch, uint32_t splitBlockIndex) {
   auto batch = BlockchainReadBatch().requestCachedBlock(splitBlockIndex);
   auto blockResult = readDatabase(batch);
@@ -519,7 +561,7 @@ std::unique_ptr<IBlockchainCache> DatabaseBlockchainCache::split(uint32_t splitB
 
   auto cache = blockchainCacheFactory.createBlockchainCache(currency, this, splitBlockIndex);
 
-  using DeleteBlockInfo = std::tuple<uint32_t, Crypto::Hash, TransactionValidatorState, uint64_t>;
+  using DeleteBlockInfo = std::tuple<uint32_t, Crypto::Hash, TransactionValidatorState, uint64_t, std::string>;
   std::vector<DeleteBlockInfo> deletingBlocks;
 
   BlockchainWriteBatch writeBatch;
@@ -529,9 +571,10 @@ std::unique_ptr<IBlockchainCache> DatabaseBlockchainCache::split(uint32_t splitB
 
     auto validatorState = extendedInfo.pushedBlockInfo.validatorState;
     logger(Logging::DEBUGGING) << "pushing block " << blockIndex << " to child segment";
-    auto blockHash = pushBlockToAnotherCache(*cache, std::move(extendedInfo.pushedBlockInfo));
+    std::string accountNumber;
+    auto blockHash = pushBlockToAnotherCache(*cache, std::move(extendedInfo.pushedBlockInfo), accountNumber);
 
-    deletingBlocks.emplace_back(blockIndex, blockHash, validatorState, extendedInfo.timestamp);
+    deletingBlocks.emplace_back(blockIndex, blockHash, validatorState, extendedInfo.timestamp, std::move(accountNumber));
   }
 
   for (auto it = deletingBlocks.rbegin(); it != deletingBlocks.rend(); ++it) {
@@ -539,8 +582,13 @@ std::unique_ptr<IBlockchainCache> DatabaseBlockchainCache::split(uint32_t splitB
     auto blockHash = std::get<1>(*it);
     auto& validatorState = std::get<2>(*it);
     uint64_t timestamp = std::get<3>(*it);
+    const auto& accountNumber = std::get<4>(*it);
 
     writeBatch.removeCachedBlock(blockHash, blockIndex).removeRawBlock(blockIndex);
+    if (!accountNumber.empty()) {
+      writeBatch.removeAccount(accountNumber);
+    }
+
     requestDeleteSpentOutputs(writeBatch,
                               blockIndex,
                               validatorState);
@@ -586,13 +634,17 @@ std::unique_ptr<IBlockchainCache> DatabaseBlockchainCache::split(uint32_t splitB
   topBlockHash = boost::none;
   transactionsCount = boost::none;
 
+  if (difficultyWindow) {
+    difficultyWindow->popBack(*this, currentTop + 1 - splitBlockIndex);
+  }
+
   logger(Logging::DEBUGGING) << "split completed";
   // return new cache
   return cache;
 }
 
-//returns hash of pushed block
-Crypto::Hash DatabaseBlockchainCache::pushBlockToAnotherCache(IBlockchainCache& segment, PushedBlockInfo&& pushedBlockInfo) {
+//returns hash of pushed block, accountNumber is set for account blocks
+Crypto::Hash DatabaseBlockchainCache::pushBlockToAnotherCache(IBlockchainCache& segment, PushedBlockInfo&& pushedBlockInfo, std::string& accountNumber) {
   BlockTemplate block;
   bool br = fromBinaryArray(block, pushedBlockInfo.rawBlock.block);
   assert(br);
@@ -610,6 +662,10 @@ Crypto::Hash DatabaseBlockchainCache::pushBlockToAnotherCache(IBlockchainCache&
                     pushedBlockInfo.blockDifficulty,
                     std::move(pushedBlockInfo.rawBlock));
 
+  if (cachedBlock.getTypeOfBlock() == ACCOUNT_BLOCK) {
+    accountNumber = block.accountNumber;
+  }
+
   return cachedBlock.getBlockHash();
 }
 
@@ -899,6 +955,10 @@ void DatabaseBlockchainCache::pushBlock(const CachedBlock& cachedBlock,
   batch.insertCachedBlock(blockInfo, getTopBlockIndex() + 1, txHashes);
   batch.insertRawBlock(getTopBlockIndex() + 1, std::move(rawBlock));
 
+  if (cachedBlock.getTypeOfBlock() == ACCOUNT_BLOCK) {
+    batch.insertAccount(cachedBlock.getBlock().accountNumber, AccountInfo{cachedBlock.getBlock().accountAddress, getTopBlockIndex() + 1});
+  }
+
   auto transactionIndex = 0;
   pushTransaction(cachedBaseTransaction, getTopBlockIndex() + 1, transactionIndex++, batch);
 
@@ -924,14 +984,32 @@ void DatabaseBlockchainCache::pushBlock(const CachedBlock& cachedBlock,
     throw std::runtime_error(res.message());
   }
 
+  // The block is written and read back by now, a failed commit leaves its writes held until the next one
+  if (cachedBlock.getBlock().timestamp + SYNC_BLOCK_AGE > static_cast<uint64_t>(time(nullptr))) {
+    res = database.flush();
+    if (res) {
+      logger(Logging::ERROR) << "push block " << cachedBlock.getBlockHash() << " flush failed: " << res.message();
+    }
+  }
+
   topBlockIndex = *topBlockIndex + 1;
   topBlockHash = cachedBlock.getBlockHash();
   logger(Logging::DEBUGGING) << "push block " << cachedBlock.getBlockHash() << " completed";
 
+  if (spentKeyImagesFilter) {
+    for (const auto& keyImage : validatorState.spentKeyImages) {
+      spentKeyImagesFilter->add(keyImage);
+    }
+  }
+
   unitsCache.push_back(blockInfo);
   if (unitsCache.size() > unitsCacheSize) {
     unitsCache.pop_front();
   }
+
+  if (difficultyWindow) {
+    difficultyWindow->pushBack(blockInfo.timestamp, blockInfo.cumulativeDifficulty);
+  }
 }
 
 PushedBlockInfo DatabaseBlockchainCache::getPushedBlockInfo(uint32_t blockIndex) const {
@@ -939,6 +1017,10 @@ PushedBlockInfo DatabaseBlockchainCache::getPushedBlockInfo(uint32_t blockIndex)
 }
 
 bool DatabaseBlockchainCache::checkIfSpent(const Crypto::KeyImage& keyImage, uint32_t blockIndex) const {
+  if (spentKeyImagesFilter && !spentKeyImagesFilter->mayContain(keyImage)) {
+    return false;
+  }
+
   auto batch = BlockchainReadBatch().requestBlockIndexBySpentKeyImage(keyImage);
   auto res = database.read(batch);
   if (res) {
@@ -1034,6 +1116,65 @@ DatabaseBlockchainCache::extractKeyOutputKeys(uint64_t amount, uint32_t blockInd
   });
 }
 
+void DatabaseBlockchainCache::extractKeyOutputKeys(uint32_t blockIndex, std::vector<KeyOutputKeysRequest>& requests) const {
+  BlockchainReadBatch batch;
+  bool hasIndexes = false;
+  for (const auto& request : requests) {
+    for (auto globalIndex : request.globalIndexes) {
+      batch.requestKeyOutputInfo(request.amount, globalIndex);
+      hasIndexes = true;
+    }
+  }
+
+  KeyOutputKeyResult outputs;
+  if (hasIndexes) {
+    outputs = readDatabase(batch).getKeyOutputInfo();
+  }
+
+  for (auto& request : requests) {
+    request.publicKeys.clear();
+    request.publicKeys.reserve(request.globalIndexes.size());
+    request.result = ExtractOutputKeysResult::SUCCESS;
+
+    for (auto globalIndex : request.globalIndexes) {
+      auto it = outputs.find(std::make_pair(request.amount, globalIndex));
+      if (it == outputs.end()) {
+        logger(Logging::DEBUGGING) << "extractKeyOutputKeys: output " << globalIndex << " for amount " << request.amount << " doesn't exist";
+        request.result = ExtractOutputKeysResult::INVALID_GLOBAL_INDEX;
+        break;
+      }
+
+      if (!isTransactionSpendTimeUnlocked(it->second.unlockTime, blockIndex)) {
+        logger(Logging::DEBUGGING) << "extractKeyOutputKeys: output " << globalIndex << " is locked";
+        request.result = ExtractOutputKeysResult::OUTPUT_LOCKED;
+        break;
+      }
+
+      request.publicKeys.push_back(it->second.publicKey);
+    }
+  }
+}
+
+void DatabaseBlockchainCache::getAccountAddresses(uint32_t blockIndex, std::vector<AccountAddressRequest>& requests) const {
+  if (requests.empty()) {
+    return;
+  }
+
+  BlockchainReadBatch batch;
+  for (const auto& request : requests) {
+    batch.requestAccount(request.accountNumber);
+  }
+
+  auto accounts = readDatabase(batch).getAccounts();
+  for (auto& request : requests) {
+    auto it = accounts.find(request.accountNumber);
+    request.found = it != accounts.end() && it->second.blockIndex <= blockIndex;
+    if (request.found) {
+      request.accountAddress = it->second.accountAddress;
+    }
+  }
+}
+
 ExtractOutputKeysResult DatabaseBlockchainCache::extractKeyOtputIndexes(uint64_t amount,
                                                                         Common::ArrayView<uint32_t> globalIndexes,
                                                                         std::vector<PackedOutIndex>& outIndexes) const {
@@ -1175,6 +1316,15 @@ Difficulty DatabaseBlockchainCache::getDifficultyForNextBlock() const {
 Difficulty DatabaseBlockchainCache::getDifficultyForNextBlock(uint32_t blockIndex) const {
   assert(blockIndex <= getTopBlockIndex());
   uint8_t nextBlockMajorVersion = getBlockMajorVersionForHeight(blockIndex+1);
+  if (blockIndex == getTopBlockIndex()) {
+    if (!difficultyWindow || difficultyWindow->getBlockMajorVersion() != nextBlockMajorVersion) {
+      difficultyWindow.reset(new DifficultyWindow(currency, nextBlockMajorVersion));
+      difficultyWindow->assign(*this, blockIndex);
+    }
+
+    return difficultyWindow->nextDifficulty();
+  }
+
   auto timestamps = getLastTimestamps(currency.difficultyBlocksCountByBlockVersion(nextBlockMajorVersion), blockIndex, UseGenesis{false});
   auto commulativeDifficulties =
       getLastCumulativeDifficulties(currency.difficultyBlocksCountByBlockVersion(nextBlockMajorVersion), blockIndex, UseGenesis{false});
@@ -1441,6 +1591,11 @@ size_t DatabaseBlockchainCache::getChildCount() const {
 }
 
 void DatabaseBlockchainCache::save() {
+  auto res = database.flush();
+  if (res) {
+    logger(Logging::ERROR) << "save failed: failed to flush database, " << res.message();
+    throw std::runtime_error(res.message());
+  }
 }
 
 void DatabaseBlockchainCache::load() {
@@ -1611,20 +1766,23 @@ ExtractOutputKeysResult DatabaseBlockchainCache::extractKeyOutputs(
   }
 
   auto result = readDatabase(batch).getKeyOutputInfo();
-uint64_t count = 0;
-  std::map<std::pair<IBlockchainCache::Amount, IBlockchainCache::GlobalOutputIndex>, KeyOutputInfo> sortedResult(result.begin(), result.end());
-  for (const auto& kv: sortedResult) {
+  for (auto globalIndex : globalIndexes) {
+    auto it = result.find(std::make_pair(amount, globalIndex));
+    if (it == result.end()) {
+      logger(Logging::DEBUGGING) << "extractKeyOutputs failed : output " << globalIndex << " for amount " << amount << " doesn't exist";
+      return ExtractOutputKeysResult::INVALID_GLOBAL_INDEX;
+    }
+
     ExtendedTransactionInfo tx;
-    tx.unlockTime = kv.second.unlockTime;
-    tx.transactionHash = kv.second.transactionHash;
-count++;
-    tx.outputs.resize(kv.second.outputIndex + 1);
-    tx.outputs[kv.second.outputIndex] = KeyOutput{kv.second.publicKey};
+    tx.unlockTime = it->second.unlockTime;
+    tx.transactionHash = it->second.transactionHash;
+    tx.outputs.resize(it->second.outputIndex + 1);
+    tx.outputs[it->second.outputIndex] = KeyOutput{it->second.publicKey};
     PackedOutIndex fakePoi;
-    fakePoi.outputIndex = kv.second.outputIndex;
+    fakePoi.outputIndex = it->second.outputIndex;
 
     //TODO: change the interface of extractKeyOutputs to return vector of structures instead of passing callback as predicate
-    auto ret = callback(tx, fakePoi, kv.first.second);
+    auto ret = callback(tx, fakePoi, globalIndex);
     if (ret != ExtractOutputKeysResult::SUCCESS) {
       logger(Logging::DEBUGGING) << "extractKeyOutputs failed : callback returned error";
       return ret;
@@ -20,6 +20,7 @@
 #include "Common/StringView.h"
 #include "Currency.h"
 #include "Difficulty.h"
+#include "DifficultyWindow.h"
 #include "IBlockchainCache.h"
 #include "CryptoNoteCore/UpgradeManager.h"
 #include <IDataBase.h>
@@ -27,6 +28,7 @@
 #include <CryptoNoteCore/BlockchainWriteBatch.h>
 #include <CryptoNoteCore/DatabaseCacheData.h>
 #include <CryptoNoteCore/IBlockchainCacheFactory.h>
+#include <CryptoNoteCore/SpentKeyImagesFilter.h>
 
 namespace CryptoNote {
 
@@ -45,9 +47,11 @@ public:
   /*
    * Constructs new DatabaseBlockchainCache object. Currnetly, only factories that produce 
    * BlockchainCache objects as children are supported.
+   * Spent checks consult an in-memory filter of spentKeyImagesFilterSize bytes first, 0 disables the filter.
    */
   DatabaseBlockchainCache(const Currency& currency, IDataBase& dataBase,
-                          IBlockchainCacheFactory& blockchainCacheFactory, Logging::ILogger& logger);
+                          IBlockchainCacheFactory& blockchainCacheFactory, Logging::ILogger& logger,
+                          uint64_t spentKeyImagesFilterSize = 0);
 
   static bool checkDBSchemeVersion(IDataBase& dataBase, Logging::ILogger& logger);
 
@@ -77,6 +81,8 @@ ExtractOutputKeysResult extractTransactionPublicKeys(uint64_t amount, uint32_t b
   ExtractOutputKeysResult extractKeyOutputKeys(uint64_t amount, uint32_t blockIndex,
                                                Common::ArrayView<uint32_t> globalIndexes,
                                                std::vector<Crypto::PublicKey>& publicKeys) const override;
+  void extractKeyOutputKeys(uint32_t blockIndex, std::vector<KeyOutputKeysRequest>& requests) const override;
+  void getAccountAddresses(uint32_t blockIndex, std::vector<AccountAddressRequest>& requests) const override;
 
   ExtractOutputKeysResult extractKeyOtputIndexes(uint64_t amount, Common::ArrayView<uint32_t> globalIndexes,
                                                  std::vector<PackedOutIndex>& outIndexes) const override;
@@ -177,6 +183,10 @@ private:
   Logging::LoggerRef logger;
   std::deque<CachedBlockInfo> unitsCache;
   const size_t unitsCacheSize = 1000;
+  // Built for the top block on the first difficulty request, then follows pushes and splits
+  mutable std::unique_ptr<DifficultyWindow> difficultyWindow;
+  // Contains every key image spent in the DB, empty if the filter is disabled
+  std::unique_ptr<SpentKeyImagesFilter> spentKeyImagesFilter;
 
   struct ExtendedPushedBlockInfo;
   ExtendedPushedBlockInfo getExtendedPushedBlockInfo(uint32_t blockIndex) const;
@@ -186,6 +196,7 @@ private:
   BlockchainReadResult readDatabase(BlockchainReadBatch& batch) const;
 
   void addSpentKeyImage(const Crypto::KeyImage& keyImage, uint32_t blockIndex);
+  void loadSpentKeyImagesFilter(uint64_t size);
   void pushTransaction(const CachedTransaction& cachedTransaction,
                        uint32_t blockIndex,
                        uint16_t transactionBlockIndex,
@@ -202,7 +213,7 @@ private:
 
   TransactionValidatorState fillOutputsSpentByBlock(uint32_t blockIndex) const;
 
-  Crypto::Hash pushBlockToAnotherCache(IBlockchainCache& segment, PushedBlockInfo&& pushedBlockInfo);
+  Crypto::Hash pushBlockToAnotherCache(IBlockchainCache& segment, PushedBlockInfo&& pushedBlockInfo, std::string& accountNumber);
   void requestDeleteSpentOutputs(BlockchainWriteBatch& writeBatch, uint32_t splitBlockIndex, const TransactionValidatorState& spentOutputs);
   std::vector<Crypto::Hash> requestTransactionHashesFromBlockIndex(uint32_t splitBlockIndex);
   void requestDeleteTransactions(BlockchainWriteBatch& writeBatch, const std::vector<Crypto::Hash>& transactionHashes);
@@ -20,11 +20,30 @@
 #include "IDataBase.h"
 
 #include "BlockchainCache.h"
+#include "BlockchainReadBatch.h"
 #include "DatabaseBlockchainCache.h"
 
 namespace CryptoNote {
 
-DatabaseBlockchainCacheFactory::DatabaseBlockchainCacheFactory(IDataBase& database, Logging::ILogger& logger): database(database), logger(logger) {
+namespace {
+
+struct DataBaseSnapshotHolder {
+  std::unique_ptr<IDataBase> snapshot;
+};
+
+// Owns the DB snapshot it reads, the holder base is constructed first
+class DatabaseBlockchainCacheSnapshot : private DataBaseSnapshotHolder, public DatabaseBlockchainCache {
+public:
+  DatabaseBlockchainCacheSnapshot(const Currency& currency, std::unique_ptr<IDataBase>&& dataBaseSnapshot,
+                                  IBlockchainCacheFactory& blockchainCacheFactory, Logging::ILogger& logger)
+      : DataBaseSnapshotHolder{ std::move(dataBaseSnapshot) }, DatabaseBlockchainCache(currency, *snapshot, blockchainCacheFactory, logger) {
+  }
+};
+
+}
+
+DatabaseBlockchainCacheFactory::DatabaseBlockchainCacheFactory(IDataBase& database, Logging::ILogger& logger, uint64_t spentKeyImagesFilterSize):
+  database(database), logger(logger), spentKeyImagesFilterSize(spentKeyImagesFilterSize) {
 
 }
 
@@ -33,11 +52,29 @@ DatabaseBlockchainCacheFactory::~DatabaseBlockchainCacheFactory() {
 }
 
 std::unique_ptr<IBlockchainCache> DatabaseBlockchainCacheFactory::createRootBlockchainCache(const Currency& currency) {
-  return std::unique_ptr<IBlockchainCache> (new DatabaseBlockchainCache(currency, database, *this, logger));
+  return std::unique_ptr<IBlockchainCache> (new DatabaseBlockchainCache(currency, database, *this, logger, spentKeyImagesFilterSize));
 }
 
 std::unique_ptr<IBlockchainCache> DatabaseBlockchainCacheFactory::createBlockchainCache(const Currency& currency, IBlockchainCache* parent, uint32_t startIndex) {
   return std::unique_ptr<IBlockchainCache> (new BlockchainCache("", currency, logger, parent, startIndex));
 }
 
+std::unique_ptr<IBlockchainCache> DatabaseBlockchainCacheFactory::createRootBlockchainCacheSnapshot(const Currency& currency) {
+  std::unique_ptr<IDataBase> snapshot = database.createSnapshot();
+
+  //the cache writes the genesis block to a DB that has no other blocks, a snapshot can't be written
+  BlockchainReadBatch readBatch;
+  auto error = snapshot->read(readBatch.requestLastBlockIndex());
+  if (error) {
+    throw std::system_error(error);
+  }
+
+  auto lastBlockIndex = readBatch.extractResult().getLastBlockIndex();
+  if (!lastBlockIndex.second || lastBlockIndex.first == 0) {
+    return nullptr;
+  }
+
+  return std::unique_ptr<IBlockchainCache>(new DatabaseBlockchainCacheSnapshot(currency, std::move(snapshot), *this, logger));
+}
+
 } //namespace CryptoNote
@@ -26,15 +26,17 @@ class IDataBase;
 
 class DatabaseBlockchainCacheFactory: public IBlockchainCacheFactory {
 public:
-  explicit DatabaseBlockchainCacheFactory(IDataBase& database, Logging::ILogger& logger);
+  explicit DatabaseBlockchainCacheFactory(IDataBase& database, Logging::ILogger& logger, uint64_t spentKeyImagesFilterSize = 0);
   virtual ~DatabaseBlockchainCacheFactory();
 
   virtual std::unique_ptr<IBlockchainCache> createRootBlockchainCache(const Currency& currency) override;
   virtual std::unique_ptr<IBlockchainCache> createBlockchainCache(const Currency& currency, IBlockchainCache* parent, uint32_t startIndex = 0) override;
+  virtual std::unique_ptr<IBlockchainCache> createRootBlockchainCacheSnapshot(const Currency& currency) override;
 
 private:
   IDataBase& database;
   Logging::ILogger& logger;
+  uint64_t spentKeyImagesFilterSize;
 };
 
 } //namespace CryptoNote
@@ -0,0 +1,86 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "DatabaseMainChainStorage.h"
+
+#include <cassert>
+#include <stdexcept>
+#include <system_error>
+
+#include "BlockchainReadBatch.h"
+
+namespace CryptoNote {
+
+DatabaseMainChainStorage::DatabaseMainChainStorage(IDataBase& database) : database(database) {
+}
+
+DatabaseMainChainStorage::~DatabaseMainChainStorage() {
+}
+
+void DatabaseMainChainStorage::pushBlock(const RawBlock& rawBlock) {
+  blockCount = getBlockCount() + 1;
+}
+
+void DatabaseMainChainStorage::popBlock() {
+  assert(getBlockCount() > 0);
+  blockCount = getBlockCount() - 1;
+}
+
+RawBlock DatabaseMainChainStorage::getBlockByIndex(uint32_t index) const {
+  if (index >= getBlockCount()) {
+    throw std::out_of_range("Block index " + std::to_string(index) + " is out of range. Blocks count: " + std::to_string(getBlockCount()));
+  }
+
+  BlockchainReadBatch batch;
+  auto error = database.read(batch.requestRawBlock(index));
+  if (error) {
+    throw std::system_error(error, "Failed to read block " + std::to_string(index) + " from DB");
+  }
+
+  auto result = batch.extractResult();
+  auto it = result.getRawBlocks().find(index);
+  if (it == result.getRawBlocks().end()) {
+    throw std::out_of_range("Block index " + std::to_string(index) + " is not in DB yet");
+  }
+
+  return it->second;
+}
+
+uint32_t DatabaseMainChainStorage::getBlockCount() const {
+  if (!blockCount) {
+    BlockchainReadBatch batch;
+    auto error = database.read(batch.requestLastBlockIndex());
+    if (error) {
+      throw std::system_error(error, "Failed to read top block index from DB");
+    }
+
+    auto lastBlockIndex = batch.extractResult().getLastBlockIndex();
+    blockCount = lastBlockIndex.second ? lastBlockIndex.first + 1 : 0;
+  }
+
+  return *blockCount;
+}
+
+void DatabaseMainChainStorage::clear() {
+  blockCount = 0;
+}
+
+std::unique_ptr<IMainChainStorage> createDatabaseMainChainStorage(IDataBase& database) {
+  return std::unique_ptr<IMainChainStorage>(new DatabaseMainChainStorage(database));
+}
+
+}
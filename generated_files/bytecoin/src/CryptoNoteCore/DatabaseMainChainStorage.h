@@ -0,0 +1,53 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+
+#include <boost/optional.hpp>
+
+#include "IDataBase.h"
+#include "IMainChainStorage.h"
+
+namespace CryptoNote {
+
+// Main chain storage without a file of its own. Raw blocks of the root segment are already in the DB,
+// DatabaseBlockchainCache writes them there, so this storage only counts pushed blocks and reads them back from the DB.
+// Blocks of the main chain in segments not merged to the root segment yet aren't readable from it.
+class DatabaseMainChainStorage: public IMainChainStorage {
+public:
+  explicit DatabaseMainChainStorage(IDataBase& database);
+  virtual ~DatabaseMainChainStorage();
+
+  virtual void pushBlock(const RawBlock& rawBlock) override;
+  virtual void popBlock() override;
+
+  virtual RawBlock getBlockByIndex(uint32_t index) const override;
+  virtual uint32_t getBlockCount() const override;
+
+  virtual void clear() override;
+
+private:
+  IDataBase& database;
+  // read from the DB on the first use, the root segment adds genesis block to an empty DB
+  mutable boost::optional<uint32_t> blockCount;
+};
+
+std::unique_ptr<IMainChainStorage> createDatabaseMainChainStorage(IDataBase& database);
+
+}
@@ -0,0 +1,207 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "DifficultyWindow.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+#include "Currency.h"
+#include "IBlockchainCache.h"
+
+namespace CryptoNote {
+
+DifficultyWindow::DifficultyWindow(const Currency& currency, uint8_t blockMajorVersion) :
+  currency(currency),
+  blockMajorVersion(blockMajorVersion),
+  windowSize(currency.difficultyWindowByBlockVersion(blockMajorVersion)),
+  cutSize(currency.difficultyCutByBlockVersion(blockMajorVersion)),
+  lagSize(currency.difficultyLagByBlockVersion(blockMajorVersion)) {
+  assert(windowSize >= 2);
+  assert(2 * cutSize <= windowSize - 2);
+}
+
+uint8_t DifficultyWindow::getBlockMajorVersion() const {
+  return blockMajorVersion;
+}
+
+size_t DifficultyWindow::getBlocksCount() const {
+  return blocks.size();
+}
+
+void DifficultyWindow::assign(const IBlockchainCache& cache, uint32_t blockIndex) {
+  blocks.clear();
+  lowTimestamps.clear();
+  usedTimestamps.clear();
+  highTimestamps.clear();
+
+  auto timestamps = cache.getLastTimestamps(windowSize + lagSize, blockIndex, UseGenesis{false});
+  auto cumulativeDifficulties = cache.getLastCumulativeDifficulties(windowSize + lagSize, blockIndex, UseGenesis{false});
+  assert(timestamps.size() == cumulativeDifficulties.size());
+
+  for (size_t i = 0; i < timestamps.size(); ++i) {
+    pushBack(timestamps[i], cumulativeDifficulties[i]);
+  }
+}
+
+void DifficultyWindow::pushBack(uint64_t timestamp, Difficulty cumulativeDifficulty) {
+  blocks.push_back(BlockEntry{timestamp, cumulativeDifficulty});
+  if (blocks.size() <= windowSize) {
+    insertTimestamp(timestamp);
+  } else if (blocks.size() > windowSize + lagSize) {
+    // The oldest block leaves the window, the oldest lagging one enters it
+    eraseTimestamp(blocks.front().timestamp);
+    blocks.pop_front();
+    insertTimestamp(blocks[windowSize - 1].timestamp);
+  }
+}
+
+void DifficultyWindow::popBack(const IBlockchainCache& cache, size_t blocksCount) {
+  if (blocksCount >= blocks.size()) {
+    assign(cache, cache.getTopBlockIndex());
+    return;
+  }
+
+  for (size_t i = 0; i < blocksCount; ++i) {
+    popBack();
+  }
+
+  // Blocks preceding the oldest one take the place of the popped ones. The genesis block is never a part of the window
+  uint32_t oldestBlockIndex = cache.getTopBlockIndex() + 1 - static_cast<uint32_t>(blocks.size());
+  if (oldestBlockIndex <= 1) {
+    return;
+  }
+
+  auto olderCount = std::min(blocksCount, windowSize + lagSize - blocks.size());
+  auto timestamps = cache.getLastTimestamps(olderCount, oldestBlockIndex - 1, UseGenesis{false});
+  auto cumulativeDifficulties = cache.getLastCumulativeDifficulties(olderCount, oldestBlockIndex - 1, UseGenesis{false});
+  assert(timestamps.size() == cumulativeDifficulties.size());
+
+  for (size_t i = timestamps.size(); i > 0; --i) {
+    pushFront(timestamps[i - 1], cumulativeDifficulties[i - 1]);
+  }
+}
+
+Difficulty DifficultyWindow::nextDifficulty() const {
+  size_t length = lowTimestamps.size() + usedTimestamps.size() + highTimestamps.size();
+  if (length <= 1) {
+    return 1;
+  }
+
+  uint64_t timeSpan = *usedTimestamps.rbegin() - *usedTimestamps.begin();
+  if (timeSpan == 0) {
+    timeSpan = 1;
+  }
+
+  // Work is taken by position in the chain, not by the sorted order of timestamps
+  size_t cutBegin = lowTimestamps.size();
+  size_t cutEnd = cutBegin + usedTimestamps.size();
+  Difficulty totalWork = blocks[cutEnd - 1].cumulativeDifficulty - blocks[cutBegin].cumulativeDifficulty;
+  assert(totalWork > 0);
+
+  return currency.difficultyForWork(totalWork, timeSpan);
+}
+
+void DifficultyWindow::popBack() {
+  assert(!blocks.empty());
+  if (blocks.size() <= windowSize) {
+    eraseTimestamp(blocks.back().timestamp);
+  }
+
+  blocks.pop_back();
+}
+
+void DifficultyWindow::pushFront(uint64_t timestamp, Difficulty cumulativeDifficulty) {
+  assert(blocks.size() < windowSize + lagSize);
+  blocks.push_front(BlockEntry{timestamp, cumulativeDifficulty});
+  insertTimestamp(timestamp);
+  if (blocks.size() > windowSize) {
+    // The newest block of the window becomes a lagging one
+    eraseTimestamp(blocks[windowSize].timestamp);
+  }
+}
+
+void DifficultyWindow::insertTimestamp(uint64_t timestamp) {
+  if (!lowTimestamps.empty() && timestamp < *lowTimestamps.rbegin()) {
+    lowTimestamps.insert(timestamp);
+  } else if (!highTimestamps.empty() && timestamp > *highTimestamps.begin()) {
+    highTimestamps.insert(timestamp);
+  } else {
+    usedTimestamps.insert(timestamp);
+  }
+
+  rebalance();
+}
+
+void DifficultyWindow::eraseTimestamp(uint64_t timestamp) {
+  // Every timestamp of lowTimestamps is not greater than any of usedTimestamps and so on, so equal ones are interchangeable
+  if (!lowTimestamps.empty() && timestamp <= *lowTimestamps.rbegin()) {
+    auto it = lowTimestamps.find(timestamp);
+    assert(it != lowTimestamps.end());
+    lowTimestamps.erase(it);
+  } else if (!highTimestamps.empty() && timestamp >= *highTimestamps.begin()) {
+    auto it = highTimestamps.find(timestamp);
+    assert(it != highTimestamps.end());
+    highTimestamps.erase(it);
+  } else {
+    auto it = usedTimestamps.find(timestamp);
+    assert(it != usedTimestamps.end());
+    usedTimestamps.erase(it);
+  }
+
+  rebalance();
+}
+
+// Moves boundary timestamps between the sets until they match the cut Currency::nextDifficulty makes for this length
+void DifficultyWindow::rebalance() {
+  size_t length = lowTimestamps.size() + usedTimestamps.size() + highTimestamps.size();
+  size_t cutBegin, cutEnd;
+  if (length <= windowSize - 2 * cutSize) {
+    cutBegin = 0;
+    cutEnd = length;
+  } else {
+    cutBegin = (length - (windowSize - 2 * cutSize) + 1) / 2;
+    cutEnd = cutBegin + (windowSize - 2 * cutSize);
+  }
+
+  while (lowTimestamps.size() > cutBegin) {
+    auto it = std::prev(lowTimestamps.end());
+    usedTimestamps.insert(*it);
+    lowTimestamps.erase(it);
+  }
+
+  while (highTimestamps.size() > length - cutEnd) {
+    auto it = highTimestamps.begin();
+    usedTimestamps.insert(*it);
+    highTimestamps.erase(it);
+  }
+
+  while (lowTimestamps.size() < cutBegin) {
+    auto it = usedTimestamps.begin();
+    lowTimestamps.insert(*it);
+    usedTimestamps.erase(it);
+  }
+
+  while (highTimestamps.size() < length - cutEnd) {
+    auto it = std::prev(usedTimestamps.end());
+    highTimestamps.insert(*it);
+    usedTimestamps.erase(it);
+  }
+}
+
+}
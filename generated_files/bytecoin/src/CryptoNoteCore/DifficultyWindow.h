@@ -0,0 +1,74 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <set>
+
+#include "Difficulty.h"
+
+namespace CryptoNote {
+
+class Currency;
+class IBlockchainCache;
+
+// Blocks the difficulty of the block after some top block depends on: the last difficultyWindow + difficultyLag blocks
+// without the genesis one, the oldest difficultyWindow of them make the window. Timestamps of the window are kept
+// split into the cut off smallest, the used and the cut off largest ones, so pushing or popping a block costs
+// O(log window) instead of sorting the whole window as Currency::nextDifficulty does.
+class DifficultyWindow {
+public:
+  DifficultyWindow(const Currency& currency, uint8_t blockMajorVersion);
+
+  uint8_t getBlockMajorVersion() const;
+  size_t getBlocksCount() const;
+
+  // Rebuilds the window for the block after blockIndex of the cache
+  void assign(const IBlockchainCache& cache, uint32_t blockIndex);
+  void pushBack(uint64_t timestamp, Difficulty cumulativeDifficulty);
+  // Removes blocksCount newest blocks, the cache is expected to be already cut to its new top block
+  void popBack(const IBlockchainCache& cache, size_t blocksCount);
+
+  Difficulty nextDifficulty() const;
+
+private:
+  struct BlockEntry {
+    uint64_t timestamp;
+    Difficulty cumulativeDifficulty;
+  };
+
+  void popBack();
+  void pushFront(uint64_t timestamp, Difficulty cumulativeDifficulty);
+  void insertTimestamp(uint64_t timestamp);
+  void eraseTimestamp(uint64_t timestamp);
+  void rebalance();
+
+  const Currency& currency;
+  const uint8_t blockMajorVersion;
+  const size_t windowSize;
+  const size_t cutSize;
+  const size_t lagSize;
+
+  std::deque<BlockEntry> blocks;
+  std::multiset<uint64_t> lowTimestamps;
+  std::multiset<uint64_t> usedTimestamps;
+  std::multiset<uint64_t> highTimestamps;
+};
+
+}
@@ -49,6 +49,21 @@ union PackedOutIndex {
   uint64_t packedValue;
 };
 
+// Ring members of a single input for the batched extractKeyOutputKeys, publicKeys and result are filled by the cache
+struct KeyOutputKeysRequest {
+  uint64_t amount;
+  std::vector<uint32_t> globalIndexes;
+  std::vector<Crypto::PublicKey> publicKeys;
+  ExtractOutputKeysResult result;
+};
+
+// Account registered by an ACCOUNT_BLOCK for the batched getAccountAddresses, accountAddress and found are filled by the cache
+struct AccountAddressRequest {
+  std::string accountNumber;
+  std::string accountAddress;
+  bool found;
+};
+
 const uint32_t INVALID_BLOCK_INDEX = std::numeric_limits<uint32_t>::max();
 
 struct PushedBlockInfo {
@@ -105,6 +120,11 @@ virtual ExtractOutputKeysResult extractTransactionPublicKeys(uint64_t amount, Co
 virtual ExtractOutputKeysResult extractTransactionPublicKeys(uint64_t amount, uint32_t blockIndex, Common::ArrayView<uint32_t> globalIndexes, std::vector<Crypto::PublicKey>& publicKeys) const = 0;
   virtual ExtractOutputKeysResult extractKeyOutputKeys(uint64_t amount, Common::ArrayView<uint32_t> globalIndexes, std::vector<Crypto::PublicKey>& publicKeys) const = 0;
   virtual ExtractOutputKeysResult extractKeyOutputKeys(uint64_t amount, uint32_t blockIndex, Common::ArrayView<uint32_t> globalIndexes, std::vector<Crypto::PublicKey>& publicKeys) const = 0;
+  // Same as above for many rings at once. Requests are passed to the parent segment in one call, so the database is read only once
+  virtual void extractKeyOutputKeys(uint32_t blockIndex, std::vector<KeyOutputKeysRequest>& requests) const = 0;
+
+  // Resolves accounts registered at or below blockIndex. Unresolved requests are passed to the parent segment in one call
+  virtual void getAccountAddresses(uint32_t blockIndex, std::vector<AccountAddressRequest>& requests) const = 0;
 
   virtual ExtractOutputKeysResult extractKeyOtputIndexes(uint64_t amount, Common::ArrayView<uint32_t> globalIndexes, std::vector<PackedOutIndex>& outIndexes) const = 0;
   virtual ExtractOutputKeysResult extractKeyOtputReferences(uint64_t amount, Common::ArrayView<uint32_t> globalIndexes, std::vector<std::pair<Crypto::Hash, size_t>>& outputReferences) const = 0;
@@ -30,6 +30,9 @@ public:
 
   virtual std::unique_ptr<IBlockchainCache> createRootBlockchainCache(const Currency& currency) = 0;
   virtual std::unique_ptr<IBlockchainCache> createBlockchainCache(const Currency& currency, IBlockchainCache* parent, uint32_t startIndex = 0) = 0;
+  // Read-only root cache of the blocks committed to the storage so far. It shares no state with the other caches,
+  // so it may be read on another thread. Returns nullptr if the storage has no snapshots or no blocks past the genesis one
+  virtual std::unique_ptr<IBlockchainCache> createRootBlockchainCacheSnapshot(const Currency& currency) = 0;
 };
 
 } //namespace CryptoNote
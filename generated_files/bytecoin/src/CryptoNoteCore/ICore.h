@@ -76,6 +76,8 @@ virtual void extractKeyOutputKeys(const uint64_t amount, const std::vector<uint3
   virtual Difficulty getDifficultyForNextBlock() const = 0;
 
   virtual std::error_code addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlock) = 0;
+  // transactions must be parsed from rawBlock.transactions in the same order, none of them exceeding the maximum transaction size
+  virtual std::error_code addBlock(const CachedBlock& cachedBlock, std::vector<CachedTransaction>&& transactions, RawBlock&& rawBlock) = 0;
   virtual std::error_code addBlock(RawBlock&& rawBlock) = 0;
 
   virtual std::error_code submitBlock(BinaryArray&& rawBlockTemplate) = 0;
@@ -88,6 +90,7 @@ virtual void extractKeyOutputKeys(const uint64_t amount, const std::vector<uint3
   virtual bool addTransactionToPool(const BinaryArray& transactionBinaryArray) = 0;
 
   virtual std::vector<Crypto::Hash> getPoolTransactionHashes() const = 0;
+  virtual bool getPoolTransaction(const Crypto::Hash& transactionHash, BinaryArray& transaction) const = 0;
   virtual bool getPoolChanges(const Crypto::Hash& lastBlockHash, const std::vector<Crypto::Hash>& knownHashes,
                               std::vector<BinaryArray>& addedTransactions,
                               std::vector<Crypto::Hash>& deletedTransactions) const = 0;
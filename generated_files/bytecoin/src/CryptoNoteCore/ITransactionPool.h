@@ -16,6 +16,8 @@
 // along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
+#include <functional>
+
 #include "CachedTransaction.h"
 
 namespace CryptoNote {
@@ -34,6 +36,11 @@ public:
 
   virtual const TransactionValidatorState& getPoolTransactionValidationState() const = 0;
   virtual std::vector<CachedTransaction> getPoolTransactions() const = 0;
+  // Visit transactions without copying them, in the order of getPoolTransactions or the reverse one, until visitor returns false
+  virtual void forEachTransaction(const std::function<bool(const CachedTransaction&)>& visitor) const = 0;
+  virtual void forEachTransactionReversed(const std::function<bool(const CachedTransaction&)>& visitor) const = 0;
+  // Blob size of the smallest transaction, 0 for the empty pool
+  virtual size_t getMinTransactionSize() const = 0;
 
   virtual uint64_t getTransactionReceiveTime(const Crypto::Hash& hash) const = 0;
   virtual std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const = 0;
@@ -0,0 +1,51 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "LongHashCalculator.h"
+
+#include "crypto/hash.h"
+
+namespace CryptoNote {
+
+LongHashCalculator::LongHashCalculator(size_t threadsCount) : workers(threadsCount) {
+  for (size_t i = 0; i < workers.getThreadsCount(); ++i) {
+    contexts.emplace_back(new Crypto::cn_context());
+  }
+}
+
+LongHashCalculator::~LongHashCalculator() {
+}
+
+size_t LongHashCalculator::getThreadsCount() const {
+  return workers.getThreadsCount();
+}
+
+bool LongHashCalculator::calculate(const std::vector<const CachedBlock*>& blocks) {
+  auto failedBlockIndex = workers.run(blocks.size(), [this, &blocks](size_t index, size_t workerIndex) {
+    try {
+      blocks[index]->getBlockLongHash(*contexts[workerIndex]);
+    } catch (std::exception&) {
+      return false;
+    }
+
+    return true;
+  });
+
+  return failedBlockIndex == blocks.size();
+}
+
+}
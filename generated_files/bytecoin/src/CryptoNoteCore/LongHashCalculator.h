@@ -0,0 +1,51 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "CachedBlock.h"
+#include "WorkerPool.h"
+
+namespace Crypto {
+
+class cn_context;
+
+}
+
+namespace CryptoNote {
+
+// Computes proof of work hashes of a window of blocks in parallel, every thread owns its own cn_context.
+// The hashes are stored in the CachedBlock objects, so later proof of work checks of these blocks don't hash again.
+class LongHashCalculator {
+public:
+  explicit LongHashCalculator(size_t threadsCount); //0 means hardware concurrency
+  ~LongHashCalculator();
+
+  size_t getThreadsCount() const;
+
+  // Blocks must not be used by other threads until it returns. Returns false if some block of unknown version couldn't be hashed.
+  bool calculate(const std::vector<const CachedBlock*>& blocks);
+
+private:
+  WorkerPool workers;
+  std::vector<std::unique_ptr<Crypto::cn_context>> contexts;
+};
+
+}
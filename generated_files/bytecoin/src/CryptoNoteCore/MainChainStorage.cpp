@@ -19,24 +19,25 @@
 
 #include <boost/filesystem.hpp>
 
+#include "Common/MemoryInputStream.h"
 #include "CryptoNoteTools.h"
+#include "SwappedVector.h"
 
 namespace CryptoNote {
 
-const size_t STORAGE_CACHE_SIZE = 100;
-
 MainChainStorage::MainChainStorage(const std::string& blocksFilename, const std::string& indexesFilename) {
-  if (!storage.open(blocksFilename, indexesFilename, STORAGE_CACHE_SIZE)) {
-    throw std::runtime_error("Failed to load main chain storage: " + blocksFilename);
+  storage.open(blocksFilename);
+  if (boost::filesystem::exists(blocksFilename) && boost::filesystem::exists(indexesFilename)) {
+    importSwappedStorage(blocksFilename, indexesFilename);
   }
 }
 
 MainChainStorage::~MainChainStorage() {
-  storage.close();
 }
 
 void MainChainStorage::pushBlock(const RawBlock& rawBlock) {
-  storage.push_back(rawBlock);
+  BinaryArray block = toBinaryArray(rawBlock);
+  storage.push_back(Common::ArrayView<uint8_t>(block.data(), block.size()));
 }
 
 void MainChainStorage::popBlock() {
@@ -48,7 +49,13 @@ RawBlock MainChainStorage::getBlockByIndex(uint32_t index) const {
     throw std::out_of_range("Block index " + std::to_string(index) + " is out of range. Blocks count: " + std::to_string(storage.size()));
   }
 
-  return storage[index];
+  //blocks are read straight from the mapped file
+  Common::ArrayView<uint8_t> block = storage[index];
+  Common::MemoryInputStream stream(block.getData(), block.getSize());
+  BinaryInputStreamSerializer serializer(stream);
+  RawBlock rawBlock;
+  serialize(rawBlock, serializer);
+  return rawBlock;
 }
 
 uint32_t MainChainStorage::getBlockCount() const {
@@ -59,6 +66,26 @@ void MainChainStorage::clear() {
   storage.clear();
 }
 
+void MainChainStorage::importSwappedStorage(const std::string& blocksFilename, const std::string& indexesFilename) {
+  //files of the previous format are removed only after all their blocks are imported, an interrupted import starts over
+  storage.clear();
+
+  {
+    SwappedVector<RawBlock> swappedStorage;
+    if (!swappedStorage.open(blocksFilename, indexesFilename, 1)) {
+      throw std::runtime_error("Failed to load main chain storage: " + blocksFilename);
+    }
+
+    for (uint64_t i = 0; i < swappedStorage.size(); ++i) {
+      pushBlock(swappedStorage[i]);
+    }
+  }
+
+  storage.flush();
+  boost::filesystem::remove(blocksFilename);
+  boost::filesystem::remove(indexesFilename);
+}
+
 std::unique_ptr<IMainChainStorage> createSwappedMainChainStorage(const std::string& dataDir, const Currency& currency) {
   boost::filesystem::path blocksFilename = boost::filesystem::path(dataDir) / currency.blocksFileName();
   boost::filesystem::path indexesFilename = boost::filesystem::path(dataDir) / currency.blockIndexesFileName();
@@ -73,4 +100,18 @@ std::unique_ptr<IMainChainStorage> createSwappedMainChainStorage(const std::stri
   return storage;
 }
 
+bool mainChainStorageExists(const std::string& dataDir, const Currency& currency) {
+  boost::filesystem::path blocksFilename = boost::filesystem::path(dataDir) / currency.blocksFileName();
+  return SegmentedMappedStorage::exists(blocksFilename.string()) || boost::filesystem::exists(blocksFilename);
+}
+
+void removeMainChainStorage(const std::string& dataDir, const Currency& currency) {
+  boost::filesystem::path blocksFilename = boost::filesystem::path(dataDir) / currency.blocksFileName();
+  boost::filesystem::path indexesFilename = boost::filesystem::path(dataDir) / currency.blockIndexesFileName();
+
+  SegmentedMappedStorage::remove(blocksFilename.string());
+  boost::filesystem::remove(blocksFilename);
+  boost::filesystem::remove(indexesFilename);
+}
+
 }
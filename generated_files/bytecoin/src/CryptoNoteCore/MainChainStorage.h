@@ -19,12 +19,13 @@
 
 #include "IMainChainStorage.h"
 #include "Currency.h"
-#include "SwappedVector.h"
+#include "SegmentedMappedStorage.h"
 
 namespace CryptoNote {
 
 class MainChainStorage: public IMainChainStorage {
 public:
+  // Blocks are kept in segments next to blocksFilename, files of the previous format are imported and removed
   MainChainStorage(const std::string& blocksFilame, const std::string& indexesFilename);
   virtual ~MainChainStorage();
 
@@ -37,9 +38,13 @@ public:
   virtual void clear() override;
 
 private:
-  mutable SwappedVector<RawBlock> storage;
+  SegmentedMappedStorage storage;
+
+  void importSwappedStorage(const std::string& blocksFilename, const std::string& indexesFilename);
 };
 
 std::unique_ptr<IMainChainStorage> createSwappedMainChainStorage(const std::string& dataDir, const Currency& currency);
+bool mainChainStorageExists(const std::string& dataDir, const Currency& currency);
+void removeMainChainStorage(const std::string& dataDir, const Currency& currency);
 
 }
@@ -38,4 +38,8 @@ std::unique_ptr<IBlockchainCache> MemoryBlockchainCacheFactory::createBlockchain
   return std::unique_ptr<IBlockchainCache>(new BlockchainCache(filename, currency, logger, parent, startIndex));
 }
 
+std::unique_ptr<IBlockchainCache> MemoryBlockchainCacheFactory::createRootBlockchainCacheSnapshot(const Currency& currency) {
+  return nullptr;
+}
+
 } //namespace CryptoNote
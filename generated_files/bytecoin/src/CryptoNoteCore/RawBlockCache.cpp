@@ -0,0 +1,164 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "RawBlockCache.h"
+
+namespace CryptoNote {
+
+namespace {
+
+size_t getRawBlockSize(const RawBlock& rawBlock) {
+  size_t size = rawBlock.block.size();
+  for (const auto& transaction : rawBlock.transactions) {
+    size += transaction.size();
+  }
+
+  return size;
+}
+
+}
+
+RawBlockCache::RawBlockCache(size_t capacity) : capacity(capacity), size(0), hitsCount(0), missesCount(0) {
+}
+
+std::shared_ptr<const RawBlock> RawBlockCache::find(uint32_t blockIndex) {
+  if (capacity == 0) {
+    return nullptr;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex);
+  auto it = findEntry(blockIndex);
+  return it == entries.end() ? nullptr : it->second.rawBlock;
+}
+
+std::shared_ptr<const RawBlock> RawBlockCache::find(const Crypto::Hash& blockHash) {
+  if (capacity == 0) {
+    return nullptr;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex);
+  auto indexIt = blockIndexes.find(blockHash);
+  if (indexIt == blockIndexes.end()) {
+    return nullptr;
+  }
+
+  return findEntry(indexIt->second)->second.rawBlock;
+}
+
+std::shared_ptr<const BlockTemplate> RawBlockCache::findTemplate(uint32_t blockIndex) {
+  if (capacity == 0) {
+    return nullptr;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex);
+  auto it = entries.find(blockIndex);
+  if (it == entries.end() || !it->second.blockTemplate) {
+    return nullptr;
+  }
+
+  return findEntry(blockIndex)->second.blockTemplate;
+}
+
+void RawBlockCache::insert(uint32_t blockIndex, const Crypto::Hash& blockHash, const RawBlock& rawBlock) {
+  size_t blockSize = getRawBlockSize(rawBlock);
+  if (blockSize > capacity) {
+    return;
+  }
+
+  std::shared_ptr<const RawBlock> cachedBlock = std::make_shared<RawBlock>(rawBlock);
+
+  std::unique_lock<std::mutex> lock(mutex);
+  auto it = entries.find(blockIndex);
+  if (it != entries.end()) {
+    erase(it);
+  }
+
+  while (size + blockSize > capacity) {
+    erase(entries.find(recentlyUsed.back()));
+  }
+
+  recentlyUsed.push_front(blockIndex);
+  entries.emplace(blockIndex, Entry{ blockHash, std::move(cachedBlock), nullptr, blockSize, recentlyUsed.begin() });
+  blockIndexes[blockHash] = blockIndex;
+  size += blockSize;
+}
+
+void RawBlockCache::insertTemplate(uint32_t blockIndex, const BlockTemplate& blockTemplate) {
+  if (capacity == 0) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex);
+  auto it = entries.find(blockIndex);
+  if (it != entries.end()) {
+    it->second.blockTemplate = std::make_shared<BlockTemplate>(blockTemplate);
+  }
+}
+
+void RawBlockCache::removeFrom(uint32_t blockIndex) {
+  std::unique_lock<std::mutex> lock(mutex);
+  auto it = entries.lower_bound(blockIndex);
+  while (it != entries.end()) {
+    erase(it++);
+  }
+}
+
+void RawBlockCache::clear() {
+  std::unique_lock<std::mutex> lock(mutex);
+  entries.clear();
+  blockIndexes.clear();
+  recentlyUsed.clear();
+  size = 0;
+}
+
+size_t RawBlockCache::getCapacity() const {
+  return capacity;
+}
+
+size_t RawBlockCache::getSize() const {
+  std::unique_lock<std::mutex> lock(mutex);
+  return size;
+}
+
+uint64_t RawBlockCache::getHitsCount() const {
+  return hitsCount.load();
+}
+
+uint64_t RawBlockCache::getMissesCount() const {
+  return missesCount.load();
+}
+
+RawBlockCache::EntryIterator RawBlockCache::findEntry(uint32_t blockIndex) {
+  auto it = entries.find(blockIndex);
+  if (it == entries.end()) {
+    ++missesCount;
+    return it;
+  }
+
+  recentlyUsed.splice(recentlyUsed.begin(), recentlyUsed, it->second.recentlyUsedIt);
+  ++hitsCount;
+  return it;
+}
+
+void RawBlockCache::erase(EntryIterator it) {
+  size -= it->second.size;
+  blockIndexes.erase(it->second.blockHash);
+  recentlyUsed.erase(it->second.recentlyUsedIt);
+  entries.erase(it);
+}
+
+}
@@ -0,0 +1,85 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "CryptoNoteCore/CryptoNoteBasic.h"
+#include "crypto/hash.h"
+
+namespace CryptoNote {
+
+// Bounded LRU cache of main chain blocks recently read to serve peers and RPC clients, along with their decoded templates.
+// A block is found by its hash or by its index in the main chain. A block never changes, only the index it is found by does,
+// so blocks from the split index on are removed when the main chain is switched.
+class RawBlockCache {
+public:
+  // capacity is the total size of cached blocks in bytes, 0 disables the cache
+  explicit RawBlockCache(size_t capacity);
+
+  RawBlockCache(const RawBlockCache&) = delete;
+  RawBlockCache& operator=(const RawBlockCache&) = delete;
+
+  // Only lookups by index count misses, callers fall back to them before reading a block from storage
+  std::shared_ptr<const RawBlock> find(uint32_t blockIndex);
+  std::shared_ptr<const RawBlock> find(const Crypto::Hash& blockHash);
+  std::shared_ptr<const BlockTemplate> findTemplate(uint32_t blockIndex);
+
+  void insert(uint32_t blockIndex, const Crypto::Hash& blockHash, const RawBlock& rawBlock);
+  // The template is kept only while its block is cached
+  void insertTemplate(uint32_t blockIndex, const BlockTemplate& blockTemplate);
+
+  void removeFrom(uint32_t blockIndex);
+  void clear();
+
+  size_t getCapacity() const;
+  size_t getSize() const;
+  uint64_t getHitsCount() const;
+  uint64_t getMissesCount() const;
+
+private:
+  struct Entry {
+    Crypto::Hash blockHash;
+    std::shared_ptr<const RawBlock> rawBlock;
+    std::shared_ptr<const BlockTemplate> blockTemplate;
+    size_t size;
+    std::list<uint32_t>::iterator recentlyUsedIt;
+  };
+
+  typedef std::map<uint32_t, Entry>::iterator EntryIterator;
+
+  EntryIterator findEntry(uint32_t blockIndex);
+  void erase(EntryIterator it);
+
+  const size_t capacity;
+  mutable std::mutex mutex;
+  size_t size;
+  std::map<uint32_t, Entry> entries;
+  std::unordered_map<Crypto::Hash, uint32_t> blockIndexes;
+  std::list<uint32_t> recentlyUsed;
+  std::atomic<uint64_t> hitsCount;
+  std::atomic<uint64_t> missesCount;
+};
+
+}
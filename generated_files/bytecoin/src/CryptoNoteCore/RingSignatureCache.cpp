@@ -0,0 +1,122 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "RingSignatureCache.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "crypto/hash.h"
+
+namespace CryptoNote {
+
+RingSignatureCache::RingSignatureCache(size_t capacity) : capacity(capacity), hitsCount(0), missesCount(0) {
+}
+
+bool RingSignatureCache::contains(const RingSignatureCheck& check) {
+  if (capacity == 0) {
+    return false;
+  }
+
+  auto hash = getCheckHash(check);
+
+  std::unique_lock<std::mutex> lock(mutex);
+  auto it = entries.find(hash);
+  if (it == entries.end()) {
+    ++missesCount;
+    return false;
+  }
+
+  recentlyUsed.splice(recentlyUsed.begin(), recentlyUsed, it->second);
+  ++hitsCount;
+  return true;
+}
+
+void RingSignatureCache::insert(const RingSignatureCheck& check) {
+  if (capacity == 0) {
+    return;
+  }
+
+  auto hash = getCheckHash(check);
+
+  std::unique_lock<std::mutex> lock(mutex);
+  auto it = entries.find(hash);
+  if (it != entries.end()) {
+    recentlyUsed.splice(recentlyUsed.begin(), recentlyUsed, it->second);
+    return;
+  }
+
+  if (entries.size() == capacity) {
+    entries.erase(recentlyUsed.back());
+    recentlyUsed.pop_back();
+  }
+
+  recentlyUsed.push_front(hash);
+  entries.emplace(hash, recentlyUsed.begin());
+}
+
+void RingSignatureCache::clear() {
+  std::unique_lock<std::mutex> lock(mutex);
+  entries.clear();
+  recentlyUsed.clear();
+}
+
+size_t RingSignatureCache::getCapacity() const {
+  return capacity;
+}
+
+size_t RingSignatureCache::getSize() const {
+  std::unique_lock<std::mutex> lock(mutex);
+  return entries.size();
+}
+
+uint64_t RingSignatureCache::getHitsCount() const {
+  return hitsCount.load();
+}
+
+uint64_t RingSignatureCache::getMissesCount() const {
+  return missesCount.load();
+}
+
+Crypto::Hash RingSignatureCache::getCheckHash(const RingSignatureCheck& check) {
+  assert(check.signatures != nullptr);
+
+  // Signatures aren't covered by the prefix hash, so they have to be hashed explicitly
+  std::vector<uint8_t> data(sizeof(check.prefixHash) + sizeof(uint64_t) + sizeof(check.keyImage) + 1 +
+                            check.outputKeys.size() * sizeof(Crypto::PublicKey) + check.signatures->size() * sizeof(Crypto::Signature));
+  uint8_t* p = data.data();
+  uint64_t inputIndex = check.inputIndex;
+  std::memcpy(p, &check.prefixHash, sizeof(check.prefixHash));
+  p += sizeof(check.prefixHash);
+  std::memcpy(p, &inputIndex, sizeof(inputIndex));
+  p += sizeof(inputIndex);
+  std::memcpy(p, &check.keyImage, sizeof(check.keyImage));
+  p += sizeof(check.keyImage);
+  *p++ = check.checkKeyImage ? 1 : 0;
+  if (!check.outputKeys.empty()) {
+    std::memcpy(p, check.outputKeys.data(), check.outputKeys.size() * sizeof(Crypto::PublicKey));
+    p += check.outputKeys.size() * sizeof(Crypto::PublicKey);
+  }
+
+  if (!check.signatures->empty()) {
+    std::memcpy(p, check.signatures->data(), check.signatures->size() * sizeof(Crypto::Signature));
+  }
+
+  return Crypto::cn_fast_hash(data.data(), data.size());
+}
+
+}
@@ -0,0 +1,61 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "RingSignatureVerifier.h"
+
+namespace CryptoNote {
+
+// Bounded LRU set of ring signatures that have already been checked successfully.
+// An entry is keyed by everything the check depends on: prefix hash, input index, key image, ring member keys and signatures.
+// Since the resolved ring members are a part of the key, an input whose ring resolves to other outputs after a reorg
+// simply misses the cache, so entries never have to be flushed on chain switch.
+class RingSignatureCache {
+public:
+  explicit RingSignatureCache(size_t capacity);
+
+  RingSignatureCache(const RingSignatureCache&) = delete;
+  RingSignatureCache& operator=(const RingSignatureCache&) = delete;
+
+  bool contains(const RingSignatureCheck& check);
+  void insert(const RingSignatureCheck& check);
+  void clear();
+
+  size_t getCapacity() const;
+  size_t getSize() const;
+  uint64_t getHitsCount() const;
+  uint64_t getMissesCount() const;
+
+private:
+  static Crypto::Hash getCheckHash(const RingSignatureCheck& check);
+
+  const size_t capacity;
+  mutable std::mutex mutex;
+  std::list<Crypto::Hash> recentlyUsed;
+  std::unordered_map<Crypto::Hash, std::list<Crypto::Hash>::iterator> entries;
+  std::atomic<uint64_t> hitsCount;
+  std::atomic<uint64_t> missesCount;
+};
+
+}
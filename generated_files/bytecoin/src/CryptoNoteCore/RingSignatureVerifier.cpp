@@ -0,0 +1,48 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "RingSignatureVerifier.h"
+
+#include <cassert>
+
+namespace CryptoNote {
+
+bool checkRingSignature(const RingSignatureCheck& check) {
+  assert(check.signatures != nullptr);
+
+  std::vector<const Crypto::PublicKey*> outputKeyPointers;
+  outputKeyPointers.reserve(check.outputKeys.size());
+  for (const auto& key : check.outputKeys) {
+    outputKeyPointers.push_back(&key);
+  }
+
+  return Crypto::check_ring_signature(check.prefixHash, check.keyImage, outputKeyPointers.data(), outputKeyPointers.size(),
+                                      check.signatures->data(), check.checkKeyImage);
+}
+
+RingSignatureVerifier::RingSignatureVerifier(size_t threadsCount) : workers(threadsCount) {
+}
+
+size_t RingSignatureVerifier::getThreadsCount() const {
+  return workers.getThreadsCount();
+}
+
+size_t RingSignatureVerifier::verify(const std::vector<RingSignatureCheck>& checks) {
+  return workers.run(checks.size(), [&checks](size_t index, size_t) { return checkRingSignature(checks[index]); });
+}
+
+}
@@ -0,0 +1,56 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "crypto/crypto.h"
+#include "WorkerPool.h"
+
+namespace CryptoNote {
+
+struct RingSignatureCheck {
+  Crypto::Hash prefixHash;
+  Crypto::KeyImage keyImage;
+  std::vector<Crypto::PublicKey> outputKeys;
+  const std::vector<Crypto::Signature>* signatures;
+  bool checkKeyImage;
+  size_t transactionIndex;
+  size_t inputIndex;
+};
+
+bool checkRingSignature(const RingSignatureCheck& check);
+
+// Verifies ring signatures of a whole block on a fixed pool of worker threads.
+// The calling thread takes part in verification, so threadsCount == 1 means plain serial checking.
+class RingSignatureVerifier {
+public:
+  explicit RingSignatureVerifier(size_t threadsCount);
+
+  size_t getThreadsCount() const;
+
+  // Returns index of the first failed check in submission order, or checks.size() if all signatures are valid.
+  // The result doesn't depend on the threads count or on scheduling.
+  size_t verify(const std::vector<RingSignatureCheck>& checks);
+
+private:
+  WorkerPool workers;
+};
+
+}
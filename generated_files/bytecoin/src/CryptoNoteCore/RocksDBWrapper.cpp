@@ -17,12 +17,18 @@
 
 #include "RocksDBWrapper.h"
 
+#include <algorithm>
+#include <cassert>
+
 #include "rocksdb/cache.h"
+#include "rocksdb/filter_policy.h"
 #include "rocksdb/table.h"
 #include "rocksdb/db.h"
+#include "rocksdb/env.h"
 #include "rocksdb/utilities/backupable_db.h"
 
 #include "DataBaseErrors.h"
+#include "DBUtils.h"
 
 using namespace CryptoNote;
 using namespace Logging;
@@ -30,9 +36,94 @@ using namespace Logging;
 namespace {
   const std::string DB_NAME = "DB";
   const std::string TESTNET_DB_NAME = "testnet_DB";
+
+  // Written to the default family once all indexes are in their own families
+  const std::string COLUMN_FAMILIES_LAYOUT_KEY = "column_families_layout";
+  const size_t MIGRATION_BATCH_SIZE = 16 * 1024 * 1024;
+  // RocksDB batch starts with sequence number and count, each record has a tag, a family id and sizes of key and value
+  const size_t WRITE_BATCH_HEADER_SIZE = 12;
+  const size_t WRITE_BATCH_RECORD_OVERHEAD = 16;
+
+  rocksdb::CompressionType getCompressionType(DataBaseCompression compression) {
+    switch (compression) {
+    case DataBaseCompression::NONE:
+      return rocksdb::kNoCompression;
+    case DataBaseCompression::SNAPPY:
+      return rocksdb::kSnappyCompression;
+    case DataBaseCompression::ZLIB:
+      return rocksdb::kZlibCompression;
+    case DataBaseCompression::BZIP2:
+      return rocksdb::kBZip2Compression;
+    case DataBaseCompression::LZ4:
+      return rocksdb::kLZ4Compression;
+    case DataBaseCompression::LZ4HC:
+      return rocksdb::kLZ4HCCompression;
+    }
+
+    assert(false);
+    return rocksdb::kNoCompression;
+  }
+
+  struct ColumnFamilyInfo {
+    std::string name;
+    std::string prefix;
+    DataBaseAccessPattern pattern;
+  };
+
+  const ColumnFamilyInfo COLUMN_FAMILIES[] = {
+    { "block_key_images", DB::BLOCK_INDEX_TO_KEY_IMAGE_PREFIX, DataBaseAccessPattern::RECORDS },
+    { "block_transaction_hashes", DB::BLOCK_INDEX_TO_TX_HASHES_PREFIX, DataBaseAccessPattern::RECORDS },
+    { "block_transaction_infos", DB::BLOCK_INDEX_TO_TRANSACTION_INFO_PREFIX, DataBaseAccessPattern::BLOBS },
+    { "raw_blocks", DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX, DataBaseAccessPattern::BLOBS },
+    { "block_indexes", DB::BLOCK_HASH_TO_BLOCK_INDEX_PREFIX, DataBaseAccessPattern::LOOKUPS },
+    { "block_infos", DB::BLOCK_INDEX_TO_BLOCK_INFO_PREFIX, DataBaseAccessPattern::RECORDS },
+    { "key_images", DB::KEY_IMAGE_TO_BLOCK_INDEX_PREFIX, DataBaseAccessPattern::LOOKUPS },
+    { "block_hashes", DB::BLOCK_INDEX_TO_BLOCK_HASH_PREFIX, DataBaseAccessPattern::RECORDS },
+    { "transactions", DB::TRANSACTION_HASH_TO_TRANSACTION_INFO_PREFIX, DataBaseAccessPattern::LOOKUPS },
+    { "key_output_amounts", DB::KEY_OUTPUT_AMOUNT_PREFIX, DataBaseAccessPattern::RECORDS },
+    { "closest_timestamp_blocks", DB::CLOSEST_TIMESTAMP_BLOCK_INDEX_PREFIX, DataBaseAccessPattern::RECORDS },
+    { "payment_ids", DB::PAYMENT_ID_TO_TX_HASH_PREFIX, DataBaseAccessPattern::LOOKUPS },
+    { "timestamp_blocks", DB::TIMESTAMP_TO_BLOCKHASHES_PREFIX, DataBaseAccessPattern::RECORDS },
+    { "key_output_amounts_count", DB::KEY_OUTPUT_AMOUNTS_COUNT_PREFIX, DataBaseAccessPattern::RECORDS },
+    { "key_outputs", DB::KEY_OUTPUT_KEY_PREFIX, DataBaseAccessPattern::RECORDS },
+    { "accounts", DB::ACCOUNT_NUMBER_TO_ACCOUNT_INFO_PREFIX, DataBaseAccessPattern::LOOKUPS }
+  };
 }
 
-RocksDBWrapper::RocksDBWrapper(Logging::ILogger& logger) : logger(logger, "RocksDBWrapper"), state(NOT_INITIALIZED){
+// Copies share the RocksDB snapshot, it's released with the last of them
+class RocksDBWrapper::Snapshot : public IDataBase {
+public:
+  explicit Snapshot(RocksDBWrapper& database) : database(database),
+    snapshot(database.db->GetSnapshot(), [&database](const rocksdb::Snapshot* snapshot) { database.db->ReleaseSnapshot(snapshot); }) {
+  }
+
+  std::error_code write(IWriteBatch& batch) override {
+    return make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR);
+  }
+
+  std::error_code writeSync(IWriteBatch& batch) override {
+    return make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR);
+  }
+
+  std::error_code flush() override {
+    return std::error_code();
+  }
+
+  std::error_code read(IReadBatch& batch) override {
+    return database.read(batch, snapshot.get());
+  }
+
+  std::unique_ptr<IDataBase> createSnapshot() override {
+    return std::unique_ptr<IDataBase>(new Snapshot(*this));
+  }
+
+private:
+  RocksDBWrapper& database;
+  std::shared_ptr<const rocksdb::Snapshot> snapshot;
+};
+
+RocksDBWrapper::RocksDBWrapper(Logging::ILogger& logger) : logger(logger, "RocksDBWrapper"), writeGroupSize(1), writeGroupMaxDataSize(0),
+  writeGroupWritesCount(0), state(NOT_INITIALIZED){
 
 }
 
@@ -40,6 +131,32 @@ RocksDBWrapper::~RocksDBWrapper() {
 
 }
 
+bool RocksDBWrapper::isCompressionSupported(DataBaseCompression compression) {
+  // RocksDB checks codecs of its build when a DB is opened, a DB in memory is enough for it
+  static const std::vector<bool> supported = [] {
+    std::unique_ptr<rocksdb::Env> env(rocksdb::NewMemEnv(rocksdb::Env::Default()));
+    std::vector<bool> result;
+    for (uint8_t i = 0; i < DATA_BASE_COMPRESSIONS_COUNT; ++i) {
+      rocksdb::Options options;
+      options.env = env.get();
+      options.create_if_missing = true;
+      options.compression = getCompressionType(static_cast<DataBaseCompression>(i));
+
+      rocksdb::DB* dbPtr;
+      rocksdb::Status status = rocksdb::DB::Open(options, "/compression_" + std::to_string(i), &dbPtr);
+      if (status.ok()) {
+        delete dbPtr;
+      }
+
+      result.push_back(status.ok());
+    }
+
+    return result;
+  }();
+
+  return supported[static_cast<size_t>(compression)];
+}
+
 void RocksDBWrapper::init(const DataBaseConfig& config) {
   if (state.load() != NOT_INITIALIZED) {
     throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::ALREADY_INITIALIZED));
@@ -49,29 +166,48 @@ void RocksDBWrapper::init(const DataBaseConfig& config) {
 
   logger(INFO) << "Opening DB in " << dataDir;
 
-  rocksdb::DB* dbPtr;
+  rocksdb::DBOptions dbOptions = getDBOptions(config);
+  dbOptions.create_missing_column_families = true;
 
-  rocksdb::Options dbOptions = getDBOptions(config);
-  rocksdb::Status status = rocksdb::DB::Open(dbOptions, dataDir, &dbPtr);
-  if (status.ok()) {
-    logger(INFO) << "DB opened in " << dataDir;
-  } else if (!status.ok() && status.IsInvalidArgument()) {
+  std::vector<std::string> existingFamilies;
+  bool created = false;
+  rocksdb::Status status = rocksdb::DB::ListColumnFamilies(dbOptions, dataDir, &existingFamilies);
+  if (!status.ok()) {
     logger(INFO) << "DB not found in " << dataDir << ". Creating new DB...";
     dbOptions.create_if_missing = true;
-    rocksdb::Status status = rocksdb::DB::Open(dbOptions, dataDir, &dbPtr);
-    if (!status.ok()) {
-      logger(ERROR) << "DB Error. DB can't be created in " << dataDir << ". Error: " << status.ToString();
-      throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR));
-    }
+    created = true;
+  }
+
+  rocksdb::DB* dbPtr;
+  std::vector<rocksdb::ColumnFamilyHandle*> handles;
+  status = rocksdb::DB::Open(dbOptions, dataDir, getColumnFamilyDescriptors(config, existingFamilies), &handles, &dbPtr);
+  if (status.ok()) {
+    logger(INFO) << "DB opened in " << dataDir;
   } else if (status.IsIOError()) {
     logger(ERROR) << "DB Error. DB can't be opened in " << dataDir << ". Error: " << status.ToString();
     throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::IO_ERROR));
   } else {
-    logger(ERROR) << "DB Error. DB can't be opened in " << dataDir << ". Error: " << status.ToString();
+    logger(ERROR) << "DB Error. DB can't be " << (created ? "created" : "opened") << " in " << dataDir << ". Error: " << status.ToString();
     throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR));
   }
 
   db.reset(dbPtr);
+  columnFamilies = std::move(handles);
+  prefixColumnFamilies.fill(columnFamilies[0]);
+  for (size_t i = 0; i < sizeof(COLUMN_FAMILIES) / sizeof(COLUMN_FAMILIES[0]); ++i) {
+    prefixColumnFamilies[static_cast<uint8_t>(COLUMN_FAMILIES[i].prefix[0])] = columnFamilies[i + 1];
+  }
+
+  // DB of the single family layout has all indexes in the default family, written by an older DB scheme
+  if (!isMigratedToColumnFamilies()) {
+    migrateToColumnFamilies();
+  }
+
+  writeGroupSize = std::max<uint32_t>(config.getWriteGroupSize(), 1);
+  // a group must fit the memtables it is written to
+  writeGroupMaxDataSize = config.getWriteBufferSize() / 8;
+  clearWriteGroup();
+
   state.store(INITIALIZED);
 }
 
@@ -81,8 +217,23 @@ void RocksDBWrapper::shutdown() {
   }
 
   logger(INFO) << "Closing DB.";
-  db->Flush(rocksdb::FlushOptions());
+  {
+    std::lock_guard<std::mutex> lock(writeGroupMutex);
+    if (commitWriteGroup(true)) {
+      logger(ERROR) << "Writes of the last blocks are lost, they are added again from blockchain storage.";
+    }
+  }
+
+  for (rocksdb::ColumnFamilyHandle* columnFamily : columnFamilies) {
+    db->Flush(rocksdb::FlushOptions(), columnFamily);
+  }
+
   db->SyncWAL();
+  for (rocksdb::ColumnFamilyHandle* columnFamily : columnFamilies) {
+    delete columnFamily;
+  }
+
+  columnFamilies.clear();
   db.reset();
   state.store(NOT_INITIALIZED);
 }
@@ -96,7 +247,7 @@ void RocksDBWrapper::destoy(const DataBaseConfig& config) {
 
   logger(WARNING) << "Destroying DB in " << dataDir;
 
-  rocksdb::Options dbOptions = getDBOptions(config);
+  rocksdb::Options dbOptions(getDBOptions(config), rocksdb::ColumnFamilyOptions());
   rocksdb::Status status = rocksdb::DestroyDB(dataDir, dbOptions);
 
   if (status.ok()) {
@@ -123,23 +274,106 @@ std::error_code RocksDBWrapper::writeSync(IWriteBatch& batch) {
   return write(batch, true);
 }
 
-std::error_code RocksDBWrapper::write(IWriteBatch& batch, bool sync) {
-  rocksdb::WriteOptions writeOptions;
-  writeOptions.sync = sync;
+std::error_code RocksDBWrapper::flush() {
+  if (state.load() != INITIALIZED) {
+    throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::NOT_INITIALIZED));
+  }
+
+  std::lock_guard<std::mutex> lock(writeGroupMutex);
+  return commitWriteGroup(false);
+}
 
-  rocksdb::WriteBatch rocksdbBatch;
+std::error_code RocksDBWrapper::write(IWriteBatch& batch, bool sync) {
   std::vector<std::pair<std::string, std::string>> rawData(batch.extractRawDataToInsert());
+  std::vector<std::string> rawKeys(batch.extractRawKeysToRemove());
+
+  // RocksDB batch is the WAL record, the pairs are appended to it once. Sized up front, it isn't copied as it grows
+  size_t dataSize = WRITE_BATCH_HEADER_SIZE;
   for (const std::pair<std::string, std::string>& kvPair : rawData) {
-    rocksdbBatch.Put(rocksdb::Slice(kvPair.first), rocksdb::Slice(kvPair.second));
+    dataSize += kvPair.first.size() + kvPair.second.size() + WRITE_BATCH_RECORD_OVERHEAD;
   }
 
-  std::vector<std::string> rawKeys(batch.extractRawKeysToRemove());
   for (const std::string& key : rawKeys) {
-    rocksdbBatch.Delete(rocksdb::Slice(key));
+    dataSize += key.size() + WRITE_BATCH_RECORD_OVERHEAD;
   }
 
-  rocksdb::Status status = db->Write(writeOptions, &rocksdbBatch);
+  std::lock_guard<std::mutex> lock(writeGroupMutex);
+  if (writeGroupWritesCount == 0 && (sync || writeGroupSize == 1)) {
+    rocksdb::WriteBatch rocksdbBatch(dataSize);
+    for (const std::pair<std::string, std::string>& kvPair : rawData) {
+      rocksdbBatch.Put(getColumnFamily(kvPair.first), rocksdb::Slice(kvPair.first), rocksdb::Slice(kvPair.second));
+    }
+
+    for (const std::string& key : rawKeys) {
+      rocksdbBatch.Delete(getColumnFamily(key), rocksdb::Slice(key));
+    }
+
+    return write(rocksdbBatch, sync);
+  }
+
+  // A group holds only whole writes, so the DB is left at the end of a write, a block, by a crash.
+  // The write that fills the group is committed with it or left out of it if the commit fails
+  bool commit = sync || writeGroupWritesCount + 1 >= writeGroupSize || writeGroupBatch.GetDataSize() + dataSize >= writeGroupMaxDataSize;
+  if (commit) {
+    writeGroupBatch.SetSavePoint();
+  }
+
+  for (const std::pair<std::string, std::string>& kvPair : rawData) {
+    writeGroupBatch.Put(getColumnFamily(kvPair.first), rocksdb::Slice(kvPair.first), rocksdb::Slice(kvPair.second));
+  }
+
+  for (const std::string& key : rawKeys) {
+    writeGroupBatch.Delete(getColumnFamily(key), rocksdb::Slice(key));
+  }
+
+  if (commit) {
+    std::error_code error = write(writeGroupBatch, sync);
+    if (error) {
+      writeGroupBatch.RollbackToSavePoint();
+      return error;
+    }
+
+    clearWriteGroup();
+    return std::error_code();
+  }
+
+  for (std::pair<std::string, std::string>& kvPair : rawData) {
+    writeGroupValues[std::move(kvPair.first)] = std::move(kvPair.second);
+  }
+
+  for (std::string& key : rawKeys) {
+    writeGroupValues[std::move(key)] = boost::none;
+  }
+
+  ++writeGroupWritesCount;
+  return std::error_code();
+}
+
+std::error_code RocksDBWrapper::commitWriteGroup(bool sync) {
+  if (writeGroupWritesCount == 0) {
+    return std::error_code();
+  }
+
+  std::error_code error = write(writeGroupBatch, sync);
+  if (!error) {
+    clearWriteGroup();
+  }
 
+  return error;
+}
+
+void RocksDBWrapper::clearWriteGroup() {
+  // the batch keeps its buffer for the next group
+  writeGroupBatch.Clear();
+  writeGroupValues.clear();
+  writeGroupWritesCount = 0;
+}
+
+std::error_code RocksDBWrapper::write(rocksdb::WriteBatch& rocksdbBatch, bool sync) {
+  rocksdb::WriteOptions writeOptions;
+  writeOptions.sync = sync;
+
+  rocksdb::Status status = db->Write(writeOptions, &rocksdbBatch);
   if (!status.ok()) {
     logger(ERROR) << "Can't write to DB. " << status.ToString();
     return make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR);
@@ -153,18 +387,43 @@ std::error_code RocksDBWrapper::read(IReadBatch& batch) {
     throw std::runtime_error("Not initialized.");
   }
 
+  return read(batch, nullptr);
+}
+
+std::unique_ptr<IDataBase> RocksDBWrapper::createSnapshot() {
+  if (state.load() != INITIALIZED) {
+    throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::NOT_INITIALIZED));
+  }
+
+  // the snapshot has every write made before it
+  std::lock_guard<std::mutex> lock(writeGroupMutex);
+  std::error_code error = commitWriteGroup(false);
+  if (error) {
+    throw std::system_error(error);
+  }
+
+  return std::unique_ptr<IDataBase>(new Snapshot(*this));
+}
+
+std::error_code RocksDBWrapper::read(IReadBatch& batch, const rocksdb::Snapshot* snapshot) {
   rocksdb::ReadOptions readOptions;
+  readOptions.snapshot = snapshot;
 
   std::vector<std::string> rawKeys(batch.getRawKeys());
   std::vector<rocksdb::Slice> keySlices;
+  std::vector<rocksdb::ColumnFamilyHandle*> keyColumnFamilies;
   keySlices.reserve(rawKeys.size());
+  keyColumnFamilies.reserve(rawKeys.size());
   for (const std::string& key : rawKeys) {
     keySlices.emplace_back(rocksdb::Slice(key));
+    keyColumnFamilies.push_back(getColumnFamily(key));
   }
 
   std::vector<std::string> values;
   values.reserve(rawKeys.size());
-  std::vector<rocksdb::Status> statuses = db->MultiGet(readOptions, keySlices, &values);
+  // a snapshot is taken after the open group is committed, it has all the writes
+  std::vector<rocksdb::Status> statuses = snapshot != nullptr ? db->MultiGet(readOptions, keyColumnFamilies, keySlices, &values) :
+    getFromWriteGroupAndDB(readOptions, keyColumnFamilies, keySlices, values);
 
   std::error_code error;
   std::vector<bool> resultStates;
@@ -179,14 +438,69 @@ std::error_code RocksDBWrapper::read(IReadBatch& batch) {
   return std::error_code();
 }
 
-rocksdb::Options RocksDBWrapper::getDBOptions(const DataBaseConfig& config) {
+std::vector<rocksdb::Status> RocksDBWrapper::getFromWriteGroupAndDB(const rocksdb::ReadOptions& readOptions,
+  const std::vector<rocksdb::ColumnFamilyHandle*>& keyColumnFamilies, const std::vector<rocksdb::Slice>& keySlices, std::vector<std::string>& values) {
+  std::unique_lock<std::mutex> lock(writeGroupMutex);
+  if (writeGroupWritesCount == 0) {
+    lock.unlock();
+    return db->MultiGet(readOptions, keyColumnFamilies, keySlices, &values);
+  }
+
+  values.resize(keySlices.size());
+  std::vector<rocksdb::Status> statuses(keySlices.size());
+  std::vector<size_t> dbKeyIndexes;
+  for (size_t i = 0; i < keySlices.size(); ++i) {
+    auto it = writeGroupValues.find(keySlices[i].ToString());
+    if (it == writeGroupValues.end()) {
+      dbKeyIndexes.push_back(i);
+    } else if (it->second) {
+      values[i] = *it->second;
+    } else {
+      statuses[i] = rocksdb::Status::NotFound();
+    }
+  }
+
+  lock.unlock();
+  if (dbKeyIndexes.empty()) {
+    return statuses;
+  }
+
+  std::vector<rocksdb::ColumnFamilyHandle*> dbKeyColumnFamilies;
+  std::vector<rocksdb::Slice> dbKeySlices;
+  for (size_t i : dbKeyIndexes) {
+    dbKeyColumnFamilies.push_back(keyColumnFamilies[i]);
+    dbKeySlices.push_back(keySlices[i]);
+  }
+
+  std::vector<std::string> dbValues;
+  std::vector<rocksdb::Status> dbStatuses = db->MultiGet(readOptions, dbKeyColumnFamilies, dbKeySlices, &dbValues);
+  for (size_t i = 0; i < dbKeyIndexes.size(); ++i) {
+    values[dbKeyIndexes[i]] = std::move(dbValues[i]);
+    statuses[dbKeyIndexes[i]] = dbStatuses[i];
+  }
+
+  return statuses;
+}
+
+rocksdb::DBOptions RocksDBWrapper::getDBOptions(const DataBaseConfig& config) {
   rocksdb::DBOptions dbOptions;
   dbOptions.IncreaseParallelism(config.getBackgroundThreadsCount());
   dbOptions.info_log_level = rocksdb::InfoLogLevel::WARN_LEVEL;
   dbOptions.max_open_files = config.getMaxOpenFiles();
+  // memtables of all families share the write buffer budget
+  dbOptions.db_write_buffer_size = static_cast<size_t>(config.getWriteBufferSize()) * 2;
+
+  return dbOptions;
+}
+
+rocksdb::ColumnFamilyOptions RocksDBWrapper::getColumnFamilyOptions(const DataBaseConfig& config, DataBaseAccessPattern pattern,
+  uint32_t bloomFilterBitsPerKey, const std::shared_ptr<rocksdb::Cache>& readCache) {
+  const DataBaseColumnFamilyConfig& familyConfig = config.getColumnFamilyConfig(pattern);
+  // blobs take the most of writes
+  uint64_t writeBufferSize = pattern == DataBaseAccessPattern::BLOBS ? config.getWriteBufferSize() / 2 : config.getWriteBufferSize() / 8;
 
   rocksdb::ColumnFamilyOptions fOptions;
-  fOptions.write_buffer_size = static_cast<size_t>(config.getWriteBufferSize());
+  fOptions.write_buffer_size = static_cast<size_t>(writeBufferSize);
   // merge two memtables when flushing to L0
   fOptions.min_write_buffer_number_to_merge = 2;
   // this means we'll use 50% extra memory in the worst case, but will reduce
@@ -201,25 +515,86 @@ rocksdb::Options RocksDBWrapper::getDBOptions(const DataBaseConfig& config) {
   fOptions.level0_stop_writes_trigger = 40;
 
   // doesn't really matter much, but we don't want to create too many files
-  fOptions.target_file_size_base = config.getWriteBufferSize() / 10;
+  fOptions.target_file_size_base = writeBufferSize / 10;
   // make Level1 size equal to Level0 size, so that L0->L1 compactions are fast
-  fOptions.max_bytes_for_level_base = config.getWriteBufferSize();
+  fOptions.max_bytes_for_level_base = writeBufferSize;
   fOptions.num_levels = 10;
   fOptions.target_file_size_multiplier = 2;
-  // level style compaction
-  fOptions.compaction_style = rocksdb::kCompactionStyleLevel;
+  fOptions.compaction_style = familyConfig.universalCompaction ? rocksdb::kCompactionStyleUniversal : rocksdb::kCompactionStyleLevel;
 
+  // the last configured compression goes down to all deeper levels
+  const std::vector<DataBaseCompression>& compressionPerLevel = familyConfig.compressionPerLevel;
+  assert(!compressionPerLevel.empty());
   fOptions.compression_per_level.resize(fOptions.num_levels);
   for (int i = 0; i < fOptions.num_levels; ++i) {
-    fOptions.compression_per_level[i] = rocksdb::kNoCompression;
+    size_t configLevel = std::min(static_cast<size_t>(i), compressionPerLevel.size() - 1);
+    fOptions.compression_per_level[i] = getCompressionType(compressionPerLevel[configLevel]);
   }
 
+  // universal compaction doesn't use levels beyond L0
+  fOptions.compression = getCompressionType(compressionPerLevel.back());
+
   rocksdb::BlockBasedTableOptions tableOptions;
-  tableOptions.block_cache = rocksdb::NewLRUCache(config.getReadCacheSize());
+  tableOptions.block_size = static_cast<size_t>(familyConfig.blockSize);
+  if (readCache) {
+    tableOptions.block_cache = readCache;
+  } else {
+    tableOptions.no_block_cache = true;
+  }
+
+  if (bloomFilterBitsPerKey != 0) {
+    // full filters over whole keys, no index is looked up by a key prefix
+    tableOptions.filter_policy.reset(rocksdb::NewBloomFilterPolicy(bloomFilterBitsPerKey, false));
+    tableOptions.whole_key_filtering = true;
+    // lookups of the other patterns mostly hit, the last level filter isn't worth its memory
+    fOptions.optimize_filters_for_hits = pattern != DataBaseAccessPattern::LOOKUPS;
+  }
+
   std::shared_ptr<rocksdb::TableFactory> tfp(NewBlockBasedTableFactory(tableOptions));
   fOptions.table_factory = tfp;
 
-  return rocksdb::Options(dbOptions, fOptions);
+  return fOptions;
+}
+
+std::vector<rocksdb::ColumnFamilyDescriptor> RocksDBWrapper::getColumnFamilyDescriptors(const DataBaseConfig& config,
+  const std::vector<std::string>& existingFamilies) {
+  // every access pattern has its share of the read cache
+  std::shared_ptr<rocksdb::Cache> readCaches[static_cast<size_t>(DataBaseAccessPattern::COUNT)];
+  for (size_t i = 0; i < static_cast<size_t>(DataBaseAccessPattern::COUNT); ++i) {
+    uint64_t cacheSize = config.getReadCacheSize() * config.getColumnFamilyConfig(static_cast<DataBaseAccessPattern>(i)).readCacheShare / 100;
+    if (cacheSize != 0) {
+      readCaches[i] = rocksdb::NewLRUCache(static_cast<size_t>(cacheSize));
+    }
+  }
+
+  auto familyOptions = [&] (DataBaseAccessPattern pattern, uint32_t bloomFilterBitsPerKey) {
+    return getColumnFamilyOptions(config, pattern, bloomFilterBitsPerKey, readCaches[static_cast<size_t>(pattern)]);
+  };
+
+  auto recordsBloomFilterBitsPerKey = config.getColumnFamilyConfig(DataBaseAccessPattern::RECORDS).bloomFilterBitsPerKey;
+
+  std::vector<rocksdb::ColumnFamilyDescriptor> descriptors;
+  descriptors.emplace_back(rocksdb::kDefaultColumnFamilyName, familyOptions(DataBaseAccessPattern::RECORDS, recordsBloomFilterBitsPerKey));
+  for (const ColumnFamilyInfo& family : COLUMN_FAMILIES) {
+    // every input of every block and pool transaction is checked in the key images index, its filter is tuned on its own
+    uint32_t bloomFilterBitsPerKey = family.prefix == DB::KEY_IMAGE_TO_BLOCK_INDEX_PREFIX ?
+      config.getKeyImagesBloomFilterBitsPerKey() : config.getColumnFamilyConfig(family.pattern).bloomFilterBitsPerKey;
+    descriptors.emplace_back(family.name, familyOptions(family.pattern, bloomFilterBitsPerKey));
+  }
+
+  // all existing families have to be opened
+  for (const std::string& name : existingFamilies) {
+    auto it = std::find_if(descriptors.begin(), descriptors.end(), [&name] (const rocksdb::ColumnFamilyDescriptor& descriptor) {
+      return descriptor.name == name;
+    });
+
+    if (it == descriptors.end()) {
+      logger(WARNING) << "Unknown DB column family " << name;
+      descriptors.emplace_back(name, familyOptions(DataBaseAccessPattern::RECORDS, recordsBloomFilterBitsPerKey));
+    }
+  }
+
+  return descriptors;
 }
 
 std::string RocksDBWrapper::getDataDir(const DataBaseConfig& config) {
@@ -229,3 +604,109 @@ std::string RocksDBWrapper::getDataDir(const DataBaseConfig& config) {
     return config.getDataDir() + '/' + DB_NAME;
   }
 }
+
+rocksdb::ColumnFamilyHandle* RocksDBWrapper::getColumnFamily(const std::string& rawKey) const {
+  return prefixColumnFamilies[static_cast<uint8_t>(DB::getKeyPrefix(rawKey))];
+}
+
+bool RocksDBWrapper::isMigratedToColumnFamilies() {
+  std::string value;
+  rocksdb::Status status = db->Get(rocksdb::ReadOptions(), columnFamilies[0], COLUMN_FAMILIES_LAYOUT_KEY, &value);
+  if (status.ok()) {
+    return true;
+  }
+
+  if (!status.IsNotFound()) {
+    logger(ERROR) << "DB Error. Can't read DB layout. Error: " << status.ToString();
+    throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR));
+  }
+
+  return false;
+}
+
+void RocksDBWrapper::migrateToColumnFamilies() {
+  rocksdb::ColumnFamilyHandle* defaultFamily = columnFamilies[0];
+
+  // the single family layout is older than the current DB scheme, its index records are converted on the way
+  uint32_t schemeVersion = 0;
+  std::string schemeVersionValue;
+  if (db->Get(rocksdb::ReadOptions(), defaultFamily, DB::SCHEME_VERSION_KEY, &schemeVersionValue).ok()) {
+    schemeVersion = static_cast<uint32_t>(std::atoi(schemeVersionValue.c_str()));
+  }
+
+  bool convertRecords = schemeVersion >= DB::FIRST_CONVERTIBLE_SCHEME_VERSION && schemeVersion < DB::SCHEME_VERSION;
+
+  // keys are moved in batches, each batch is atomic, so an interrupted migration continues on the next start
+  rocksdb::WriteBatch batch;
+  uint64_t movedCount = 0;
+  auto writeBatch = [&] (bool sync) {
+    rocksdb::WriteOptions writeOptions;
+    writeOptions.sync = sync;
+    rocksdb::Status status = db->Write(writeOptions, &batch);
+    if (!status.ok()) {
+      logger(ERROR) << "DB Error. Can't move DB indexes to column families. Error: " << status.ToString();
+      throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR));
+    }
+
+    batch.Clear();
+  };
+
+  std::vector<std::pair<std::string, std::string>> records;
+  std::unique_ptr<rocksdb::Iterator> it(db->NewIterator(rocksdb::ReadOptions(), defaultFamily));
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    std::string key = it->key().ToString();
+    records.clear();
+    if (convertRecords) {
+      try {
+        DB::convertRecord(schemeVersion, key, it->value().ToString(), records);
+      } catch (std::exception& e) {
+        logger(ERROR) << "DB Error. Can't convert DB scheme version " << schemeVersion << " record. Error: " << e.what();
+        throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR));
+      }
+    }
+
+    if (records.empty() && getColumnFamily(key) != defaultFamily) {
+      records.emplace_back(key, it->value().ToString());
+    }
+
+    if (records.empty()) {
+      continue;
+    }
+
+    if (movedCount == 0) {
+      logger(INFO) << "Moving DB indexes to column families, it can take a while...";
+    }
+
+    for (const auto& record : records) {
+      batch.Put(getColumnFamily(record.first), record.first, record.second);
+    }
+
+    batch.Delete(defaultFamily, it->key());
+    ++movedCount;
+
+    if (batch.GetDataSize() >= MIGRATION_BATCH_SIZE) {
+      writeBatch(false);
+      logger(INFO) << "Moved " << movedCount << " DB records";
+    }
+  }
+
+  if (!it->status().ok()) {
+    logger(ERROR) << "DB Error. Can't read DB indexes. Error: " << it->status().ToString();
+    throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR));
+  }
+
+  it.reset();
+
+  if (convertRecords) {
+    logger(INFO) << "DB scheme version " << schemeVersion << " converted to " << DB::SCHEME_VERSION;
+    batch.Put(defaultFamily, DB::SCHEME_VERSION_KEY, std::to_string(DB::SCHEME_VERSION));
+  }
+
+  batch.Put(defaultFamily, COLUMN_FAMILIES_LAYOUT_KEY, "1");
+  writeBatch(true);
+
+  if (movedCount != 0) {
+    logger(INFO) << "Moved " << movedCount << " DB records to column families, compacting";
+    db->CompactRange(rocksdb::CompactRangeOptions(), defaultFamily, nullptr, nullptr);
+  }
+}
@@ -17,11 +17,18 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/optional.hpp>
 
 #include "rocksdb/db.h"
+#include "rocksdb/write_batch.h"
 
 #include "IDataBase.h"
 #include "DataBaseConfig.h"
@@ -45,16 +52,39 @@ public:
   void shutdown();
   void destoy(const DataBaseConfig& config); //Be careful with this method!
 
+  // Whether the RocksDB build is linked with the codec
+  static bool isCompressionSupported(DataBaseCompression compression);
+
   std::error_code write(IWriteBatch& batch) override;
   std::error_code writeSync(IWriteBatch& batch) override;
+  std::error_code flush() override;
   std::error_code read(IReadBatch& batch) override;
+  std::unique_ptr<IDataBase> createSnapshot() override;
 
 private:
+  class Snapshot;
+
+  // Reads the given snapshot, or the DB with the writes of the open group if there's none
+  std::error_code read(IReadBatch& batch, const rocksdb::Snapshot* snapshot);
   std::error_code write(IWriteBatch& batch, bool sync);
+  std::error_code write(rocksdb::WriteBatch& rocksdbBatch, bool sync);
+  // Held writes stay in the group if the commit fails
+  std::error_code commitWriteGroup(bool sync);
+  void clearWriteGroup();
+  std::vector<rocksdb::Status> getFromWriteGroupAndDB(const rocksdb::ReadOptions& readOptions,
+    const std::vector<rocksdb::ColumnFamilyHandle*>& keyColumnFamilies, const std::vector<rocksdb::Slice>& keySlices, std::vector<std::string>& values);
 
-  rocksdb::Options getDBOptions(const DataBaseConfig& config);
+  rocksdb::DBOptions getDBOptions(const DataBaseConfig& config);
+  rocksdb::ColumnFamilyOptions getColumnFamilyOptions(const DataBaseConfig& config, DataBaseAccessPattern pattern,
+    uint32_t bloomFilterBitsPerKey, const std::shared_ptr<rocksdb::Cache>& readCache);
+  std::vector<rocksdb::ColumnFamilyDescriptor> getColumnFamilyDescriptors(const DataBaseConfig& config,
+    const std::vector<std::string>& existingFamilies);
   std::string getDataDir(const DataBaseConfig& config);
 
+  rocksdb::ColumnFamilyHandle* getColumnFamily(const std::string& rawKey) const;
+  bool isMigratedToColumnFamilies();
+  void migrateToColumnFamilies();
+
   enum State {
     NOT_INITIALIZED,
     INITIALIZED
@@ -62,6 +92,17 @@ private:
 
   Logging::LoggerRef logger;
   std::unique_ptr<rocksdb::DB> db;
+  // default family first, then families of the indexes
+  std::vector<rocksdb::ColumnFamilyHandle*> columnFamilies;
+  std::array<rocksdb::ColumnFamilyHandle*, 256> prefixColumnFamilies;
+  uint32_t writeGroupSize;
+  uint64_t writeGroupMaxDataSize;
+  // the held writes in order, whole writes only. It's the batch the group is committed with
+  rocksdb::WriteBatch writeGroupBatch;
+  // the last value written to each key of the open group, none for removed keys. Reads look keys up here before the DB
+  std::unordered_map<std::string, boost::optional<std::string>> writeGroupValues;
+  uint32_t writeGroupWritesCount;
+  std::mutex writeGroupMutex;
   std::atomic<State> state;
 };
 }
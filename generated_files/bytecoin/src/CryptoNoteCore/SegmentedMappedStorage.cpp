@@ -0,0 +1,290 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "SegmentedMappedStorage.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include <boost/filesystem.hpp>
+
+#include "crypto/hash.h"
+
+namespace CryptoNote {
+
+namespace {
+
+const uint32_t NO_DIRTY_SEGMENT = std::numeric_limits<uint32_t>::max();
+
+}
+
+const uint64_t SegmentedMappedStorage::DEFAULT_SEGMENT_SIZE;
+const uint64_t SegmentedMappedStorage::READAHEAD_SIZE;
+
+SegmentedMappedStorage::SegmentedMappedStorage() :
+  m_segmentSize(DEFAULT_SEGMENT_SIZE),
+  m_firstDirtySegment(NO_DIRTY_SEGMENT),
+  m_lastReadIndex(std::numeric_limits<uint64_t>::max()),
+  m_readaheadSegment(0),
+  m_readaheadEnd(0) {
+}
+
+SegmentedMappedStorage::~SegmentedMappedStorage() {
+  if (isOpened()) {
+    try {
+      close();
+    } catch (std::exception&) {
+    }
+  }
+}
+
+void SegmentedMappedStorage::open(const std::string& path, uint64_t segmentSize) {
+  assert(!isOpened());
+
+  if (segmentSize == 0 || segmentSize > std::numeric_limits<uint32_t>::max()) {
+    throw std::runtime_error("SegmentedMappedStorage::open() invalid segment size: " + std::to_string(segmentSize));
+  }
+
+  m_path = path;
+  m_segmentSize = segmentSize;
+  m_firstDirtySegment = NO_DIRTY_SEGMENT;
+  m_lastReadIndex = std::numeric_limits<uint64_t>::max();
+  m_readaheadEnd = 0;
+
+  m_index.open(indexPath(path), Common::FileMappedVectorOpenMode::OPEN_OR_CREATE, sizeof(uint64_t));
+  m_index.setAutoFlush(false);
+
+  uint64_t flushed = std::min(flushedCount(), m_index.size());
+  if (flushed != 0) {
+    for (uint32_t segment = 0; segment <= m_index[flushed - 1].segment; ++segment) {
+      if (!boost::filesystem::exists(segmentPath(m_path, segment))) {
+        throw std::runtime_error("SegmentedMappedStorage::open() segment file is missing: " + segmentPath(m_path, segment));
+      }
+
+      mapSegment(segment, 0);
+    }
+  }
+
+  recoverUnflushedItems();
+}
+
+void SegmentedMappedStorage::close() {
+  assert(isOpened());
+
+  flush();
+  for (auto& segment : m_segments) {
+    segment->close();
+  }
+
+  m_segments.clear();
+  m_index.close();
+}
+
+bool SegmentedMappedStorage::isOpened() const {
+  return m_index.isOpened();
+}
+
+bool SegmentedMappedStorage::exists(const std::string& path) {
+  return boost::filesystem::exists(indexPath(path)) || boost::filesystem::exists(indexPath(path) + ".bak");
+}
+
+void SegmentedMappedStorage::remove(const std::string& path) {
+  boost::filesystem::remove(indexPath(path));
+  boost::filesystem::remove(indexPath(path) + ".bak");
+  for (uint32_t segment = 0; boost::filesystem::exists(segmentPath(path, segment)); ++segment) {
+    boost::filesystem::remove(segmentPath(path, segment));
+  }
+}
+
+bool SegmentedMappedStorage::empty() const {
+  return m_index.empty();
+}
+
+uint64_t SegmentedMappedStorage::size() const {
+  return m_index.size();
+}
+
+Common::ArrayView<uint8_t> SegmentedMappedStorage::operator[](uint64_t index) const {
+  assert(index < size());
+
+  const ItemEntry& entry = m_index[index];
+  readahead(index, entry);
+  return Common::ArrayView<uint8_t>(m_segments[entry.segment]->data() + entry.offset, entry.size);
+}
+
+void SegmentedMappedStorage::push_back(Common::ArrayView<uint8_t> item) {
+  assert(isOpened());
+
+  ItemEntry entry;
+  if (m_index.empty()) {
+    entry.segment = 0;
+    entry.offset = 0;
+  } else {
+    const ItemEntry& last = m_index.back();
+    entry.segment = last.segment;
+    entry.offset = last.offset + last.size;
+  }
+
+  if (entry.offset != 0 && entry.offset + item.getSize() > m_segments[entry.segment]->size()) {
+    //segment is complete, the next one starts from a durable state
+    flush();
+    ++entry.segment;
+    entry.offset = 0;
+  }
+
+  System::MemoryMappedFile& file = mapSegment(entry.segment, entry.offset + item.getSize());
+  std::copy(item.getData(), item.getData() + item.getSize(), file.data() + entry.offset);
+
+  entry.size = static_cast<uint32_t>(item.getSize());
+  entry.checksum = checksum(item.getData(), item.getSize());
+  m_firstDirtySegment = std::min(m_firstDirtySegment, entry.segment);
+  m_index.push_back(entry);
+}
+
+void SegmentedMappedStorage::pop_back() {
+  assert(!empty());
+
+  m_index.pop_back();
+  if (flushedCount() > m_index.size()) {
+    //data of the popped items is overwritten by next items, they must be checked again after a crash
+    flushedCount() = m_index.size();
+    flushIndex();
+  }
+}
+
+void SegmentedMappedStorage::clear() {
+  assert(isOpened());
+
+  m_index.clear();
+  flushedCount() = 0;
+  flushIndex();
+
+  for (auto& segment : m_segments) {
+    segment->close();
+  }
+
+  m_segments.clear();
+  m_firstDirtySegment = NO_DIRTY_SEGMENT;
+  for (uint32_t segment = 0; boost::filesystem::exists(segmentPath(m_path, segment)); ++segment) {
+    boost::filesystem::remove(segmentPath(m_path, segment));
+  }
+}
+
+void SegmentedMappedStorage::flush() {
+  assert(isOpened());
+
+  for (uint32_t segment = m_firstDirtySegment; segment < m_segments.size(); ++segment) {
+    m_segments[segment]->flush(m_segments[segment]->data(), m_segments[segment]->size());
+  }
+
+  m_firstDirtySegment = NO_DIRTY_SEGMENT;
+
+  //items must be durable before they are marked as flushed
+  flushIndex();
+  flushedCount() = m_index.size();
+  flushIndex();
+}
+
+System::MemoryMappedFile& SegmentedMappedStorage::mapSegment(uint32_t segment, uint64_t minSize) {
+  assert(segment <= m_segments.size());
+
+  if (segment == m_segments.size()) {
+    std::unique_ptr<System::MemoryMappedFile> file(new System::MemoryMappedFile());
+    if (boost::filesystem::exists(segmentPath(m_path, segment))) {
+      file->open(segmentPath(m_path, segment));
+    }
+
+    m_segments.push_back(std::move(file));
+  }
+
+  System::MemoryMappedFile& file = *m_segments[segment];
+  if (!file.isOpened() || file.size() < minSize) {
+    //only the segment appended to is recreated, there are no items in it
+    file.create(segmentPath(m_path, segment), std::max(m_segmentSize, minSize), true);
+  }
+
+  return file;
+}
+
+bool SegmentedMappedStorage::isValid(const ItemEntry& entry) {
+  if (entry.segment > m_segments.size() ||
+    (entry.segment == m_segments.size() && !boost::filesystem::exists(segmentPath(m_path, entry.segment)))) {
+    return false;
+  }
+
+  System::MemoryMappedFile& file = mapSegment(entry.segment, 0);
+  if (static_cast<uint64_t>(entry.offset) + entry.size > file.size()) {
+    return false;
+  }
+
+  return checksum(file.data() + entry.offset, entry.size) == entry.checksum;
+}
+
+void SegmentedMappedStorage::recoverUnflushedItems() {
+  uint64_t validCount = std::min(flushedCount(), m_index.size());
+  while (validCount < m_index.size() && isValid(m_index[validCount])) {
+    ++validCount;
+  }
+
+  while (m_index.size() > validCount) {
+    m_index.pop_back();
+  }
+
+  flush();
+}
+
+void SegmentedMappedStorage::readahead(uint64_t index, const ItemEntry& entry) const {
+  bool sequential = index == m_lastReadIndex + 1;
+  m_lastReadIndex = index;
+  if (!sequential || (entry.segment == m_readaheadSegment && entry.offset + entry.size <= m_readaheadEnd)) {
+    return;
+  }
+
+  const System::MemoryMappedFile& file = *m_segments[entry.segment];
+  uint64_t readaheadSize = std::min(READAHEAD_SIZE, file.size() - entry.offset);
+  file.prefetch(file.data() + entry.offset, readaheadSize);
+  m_readaheadSegment = entry.segment;
+  m_readaheadEnd = entry.offset + readaheadSize;
+}
+
+uint64_t& SegmentedMappedStorage::flushedCount() {
+  return *reinterpret_cast<uint64_t*>(m_index.prefix());
+}
+
+void SegmentedMappedStorage::flushIndex() {
+  m_index.flush();
+}
+
+std::string SegmentedMappedStorage::indexPath(const std::string& path) {
+  return path + ".index";
+}
+
+std::string SegmentedMappedStorage::segmentPath(const std::string& path, uint32_t segment) {
+  std::string number = std::to_string(segment);
+  return path + "." + std::string(number.size() < 4 ? 4 - number.size() : 0, '0') + number;
+}
+
+uint32_t SegmentedMappedStorage::checksum(const uint8_t* data, uint64_t size) {
+  Crypto::Hash hash = Crypto::cn_fast_hash(data, static_cast<size_t>(size));
+  uint32_t result;
+  std::memcpy(&result, hash.data, sizeof(result));
+  return result;
+}
+
+}
@@ -0,0 +1,94 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Common/ArrayView.h"
+#include "Common/FileMappedVector.h"
+#include "System/MemoryMappedFile.h"
+
+namespace CryptoNote {
+
+// Append only storage of byte arrays in memory mapped segment files <path>.0000, <path>.0001, ...
+// Item locations are kept in <path>.index. Items appended since the last flush are checked against
+// their checksums on open, so a crash leaves the storage truncated to its last complete item.
+class SegmentedMappedStorage {
+public:
+  static const uint64_t DEFAULT_SEGMENT_SIZE = 64 * 1024 * 1024;
+  static const uint64_t READAHEAD_SIZE = 4 * 1024 * 1024;
+
+  SegmentedMappedStorage();
+  SegmentedMappedStorage(const SegmentedMappedStorage&) = delete;
+  SegmentedMappedStorage& operator=(const SegmentedMappedStorage&) = delete;
+  ~SegmentedMappedStorage();
+
+  void open(const std::string& path, uint64_t segmentSize = DEFAULT_SEGMENT_SIZE);
+  void close();
+  bool isOpened() const;
+
+  static bool exists(const std::string& path);
+  static void remove(const std::string& path);
+
+  bool empty() const;
+  uint64_t size() const;
+
+  // The view points to the mapped file and is valid until the storage is changed
+  Common::ArrayView<uint8_t> operator[](uint64_t index) const;
+
+  void push_back(Common::ArrayView<uint8_t> item);
+  void pop_back();
+  void clear();
+
+  // Makes all items durable
+  void flush();
+
+private:
+  struct ItemEntry {
+    uint32_t segment;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t checksum;
+  };
+
+  std::string m_path;
+  uint64_t m_segmentSize;
+  Common::FileMappedVector<ItemEntry> m_index;
+  std::vector<std::unique_ptr<System::MemoryMappedFile>> m_segments;
+  uint32_t m_firstDirtySegment;
+  mutable uint64_t m_lastReadIndex;
+  mutable uint32_t m_readaheadSegment;
+  mutable uint64_t m_readaheadEnd;
+
+  System::MemoryMappedFile& mapSegment(uint32_t segment, uint64_t minSize);
+  bool isValid(const ItemEntry& entry);
+  void recoverUnflushedItems();
+  void readahead(uint64_t index, const ItemEntry& entry) const;
+
+  uint64_t& flushedCount();
+  void flushIndex();
+
+  static std::string indexPath(const std::string& path);
+  static std::string segmentPath(const std::string& path, uint32_t segment);
+  static uint32_t checksum(const uint8_t* data, uint64_t size);
+};
+
+}
@@ -0,0 +1,81 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "SpentKeyImagesFilter.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace CryptoNote {
+
+namespace {
+
+// optimal for 8-12 bits per key image, that is 8-12 million key images per 10 MB of the filter
+const uint32_t HASH_FUNCTIONS_COUNT = 6;
+
+// key images are curve points of secret keys, their bytes are uniformly distributed
+// and are used as hashes, double hashing derives the rest of bit indexes
+void getHashes(const Crypto::KeyImage& keyImage, uint64_t& first, uint64_t& second) {
+  static_assert(sizeof(keyImage.data) >= 2 * sizeof(uint64_t), "Key image is too short to be split into two hashes");
+  std::memcpy(&first, keyImage.data, sizeof(first));
+  std::memcpy(&second, keyImage.data + sizeof(first), sizeof(second));
+  second |= 1;
+}
+
+}
+
+SpentKeyImagesFilter::SpentKeyImagesFilter(uint64_t size) : bits(std::max<uint64_t>(size / sizeof(uint64_t), 1), 0), keyImagesCount(0) {
+  bitsCount = bits.size() * sizeof(uint64_t) * 8;
+}
+
+void SpentKeyImagesFilter::add(const Crypto::KeyImage& keyImage) {
+  uint64_t hash;
+  uint64_t delta;
+  getHashes(keyImage, hash, delta);
+
+  for (uint32_t i = 0; i < HASH_FUNCTIONS_COUNT; ++i, hash += delta) {
+    uint64_t bit = hash % bitsCount;
+    bits[bit / 64] |= uint64_t(1) << (bit % 64);
+  }
+
+  ++keyImagesCount;
+}
+
+bool SpentKeyImagesFilter::mayContain(const Crypto::KeyImage& keyImage) const {
+  uint64_t hash;
+  uint64_t delta;
+  getHashes(keyImage, hash, delta);
+
+  for (uint32_t i = 0; i < HASH_FUNCTIONS_COUNT; ++i, hash += delta) {
+    uint64_t bit = hash % bitsCount;
+    if ((bits[bit / 64] & (uint64_t(1) << (bit % 64))) == 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+uint64_t SpentKeyImagesFilter::getSize() const {
+  return bits.size() * sizeof(uint64_t);
+}
+
+uint64_t SpentKeyImagesFilter::getKeyImagesCount() const {
+  return keyImagesCount;
+}
+
+}
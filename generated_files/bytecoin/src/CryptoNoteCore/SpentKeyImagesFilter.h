@@ -0,0 +1,46 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "crypto/crypto.h"
+
+namespace CryptoNote {
+
+// In-memory bloom filter of spent key images. A key image the filter doesn't contain is surely unspent,
+// so the most of spent checks are answered without reading the DB. Bits are never cleared: key images of
+// popped blocks stay in the filter as false positives, which only cost a DB read.
+class SpentKeyImagesFilter {
+public:
+  explicit SpentKeyImagesFilter(uint64_t size); //Bytes
+
+  void add(const Crypto::KeyImage& keyImage);
+  bool mayContain(const Crypto::KeyImage& keyImage) const;
+
+  uint64_t getSize() const; //Bytes
+  uint64_t getKeyImagesCount() const;
+
+private:
+  std::vector<uint64_t> bits;
+  uint64_t bitsCount;
+  uint64_t keyImagesCount;
+};
+
+}
@@ -49,6 +49,10 @@ const Crypto::Hash& TransactionPool::PendingTransactionInfo::getTransactionHash(
   return cachedTransaction.getTransactionHash();
 }
 
+size_t TransactionPool::PendingTransactionInfo::getTransactionSize() const {
+  return cachedTransaction.getTransactionBinaryArray().size();
+}
+
 size_t TransactionPool::PaymentIdHasher::operator() (const boost::optional<Crypto::Hash>& paymentId) const {
   if (!paymentId) {
     return std::numeric_limits<size_t>::max();
@@ -61,6 +65,7 @@ TransactionPool::TransactionPool(Logging::ILogger& logger) :
   transactionHashIndex(transactions.get<TransactionHashTag>()),
   transactionCostIndex(transactions.get<TransactionCostTag>()),
   paymentIdIndex(transactions.get<PaymentIdTag>()),
+  transactionSizeIndex(transactions.get<TransactionSizeTag>()),
   logger(logger, "TransactionPool") {
 }
 
@@ -141,6 +146,30 @@ std::vector<CachedTransaction> TransactionPool::getPoolTransactions() const {
   return result;
 }
 
+void TransactionPool::forEachTransaction(const std::function<bool(const CachedTransaction&)>& visitor) const {
+  for (auto it = transactionCostIndex.begin(); it != transactionCostIndex.end(); ++it) {
+    if (!visitor(it->cachedTransaction)) {
+      break;
+    }
+  }
+}
+
+void TransactionPool::forEachTransactionReversed(const std::function<bool(const CachedTransaction&)>& visitor) const {
+  for (auto it = transactionCostIndex.rbegin(); it != transactionCostIndex.rend(); ++it) {
+    if (!visitor(it->cachedTransaction)) {
+      break;
+    }
+  }
+}
+
+size_t TransactionPool::getMinTransactionSize() const {
+  if (transactionSizeIndex.empty()) {
+    return 0;
+  }
+
+  return transactionSizeIndex.begin()->getTransactionSize();
+}
+
 uint64_t TransactionPool::getTransactionReceiveTime(const Crypto::Hash& hash) const {
   auto it = transactionHashIndex.find(hash);
   assert(it != transactionHashIndex.end());
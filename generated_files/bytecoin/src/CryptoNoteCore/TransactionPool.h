@@ -48,6 +48,9 @@ public:
 
   virtual const TransactionValidatorState& getPoolTransactionValidationState() const override;
   virtual std::vector<CachedTransaction> getPoolTransactions() const override;
+  virtual void forEachTransaction(const std::function<bool(const CachedTransaction&)>& visitor) const override;
+  virtual void forEachTransactionReversed(const std::function<bool(const CachedTransaction&)>& visitor) const override;
+  virtual size_t getMinTransactionSize() const override;
 
   virtual uint64_t getTransactionReceiveTime(const Crypto::Hash& hash) const override;
   virtual std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const override;
@@ -60,6 +63,7 @@ private:
     boost::optional<Crypto::Hash> paymentId;
 
     const Crypto::Hash& getTransactionHash() const;
+    size_t getTransactionSize() const;
   };
 
   struct TransactionPriorityComparator {
@@ -70,6 +74,7 @@ private:
   struct TransactionHashTag {};
   struct TransactionCostTag {};
   struct PaymentIdTag {};
+  struct TransactionSizeTag {};
 
   typedef boost::multi_index::ordered_non_unique<
     boost::multi_index::tag<TransactionCostTag>,
@@ -96,12 +101,22 @@ private:
     PaymentIdHasher
   > PaymentIdIndex;
 
+  typedef boost::multi_index::ordered_non_unique<
+    boost::multi_index::tag<TransactionSizeTag>,
+    boost::multi_index::const_mem_fun<
+      PendingTransactionInfo,
+      size_t,
+      &PendingTransactionInfo::getTransactionSize
+    >
+  > TransactionSizeIndex;
+
   typedef boost::multi_index_container<
     PendingTransactionInfo,
     boost::multi_index::indexed_by<
       TransactionHashIndex,
       TransactionCostIndex,
-      PaymentIdIndex
+      PaymentIdIndex,
+      TransactionSizeIndex
     >
   > TransactionsContainer;
 
@@ -109,6 +124,7 @@ private:
   TransactionsContainer::index<TransactionHashTag>::type& transactionHashIndex;
   TransactionsContainer::index<TransactionCostTag>::type& transactionCostIndex;
   TransactionsContainer::index<PaymentIdTag>::type& paymentIdIndex;
+  TransactionsContainer::index<TransactionSizeTag>::type& transactionSizeIndex;
   
   Logging::LoggerRef logger;
 };
@@ -73,6 +73,18 @@ std::vector<CachedTransaction> TransactionPoolCleanWrapper::getPoolTransactions(
   return transactionPool->getPoolTransactions();
 }
 
+void TransactionPoolCleanWrapper::forEachTransaction(const std::function<bool(const CachedTransaction&)>& visitor) const {
+  transactionPool->forEachTransaction(visitor);
+}
+
+void TransactionPoolCleanWrapper::forEachTransactionReversed(const std::function<bool(const CachedTransaction&)>& visitor) const {
+  transactionPool->forEachTransactionReversed(visitor);
+}
+
+size_t TransactionPoolCleanWrapper::getMinTransactionSize() const {
+  return transactionPool->getMinTransactionSize();
+}
+
 uint64_t TransactionPoolCleanWrapper::getTransactionReceiveTime(const Crypto::Hash& hash) const {
   return transactionPool->getTransactionReceiveTime(hash);
 }
@@ -59,6 +59,9 @@ public:
 
   virtual const TransactionValidatorState& getPoolTransactionValidationState() const override;
   virtual std::vector<CachedTransaction> getPoolTransactions() const override;
+  virtual void forEachTransaction(const std::function<bool(const CachedTransaction&)>& visitor) const override;
+  virtual void forEachTransactionReversed(const std::function<bool(const CachedTransaction&)>& visitor) const override;
+  virtual size_t getMinTransactionSize() const override;
 
   virtual uint64_t getTransactionReceiveTime(const Crypto::Hash& hash) const override;
   virtual std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const override;
@@ -0,0 +1,129 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace CryptoNote {
+
+WorkerPool::WorkerPool(size_t threadsCount) :
+  procedure(nullptr), itemsCount(0), nextItem(0), firstFailedItem(0), activeWorkers(0), jobGeneration(0), stopped(false) {
+  if (threadsCount == 0) {
+    threadsCount = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  }
+
+  for (size_t i = 1; i < threadsCount; ++i) {
+    workers.emplace_back(&WorkerPool::workerProcedure, this, i);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    stopped = true;
+  }
+
+  jobStarted.notify_all();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+size_t WorkerPool::getThreadsCount() const {
+  return workers.size() + 1;
+}
+
+size_t WorkerPool::run(size_t jobItemsCount, const Procedure& jobProcedure) {
+  std::unique_lock<std::mutex> runLock(runMutex);
+
+  if (workers.empty() || jobItemsCount < 2) {
+    for (size_t i = 0; i < jobItemsCount; ++i) {
+      if (!jobProcedure(i, 0)) {
+        return i;
+      }
+    }
+
+    return jobItemsCount;
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    procedure = &jobProcedure;
+    itemsCount = jobItemsCount;
+    nextItem = 0;
+    firstFailedItem = jobItemsCount;
+    activeWorkers = workers.size();
+    ++jobGeneration;
+  }
+
+  jobStarted.notify_all();
+  processItems(0);
+
+  std::unique_lock<std::mutex> lock(mutex);
+  jobFinished.wait(lock, [this] { return activeWorkers == 0; });
+  procedure = nullptr;
+
+  return firstFailedItem.load();
+}
+
+void WorkerPool::workerProcedure(size_t workerIndex) {
+  uint64_t processedGeneration = 0;
+
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      jobStarted.wait(lock, [this, processedGeneration] { return stopped || jobGeneration != processedGeneration; });
+      if (stopped) {
+        return;
+      }
+
+      processedGeneration = jobGeneration;
+    }
+
+    processItems(workerIndex);
+
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      assert(activeWorkers > 0);
+      --activeWorkers;
+    }
+
+    jobFinished.notify_one();
+  }
+}
+
+void WorkerPool::processItems(size_t workerIndex) {
+  const auto& currentProcedure = *procedure;
+
+  for (;;) {
+    size_t index = nextItem.fetch_add(1);
+    // Items are taken in index order, so once a failure is found nothing after it can change the result
+    if (index >= itemsCount || index > firstFailedItem.load()) {
+      return;
+    }
+
+    if (!currentProcedure(index, workerIndex)) {
+      size_t failed = firstFailedItem.load();
+      while (index < failed && !firstFailedItem.compare_exchange_weak(failed, index)) {
+      }
+    }
+  }
+}
+
+}
@@ -0,0 +1,69 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace CryptoNote {
+
+// Fixed set of threads processing items of one job at a time. The calling thread takes part in the job as worker 0,
+// so threadsCount == 1 means plain serial processing.
+class WorkerPool {
+public:
+  // Returns false if the item failed, workerIndex is less than getThreadsCount()
+  typedef std::function<bool(size_t itemIndex, size_t workerIndex)> Procedure;
+
+  explicit WorkerPool(size_t threadsCount); //0 means hardware concurrency
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  size_t getThreadsCount() const;
+
+  // Items are taken in index order. Returns index of the first failed item, or itemsCount if all items succeeded.
+  // The result doesn't depend on the threads count or on scheduling, items after the failed one may be skipped.
+  // Concurrent calls are executed one after another.
+  size_t run(size_t itemsCount, const Procedure& procedure);
+
+private:
+  void workerProcedure(size_t workerIndex);
+  void processItems(size_t workerIndex);
+
+  std::vector<std::thread> workers;
+  std::mutex runMutex;
+  std::mutex mutex;
+  std::condition_variable jobStarted;
+  std::condition_variable jobFinished;
+
+  const Procedure* procedure;
+  size_t itemsCount;
+  std::atomic<size_t> nextItem;
+  std::atomic<size_t> firstFailedItem;
+  size_t activeWorkers;
+  uint64_t jobGeneration;
+  bool stopped;
+};
+
+}
@@ -0,0 +1,362 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BlockDownloadScheduler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace CryptoNote {
+
+BlockDownloadScheduler::BlockDownloadScheduler(uint32_t windowSize, std::chrono::milliseconds stallTimeout) :
+  m_windowSize(windowSize),
+  m_stallTimeout(stallTimeout),
+  m_chainStartIndex(0),
+  m_nextSpanIndex(0),
+  m_spanTaken(false),
+  m_takenSpanEndIndex(0) {
+  assert(m_windowSize > 0);
+}
+
+void BlockDownloadScheduler::addChainRequest(const PeerId& peerId) {
+  m_peers[peerId].chainRequested = true;
+}
+
+bool BlockDownloadScheduler::addChainEntry(const PeerId& peerId, uint32_t startIndex, const std::vector<Crypto::Hash>& blockHashes) {
+  assert(!blockHashes.empty());
+
+  Peer& peer = m_peers[peerId];
+  peer.chainRequested = false;
+  uint32_t lastIndex = startIndex + static_cast<uint32_t>(blockHashes.size()) - 1;
+
+  if (m_chain.empty()) {
+    m_chain.assign(blockHashes.begin() + 1, blockHashes.end());
+    m_chainStartIndex = startIndex + 1;
+    m_nextSpanIndex = m_chainStartIndex;
+    m_returnedSpans.clear();
+    m_downloadedSpans.clear();
+
+    peer.chainAccepted = true;
+    peer.lastBlockIndex = lastIndex;
+    return true;
+  }
+
+  // The entry has to continue the chain, blocks below the chain start were handed to the core already
+  uint32_t chainEndIndex = getChainEndIndex();
+  if (startIndex > chainEndIndex) {
+    peer.chainAccepted = false;
+    return false;
+  }
+
+  for (uint32_t index = std::max(startIndex, m_chainStartIndex); index <= std::min(lastIndex, chainEndIndex); ++index) {
+    if (m_chain[index - m_chainStartIndex] != blockHashes[index - startIndex]) {
+      peer.chainAccepted = false;
+      return false;
+    }
+  }
+
+  for (uint32_t index = chainEndIndex + 1; index <= lastIndex; ++index) {
+    m_chain.push_back(blockHashes[index - startIndex]);
+  }
+
+  peer.chainAccepted = true;
+  peer.lastBlockIndex = lastIndex;
+  return true;
+}
+
+bool BlockDownloadScheduler::assignSpan(const PeerId& peerId, size_t maxBlocksCount, Clock::time_point now, Span& span) {
+  auto it = m_peers.find(peerId);
+  if (it == m_peers.end() || m_chain.empty() || maxBlocksCount == 0) {
+    return false;
+  }
+
+  Peer& peer = it->second;
+  if (!peer.chainAccepted || peer.chainRequested || peer.spanAssigned) {
+    return false;
+  }
+
+  // Returned spans are below the never assigned ones, the lowest span goes first to unblock the core
+  uint32_t startIndex;
+  uint32_t availableCount;
+  bool returned = !m_returnedSpans.empty();
+  if (returned) {
+    startIndex = m_returnedSpans.begin()->first;
+    availableCount = m_returnedSpans.begin()->second;
+  } else if (m_nextSpanIndex <= getChainEndIndex()) {
+    startIndex = m_nextSpanIndex;
+    availableCount = getChainEndIndex() - m_nextSpanIndex + 1;
+  } else {
+    return false;
+  }
+
+  uint32_t windowEndIndex = m_chainStartIndex + m_windowSize;
+  if (startIndex > peer.lastBlockIndex || startIndex >= windowEndIndex) {
+    return false;
+  }
+
+  uint32_t blocksCount = std::min(availableCount, static_cast<uint32_t>(std::min<size_t>(maxBlocksCount, std::numeric_limits<uint32_t>::max())));
+  blocksCount = std::min(blocksCount, peer.lastBlockIndex - startIndex + 1);
+  blocksCount = std::min(blocksCount, windowEndIndex - startIndex);
+
+  if (returned) {
+    removeReturnedSpans(startIndex, blocksCount);
+  } else {
+    m_nextSpanIndex = startIndex + blocksCount;
+  }
+
+  auto chainIt = m_chain.begin() + (startIndex - m_chainStartIndex);
+  span.startIndex = startIndex;
+  span.blockHashes.assign(chainIt, chainIt + blocksCount);
+
+  peer.spanAssigned = true;
+  peer.spanStalled = false;
+  peer.spanStartIndex = startIndex;
+  peer.spanBlocksCount = blocksCount;
+  peer.spanRequestTime = now;
+  return true;
+}
+
+BlockDownloadScheduler::SpanCompletion BlockDownloadScheduler::completeSpan(const PeerId& peerId, DownloadedSpan&& span) {
+  auto it = m_peers.find(peerId);
+  if (it == m_peers.end() || !it->second.spanAssigned) {
+    return SpanCompletion::NOT_NEEDED;
+  }
+
+  Peer& peer = it->second;
+  peer.spanAssigned = false;
+  bool wrongBlocks = span.rawBlocks.size() != peer.spanBlocksCount || span.blockTemplates.size() != peer.spanBlocksCount ||
+    span.blockHashes.size() != peer.spanBlocksCount;
+  for (uint32_t index = std::max(peer.spanStartIndex, m_chainStartIndex); !wrongBlocks && !m_chain.empty() &&
+    index < peer.spanStartIndex + peer.spanBlocksCount && index <= getChainEndIndex(); ++index) {
+    wrongBlocks = span.blockHashes[index - peer.spanStartIndex] != m_chain[index - m_chainStartIndex];
+  }
+
+  if (wrongBlocks) {
+    if (!peer.spanStalled) {
+      returnSpan(peer.spanStartIndex, peer.spanBlocksCount);
+    }
+
+    return SpanCompletion::WRONG_BLOCKS;
+  }
+
+  if (peer.spanStartIndex < m_chainStartIndex || m_downloadedSpans.count(peer.spanStartIndex) != 0) {
+    return SpanCompletion::NOT_NEEDED;
+  }
+
+  removeReturnedSpans(peer.spanStartIndex, peer.spanBlocksCount);
+
+  span.startIndex = peer.spanStartIndex;
+  span.peerId = peerId;
+  m_downloadedSpans.emplace(peer.spanStartIndex, std::move(span));
+  return SpanCompletion::ADDED;
+}
+
+bool BlockDownloadScheduler::popDownloadedSpan(DownloadedSpan& span) {
+  while (!m_spanTaken && !m_downloadedSpans.empty() && m_downloadedSpans.begin()->first <= m_chainStartIndex) {
+    auto it = m_downloadedSpans.begin();
+    uint32_t endIndex = it->first + static_cast<uint32_t>(it->second.rawBlocks.size());
+    if (endIndex <= m_chainStartIndex) {
+      // another copy of these blocks was taken already
+      m_downloadedSpans.erase(it);
+      continue;
+    }
+
+    span = std::move(it->second);
+    m_downloadedSpans.erase(it);
+
+    // The span was downloaded again in other bounds and overlaps a span taken already
+    if (span.startIndex < m_chainStartIndex) {
+      size_t skippedCount = m_chainStartIndex - span.startIndex;
+      span.rawBlocks.erase(span.rawBlocks.begin(), span.rawBlocks.begin() + skippedCount);
+      span.blockTemplates.erase(span.blockTemplates.begin(), span.blockTemplates.begin() + skippedCount);
+      span.blockHashes.erase(span.blockHashes.begin(), span.blockHashes.begin() + skippedCount);
+      span.startIndex = m_chainStartIndex;
+    }
+
+    assert(endIndex <= getChainEndIndex() + 1);
+    removeReturnedSpans(m_chainStartIndex, endIndex - m_chainStartIndex);
+    m_spanTaken = true;
+    m_takenSpanEndIndex = endIndex;
+    return true;
+  }
+
+  return false;
+}
+
+void BlockDownloadScheduler::releaseDownloadedSpan(size_t addedCount) {
+  // The download was reset while the span was being added
+  if (!m_spanTaken) {
+    return;
+  }
+
+  m_spanTaken = false;
+  assert(addedCount <= m_takenSpanEndIndex - m_chainStartIndex);
+  uint32_t addedEndIndex = m_chainStartIndex + static_cast<uint32_t>(addedCount);
+  m_chain.erase(m_chain.begin(), m_chain.begin() + addedCount);
+  m_chainStartIndex = addedEndIndex;
+  m_nextSpanIndex = std::max(m_nextSpanIndex, m_chainStartIndex);
+  if (addedEndIndex < m_takenSpanEndIndex) {
+    returnSpan(addedEndIndex, m_takenSpanEndIndex - addedEndIndex);
+  }
+}
+
+std::vector<BlockDownloadScheduler::PeerId> BlockDownloadScheduler::reassignStalledSpans(Clock::time_point now) {
+  std::vector<PeerId> stalledPeers;
+  for (auto& peer : m_peers) {
+    if (peer.second.spanAssigned && !peer.second.spanStalled && now - peer.second.spanRequestTime > m_stallTimeout) {
+      peer.second.spanStalled = true;
+      returnSpan(peer.second.spanStartIndex, peer.second.spanBlocksCount);
+      stalledPeers.push_back(peer.first);
+    }
+  }
+
+  return stalledPeers;
+}
+
+void BlockDownloadScheduler::removePeer(const PeerId& peerId) {
+  auto it = m_peers.find(peerId);
+  if (it == m_peers.end()) {
+    return;
+  }
+
+  if (it->second.spanAssigned && !it->second.spanStalled) {
+    returnSpan(it->second.spanStartIndex, it->second.spanBlocksCount);
+  }
+
+  m_peers.erase(it);
+}
+
+void BlockDownloadScheduler::reset() {
+  m_chain.clear();
+  m_returnedSpans.clear();
+  m_downloadedSpans.clear();
+  m_spanTaken = false;
+  for (auto& peer : m_peers) {
+    peer.second.chainAccepted = false;
+    peer.second.spanAssigned = false;
+  }
+}
+
+bool BlockDownloadScheduler::isEmpty() const {
+  return m_chain.empty();
+}
+
+bool BlockDownloadScheduler::hasBlock(uint32_t blockIndex, const Crypto::Hash& blockHash) const {
+  if (m_chain.empty() || blockIndex < m_chainStartIndex || blockIndex > getChainEndIndex()) {
+    return false;
+  }
+
+  return m_chain[blockIndex - m_chainStartIndex] == blockHash;
+}
+
+bool BlockDownloadScheduler::getTopBlock(uint32_t& blockIndex, Crypto::Hash& blockHash) const {
+  if (m_chain.empty()) {
+    return false;
+  }
+
+  blockIndex = getChainEndIndex();
+  blockHash = m_chain.back();
+  return true;
+}
+
+bool BlockDownloadScheduler::canExtendChain() const {
+  return m_chain.size() < m_windowSize;
+}
+
+bool BlockDownloadScheduler::canDownloadNextSpan() const {
+  if (m_chain.empty() || (!m_downloadedSpans.empty() && m_downloadedSpans.begin()->first <= m_chainStartIndex)) {
+    return true;
+  }
+
+  return std::any_of(m_peers.begin(), m_peers.end(), [this](const std::pair<const PeerId, Peer>& peer) {
+    return peer.second.chainAccepted && peer.second.lastBlockIndex >= m_chainStartIndex;
+  });
+}
+
+bool BlockDownloadScheduler::hasPeer(const PeerId& peerId) const {
+  auto it = m_peers.find(peerId);
+  return it != m_peers.end() && it->second.chainAccepted;
+}
+
+bool BlockDownloadScheduler::isPeerBusy(const PeerId& peerId) const {
+  auto it = m_peers.find(peerId);
+  return it != m_peers.end() && (it->second.chainRequested || it->second.spanAssigned);
+}
+
+bool BlockDownloadScheduler::isPeerChainDownloaded(const PeerId& peerId) const {
+  if (m_chain.empty()) {
+    return true;
+  }
+
+  auto it = m_peers.find(peerId);
+  return it != m_peers.end() && it->second.chainAccepted && it->second.lastBlockIndex < m_chainStartIndex;
+}
+
+size_t BlockDownloadScheduler::getDownloadedSpansCount() const {
+  return m_downloadedSpans.size();
+}
+
+uint32_t BlockDownloadScheduler::getChainEndIndex() const {
+  assert(!m_chain.empty());
+  return m_chainStartIndex + static_cast<uint32_t>(m_chain.size()) - 1;
+}
+
+void BlockDownloadScheduler::returnSpan(uint32_t startIndex, uint32_t blocksCount) {
+  uint32_t endIndex = startIndex + blocksCount;
+  startIndex = std::max(startIndex, m_chainStartIndex);
+  if (m_chain.empty() || startIndex >= endIndex) {
+    return;
+  }
+
+  auto downloaded = m_downloadedSpans.find(startIndex);
+  if (downloaded != m_downloadedSpans.end() && downloaded->first + downloaded->second.rawBlocks.size() >= endIndex) {
+    return;
+  }
+
+  removeReturnedSpans(startIndex, endIndex - startIndex);
+  m_returnedSpans.emplace(startIndex, endIndex - startIndex);
+}
+
+void BlockDownloadScheduler::removeReturnedSpans(uint32_t startIndex, uint32_t blocksCount) {
+  uint32_t endIndex = startIndex + blocksCount;
+  auto it = m_returnedSpans.upper_bound(startIndex);
+  if (it != m_returnedSpans.begin()) {
+    --it;
+  }
+
+  while (it != m_returnedSpans.end() && it->first < endIndex) {
+    uint32_t spanStartIndex = it->first;
+    uint32_t spanEndIndex = it->first + it->second;
+    if (spanEndIndex <= startIndex) {
+      ++it;
+      continue;
+    }
+
+    it = m_returnedSpans.erase(it);
+    if (spanStartIndex < startIndex) {
+      m_returnedSpans.emplace(spanStartIndex, startIndex - spanStartIndex);
+    }
+
+    if (spanEndIndex > endIndex) {
+      it = m_returnedSpans.emplace(endIndex, spanEndIndex - endIndex).first;
+      ++it;
+    }
+  }
+}
+
+}
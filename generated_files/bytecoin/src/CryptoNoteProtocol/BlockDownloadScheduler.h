@@ -0,0 +1,137 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <vector>
+
+#include <boost/uuid/uuid.hpp>
+
+#include "CryptoNoteCore/CryptoNoteBasic.h"
+#include "crypto/hash.h"
+
+namespace CryptoNote {
+
+// Node-wide plan of the blocks downloaded during synchronization. The chain of needed block hashes is learned from chain entries
+// of the peers and is downloaded in spans of consecutive blocks, requested from all synchronizing peers at once.
+// Downloaded spans wait in a reorder buffer until the blocks before them are downloaded, so the core gets blocks in order.
+// A span that isn't received in time is handed out again to the next free peer, the copy that comes first is used.
+class BlockDownloadScheduler {
+public:
+  typedef std::chrono::steady_clock Clock;
+  typedef boost::uuids::uuid PeerId;
+
+  struct Span {
+    uint32_t startIndex;
+    std::vector<Crypto::Hash> blockHashes;
+  };
+
+  // blockHashes are the hashes of blockTemplates, computed by the receiver
+  struct DownloadedSpan {
+    uint32_t startIndex;
+    PeerId peerId;
+    std::vector<RawBlock> rawBlocks;
+    std::vector<BlockTemplate> blockTemplates;
+    std::vector<Crypto::Hash> blockHashes;
+  };
+
+  enum class SpanCompletion {
+    ADDED,
+    // the blocks were downloaded from another peer or the download was reset
+    NOT_NEEDED,
+    // the blocks aren't the requested ones or are in other order, the span is handed out again
+    WRONG_BLOCKS
+  };
+
+  // windowSize bounds the blocks known and downloaded ahead of the first block not handed to the core yet
+  BlockDownloadScheduler(uint32_t windowSize, std::chrono::milliseconds stallTimeout);
+
+  BlockDownloadScheduler(const BlockDownloadScheduler&) = delete;
+  BlockDownloadScheduler& operator=(const BlockDownloadScheduler&) = delete;
+
+  void addChainRequest(const PeerId& peerId);
+  // blockHashes start at startIndex with a block known already, to the core or to the scheduler.
+  // Returns false if the entry conflicts with the chain being downloaded, the peer gets no spans until it's downloaded.
+  bool addChainEntry(const PeerId& peerId, uint32_t startIndex, const std::vector<Crypto::Hash>& blockHashes);
+
+  // The lowest span not downloaded yet that the peer knows of, at most maxBlocksCount blocks long
+  bool assignSpan(const PeerId& peerId, size_t maxBlocksCount, Clock::time_point now, Span& span);
+  SpanCompletion completeSpan(const PeerId& peerId, DownloadedSpan&& span);
+  // Takes the next downloaded span in chain order. The blocks of it stay in the chain until the span is released,
+  // no other span is taken meanwhile.
+  bool popDownloadedSpan(DownloadedSpan& span);
+  // The first addedCount blocks of the taken span were handed to the core, the rest is downloaded again
+  void releaseDownloadedSpan(size_t addedCount);
+  // Spans requested longer than the stall timeout ago are handed out again, returns the peers they were requested from
+  std::vector<PeerId> reassignStalledSpans(Clock::time_point now);
+  void removePeer(const PeerId& peerId);
+  // Forgets the chain and the downloaded blocks, peers have to send their chain entries again
+  void reset();
+
+  bool isEmpty() const;
+  bool hasBlock(uint32_t blockIndex, const Crypto::Hash& blockHash) const;
+  bool getTopBlock(uint32_t& blockIndex, Crypto::Hash& blockHash) const;
+  // False when the chain being downloaded reaches the end of the window
+  bool canExtendChain() const;
+  // False when no peer knows the next block to hand to the core and it isn't downloaded
+  bool canDownloadNextSpan() const;
+
+  // The chain entry of the peer was accepted
+  bool hasPeer(const PeerId& peerId) const;
+  // A span or a chain entry was requested from the peer and isn't received yet
+  bool isPeerBusy(const PeerId& peerId) const;
+  // All blocks of the peer's chain entries were handed to the core
+  bool isPeerChainDownloaded(const PeerId& peerId) const;
+
+  size_t getDownloadedSpansCount() const;
+
+private:
+  struct Peer {
+    bool chainRequested = false;
+    bool chainAccepted = false;
+    uint32_t lastBlockIndex = 0;
+    bool spanAssigned = false;
+    bool spanStalled = false;
+    uint32_t spanStartIndex = 0;
+    uint32_t spanBlocksCount = 0;
+    Clock::time_point spanRequestTime;
+  };
+
+  uint32_t getChainEndIndex() const;
+  void returnSpan(uint32_t startIndex, uint32_t blocksCount);
+  void removeReturnedSpans(uint32_t startIndex, uint32_t blocksCount);
+
+  const uint32_t m_windowSize;
+  const std::chrono::milliseconds m_stallTimeout;
+  std::map<PeerId, Peer> m_peers;
+  // Hashes of the blocks not handed to the core yet, the first one is at m_chainStartIndex
+  std::deque<Crypto::Hash> m_chain;
+  uint32_t m_chainStartIndex;
+  // The first block never assigned to a peer, the spans below it that have to be assigned again are in m_returnedSpans
+  uint32_t m_nextSpanIndex;
+  std::map<uint32_t, uint32_t> m_returnedSpans;
+  std::map<uint32_t, DownloadedSpan> m_downloadedSpans;
+  // The taken span starts at m_chainStartIndex
+  bool m_spanTaken;
+  uint32_t m_takenSpanEndIndex;
+};
+
+}
@@ -24,6 +24,7 @@
 #include "Serialization/ISerializer.h"
 #include "Serialization/SerializationOverloads.h"
 #include "CryptoNoteCore/CryptoNoteSerialization.h"
+#include "CryptoNoteProtocol/TransactionPoolSketch.h"
 
 namespace CryptoNote
 {
@@ -165,5 +166,152 @@ namespace CryptoNote
     typedef NOTIFY_NEW_SMART_CONTRACT_request request;
   };
 
+  /************************************************************************/
+  /*                                                                      */
+  /************************************************************************/
+  // Consecutive blocks relayed in one message, blocks are ordered by index
+  struct NOTIFY_NEW_BLOCKS_request {
+    std::vector<RawBlockLegacy> blocks;
+    uint32_t current_blockchain_height;
+    uint32_t hop;
+  };
+
+  struct NOTIFY_NEW_BLOCKS {
+    const static int ID = BC_COMMANDS_POOL_BASE + 10;
+    typedef NOTIFY_NEW_BLOCKS_request request;
+  };
+
+  /************************************************************************/
+  /*                                                                      */
+  /************************************************************************/
+  // Block relayed without its transactions, the receiver takes them from its pool by the hashes in the block
+  struct NOTIFY_NEW_COMPACT_BLOCK_request {
+    BinaryArray block;
+    uint32_t current_blockchain_height;
+    uint32_t hop;
+
+    void serialize(ISerializer& s) {
+      serializeAsBinary(block, "block", s);
+      KV_MEMBER(current_blockchain_height)
+      KV_MEMBER(hop)
+    }
+  };
+
+  struct NOTIFY_NEW_COMPACT_BLOCK {
+    const static int ID = BC_COMMANDS_POOL_BASE + 11;
+    typedef NOTIFY_NEW_COMPACT_BLOCK_request request;
+  };
+
+  // Transactions of a compact block that are missing in the receiver's pool, at most P2P_TRANSACTIONS_REQUESTED_MAX_COUNT
+  struct NOTIFY_REQUEST_BLOCK_TRANSACTIONS_request {
+    Crypto::Hash block_hash;
+    std::vector<Crypto::Hash> txs;
+
+    void serialize(ISerializer& s) {
+      KV_MEMBER(block_hash)
+      serializeAsBinary(txs, "txs", s);
+    }
+  };
+
+  struct NOTIFY_REQUEST_BLOCK_TRANSACTIONS {
+    const static int ID = BC_COMMANDS_POOL_BASE + 12;
+    typedef NOTIFY_REQUEST_BLOCK_TRANSACTIONS_request request;
+  };
+
+  struct NOTIFY_RESPONSE_BLOCK_TRANSACTIONS_request {
+    Crypto::Hash block_hash;
+    std::vector<BinaryArray> txs;
+
+    // transactions are sent as strings, like in NOTIFY_NEW_TRANSACTIONS
+    void serialize(ISerializer& s) {
+      KV_MEMBER(block_hash)
+      std::vector<std::string> transactions;
+      if (s.type() == ISerializer::OUTPUT) {
+        for (const auto& transaction : txs) {
+          transactions.emplace_back(transaction.begin(), transaction.end());
+        }
+      }
+
+      s(transactions, "txs");
+      if (s.type() == ISerializer::INPUT) {
+        txs.clear();
+        for (const auto& transaction : transactions) {
+          txs.emplace_back(transaction.begin(), transaction.end());
+        }
+      }
+    }
+  };
+
+  struct NOTIFY_RESPONSE_BLOCK_TRANSACTIONS {
+    const static int ID = BC_COMMANDS_POOL_BASE + 13;
+    typedef NOTIFY_RESPONSE_BLOCK_TRANSACTIONS_request request;
+  };
+
+  /************************************************************************/
+  /*                                                                      */
+  /************************************************************************/
+  // Hashes of new pool transactions, the receiver requests the ones it doesn't have with NOTIFY_REQUEST_TRANSACTIONS
+  struct NOTIFY_TRANSACTION_HASHES_request {
+    std::vector<Crypto::Hash> txs;
+
+    void serialize(ISerializer& s) {
+      serializeAsBinary(txs, "txs", s);
+    }
+  };
+
+  struct NOTIFY_TRANSACTION_HASHES {
+    const static int ID = BC_COMMANDS_POOL_BASE + 14;
+    typedef NOTIFY_TRANSACTION_HASHES_request request;
+  };
+
+  // Answered with NOTIFY_NEW_TRANSACTIONS
+  struct NOTIFY_REQUEST_TRANSACTIONS_request {
+    std::vector<Crypto::Hash> txs;
+
+    void serialize(ISerializer& s) {
+      serializeAsBinary(txs, "txs", s);
+    }
+  };
+
+  struct NOTIFY_REQUEST_TRANSACTIONS {
+    const static int ID = BC_COMMANDS_POOL_BASE + 15;
+    typedef NOTIFY_REQUEST_TRANSACTIONS_request request;
+  };
+
+  /************************************************************************/
+  /*                                                                      */
+  /************************************************************************/
+  // Replaces NOTIFY_REQUEST_TX_POOL for peers supporting it, the receiver finds the pool differences from the sketch
+  struct NOTIFY_REQUEST_TX_POOL_SKETCH_request {
+    TransactionPoolSketch sketch;
+    uint32_t pool_size;
+
+    void serialize(ISerializer& s) {
+      s(sketch, "sketch");
+      s(pool_size, "pool_size");
+    }
+  };
+
+  struct NOTIFY_REQUEST_TX_POOL_SKETCH {
+    const static int ID = BC_COMMANDS_POOL_BASE + 16;
+    typedef NOTIFY_REQUEST_TX_POOL_SKETCH_request request;
+  };
+
+  // The difference is too large for the sketch, the sender retries with a larger one or with all its pool hashes
+  struct NOTIFY_TX_POOL_SKETCH_NOT_DECODED_request {
+    uint32_t cells_count;
+    uint32_t pool_size;
+
+    void serialize(ISerializer& s) {
+      KV_MEMBER(cells_count)
+      KV_MEMBER(pool_size)
+    }
+  };
+
+  struct NOTIFY_TX_POOL_SKETCH_NOT_DECODED {
+    const static int ID = BC_COMMANDS_POOL_BASE + 17;
+    typedef NOTIFY_TX_POOL_SKETCH_NOT_DECODED_request request;
+  };
+
 
 }
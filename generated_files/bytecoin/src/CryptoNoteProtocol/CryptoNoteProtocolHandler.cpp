@@ -18,10 +18,14 @@
 #include "CryptoNoteProtocolHandler.h"
 
 #include <future>
+#include <unordered_set>
 #include <boost/scope_exit.hpp>
 #include <boost/uuid/uuid_io.hpp>
 #include <System/Dispatcher.h>
+#include <System/InterruptedException.h>
+#include <System/RemoteContext.h>
 
+#include "Common/ScopeExit.h"
 #include "CryptoNoteCore/CryptoNoteBasicImpl.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 #include "CryptoNoteCore/CryptoNoteTools.h"
@@ -36,6 +40,43 @@ namespace CryptoNote {
 
 namespace {
 
+// Blocks of a downloaded batch are prepared in chunks of at least this size, while the previous chunk is being added to the core
+const size_t BLOCKS_PREPARATION_CHUNK_SIZE = 10;
+
+struct PreparedTransactions {
+  std::vector<CachedTransaction> transactions;
+  bool prepared;
+};
+
+// Proof of work check of later block versions doesn't use the long hash
+bool isLongHashChecked(const CachedBlock& cachedBlock) {
+  return cachedBlock.getTypeOfBlock() == LEGACY_BLOCK && cachedBlock.getBlock().majorVersion == BLOCK_MAJOR_VERSION_1;
+}
+
+// Does the CPU heavy part of adding a block that doesn't depend on the blockchain state: parsing and hashing of transactions.
+// Failures are left for the core to report, it gets the raw block then.
+void prepareBlock(const Currency& currency, const RawBlock& rawBlock, PreparedTransactions& preparedTransactions) {
+  preparedTransactions.prepared = false;
+  try {
+    preparedTransactions.transactions.reserve(rawBlock.transactions.size());
+    for (const auto& rawTransaction : rawBlock.transactions) {
+      if (rawTransaction.size() > currency.maxTxSize()) {
+        preparedTransactions.transactions.clear();
+        return;
+      }
+
+      preparedTransactions.transactions.emplace_back(rawTransaction);
+      preparedTransactions.transactions.back().getTransactionHash();
+      preparedTransactions.transactions.back().getTransactionPrefixHash();
+    }
+  } catch (std::exception&) {
+    preparedTransactions.transactions.clear();
+    return;
+  }
+
+  preparedTransactions.prepared = true;
+}
+
 template<class t_parametr>
 bool post_notify(IP2pEndpoint& p2p, typename t_parametr::request& arg, const CryptoNoteConnectionContext& context) {
   return p2p.invoke_notify_to_peer(t_parametr::ID, LevinProtocol::encode(arg), context);
@@ -101,24 +142,34 @@ static inline void serialize(NOTIFY_NEW_BLOCK_request& request, ISerializer& s)
   s(request.hop, "hop");
 }
 
+static inline void serialize(NOTIFY_NEW_BLOCKS_request& request, ISerializer& s) {
+  s(request.blocks, "blocks");
+  s(request.current_blockchain_height, "current_blockchain_height");
+  s(request.hop, "hop");
+}
+
 // unpack to strings to maintain protocol compatibility with older versions
-static inline void serialize(NOTIFY_NEW_TRANSACTIONS_request& request, ISerializer& s) {
+static inline void serializeTransactions(std::vector<BinaryArray>& txs, ISerializer& s) {
   std::vector<std::string> transactions;
   if (s.type() == ISerializer::INPUT) {
     s(transactions, "txs");
-    request.txs.reserve(transactions.size());
-    std::transform(transactions.begin(), transactions.end(), std::back_inserter(request.txs), [] (const std::string& s) {
+    txs.reserve(transactions.size());
+    std::transform(transactions.begin(), transactions.end(), std::back_inserter(txs), [] (const std::string& s) {
       return BinaryArray(s.begin(), s.end());
     });
   }else {
-    transactions.reserve(request.txs.size());
-    std::transform(request.txs.begin(), request.txs.end(), std::back_inserter(transactions), [] (const BinaryArray& s) {
+    transactions.reserve(txs.size());
+    std::transform(txs.begin(), txs.end(), std::back_inserter(transactions), [] (const BinaryArray& s) {
       return std::string(s.begin(), s.end());
     });
     s(transactions, "txs");
   }
 }
 
+static inline void serialize(NOTIFY_NEW_TRANSACTIONS_request& request, ISerializer& s) {
+  serializeTransactions(request.txs, s);
+}
+
 static inline void serialize(NOTIFY_RESPONSE_GET_OBJECTS_request& request, ISerializer& s) {
   s(request.txs, "txs");
   s(request.blocks, "blocks");
@@ -126,7 +177,8 @@ static inline void serialize(NOTIFY_RESPONSE_GET_OBJECTS_request& request, ISeri
   s(request.current_blockchain_height, "current_blockchain_height");
 }
 
-CryptoNoteProtocolHandler::CryptoNoteProtocolHandler(const Currency& currency, System::Dispatcher& dispatcher, ICore& rcore, IP2pEndpoint* p_net_layout, Logging::ILogger& log) :
+CryptoNoteProtocolHandler::CryptoNoteProtocolHandler(const Currency& currency, System::Dispatcher& dispatcher, ICore& rcore, IP2pEndpoint* p_net_layout, Logging::ILogger& log,
+                                                     size_t proofOfWorkThreadsCount, std::chrono::milliseconds compactBlockTransactionsTimeout) :
   m_dispatcher(dispatcher),
   m_currency(currency),
   m_core(rcore),
@@ -135,6 +187,13 @@ CryptoNoteProtocolHandler::CryptoNoteProtocolHandler(const Currency& currency, S
   m_stop(false),
   m_observedHeight(0),
   m_peersCount(0),
+  m_longHashCalculator(proofOfWorkThreadsCount),
+  m_downloadScheduler(static_cast<uint32_t>(BLOCKS_DOWNLOAD_WINDOW_SIZE), std::chrono::milliseconds(BLOCKS_DOWNLOAD_STALL_TIMEOUT)),
+  m_processingDownloadedBlocks(false),
+  m_processingContextGroup(dispatcher),
+  m_compactBlockTransactionsTimeout(compactBlockTransactionsTimeout),
+  m_transactionInventory(P2P_TRANSACTIONS_KNOWN_COUNT, P2P_TRANSACTIONS_REQUESTED_MAX_COUNT, std::chrono::milliseconds(P2P_TRANSACTIONS_REQUEST_TIMEOUT),
+    P2P_TRANSACTIONS_REQUEST_MAX_ATTEMPTS),
   logger(log, "protocol") {
   
   if (!m_p2p) {
@@ -176,6 +235,57 @@ void CryptoNoteProtocolHandler::onConnectionClosed(CryptoNoteConnectionContext&
     m_peersCount--;
     m_observerManager.notify(&ICryptoNoteProtocolObserver::peerCountUpdated, m_peersCount.load());
   }
+
+  m_pendingCompactBlocks.erase(context.m_connection_id);
+  m_transactionInventory.removePeer(context.m_connection_id);
+
+  // The span requested from the peer is handed out to the other ones
+  m_downloadScheduler.removePeer(context.m_connection_id);
+  requestMissingObjectsFromIdlePeers(&context.m_connection_id);
+}
+
+void CryptoNoteProtocolHandler::onIdle() {
+  auto stalledPeers = m_downloadScheduler.reassignStalledSpans(BlockDownloadScheduler::Clock::now());
+  if (!stalledPeers.empty()) {
+    logger(Logging::DEBUGGING) << "Blocks requested from " << stalledPeers.size() << " stalled peer(s) are requested from other peers";
+    requestMissingObjectsFromIdlePeers();
+  }
+
+  // Transaction hashes are announced in batches collected since the previous call
+  m_p2p->for_each_connection([this](CryptoNoteConnectionContext& context, PeerIdType peerId) {
+    NOTIFY_TRANSACTION_HASHES::request notification;
+    notification.txs = m_transactionInventory.takeAnnouncements(context.m_connection_id);
+    if (!notification.txs.empty() && !post_notify<NOTIFY_TRANSACTION_HASHES>(*m_p2p, notification, context)) {
+      logger(Logging::WARNING, Logging::BRIGHT_YELLOW) << "Failed to post notification NOTIFY_TRANSACTION_HASHES to " << context.m_connection_id;
+    }
+  });
+
+  if (!m_pendingCompactBlocks.empty()) {
+    auto now = std::chrono::steady_clock::now();
+    m_p2p->for_each_connection([&](CryptoNoteConnectionContext& context, PeerIdType peerId) {
+      auto it = m_pendingCompactBlocks.find(context.m_connection_id);
+      if (it != m_pendingCompactBlocks.end() && now - it->second.requestTime >= m_compactBlockTransactionsTimeout) {
+        logger(Logging::DEBUGGING) << context << "Transactions of compact block " << it->second.blockHash << " aren't received in time, synchronizing";
+        synchronizeMissingBlock(context);
+      }
+    });
+  }
+
+  auto requests = m_transactionInventory.expireRequests(TransactionInventory::Clock::now());
+  if (!requests.empty()) {
+    m_p2p->for_each_connection([&](CryptoNoteConnectionContext& context, PeerIdType peerId) {
+      auto it = requests.find(context.m_connection_id);
+      if (it == requests.end()) {
+        return;
+      }
+
+      NOTIFY_REQUEST_TRANSACTIONS::request request;
+      request.txs = std::move(it->second);
+      if (!post_notify<NOTIFY_REQUEST_TRANSACTIONS>(*m_p2p, request, context)) {
+        logger(Logging::WARNING, Logging::BRIGHT_YELLOW) << "Failed to post notification NOTIFY_REQUEST_TRANSACTIONS to " << context.m_connection_id;
+      }
+    });
+  }
 }
 
 void CryptoNoteProtocolHandler::stop() {
@@ -186,16 +296,8 @@ bool CryptoNoteProtocolHandler::start_sync(CryptoNoteConnectionContext& context)
   logger(Logging::TRACE) << context << "Starting synchronization";
 
   if (context.m_state == CryptoNoteConnectionContext::state_synchronizing) {
-    assert(context.m_needed_objects.empty());
     assert(context.m_requested_objects.empty());
-
-    logger(Logging::TRACE) << context << "Before NOTIFY_REQUEST_CHANGE";
-    NOTIFY_REQUEST_CHAIN::request r = boost::value_initialized<NOTIFY_REQUEST_CHAIN::request>();
-    logger(Logging::TRACE) << context << "After NOTIFY_REQUEST_CHANGE";
-    logger(Logging::TRACE) << context << "Befor SPARSE CHAIN";
-    r.block_ids = m_core.buildSparseChain();
-    logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_CHAIN: m_block_ids.size()=" << r.block_ids.size();
-    post_notify<NOTIFY_REQUEST_CHAIN>(*m_p2p, r, context);
+    requestChain(context);
   }
 
   return true;
@@ -212,7 +314,11 @@ void CryptoNoteProtocolHandler::log_connections() {
     << std::setw(20) << "Peer id"
     << std::setw(25) << "Recv/Sent (inactive,sec)"
     << std::setw(25) << "State"
-    << std::setw(20) << "Lifetime(seconds)" << ENDL;
+    << std::setw(20) << "Lifetime(seconds)"
+    << std::setw(16) << "Request blocks"
+    << std::setw(14) << "Speed(kB/s)"
+    << std::setw(14) << "Latency(ms)"
+    << std::setw(16) << "Block size(B)" << ENDL;
 
   m_p2p->for_each_connection([&](const CryptoNoteConnectionContext& cntxt, PeerIdType peer_id) {
     ss << std::setw(25) << std::left << std::string(cntxt.m_is_income ? "[INC]" : "[OUT]") +
@@ -220,7 +326,11 @@ void CryptoNoteProtocolHandler::log_connections() {
       << std::setw(20) << std::hex << peer_id
       // << std::setw(25) << std::to_string(cntxt.m_recv_cnt) + "(" + std::to_string(time(NULL) - cntxt.m_last_recv) + ")" + "/" + std::to_string(cntxt.m_send_cnt) + "(" + std::to_string(time(NULL) - cntxt.m_last_send) + ")"
       << std::setw(25) << get_protocol_state_string(cntxt.m_state)
-      << std::setw(20) << std::to_string(time(NULL) - cntxt.m_started) << ENDL;
+      << std::setw(20) << std::to_string(time(NULL) - cntxt.m_started)
+      << std::setw(16) << std::dec << cntxt.m_request_sizer.getBlocksCount()
+      << std::setw(14) << cntxt.m_request_sizer.getBytesPerSecond() / 1024
+      << std::setw(14) << cntxt.m_request_sizer.getLatency().count()
+      << std::setw(16) << cntxt.m_request_sizer.getAverageBlockSize() << ENDL;
   });
   logger(INFO) << "Connections: " << ENDL << ss.str();
 }
@@ -295,12 +405,20 @@ int CryptoNoteProtocolHandler::handleCommand(bool is_notify, int command, const
 
   switch (command) {
     HANDLE_NOTIFY(NOTIFY_NEW_BLOCK, handle_notify_new_block)
+    HANDLE_NOTIFY(NOTIFY_NEW_BLOCKS, handle_notify_new_blocks)
+    HANDLE_NOTIFY(NOTIFY_NEW_COMPACT_BLOCK, handle_notify_new_compact_block)
+    HANDLE_NOTIFY(NOTIFY_REQUEST_BLOCK_TRANSACTIONS, handle_request_block_transactions)
+    HANDLE_NOTIFY(NOTIFY_RESPONSE_BLOCK_TRANSACTIONS, handle_response_block_transactions)
     HANDLE_NOTIFY(NOTIFY_NEW_TRANSACTIONS, handle_notify_new_transactions)
+    HANDLE_NOTIFY(NOTIFY_TRANSACTION_HASHES, handle_notify_transaction_hashes)
+    HANDLE_NOTIFY(NOTIFY_REQUEST_TRANSACTIONS, handle_request_transactions)
     HANDLE_NOTIFY(NOTIFY_REQUEST_GET_OBJECTS, handle_request_get_objects)
     HANDLE_NOTIFY(NOTIFY_RESPONSE_GET_OBJECTS, handle_response_get_objects)
     HANDLE_NOTIFY(NOTIFY_REQUEST_CHAIN, handle_request_chain)
     HANDLE_NOTIFY(NOTIFY_RESPONSE_CHAIN_ENTRY, handle_response_chain_entry)
     HANDLE_NOTIFY(NOTIFY_REQUEST_TX_POOL, handleRequestTxPool)
+    HANDLE_NOTIFY(NOTIFY_REQUEST_TX_POOL_SKETCH, handleRequestTxPoolSketch)
+    HANDLE_NOTIFY(NOTIFY_TX_POOL_SKETCH_NOT_DECODED, handleTxPoolSketchNotDecoded)
 	//HANDLE_NOTIFY(NOTIFY_NEW_SMART_CONTRACT, handle_notify_new_smarct_contract)
 
   default:
@@ -320,19 +438,182 @@ int CryptoNoteProtocolHandler::handle_notify_new_block(int command, NOTIFY_NEW_B
     return 1;
   }
 
+  processNewBlock(arg, context);
+  return 1;
+}
+
+int CryptoNoteProtocolHandler::handle_notify_new_compact_block(int command, NOTIFY_NEW_COMPACT_BLOCK::request& arg, CryptoNoteConnectionContext& context) {
+  logger(Logging::TRACE) << context << "NOTIFY_NEW_COMPACT_BLOCK (hop " << arg.hop << ")";
+  updateObservedHeight(arg.current_blockchain_height, context);
+  context.m_remote_blockchain_height = arg.current_blockchain_height;
+  if (context.m_state != CryptoNoteConnectionContext::state_normal) {
+    return 1;
+  }
+
+  BlockTemplate blockTemplate;
+  if (!fromBinaryArray(blockTemplate, arg.block)) {
+    logger(Logging::DEBUGGING) << context << "Failed to parse compact block, dropping connection";
+    context.m_state = CryptoNoteConnectionContext::state_shutdown;
+    return 1;
+  }
+
+  CachedBlock cachedBlock(blockTemplate);
+  const Crypto::Hash& blockHash = cachedBlock.getBlockHash();
+  if (m_core.hasBlock(blockHash)) {
+    logger(Logging::TRACE) << context << "Block already exists";
+    return 1;
+  }
+
+  // A request that isn't answered in time doesn't hold the block back, it's requested from this peer then
+  auto now = std::chrono::steady_clock::now();
+  for (const auto& pending : m_pendingCompactBlocks) {
+    if (pending.second.blockHash == blockHash && now - pending.second.requestTime < m_compactBlockTransactionsTimeout) {
+      logger(Logging::TRACE) << context << "Transactions of compact block " << blockHash << " are already requested";
+      return 1;
+    }
+  }
+
+  PendingCompactBlock pending;
+  pending.blockHash = blockHash;
+  pending.requestTime = now;
+  pending.transactionHashes = blockTemplate.transactionHashes;
+  pending.block.current_blockchain_height = arg.current_blockchain_height;
+  pending.block.hop = arg.hop;
+  pending.block.b.block = std::move(arg.block);
+  pending.block.b.transactions.resize(pending.transactionHashes.size());
+
+  NOTIFY_REQUEST_BLOCK_TRANSACTIONS::request request;
+  request.block_hash = blockHash;
+  for (size_t i = 0; i < pending.transactionHashes.size(); ++i) {
+    if (!m_core.getPoolTransaction(pending.transactionHashes[i], pending.block.b.transactions[i])) {
+      request.txs.push_back(pending.transactionHashes[i]);
+    }
+  }
+
+  if (request.txs.empty()) {
+    logger(Logging::DEBUGGING) << context << "Compact block " << blockHash << " is rebuilt from the pool";
+    processNewBlock(pending.block, context);
+    return 1;
+  }
+
+  if (request.txs.size() > P2P_TRANSACTIONS_REQUESTED_MAX_COUNT) {
+    logger(Logging::DEBUGGING) << context << "Compact block " << blockHash << " misses " << request.txs.size() << " transactions in the pool, synchronizing";
+    synchronizeMissingBlock(context);
+    return 1;
+  }
+
+  logger(Logging::DEBUGGING) << context << "Compact block " << blockHash << " misses " << request.txs.size() << " of " <<
+    pending.transactionHashes.size() << " transactions in the pool, requesting them";
+  // A peer has at most one pending block, a new one replaces the previous
+  m_pendingCompactBlocks[context.m_connection_id] = std::move(pending);
+  if (!post_notify<NOTIFY_REQUEST_BLOCK_TRANSACTIONS>(*m_p2p, request, context)) {
+    logger(Logging::WARNING, Logging::BRIGHT_YELLOW) << "Failed to post notification NOTIFY_REQUEST_BLOCK_TRANSACTIONS to " << context.m_connection_id;
+    m_pendingCompactBlocks.erase(context.m_connection_id);
+  }
+
+  return 1;
+}
+
+int CryptoNoteProtocolHandler::handle_request_block_transactions(int command, NOTIFY_REQUEST_BLOCK_TRANSACTIONS::request& arg, CryptoNoteConnectionContext& context) {
+  logger(Logging::TRACE) << context << "NOTIFY_REQUEST_BLOCK_TRANSACTIONS: txs.size() = " << arg.txs.size();
+  if (arg.txs.size() > P2P_TRANSACTIONS_REQUESTED_MAX_COUNT) {
+    logger(Logging::DEBUGGING) << context << "Requested too many transactions of a block, dropping connection";
+    context.m_state = CryptoNoteConnectionContext::state_shutdown;
+    return 1;
+  }
+
+  // The block is relayed after it is added, a request for an unknown block isn't answered
+  if (!m_core.hasBlock(arg.block_hash)) {
+    logger(Logging::DEBUGGING) << context << "Requested transactions of unknown block " << arg.block_hash << ", ignoring";
+    return 1;
+  }
+
+  // Only the transactions of the block are sent
+  BlockTemplate block = m_core.getBlockByHash(arg.block_hash);
+  std::unordered_set<Crypto::Hash> blockTransactions(block.transactionHashes.begin(), block.transactionHashes.end());
+  std::vector<Crypto::Hash> transactionHashes;
+  std::copy_if(arg.txs.begin(), arg.txs.end(), std::back_inserter(transactionHashes), [&blockTransactions](const Crypto::Hash& hash) {
+    return blockTransactions.count(hash) != 0;
+  });
+
+  NOTIFY_RESPONSE_BLOCK_TRANSACTIONS::request response;
+  response.block_hash = arg.block_hash;
+
+  // Transactions of a main chain block are in the chain, the ones of an alternative block may be in the pool
+  std::vector<Crypto::Hash> missedHashes;
+  m_core.getTransactions(transactionHashes, response.txs, missedHashes);
+  for (const auto& hash : missedHashes) {
+    BinaryArray transaction;
+    if (m_core.getPoolTransaction(hash, transaction)) {
+      response.txs.push_back(std::move(transaction));
+    }
+  }
+
+  if (!post_notify<NOTIFY_RESPONSE_BLOCK_TRANSACTIONS>(*m_p2p, response, context)) {
+    logger(Logging::WARNING, Logging::BRIGHT_YELLOW) << "Failed to post notification NOTIFY_RESPONSE_BLOCK_TRANSACTIONS to " << context.m_connection_id;
+  }
+
+  return 1;
+}
+
+int CryptoNoteProtocolHandler::handle_response_block_transactions(int command, NOTIFY_RESPONSE_BLOCK_TRANSACTIONS::request& arg, CryptoNoteConnectionContext& context) {
+  logger(Logging::TRACE) << context << "NOTIFY_RESPONSE_BLOCK_TRANSACTIONS: txs.size() = " << arg.txs.size();
+  auto it = m_pendingCompactBlocks.find(context.m_connection_id);
+  if (it == m_pendingCompactBlocks.end() || it->second.blockHash != arg.block_hash) {
+    logger(Logging::DEBUGGING) << context << "Got transactions of a block that wasn't requested, ignoring";
+    return 1;
+  }
+
+  PendingCompactBlock pending = std::move(it->second);
+  m_pendingCompactBlocks.erase(it);
+  if (context.m_state != CryptoNoteConnectionContext::state_normal) {
+    return 1;
+  }
+
+  // The response is in any order, transactions are matched by their hashes
+  std::unordered_map<Crypto::Hash, BinaryArray*> received;
+  for (auto& transaction : arg.txs) {
+    if (transaction.size() <= m_currency.maxTxSize()) {
+      received.emplace(getBinaryArrayHash(transaction), &transaction);
+    }
+  }
+
+  for (size_t i = 0; i < pending.transactionHashes.size(); ++i) {
+    if (!pending.block.b.transactions[i].empty()) {
+      continue;
+    }
+
+    auto transaction = received.find(pending.transactionHashes[i]);
+    if (transaction == received.end()) {
+      logger(Logging::DEBUGGING) << context << "Peer didn't send all transactions of compact block " << pending.blockHash << ", dropping connection";
+      context.m_state = CryptoNoteConnectionContext::state_shutdown;
+      return 1;
+    }
+
+    pending.block.b.transactions[i] = std::move(*transaction->second);
+  }
+
+  processNewBlock(pending.block, context);
+  return 1;
+}
+
+// The block of a compact block that can't be rebuilt is downloaded by synchronizing with the peer
+void CryptoNoteProtocolHandler::synchronizeMissingBlock(CryptoNoteConnectionContext& context) {
+  m_pendingCompactBlocks.erase(context.m_connection_id);
+  context.m_state = CryptoNoteConnectionContext::state_synchronizing;
+  requestChain(context);
+}
+
+void CryptoNoteProtocolHandler::processNewBlock(NOTIFY_NEW_BLOCK::request& arg, CryptoNoteConnectionContext& context) {
   auto result = m_core.addBlock(RawBlock{ arg.b.block, arg.b.transactions });
   if (result == error::AddBlockErrorCondition::BLOCK_ADDED) {
     if (result == error::AddBlockErrorCode::ADDED_TO_ALTERNATIVE_AND_SWITCHED) {
       ++arg.hop;
-      //TODO: Add here announce protocol usage
-      relay_post_notify<NOTIFY_NEW_BLOCK>(*m_p2p, arg, &context.m_connection_id);
-      // relay_block(arg, context);
+      relayNewBlock(arg, &context.m_connection_id);
       requestMissingPoolTransactions(context);
     } else if (result == error::AddBlockErrorCode::ADDED_TO_MAIN) {
       ++arg.hop;
-      //TODO: Add here announce protocol usage
-      relay_post_notify<NOTIFY_NEW_BLOCK>(*m_p2p, arg, &context.m_connection_id);
-      // relay_block(arg, context);
+      relayNewBlock(arg, &context.m_connection_id);
     } else if (result == error::AddBlockErrorCode::ADDED_TO_ALTERNATIVE) {
       logger(Logging::TRACE) << context << "Block added as alternative";
     } else {
@@ -341,14 +622,43 @@ int CryptoNoteProtocolHandler::handle_notify_new_block(int command, NOTIFY_NEW_B
   } else if (result == error::AddBlockErrorCondition::BLOCK_REJECTED) {
     m_p2p->drop_connection(context, true);
     context.m_state = CryptoNoteConnectionContext::state_synchronizing;
-    NOTIFY_REQUEST_CHAIN::request r = boost::value_initialized<NOTIFY_REQUEST_CHAIN::request>();
-    r.block_ids = m_core.buildSparseChain();
-    logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_CHAIN: m_block_ids.size()=" << r.block_ids.size();
-    post_notify<NOTIFY_REQUEST_CHAIN>(*m_p2p, r, context);
+    requestChain(context);
   } else {
     logger(Logging::DEBUGGING) << context << "Block verification failed, dropping connection: " << result.message();
     context.m_state = CryptoNoteConnectionContext::state_shutdown;
   }
+}
+
+int CryptoNoteProtocolHandler::handle_notify_new_blocks(int command, NOTIFY_NEW_BLOCKS::request& arg, CryptoNoteConnectionContext& context) {
+  logger(Logging::TRACE) << context << "NOTIFY_NEW_BLOCKS (" << arg.blocks.size() << " blocks, hop " << arg.hop << ")";
+  updateObservedHeight(arg.current_blockchain_height, context);
+  context.m_remote_blockchain_height = arg.current_blockchain_height;
+  if (context.m_state != CryptoNoteConnectionContext::state_normal) {
+    return 1;
+  }
+
+  bool relay = false;
+  for (const auto& block : arg.blocks) {
+    auto result = m_core.addBlock(RawBlock{ block.block, block.transactions });
+    if (result == error::AddBlockErrorCondition::BLOCK_ADDED) {
+      if (result == error::AddBlockErrorCode::ADDED_TO_MAIN || result == error::AddBlockErrorCode::ADDED_TO_ALTERNATIVE_AND_SWITCHED) {
+        relay = true;
+      }
+    } else if (result == error::AddBlockErrorCondition::BLOCK_REJECTED) {
+      context.m_state = CryptoNoteConnectionContext::state_synchronizing;
+      requestChain(context);
+      return 1;
+    } else {
+      logger(Logging::DEBUGGING) << context << "Block verification failed, dropping connection: " << result.message();
+      context.m_state = CryptoNoteConnectionContext::state_shutdown;
+      return 1;
+    }
+  }
+
+  if (relay) {
+    ++arg.hop;
+    relay_post_notify<NOTIFY_NEW_BLOCKS>(*m_p2p, arg, &context.m_connection_id);
+  }
 
   return 1;
 }
@@ -359,6 +669,10 @@ int CryptoNoteProtocolHandler::handle_notify_new_transactions(int command, NOTIF
   if (context.m_state != CryptoNoteConnectionContext::state_normal)
     return 1;
 
+  for (const auto& transaction : arg.txs) {
+    m_transactionInventory.addReceived(context.m_connection_id, getBinaryArrayHash(transaction));
+  }
+
   for (auto tx_blob_it = arg.txs.begin(); tx_blob_it != arg.txs.end();) {
     if (!m_core.addTransactionToPool(*tx_blob_it)) {
       //logger(Logging::DEBUG) << context << "Tx verification failed";
@@ -369,13 +683,51 @@ int CryptoNoteProtocolHandler::handle_notify_new_transactions(int command, NOTIF
   }
 
   if (arg.txs.size()) {
-    //TODO: add announce usage here
-    relay_post_notify<NOTIFY_NEW_TRANSACTIONS>(*m_p2p, arg, &context.m_connection_id);
+    relayNewTransactions(arg.txs, &context.m_connection_id);
   }
 
   return true;
 }
 
+int CryptoNoteProtocolHandler::handle_notify_transaction_hashes(int command, NOTIFY_TRANSACTION_HASHES::request& arg, CryptoNoteConnectionContext& context) {
+  logger(Logging::TRACE) << context << "NOTIFY_TRANSACTION_HASHES: txs.size() = " << arg.txs.size();
+  if (context.m_state != CryptoNoteConnectionContext::state_normal) {
+    return 1;
+  }
+
+  std::vector<Crypto::Hash> missedHashes;
+  for (const auto& hash : arg.txs) {
+    if (!m_core.hasTransaction(hash)) {
+      missedHashes.push_back(hash);
+    }
+  }
+
+  NOTIFY_REQUEST_TRANSACTIONS::request request;
+  request.txs = m_transactionInventory.addAnnounced(context.m_connection_id, missedHashes, TransactionInventory::Clock::now());
+  if (!request.txs.empty() && !post_notify<NOTIFY_REQUEST_TRANSACTIONS>(*m_p2p, request, context)) {
+    logger(Logging::WARNING, Logging::BRIGHT_YELLOW) << "Failed to post notification NOTIFY_REQUEST_TRANSACTIONS to " << context.m_connection_id;
+  }
+
+  return 1;
+}
+
+int CryptoNoteProtocolHandler::handle_request_transactions(int command, NOTIFY_REQUEST_TRANSACTIONS::request& arg, CryptoNoteConnectionContext& context) {
+  logger(Logging::TRACE) << context << "NOTIFY_REQUEST_TRANSACTIONS: txs.size() = " << arg.txs.size();
+  NOTIFY_NEW_TRANSACTIONS::request response;
+  for (size_t i = 0; i < arg.txs.size() && i < P2P_TRANSACTIONS_REQUESTED_MAX_COUNT; ++i) {
+    BinaryArray transaction;
+    if (m_core.getPoolTransaction(arg.txs[i], transaction)) {
+      response.txs.push_back(std::move(transaction));
+    }
+  }
+
+  if (!response.txs.empty() && !post_notify<NOTIFY_NEW_TRANSACTIONS>(*m_p2p, response, context)) {
+    logger(Logging::WARNING, Logging::BRIGHT_YELLOW) << "Failed to post notification NOTIFY_NEW_TRANSACTIONS to " << context.m_connection_id;
+  }
+
+  return 1;
+}
+
 int CryptoNoteProtocolHandler::handle_request_get_objects(int command, NOTIFY_REQUEST_GET_OBJECTS::request& arg, CryptoNoteConnectionContext& context) {
   logger(Logging::TRACE) << context << "NOTIFY_REQUEST_GET_OBJECTS";
   NOTIFY_RESPONSE_GET_OBJECTS::request rsp;
@@ -401,6 +753,14 @@ int CryptoNoteProtocolHandler::handle_request_get_objects(int command, NOTIFY_RE
 
 int CryptoNoteProtocolHandler::handle_response_get_objects(int command, NOTIFY_RESPONSE_GET_OBJECTS::request& arg, CryptoNoteConnectionContext& context) {
   logger(Logging::TRACE) << context << "NOTIFY_RESPONSE_GET_OBJECTS";
+  // The response time is taken before the blocks are parsed, the parsing isn't part of the link's throughput
+  auto receivedTime = BlockRequestSizer::Clock::now();
+
+  if (context.m_requested_objects.empty()) {
+    // The batch was requested before the download was restarted
+    logger(Logging::DEBUGGING) << context << "Ignoring NOTIFY_RESPONSE_GET_OBJECTS, no blocks are requested";
+    return 1;
+  }
 
   if (context.m_last_response_height > arg.current_blockchain_height) {
     logger(Logging::ERROR) << context << "sent wrong NOTIFY_HAVE_OBJECTS: arg.m_current_blockchain_height=" << arg.current_blockchain_height
@@ -411,44 +771,55 @@ int CryptoNoteProtocolHandler::handle_response_get_objects(int command, NOTIFY_R
 
   updateObservedHeight(arg.current_blockchain_height, context);
   context.m_remote_blockchain_height = arg.current_blockchain_height;
-  std::vector<BlockTemplate> blockTemplates;
-  std::vector<CachedBlock> cachedBlocks;
+  BlockDownloadScheduler::DownloadedSpan span;
+  std::vector<BlockTemplate>& blockTemplates = span.blockTemplates;
+  std::vector<Crypto::Hash>& blockHashes = span.blockHashes;
   blockTemplates.resize(arg.blocks.size());
-  cachedBlocks.reserve(arg.blocks.size());
+  blockHashes.reserve(arg.blocks.size());
+
+  std::vector<RawBlock>& rawBlocks = span.rawBlocks;
+  rawBlocks = convertRawBlocksLegacyToRawBlocks(arg.blocks);
+  uint64_t requestGeneration = context.m_request_generation;
+
+  // Block headers are parsed and hashed off the dispatcher thread
+  size_t parsedBlocksCount = System::RemoteContext<size_t>(m_dispatcher, [&] {
+    for (size_t index = 0; index < rawBlocks.size(); ++index) {
+      if (!fromBinaryArray(blockTemplates[index], rawBlocks[index].block)) {
+        return index;
+      }
+
+      blockHashes.push_back(CachedBlock(blockTemplates[index]).getBlockHash());
+    }
 
-  std::vector<RawBlock> rawBlocks = convertRawBlocksLegacyToRawBlocks(arg.blocks);
+    return rawBlocks.size();
+  }).get();
+
+  // The dispatcher ran other handlers meanwhile, the download could be restarted and the blocks requested again
+  if (m_stop || context.m_request_generation != requestGeneration) {
+    logger(Logging::DEBUGGING) << context << "Ignoring NOTIFY_RESPONSE_GET_OBJECTS, the request was replaced while the blocks were parsed";
+    return 1;
+  }
 
   for (size_t index = 0; index < rawBlocks.size(); ++index) {
-    if (!fromBinaryArray(blockTemplates[index], rawBlocks[index].block)) {
+    if (index == parsedBlocksCount) {
       logger(Logging::ERROR) << context << "sent wrong block: failed to parse and validate block: \r\n"
         << toHex(rawBlocks[index].block) << "\r\n dropping connection";
       context.m_state = CryptoNoteConnectionContext::state_shutdown;
       return 1;
     }
 
-    cachedBlocks.emplace_back(blockTemplates[index]);
-    if (index == 1) {
-      if (m_core.hasBlock(cachedBlocks.back().getBlockHash())) { //TODO
-        context.m_state = CryptoNoteConnectionContext::state_idle;
-        context.m_needed_objects.clear();
-        context.m_requested_objects.clear();
-        logger(Logging::DEBUGGING) << context << "Connection set to idle state.";
-        return 1;
-      }
-    }
-
-    auto req_it = context.m_requested_objects.find(cachedBlocks.back().getBlockHash());
+    auto req_it = context.m_requested_objects.find(blockHashes[index]);
     if (req_it == context.m_requested_objects.end()) {
-      logger(Logging::ERROR) << context << "sent wrong NOTIFY_RESPONSE_GET_OBJECTS: block with id=" << Common::podToHex(cachedBlocks.back().getBlockHash())
+      logger(Logging::ERROR) << context << "sent wrong NOTIFY_RESPONSE_GET_OBJECTS: block with id=" << Common::podToHex(blockHashes[index])
         << " wasn't requested, dropping connection";
       context.m_state = CryptoNoteConnectionContext::state_shutdown;
       return 1;
     }
-	if (cachedBlocks.back().getTypeOfBlock()==LEGACY_BLOCK) {
-		if (cachedBlocks.back().getBlock().transactionHashes.size() != rawBlocks[index].transactions.size()) {
+	if (CachedBlock(blockTemplates[index]).getTypeOfBlock()==LEGACY_BLOCK) {
+		if (blockTemplates[index].transactionHashes.size() != rawBlocks[index].transactions.size()) {
 			logger(Logging::ERROR) << context
-				<< "sent wrong NOTIFY_RESPONSE_GET_OBJECTS: block with id=" << Common::podToHex(cachedBlocks.back().getBlockHash())
-				<< ", transactionHashes.size()=" << cachedBlocks.back().getBlock().transactionHashes.size()
+				<< "sent wrong NOTIFY_RESPONSE_GET_OBJECTS: block with id=" << Common::podToHex(blockHashes[index])
+				<< ", transactionHashes.size()=" << blockTemplates[index].transactionHashes.size()
 				<< " mismatch with block_complete_entry.m_txs.size()=" << rawBlocks[index].transactions.size()
 				<< ", dropping connection";
 			context.m_state = CryptoNoteConnectionContext::state_shutdown;
@@ -466,51 +837,148 @@ int CryptoNoteProtocolHandler::handle_response_get_objects(int command, NOTIFY_R
     return 1;
   }
 
-  {
-    int result = processObjects(context, std::move(rawBlocks), cachedBlocks);
-    if (result != 0) {
-      return result;
+  size_t bytesCount = 0;
+  for (const auto& rawBlock : rawBlocks) {
+    bytesCount += rawBlock.block.size();
+    for (const auto& transaction : rawBlock.transactions) {
+      bytesCount += transaction.size();
     }
   }
 
-  logger(DEBUGGING, BRIGHT_GREEN) << "Local blockchain updated, new index = " << m_core.getTopBlockIndex();
+  context.m_request_sizer.onBlocksReceived(rawBlocks.size(), bytesCount, receivedTime);
+
+  auto completion = m_downloadScheduler.completeSpan(context.m_connection_id, std::move(span));
+  if (completion == BlockDownloadScheduler::SpanCompletion::WRONG_BLOCKS) {
+    logger(Logging::ERROR) << context << "sent wrong NOTIFY_RESPONSE_GET_OBJECTS: blocks aren't in the requested order, dropping connection";
+    context.m_state = CryptoNoteConnectionContext::state_shutdown;
+    return 1;
+  } else if (completion == BlockDownloadScheduler::SpanCompletion::NOT_NEEDED) {
+    logger(Logging::DEBUGGING) << context << "Blocks are downloaded from another peer already";
+  }
+
+  // The next span is requested before the blocks are added, so the peer sends it while the core is busy
   if (!m_stop && context.m_state == CryptoNoteConnectionContext::state_synchronizing) {
-    request_missing_objects(context, true);
+    request_missing_objects(context);
   }
 
+  startProcessingDownloadedBlocks();
   return 1;
 }
 
-int CryptoNoteProtocolHandler::processObjects(CryptoNoteConnectionContext& context, std::vector<RawBlock>&& rawBlocks, const std::vector<CachedBlock>& cachedBlocks) {
-  assert(rawBlocks.size() == cachedBlocks.size());
+std::error_code CryptoNoteProtocolHandler::processObjects(std::vector<RawBlock>&& rawBlocks, const std::vector<BlockTemplate>& blockTemplates, size_t& addedCount) {
+  assert(rawBlocks.size() == blockTemplates.size());
+  addedCount = 0;
+  std::vector<CachedBlock> cachedBlocks(blockTemplates.begin(), blockTemplates.end());
+  std::vector<PreparedTransactions> preparedTransactions(rawBlocks.size());
+  auto chunkSize = std::max(BLOCKS_PREPARATION_CHUNK_SIZE, m_longHashCalculator.getThreadsCount());
+  auto prepareChunk = [&](size_t chunkBegin) {
+    auto chunkEnd = std::min(chunkBegin + chunkSize, rawBlocks.size());
+    return [&, chunkBegin, chunkEnd] {
+      std::vector<const CachedBlock*> hashedBlocks;
+      for (size_t index = chunkBegin; index < chunkEnd; ++index) {
+        cachedBlocks[index].getBlockHash();
+        if (isLongHashChecked(cachedBlocks[index])) {
+          hashedBlocks.push_back(&cachedBlocks[index]);
+        }
+      }
+
+      m_longHashCalculator.calculate(hashedBlocks);
+      for (size_t index = chunkBegin; index < chunkEnd; ++index) {
+        prepareBlock(m_currency, rawBlocks[index], preparedTransactions[index]);
+      }
+    };
+  };
+
+  // Waits for the running preparation on destruction, so it has to be destroyed before the data it works on
+  std::unique_ptr<System::RemoteContext<void>> preparation;
+  if (!rawBlocks.empty()) {
+    preparation.reset(new System::RemoteContext<void>(m_dispatcher, prepareChunk(0)));
+  }
+
   for (size_t index = 0; index < rawBlocks.size(); ++index) {
     if (m_stop) {
       break;
     }
 
-    auto addResult = m_core.addBlock(cachedBlocks[index], std::move(rawBlocks[index]));
+    if (index % chunkSize == 0) {
+      preparation->get();
+      preparation.reset();
+      if (index + chunkSize < rawBlocks.size()) {
+        preparation.reset(new System::RemoteContext<void>(m_dispatcher, prepareChunk(index + chunkSize)));
+      }
+    }
+
+    std::error_code addResult;
+    if (preparedTransactions[index].prepared) {
+      addResult = m_core.addBlock(cachedBlocks[index], std::move(preparedTransactions[index].transactions), std::move(rawBlocks[index]));
+    } else {
+      addResult = m_core.addBlock(cachedBlocks[index], std::move(rawBlocks[index]));
+    }
+
     if (addResult == error::AddBlockErrorCondition::BLOCK_VALIDATION_FAILED ||
         addResult == error::AddBlockErrorCondition::TRANSACTION_VALIDATION_FAILED ||
-        addResult == error::AddBlockErrorCondition::DESERIALIZATION_FAILED) {
-      logger(Logging::DEBUGGING) << context << "Block verification failed, dropping connection: " << addResult.message();
-      context.m_state = CryptoNoteConnectionContext::state_shutdown;
-      return 1;
-    } else if (addResult == error::AddBlockErrorCondition::BLOCK_REJECTED) {
-      logger(Logging::INFO) << context << "Block received at sync phase was marked as orphaned, dropping connection: " << addResult.message();
-      context.m_state = CryptoNoteConnectionContext::state_shutdown;
-      return 1;
+        addResult == error::AddBlockErrorCondition::DESERIALIZATION_FAILED ||
+        addResult == error::AddBlockErrorCondition::BLOCK_REJECTED) {
+      return addResult;
     } else if (addResult == error::AddBlockErrorCode::ALREADY_EXISTS) {
-      logger(Logging::DEBUGGING) << context << "Block already exists, switching to idle state: " << addResult.message();
-      context.m_state = CryptoNoteConnectionContext::state_idle;
-      context.m_needed_objects.clear();
-      context.m_requested_objects.clear();
-      return 1;
+      // The block was relayed to the node while it was downloaded
+      logger(Logging::DEBUGGING) << "Downloaded block already exists: " << cachedBlocks[index].getBlockHash();
     }
 
+    ++addedCount;
     m_dispatcher.yield();
   }
 
-  return 0;
+  return std::error_code();
+}
+
+void CryptoNoteProtocolHandler::startProcessingDownloadedBlocks() {
+  if (m_processingDownloadedBlocks) {
+    return;
+  }
+
+  // Blocks are added in a separate context, so the connection that received them goes on receiving
+  m_processingDownloadedBlocks = true;
+  m_processingContextGroup.spawn([this] {
+    try {
+      processDownloadedBlocks();
+    } catch (System::InterruptedException&) {
+      logger(Logging::DEBUGGING) << "processDownloadedBlocks() is interrupted";
+    } catch (std::exception& e) {
+      logger(Logging::WARNING) << "Exception in processDownloadedBlocks: " << e.what();
+    }
+
+    m_processingDownloadedBlocks = false;
+  });
+}
+
+void CryptoNoteProtocolHandler::processDownloadedBlocks() {
+  BlockDownloadScheduler::DownloadedSpan span;
+  while (!m_stop && m_downloadScheduler.popDownloadedSpan(span)) {
+    size_t addedCount = 0;
+    std::error_code result;
+    {
+      // The added blocks leave the download window, the rest of the span is downloaded again
+      Tools::ScopeExit release([this, &addedCount] { m_downloadScheduler.releaseDownloadedSpan(addedCount); });
+      result = processObjects(std::move(span.rawBlocks), span.blockTemplates, addedCount);
+    }
+
+    if (result) {
+      // Only the peer that sent the invalid block is dropped, the others go on downloading the chain
+      m_downloadScheduler.removePeer(span.peerId);
+      m_p2p->for_each_connection([&](CryptoNoteConnectionContext& context, PeerIdType peerId) {
+        if (context.m_connection_id == span.peerId) {
+          logger(Logging::DEBUGGING) << context << "Block verification failed, dropping connection: " << result.message();
+          m_p2p->drop_connection(context, result != error::AddBlockErrorCondition::BLOCK_REJECTED);
+        }
+      });
+    } else {
+      logger(DEBUGGING, BRIGHT_GREEN) << "Local blockchain updated, new index = " << m_core.getTopBlockIndex();
+    }
+
+    // The download window moved, idle peers request more blocks
+    requestMissingObjectsFromIdlePeers();
+  }
 }
 
 int CryptoNoteProtocolHandler::handle_request_chain(int command, NOTIFY_REQUEST_CHAIN::request& arg, CryptoNoteConnectionContext& context) {
@@ -536,39 +1004,33 @@ int CryptoNoteProtocolHandler::handle_request_chain(int command, NOTIFY_REQUEST_
   return 1;
 }
 
-bool CryptoNoteProtocolHandler::request_missing_objects(CryptoNoteConnectionContext& context, bool check_having_blocks) {
-  if (context.m_needed_objects.size()) {
-    //we know objects that we need, request this objects
+bool CryptoNoteProtocolHandler::request_missing_objects(CryptoNoteConnectionContext& context) {
+  BlockDownloadScheduler::Span span;
+  auto now = BlockDownloadScheduler::Clock::now();
+  if (m_downloadScheduler.assignSpan(context.m_connection_id, context.m_request_sizer.getBlocksCount(), now, span)) {
+    context.m_request_sizer.onBlocksRequested(now);
     NOTIFY_REQUEST_GET_OBJECTS::request req;
-    size_t count = 0;
-    auto it = context.m_needed_objects.begin();
-
-    while (it != context.m_needed_objects.end() && count < BLOCKS_SYNCHRONIZING_DEFAULT_COUNT) {
-      if (!(check_having_blocks && m_core.hasBlock(*it))) {
-        req.blocks.push_back(*it);
-        ++count;
-        context.m_requested_objects.insert(*it);
-      }
-      it = context.m_needed_objects.erase(it);
-    }
-    logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_GET_OBJECTS: blocks.size()=" << req.blocks.size() << ", txs.size()=" << req.txs.size();
+    req.blocks = std::move(span.blockHashes);
+    context.m_requested_objects.insert(req.blocks.begin(), req.blocks.end());
+    ++context.m_request_generation;
+    logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_GET_OBJECTS: start index=" << span.startIndex << ", blocks.size()=" << req.blocks.size()
+      << ", txs.size()=" << req.txs.size();
     post_notify<NOTIFY_REQUEST_GET_OBJECTS>(*m_p2p, req, context);
-  } else if (context.m_last_response_height < context.m_remote_blockchain_height - 1) {//we have to fetch more objects ids, request blockchain entry
-
-    NOTIFY_REQUEST_CHAIN::request r = boost::value_initialized<NOTIFY_REQUEST_CHAIN::request>();
-    r.block_ids = m_core.buildSparseChain();
-    logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_CHAIN: m_block_ids.size()=" << r.block_ids.size();
-    post_notify<NOTIFY_REQUEST_CHAIN>(*m_p2p, r, context);
-  } else {
+  } else if (m_downloadScheduler.isPeerBusy(context.m_connection_id)) {
+    // the span of a stalled peer is requested from another peer too, the copy that comes first is used
+  } else if (!m_downloadScheduler.hasPeer(context.m_connection_id) || context.m_last_response_height < context.m_remote_blockchain_height - 1) {
+    // A peer with another chain waits until the chain being downloaded is added, the chain is known up to the window end only
+    if (m_downloadScheduler.isEmpty() || (m_downloadScheduler.hasPeer(context.m_connection_id) && m_downloadScheduler.canExtendChain())) {
+      requestChain(context);
+    }
+  } else if (m_downloadScheduler.isPeerChainDownloaded(context.m_connection_id)) {
     if (!(context.m_last_response_height ==
       context.m_remote_blockchain_height - 1 &&
-      !context.m_needed_objects.size() &&
       !context.m_requested_objects.size())) {
       logger(Logging::ERROR, Logging::BRIGHT_RED)
         << "request_missing_blocks final condition failed!"
         << "\r\nm_last_response_height=" << context.m_last_response_height
         << "\r\nm_remote_blockchain_height=" << context.m_remote_blockchain_height
-        << "\r\nm_needed_objects.size()=" << context.m_needed_objects.size()
         << "\r\nm_requested_objects.size()=" << context.m_requested_objects.size() 
         << "\r\non connection [" << context << "]";
       return false;
@@ -583,6 +1045,55 @@ bool CryptoNoteProtocolHandler::request_missing_objects(CryptoNoteConnectionCont
   return true;
 }
 
+void CryptoNoteProtocolHandler::requestChain(CryptoNoteConnectionContext& context) {
+  NOTIFY_REQUEST_CHAIN::request r = boost::value_initialized<NOTIFY_REQUEST_CHAIN::request>();
+  r.block_ids = m_core.buildSparseChain();
+
+  // The chain being downloaded is continued from its top block, if the peer knows it
+  uint32_t topIndex;
+  Crypto::Hash topHash;
+  if (m_downloadScheduler.getTopBlock(topIndex, topHash)) {
+    r.block_ids.insert(r.block_ids.begin(), topHash);
+  }
+
+  m_downloadScheduler.addChainRequest(context.m_connection_id);
+  context.m_request_sizer.onChainRequested(BlockRequestSizer::Clock::now());
+  logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_CHAIN: m_block_ids.size()=" << r.block_ids.size();
+  post_notify<NOTIFY_REQUEST_CHAIN>(*m_p2p, r, context);
+}
+
+void CryptoNoteProtocolHandler::requestMissingObjectsFromIdlePeers(const net_connection_id* excludeConnection) {
+  if (m_stop) {
+    return;
+  }
+
+  if (!m_downloadScheduler.canDownloadNextSpan()) {
+    logger(Logging::DEBUGGING) << "No peer knows the next block of the chain being downloaded, restarting synchronization";
+    restartSynchronization(excludeConnection);
+    return;
+  }
+
+  m_p2p->for_each_connection([&](CryptoNoteConnectionContext& context, PeerIdType peerId) {
+    if ((excludeConnection == nullptr || context.m_connection_id != *excludeConnection) &&
+        context.m_state == CryptoNoteConnectionContext::state_synchronizing &&
+        !m_downloadScheduler.isPeerBusy(context.m_connection_id)) {
+      request_missing_objects(context);
+    }
+  });
+}
+
+void CryptoNoteProtocolHandler::restartSynchronization(const net_connection_id* excludeConnection) {
+  m_downloadScheduler.reset();
+  m_p2p->for_each_connection([&](CryptoNoteConnectionContext& context, PeerIdType peerId) {
+    if ((excludeConnection == nullptr || context.m_connection_id != *excludeConnection) &&
+        context.m_state == CryptoNoteConnectionContext::state_synchronizing) {
+      context.m_requested_objects.clear();
+      ++context.m_request_generation;
+      requestChain(context);
+    }
+  });
+}
+
 bool CryptoNoteProtocolHandler::on_connection_synchronized() {
   bool val_expected = false;
   if (m_synchronized.compare_exchange_strong(val_expected, true)) {
@@ -602,6 +1113,7 @@ bool CryptoNoteProtocolHandler::on_connection_synchronized() {
 int CryptoNoteProtocolHandler::handle_response_chain_entry(int command, NOTIFY_RESPONSE_CHAIN_ENTRY::request& arg, CryptoNoteConnectionContext& context) {
   logger(Logging::TRACE) << context << "NOTIFY_RESPONSE_CHAIN_ENTRY: m_block_ids.size()=" << arg.m_block_ids.size()
     << ", m_start_height=" << arg.start_height << ", m_total_height=" << arg.total_height;
+  context.m_request_sizer.onChainReceived(BlockRequestSizer::Clock::now());
 
   if (!arg.m_block_ids.size()) {
     logger(Logging::ERROR) << context << "sent empty m_block_ids, dropping connection";
@@ -609,7 +1121,7 @@ int CryptoNoteProtocolHandler::handle_response_chain_entry(int command, NOTIFY_R
     return 1;
   }
 
-  if (!m_core.hasBlock(arg.m_block_ids.front())) {
+  if (!m_core.hasBlock(arg.m_block_ids.front()) && !m_downloadScheduler.hasBlock(arg.start_height, arg.m_block_ids.front())) {
     logger(Logging::ERROR)
       << context << "sent m_block_ids starting from unknown id: "
       << Common::podToHex(arg.m_block_ids.front())
@@ -628,21 +1140,23 @@ int CryptoNoteProtocolHandler::handle_response_chain_entry(int command, NOTIFY_R
       << arg.total_height << "\r\nm_start_height=" << arg.start_height
       << "\r\nm_block_ids.size()=" << arg.m_block_ids.size();
     context.m_state = CryptoNoteConnectionContext::state_shutdown;
+    return 1;
   }
 
-  bool allBlocksKnown = true;
-  for (auto& bl_id : arg.m_block_ids) {
-    if (allBlocksKnown) {
-      if (!m_core.hasBlock(bl_id)) {
-        context.m_needed_objects.push_back(bl_id);
-        allBlocksKnown = false;
-      }
-    } else {
-      context.m_needed_objects.push_back(bl_id);
-    }
+  // The entry goes to the scheduler from the last block the core has
+  size_t knownBlocksCount = 1;
+  while (knownBlocksCount < arg.m_block_ids.size() && m_core.hasBlock(arg.m_block_ids[knownBlocksCount])) {
+    ++knownBlocksCount;
+  }
+
+  std::vector<Crypto::Hash> blockHashes(arg.m_block_ids.begin() + (knownBlocksCount - 1), arg.m_block_ids.end());
+  if (!m_downloadScheduler.addChainEntry(context.m_connection_id, arg.start_height + static_cast<uint32_t>(knownBlocksCount - 1), blockHashes)) {
+    logger(Logging::DEBUGGING) << context << "Chain entry doesn't match the chain being downloaded, waiting for the download to finish";
   }
 
-  request_missing_objects(context, false);
+  request_missing_objects(context);
+  // Blocks of the entry can be downloaded from the other peers as well
+  requestMissingObjectsFromIdlePeers();
   return 1;
 }
 
@@ -662,24 +1176,197 @@ int CryptoNoteProtocolHandler::handleRequestTxPool(int command, NOTIFY_REQUEST_T
   return 1;
 }
 
+int CryptoNoteProtocolHandler::handleRequestTxPoolSketch(int command, NOTIFY_REQUEST_TX_POOL_SKETCH::request& arg,
+                                                           CryptoNoteConnectionContext& context) {
+  logger(Logging::TRACE) << context << "NOTIFY_REQUEST_TX_POOL_SKETCH: cells = " << arg.sketch.getCellsCount() << ", pool_size = " << arg.pool_size;
+  size_t cellsCount = arg.sketch.getCellsCount();
+  if (cellsCount == 0 || cellsCount > P2P_TX_POOL_SKETCH_MAX_CELLS) {
+    logger(Logging::DEBUGGING) << context << "Invalid pool sketch, dropping connection";
+    context.m_state = CryptoNoteConnectionContext::state_shutdown;
+    return 1;
+  }
+
+  std::vector<Crypto::Hash> poolHashes = m_core.getPoolTransactionHashes();
+  TransactionPoolSketch sketch(cellsCount);
+  for (const auto& hash : poolHashes) {
+    sketch.insert(hash);
+  }
+
+  std::vector<Crypto::Hash> ownHashes;
+  std::vector<Crypto::Hash> peerHashes;
+  if (!sketch.subtract(arg.sketch) || !sketch.decode(ownHashes, peerHashes)) {
+    logger(Logging::TRACE) << context << "Pool sketch isn't decoded, own pool size = " << poolHashes.size();
+    NOTIFY_TX_POOL_SKETCH_NOT_DECODED::request notification;
+    notification.cells_count = static_cast<uint32_t>(cellsCount);
+    notification.pool_size = static_cast<uint32_t>(poolHashes.size());
+    if (!post_notify<NOTIFY_TX_POOL_SKETCH_NOT_DECODED>(*m_p2p, notification, context)) {
+      logger(Logging::WARNING, Logging::BRIGHT_YELLOW) << "Failed to post notification NOTIFY_TX_POOL_SKETCH_NOT_DECODED to " << context.m_connection_id;
+    }
+
+    return 1;
+  }
+
+  NOTIFY_NEW_TRANSACTIONS::request notification;
+  for (const auto& hash : ownHashes) {
+    BinaryArray transaction;
+    if (m_core.getPoolTransaction(hash, transaction)) {
+      notification.txs.push_back(std::move(transaction));
+    }
+  }
+
+  if (!notification.txs.empty() && !post_notify<NOTIFY_NEW_TRANSACTIONS>(*m_p2p, notification, context)) {
+    logger(Logging::WARNING, Logging::BRIGHT_YELLOW) << "Failed to post notification NOTIFY_NEW_TRANSACTIONS to " << context.m_connection_id;
+  }
+
+  // Transactions only the peer has are requested as if the peer announced them
+  std::vector<Crypto::Hash> missedHashes;
+  for (const auto& hash : peerHashes) {
+    if (!m_core.hasTransaction(hash)) {
+      missedHashes.push_back(hash);
+    }
+  }
+
+  NOTIFY_REQUEST_TRANSACTIONS::request request;
+  request.txs = m_transactionInventory.addAnnounced(context.m_connection_id, missedHashes, TransactionInventory::Clock::now());
+  if (!request.txs.empty() && !post_notify<NOTIFY_REQUEST_TRANSACTIONS>(*m_p2p, request, context)) {
+    logger(Logging::WARNING, Logging::BRIGHT_YELLOW) << "Failed to post notification NOTIFY_REQUEST_TRANSACTIONS to " << context.m_connection_id;
+  }
+
+  return 1;
+}
+
+int CryptoNoteProtocolHandler::handleTxPoolSketchNotDecoded(int command, NOTIFY_TX_POOL_SKETCH_NOT_DECODED::request& arg,
+                                                              CryptoNoteConnectionContext& context) {
+  logger(Logging::TRACE) << context << "NOTIFY_TX_POOL_SKETCH_NOT_DECODED: cells = " << arg.cells_count << ", pool_size = " << arg.pool_size;
+  // Only the answer to the sketch sent last is taken, the sketch size isn't chosen by the peer
+  if (context.m_pool_sketch_cells == 0 || arg.cells_count != context.m_pool_sketch_cells) {
+    logger(Logging::DEBUGGING) << context << "Ignoring NOTIFY_TX_POOL_SKETCH_NOT_DECODED, the sketch of " << arg.cells_count << " cells wasn't sent";
+    return 1;
+  }
+
+  std::vector<Crypto::Hash> poolHashes = m_core.getPoolTransactionHashes();
+
+  // The difference is at least the difference of the pool sizes, a sketch decodes it reliably with about three cells per transaction.
+  // Sketches grow with every retry, after the last retry the list of pool hashes is sent.
+  size_t cellsCount = 0;
+  if (context.m_pool_sketch_retries < P2P_TX_POOL_SKETCH_MAX_RETRIES) {
+    size_t sizeDifference = poolHashes.size() > arg.pool_size ? poolHashes.size() - arg.pool_size : arg.pool_size - poolHashes.size();
+    cellsCount = std::max(context.m_pool_sketch_cells * 4, sizeDifference * 3 + P2P_TX_POOL_SKETCH_MIN_CELLS);
+    ++context.m_pool_sketch_retries;
+  }
+
+  requestPoolTransactions(context, std::move(poolHashes), cellsCount);
+  return 1;
+}
+
 
 void CryptoNoteProtocolHandler::relayBlock(NOTIFY_NEW_BLOCK::request& arg) {
+  m_dispatcher.remoteSpawn([this, arg] {
+    relayNewBlock(arg, nullptr);
+  });
+}
+
+// Peers supporting compact blocks get the block without transactions, the others get the full block
+void CryptoNoteProtocolHandler::relayNewBlock(const NOTIFY_NEW_BLOCK::request& arg, const net_connection_id* excludeConnection) {
+  BinaryArray fullBlock = LevinProtocol::encode(arg);
+  BinaryArray compactBlock;
+
+  BlockTemplate blockTemplate;
+  if (fromBinaryArray(blockTemplate, arg.b.block) && CachedBlock(blockTemplate).getTypeOfBlock() == LEGACY_BLOCK &&
+      blockTemplate.transactionHashes.size() == arg.b.transactions.size()) {
+    compactBlock = LevinProtocol::encode(NOTIFY_NEW_COMPACT_BLOCK::request{arg.b.block, arg.current_blockchain_height, arg.hop});
+  }
+
+  net_connection_id excludeId = excludeConnection ? *excludeConnection : boost::value_initialized<net_connection_id>();
+  m_p2p->for_each_connection([&](CryptoNoteConnectionContext& context, PeerIdType peerId) {
+    if (peerId == 0 || context.m_connection_id == excludeId ||
+        (context.m_state != CryptoNoteConnectionContext::state_normal && context.m_state != CryptoNoteConnectionContext::state_synchronizing)) {
+      return;
+    }
+
+    if (!compactBlock.empty() && context.version >= P2PProtocolVersion::V2) {
+      m_p2p->invoke_notify_to_peer(NOTIFY_NEW_COMPACT_BLOCK::ID, compactBlock, context);
+    } else {
+      m_p2p->invoke_notify_to_peer(NOTIFY_NEW_BLOCK::ID, fullBlock, context);
+    }
+  });
+}
+
+void CryptoNoteProtocolHandler::relayBlocks(NOTIFY_NEW_BLOCKS::request& arg) {
   auto buf = LevinProtocol::encode(arg);
-  m_p2p->externalRelayNotifyToAll(NOTIFY_NEW_BLOCK::ID, buf);
+  m_p2p->externalRelayNotifyToAll(NOTIFY_NEW_BLOCKS::ID, buf);
 }
 
 void CryptoNoteProtocolHandler::relayTransactions(const std::vector<BinaryArray>& transactions) {
-  auto buf = LevinProtocol::encode(NOTIFY_NEW_TRANSACTIONS::request{transactions});
-  m_p2p->externalRelayNotifyToAll(NOTIFY_NEW_TRANSACTIONS::ID, buf);
+  m_dispatcher.remoteSpawn([this, transactions] {
+    relayNewTransactions(transactions, nullptr);
+  });
+}
+
+// Peers supporting announcements get the transaction hashes with the next idle call, the others get the transactions now
+void CryptoNoteProtocolHandler::relayNewTransactions(const std::vector<BinaryArray>& transactions, const net_connection_id* excludeConnection) {
+  std::vector<Crypto::Hash> transactionHashes;
+  transactionHashes.reserve(transactions.size());
+  for (const auto& transaction : transactions) {
+    transactionHashes.push_back(getBinaryArrayHash(transaction));
+  }
+
+  BinaryArray fullTransactions;
+  net_connection_id excludeId = excludeConnection ? *excludeConnection : boost::value_initialized<net_connection_id>();
+  m_p2p->for_each_connection([&](CryptoNoteConnectionContext& context, PeerIdType peerId) {
+    if (peerId == 0 || context.m_connection_id == excludeId ||
+        (context.m_state != CryptoNoteConnectionContext::state_normal && context.m_state != CryptoNoteConnectionContext::state_synchronizing)) {
+      return;
+    }
+
+    if (context.version >= P2PProtocolVersion::V3) {
+      for (const auto& transactionHash : transactionHashes) {
+        m_transactionInventory.addAnnouncement(context.m_connection_id, transactionHash);
+      }
+    } else {
+      if (fullTransactions.empty()) {
+        fullTransactions = LevinProtocol::encode(NOTIFY_NEW_TRANSACTIONS::request{transactions});
+      }
+
+      m_p2p->invoke_notify_to_peer(NOTIFY_NEW_TRANSACTIONS::ID, fullTransactions, context);
+    }
+  });
 }
 
-void CryptoNoteProtocolHandler::requestMissingPoolTransactions(const CryptoNoteConnectionContext& context) {
+void CryptoNoteProtocolHandler::requestMissingPoolTransactions(CryptoNoteConnectionContext& context) {
   if (context.version < P2PProtocolVersion::V1) {
     return;
   }
 
+  context.m_pool_sketch_retries = 0;
+  requestPoolTransactions(context, m_core.getPoolTransactionHashes(), P2P_TX_POOL_SKETCH_MIN_CELLS);
+}
+
+// Peers supporting sketches get one unless it's larger than the list of pool hashes or than the maximum sketch,
+// sketchCellsCount 0 sends the list of pool hashes
+void CryptoNoteProtocolHandler::requestPoolTransactions(CryptoNoteConnectionContext& context, std::vector<Crypto::Hash>&& poolHashes,
+                                                        size_t sketchCellsCount) {
+  context.m_pool_sketch_cells = 0;
+  if (context.version >= P2PProtocolVersion::V4 && sketchCellsCount != 0 && sketchCellsCount <= P2P_TX_POOL_SKETCH_MAX_CELLS &&
+      sketchCellsCount * TransactionPoolSketch::CELL_SIZE < poolHashes.size() * sizeof(Crypto::Hash)) {
+    NOTIFY_REQUEST_TX_POOL_SKETCH::request request;
+    request.sketch = TransactionPoolSketch(sketchCellsCount);
+    for (const auto& hash : poolHashes) {
+      request.sketch.insert(hash);
+    }
+
+    request.pool_size = static_cast<uint32_t>(poolHashes.size());
+    if (!post_notify<NOTIFY_REQUEST_TX_POOL_SKETCH>(*m_p2p, request, context)) {
+      logger(Logging::WARNING, Logging::BRIGHT_YELLOW) << "Failed to post notification NOTIFY_REQUEST_TX_POOL_SKETCH to " << context.m_connection_id;
+      return;
+    }
+
+    context.m_pool_sketch_cells = sketchCellsCount;
+    return;
+  }
+
   NOTIFY_REQUEST_TX_POOL::request notification;
-  notification.txs = m_core.getPoolTransactionHashes();
+  notification.txs = std::move(poolHashes);
 
   bool ok = post_notify<NOTIFY_REQUEST_TX_POOL>(*m_p2p, notification, context);
   if (!ok) {
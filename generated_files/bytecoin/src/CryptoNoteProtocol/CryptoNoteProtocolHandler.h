@@ -18,15 +18,22 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <map>
 
 #include <Common/ObserverManager.h>
+#include <System/ContextGroup.h>
 
+#include "CryptoNoteConfig.h"
 #include "CryptoNoteCore/ICore.h"
+#include "CryptoNoteCore/LongHashCalculator.h"
 
+#include "CryptoNoteProtocol/BlockDownloadScheduler.h"
 #include "CryptoNoteProtocol/CryptoNoteProtocolDefinitions.h"
 #include "CryptoNoteProtocol/CryptoNoteProtocolHandlerCommon.h"
 #include "CryptoNoteProtocol/ICryptoNoteProtocolObserver.h"
 #include "CryptoNoteProtocol/ICryptoNoteProtocolQuery.h"
+#include "CryptoNoteProtocol/TransactionInventory.h"
 
 #include "P2p/P2pProtocolDefinitions.h"
 #include "P2p/NetNodeCommon.h"
@@ -46,7 +53,10 @@ namespace CryptoNote
   {
   public:
 
-    CryptoNoteProtocolHandler(const Currency& currency, System::Dispatcher& dispatcher, ICore& rcore, IP2pEndpoint* p_net_layout, Logging::ILogger& log);
+    // Missing transactions of a compact block not received in compactBlockTransactionsTimeout are downloaded with the block by synchronization
+    CryptoNoteProtocolHandler(const Currency& currency, System::Dispatcher& dispatcher, ICore& rcore, IP2pEndpoint* p_net_layout, Logging::ILogger& log,
+                              size_t proofOfWorkThreadsCount = 0,
+                              std::chrono::milliseconds compactBlockTransactionsTimeout = std::chrono::milliseconds(P2P_COMPACT_BLOCK_TRANSACTIONS_TIMEOUT));
 
     virtual bool addObserver(ICryptoNoteProtocolObserver* observer) override;
     virtual bool removeObserver(ICryptoNoteProtocolObserver* observer) override;
@@ -61,38 +71,67 @@ namespace CryptoNote
     bool start_sync(CryptoNoteConnectionContext& context);
     void onConnectionOpened(CryptoNoteConnectionContext& context);
     void onConnectionClosed(CryptoNoteConnectionContext& context);
+    void onIdle();
     CoreStatistics getStatistics();
     bool get_payload_sync_data(CORE_SYNC_DATA& hshd);
     bool process_payload_sync_data(const CORE_SYNC_DATA& hshd, CryptoNoteConnectionContext& context, bool is_inital);
     int handleCommand(bool is_notify, int command, const BinaryArray& in_buff, BinaryArray& buff_out, CryptoNoteConnectionContext& context, bool& handled);
     virtual size_t getPeerCount() const override;
     virtual uint32_t getObservedHeight() const override;
-    void requestMissingPoolTransactions(const CryptoNoteConnectionContext& context);
+    void requestMissingPoolTransactions(CryptoNoteConnectionContext& context);
 
   private:
     //----------------- commands handlers ----------------------------------------------
     int handle_notify_new_block(int command, NOTIFY_NEW_BLOCK::request& arg, CryptoNoteConnectionContext& context);
+    int handle_notify_new_blocks(int command, NOTIFY_NEW_BLOCKS::request& arg, CryptoNoteConnectionContext& context);
+    int handle_notify_new_compact_block(int command, NOTIFY_NEW_COMPACT_BLOCK::request& arg, CryptoNoteConnectionContext& context);
+    int handle_request_block_transactions(int command, NOTIFY_REQUEST_BLOCK_TRANSACTIONS::request& arg, CryptoNoteConnectionContext& context);
+    int handle_response_block_transactions(int command, NOTIFY_RESPONSE_BLOCK_TRANSACTIONS::request& arg, CryptoNoteConnectionContext& context);
     int handle_notify_new_transactions(int command, NOTIFY_NEW_TRANSACTIONS::request& arg, CryptoNoteConnectionContext& context);
+    int handle_notify_transaction_hashes(int command, NOTIFY_TRANSACTION_HASHES::request& arg, CryptoNoteConnectionContext& context);
+    int handle_request_transactions(int command, NOTIFY_REQUEST_TRANSACTIONS::request& arg, CryptoNoteConnectionContext& context);
     int handle_request_get_objects(int command, NOTIFY_REQUEST_GET_OBJECTS::request& arg, CryptoNoteConnectionContext& context);
     int handle_response_get_objects(int command, NOTIFY_RESPONSE_GET_OBJECTS::request& arg, CryptoNoteConnectionContext& context);
     int handle_request_chain(int command, NOTIFY_REQUEST_CHAIN::request& arg, CryptoNoteConnectionContext& context);
     int handle_response_chain_entry(int command, NOTIFY_RESPONSE_CHAIN_ENTRY::request& arg, CryptoNoteConnectionContext& context);
     int handleRequestTxPool(int command, NOTIFY_REQUEST_TX_POOL::request& arg, CryptoNoteConnectionContext& context);
+    int handleRequestTxPoolSketch(int command, NOTIFY_REQUEST_TX_POOL_SKETCH::request& arg, CryptoNoteConnectionContext& context);
+    int handleTxPoolSketchNotDecoded(int command, NOTIFY_TX_POOL_SKETCH_NOT_DECODED::request& arg, CryptoNoteConnectionContext& context);
 
     //----------------- i_cryptonote_protocol ----------------------------------
     virtual void relayBlock(NOTIFY_NEW_BLOCK::request& arg) override;
+    virtual void relayBlocks(NOTIFY_NEW_BLOCKS::request& arg) override;
     virtual void relayTransactions(const std::vector<BinaryArray>& transactions) override;
 
     //----------------------------------------------------------------------------------
     uint32_t get_current_blockchain_height();
-    bool request_missing_objects(CryptoNoteConnectionContext& context, bool check_having_blocks);
+    void processNewBlock(NOTIFY_NEW_BLOCK::request& arg, CryptoNoteConnectionContext& context);
+    void relayNewBlock(const NOTIFY_NEW_BLOCK::request& arg, const net_connection_id* excludeConnection);
+    void relayNewTransactions(const std::vector<BinaryArray>& transactions, const net_connection_id* excludeConnection);
+    void requestPoolTransactions(CryptoNoteConnectionContext& context, std::vector<Crypto::Hash>&& poolHashes, size_t sketchCellsCount);
+    bool request_missing_objects(CryptoNoteConnectionContext& context);
+    void requestChain(CryptoNoteConnectionContext& context);
+    void requestMissingObjectsFromIdlePeers(const net_connection_id* excludeConnection = nullptr);
+    void restartSynchronization(const net_connection_id* excludeConnection = nullptr);
+    void startProcessingDownloadedBlocks();
+    void processDownloadedBlocks();
     bool on_connection_synchronized();
     void updateObservedHeight(uint32_t peerHeight, const CryptoNoteConnectionContext& context);
     void recalculateMaxObservedHeight(const CryptoNoteConnectionContext& context);
-    int processObjects(CryptoNoteConnectionContext& context, std::vector<RawBlock>&& rawBlocks, const std::vector<CachedBlock>& cachedBlocks);
+    // addedCount is the number of blocks handed to the core, the blocks after a failed one are not added
+    std::error_code processObjects(std::vector<RawBlock>&& rawBlocks, const std::vector<BlockTemplate>& blockTemplates, size_t& addedCount);
     Logging::LoggerRef logger;
 
   private:
+    // Compact block waiting for the transactions that were missing in the pool, they are left empty in block
+    struct PendingCompactBlock {
+      Crypto::Hash blockHash;
+      std::vector<Crypto::Hash> transactionHashes;
+      NOTIFY_NEW_BLOCK::request block;
+      std::chrono::steady_clock::time_point requestTime;
+    };
+
+    void synchronizeMissingBlock(CryptoNoteConnectionContext& context);
 
     System::Dispatcher& m_dispatcher;
     ICore& m_core;
@@ -108,5 +147,13 @@ namespace CryptoNote
 
     std::atomic<size_t> m_peersCount;
     Tools::ObserverManager<ICryptoNoteProtocolObserver> m_observerManager;
+    LongHashCalculator m_longHashCalculator;
+
+    BlockDownloadScheduler m_downloadScheduler;
+    bool m_processingDownloadedBlocks;
+    System::ContextGroup m_processingContextGroup;
+    std::map<net_connection_id, PendingCompactBlock> m_pendingCompactBlocks;
+    const std::chrono::milliseconds m_compactBlockTransactionsTimeout;
+    TransactionInventory m_transactionInventory;
   };
 }
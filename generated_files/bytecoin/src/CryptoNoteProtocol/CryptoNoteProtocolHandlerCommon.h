@@ -25,12 +25,14 @@
 namespace CryptoNote
 {
   struct NOTIFY_NEW_BLOCK_request;
+  struct NOTIFY_NEW_BLOCKS_request;
 
   /************************************************************************/
   /*                                                                      */
   /************************************************************************/
   struct ICryptoNoteProtocol {
     virtual void relayBlock(NOTIFY_NEW_BLOCK_request& arg) = 0;
+    virtual void relayBlocks(NOTIFY_NEW_BLOCKS_request& arg) = 0;
     virtual void relayTransactions(const std::vector<BinaryArray>& transactions) = 0;
   };
   
@@ -0,0 +1,244 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "TransactionInventory.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+namespace CryptoNote {
+
+TransactionInventory::TransactionInventory(size_t knownHashesCount, size_t maxRequestedCount, std::chrono::milliseconds requestTimeout,
+                                           size_t maxRequestAttempts) :
+  m_knownHashesCount(knownHashesCount),
+  m_maxRequestedCount(maxRequestedCount),
+  m_requestTimeout(requestTimeout),
+  m_maxRequestAttempts(maxRequestAttempts) {
+  assert(m_knownHashesCount > 0);
+  assert(m_maxRequestAttempts > 0);
+}
+
+void TransactionInventory::addAnnouncement(const PeerId& peerId, const Crypto::Hash& transactionHash) {
+  Peer& peer = m_peers[peerId];
+  if (peer.knownHashes.count(transactionHash) != 0) {
+    return;
+  }
+
+  // The peer gets the hash once, it announces the transaction or requests it then
+  addKnown(peer, transactionHash);
+  peer.announcements.push_back(transactionHash);
+}
+
+std::vector<Crypto::Hash> TransactionInventory::takeAnnouncements(const PeerId& peerId) {
+  auto it = m_peers.find(peerId);
+  if (it == m_peers.end()) {
+    return {};
+  }
+
+  std::vector<Crypto::Hash> announcements;
+  announcements.swap(it->second.announcements);
+  return announcements;
+}
+
+std::vector<Crypto::Hash> TransactionInventory::addAnnounced(const PeerId& peerId, const std::vector<Crypto::Hash>& transactionHashes,
+                                                             Clock::time_point now) {
+  Peer& peer = m_peers[peerId];
+  std::vector<Crypto::Hash> requestedHashes;
+  for (const auto& transactionHash : transactionHashes) {
+    addKnown(peer, transactionHash);
+    if (m_requests.count(transactionHash) != 0) {
+      continue;
+    }
+
+    if (peer.requestedCount >= m_maxRequestedCount) {
+      addQueued(peer, transactionHash);
+      continue;
+    }
+
+    addRequest(peerId, peer, transactionHash, now);
+    requestedHashes.push_back(transactionHash);
+  }
+
+  return requestedHashes;
+}
+
+void TransactionInventory::addReceived(const PeerId& peerId, const Crypto::Hash& transactionHash) {
+  addKnown(m_peers[peerId], transactionHash);
+  if (m_queuedHashes.count(transactionHash) != 0) {
+    eraseQueued(transactionHash);
+  }
+
+  auto requestIt = m_requests.find(transactionHash);
+  if (requestIt == m_requests.end()) {
+    return;
+  }
+
+  auto requestedPeerIt = m_peers.find(requestIt->second.peerId);
+  if (requestedPeerIt != m_peers.end() && !requestIt->second.expired) {
+    assert(requestedPeerIt->second.requestedCount > 0);
+    --requestedPeerIt->second.requestedCount;
+  }
+
+  m_requests.erase(requestIt);
+}
+
+std::map<TransactionInventory::PeerId, std::vector<Crypto::Hash>> TransactionInventory::expireRequests(Clock::time_point now) {
+  std::map<PeerId, std::vector<Crypto::Hash>> newRequests;
+  for (auto it = m_requests.begin(); it != m_requests.end();) {
+    Request& request = it->second;
+    if (!request.expired && now - request.time < m_requestTimeout) {
+      ++it;
+      continue;
+    }
+
+    auto requestedPeerIt = m_peers.find(request.peerId);
+    if (requestedPeerIt != m_peers.end() && !request.expired) {
+      assert(requestedPeerIt->second.requestedCount > 0);
+      --requestedPeerIt->second.requestedCount;
+    }
+
+    // The next peer in order that announced the transaction, requests move round the announcers until one of them answers
+    const Crypto::Hash& transactionHash = it->first;
+    auto nextPeerIt = m_peers.end();
+    if (requestedPeerIt != m_peers.end()) {
+      for (auto peerIt = std::next(requestedPeerIt); peerIt != m_peers.end() && nextPeerIt == m_peers.end(); ++peerIt) {
+        if (peerIt->second.knownHashes.count(transactionHash) != 0 && peerIt->second.requestedCount < m_maxRequestedCount) {
+          nextPeerIt = peerIt;
+        }
+      }
+    }
+
+    for (auto peerIt = m_peers.begin(); peerIt != requestedPeerIt && nextPeerIt == m_peers.end(); ++peerIt) {
+      if (peerIt->second.knownHashes.count(transactionHash) != 0 && peerIt->second.requestedCount < m_maxRequestedCount) {
+        nextPeerIt = peerIt;
+      }
+    }
+
+    // The peers skip transactions they don't have, one that nobody sends is forgotten until it's announced again
+    if (nextPeerIt == m_peers.end() || request.attemptsCount >= m_maxRequestAttempts) {
+      it = m_requests.erase(it);
+      continue;
+    }
+
+    request.peerId = nextPeerIt->first;
+    request.time = now;
+    request.expired = false;
+    ++request.attemptsCount;
+    ++nextPeerIt->second.requestedCount;
+    newRequests[nextPeerIt->first].push_back(transactionHash);
+    ++it;
+  }
+
+  for (auto& peer : m_peers) {
+    while (!peer.second.queuedHashes.empty() && peer.second.requestedCount < m_maxRequestedCount) {
+      Crypto::Hash transactionHash = peer.second.queuedHashes.front();
+      peer.second.queuedHashes.pop_front();
+      removeQueued(transactionHash);
+      if (m_requests.count(transactionHash) == 0) {
+        addRequest(peer.first, peer.second, transactionHash, now);
+        newRequests[peer.first].push_back(transactionHash);
+      }
+    }
+  }
+
+  return newRequests;
+}
+
+void TransactionInventory::removePeer(const PeerId& peerId) {
+  auto it = m_peers.find(peerId);
+  if (it == m_peers.end()) {
+    return;
+  }
+
+  for (const auto& transactionHash : it->second.queuedHashes) {
+    removeQueued(transactionHash);
+  }
+
+  m_peers.erase(it);
+
+  for (auto& request : m_requests) {
+    if (request.second.peerId == peerId) {
+      request.second.expired = true;
+    }
+  }
+}
+
+bool TransactionInventory::isKnown(const PeerId& peerId, const Crypto::Hash& transactionHash) const {
+  auto it = m_peers.find(peerId);
+  return it != m_peers.end() && it->second.knownHashes.count(transactionHash) != 0;
+}
+
+bool TransactionInventory::isRequested(const Crypto::Hash& transactionHash) const {
+  return m_requests.count(transactionHash) != 0;
+}
+
+bool TransactionInventory::isQueued(const Crypto::Hash& transactionHash) const {
+  return m_queuedHashes.count(transactionHash) != 0;
+}
+
+size_t TransactionInventory::getRequestedCount(const PeerId& peerId) const {
+  auto it = m_peers.find(peerId);
+  return it != m_peers.end() ? it->second.requestedCount : 0;
+}
+
+void TransactionInventory::addKnown(Peer& peer, const Crypto::Hash& transactionHash) {
+  if (!peer.knownHashes.insert(transactionHash).second) {
+    return;
+  }
+
+  peer.knownHashesOrder.push_back(transactionHash);
+  if (peer.knownHashesOrder.size() > m_knownHashesCount) {
+    peer.knownHashes.erase(peer.knownHashesOrder.front());
+    peer.knownHashesOrder.pop_front();
+  }
+}
+
+void TransactionInventory::addRequest(const PeerId& peerId, Peer& peer, const Crypto::Hash& transactionHash, Clock::time_point now) {
+  m_requests[transactionHash] = Request{peerId, now, false, 1};
+  ++peer.requestedCount;
+}
+
+void TransactionInventory::addQueued(Peer& peer, const Crypto::Hash& transactionHash) {
+  if (peer.queuedHashes.size() >= m_knownHashesCount) {
+    removeQueued(peer.queuedHashes.front());
+    peer.queuedHashes.pop_front();
+  }
+
+  peer.queuedHashes.push_back(transactionHash);
+  ++m_queuedHashes[transactionHash];
+}
+
+// Drops the hash from the queues of all peers
+void TransactionInventory::eraseQueued(const Crypto::Hash& transactionHash) {
+  for (auto& peer : m_peers) {
+    auto& queuedHashes = peer.second.queuedHashes;
+    queuedHashes.erase(std::remove(queuedHashes.begin(), queuedHashes.end(), transactionHash), queuedHashes.end());
+  }
+
+  m_queuedHashes.erase(transactionHash);
+}
+
+void TransactionInventory::removeQueued(const Crypto::Hash& transactionHash) {
+  auto it = m_queuedHashes.find(transactionHash);
+  if (it != m_queuedHashes.end() && --it->second == 0) {
+    m_queuedHashes.erase(it);
+  }
+}
+
+}
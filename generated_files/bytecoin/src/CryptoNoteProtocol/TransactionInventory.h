@@ -0,0 +1,103 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <boost/uuid/uuid.hpp>
+
+#include "crypto/hash.h"
+
+namespace CryptoNote {
+
+// Transaction relay state of the peers: the transactions each peer has, the hashes waiting to be announced to it
+// and the transactions requested from it. A transaction announced by several peers is requested from one of them at a time,
+// if it isn't received in time it's requested from another peer that announced it. Announced transactions over the limit
+// of the peer's requests wait in a queue of the peer until its earlier requests are answered.
+class TransactionInventory {
+public:
+  typedef std::chrono::steady_clock Clock;
+  typedef boost::uuids::uuid PeerId;
+
+  // knownHashesCount bounds the remembered and the queued hashes of each peer, the oldest are forgotten first.
+  // A transaction is requested from maxRequestAttempts peers at most, a peer skips transactions it doesn't have
+  TransactionInventory(size_t knownHashesCount, size_t maxRequestedCount, std::chrono::milliseconds requestTimeout, size_t maxRequestAttempts);
+
+  TransactionInventory(const TransactionInventory&) = delete;
+  TransactionInventory& operator=(const TransactionInventory&) = delete;
+
+  // Queues the hash to be announced to the peer, unless the peer has the transaction
+  void addAnnouncement(const PeerId& peerId, const Crypto::Hash& transactionHash);
+  std::vector<Crypto::Hash> takeAnnouncements(const PeerId& peerId);
+
+  // The peer announced transactions the node doesn't have. Returns the ones to request from it,
+  // that aren't requested from another peer already and fit in the limit of the peer's requests, the rest is queued
+  std::vector<Crypto::Hash> addAnnounced(const PeerId& peerId, const std::vector<Crypto::Hash>& transactionHashes, Clock::time_point now);
+  // The peer sent the transaction, requested or not
+  void addReceived(const PeerId& peerId, const Crypto::Hash& transactionHash);
+  // Requests not answered in time are moved to other peers that announced the transactions and queued transactions
+  // are requested from peers with free requests, returns the new requests by peer
+  std::map<PeerId, std::vector<Crypto::Hash>> expireRequests(Clock::time_point now);
+  // Transactions requested from the peer are moved to other peers by the next expireRequests
+  void removePeer(const PeerId& peerId);
+
+  bool isKnown(const PeerId& peerId, const Crypto::Hash& transactionHash) const;
+  bool isRequested(const Crypto::Hash& transactionHash) const;
+  bool isQueued(const Crypto::Hash& transactionHash) const;
+  size_t getRequestedCount(const PeerId& peerId) const;
+
+private:
+  struct Peer {
+    std::unordered_set<Crypto::Hash> knownHashes;
+    std::deque<Crypto::Hash> knownHashesOrder;
+    std::vector<Crypto::Hash> announcements;
+    std::deque<Crypto::Hash> queuedHashes;
+    size_t requestedCount = 0;
+  };
+
+  struct Request {
+    PeerId peerId;
+    Clock::time_point time;
+    bool expired;
+    size_t attemptsCount;
+  };
+
+  void addKnown(Peer& peer, const Crypto::Hash& transactionHash);
+  void addRequest(const PeerId& peerId, Peer& peer, const Crypto::Hash& transactionHash, Clock::time_point now);
+  void addQueued(Peer& peer, const Crypto::Hash& transactionHash);
+  void eraseQueued(const Crypto::Hash& transactionHash);
+  void removeQueued(const Crypto::Hash& transactionHash);
+
+  const size_t m_knownHashesCount;
+  const size_t m_maxRequestedCount;
+  const std::chrono::milliseconds m_requestTimeout;
+  const size_t m_maxRequestAttempts;
+  std::map<PeerId, Peer> m_peers;
+  std::unordered_map<Crypto::Hash, Request> m_requests;
+  // Queued transactions with the number of peer queues they are in
+  std::unordered_map<Crypto::Hash, size_t> m_queuedHashes;
+};
+
+}
@@ -0,0 +1,182 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "TransactionPoolSketch.h"
+
+#include <cstring>
+
+#include "Serialization/SerializationOverloads.h"
+
+namespace CryptoNote {
+
+namespace {
+
+// Cell indexes and the checksum come from a hash of the key, sums of keys don't have matching checksums then
+void hashKey(const Crypto::Hash& key, uint64_t (&words)[TransactionPoolSketch::HASH_FUNCTIONS_COUNT + 1]) {
+  static_assert(sizeof(words) <= sizeof(Crypto::Hash), "Key hash is too short");
+  Crypto::Hash keyHash = Crypto::cn_fast_hash(key.data, sizeof(key.data));
+  memcpy(words, keyHash.data, sizeof(words));
+}
+
+void xorHash(Crypto::Hash& sum, const Crypto::Hash& hash) {
+  for (size_t i = 0; i < sizeof(sum.data); ++i) {
+    sum.data[i] ^= hash.data[i];
+  }
+}
+
+}
+
+const size_t TransactionPoolSketch::HASH_FUNCTIONS_COUNT;
+const size_t TransactionPoolSketch::CELL_SIZE;
+
+TransactionPoolSketch::TransactionPoolSketch() {
+}
+
+TransactionPoolSketch::TransactionPoolSketch(size_t cellsCount) :
+  m_cells((cellsCount + HASH_FUNCTIONS_COUNT - 1) / HASH_FUNCTIONS_COUNT * HASH_FUNCTIONS_COUNT, Cell{0, Crypto::Hash(), 0}) {
+}
+
+void TransactionPoolSketch::insert(const Crypto::Hash& transactionHash) {
+  update(m_cells, transactionHash, 1);
+}
+
+bool TransactionPoolSketch::subtract(const TransactionPoolSketch& other) {
+  if (m_cells.size() != other.m_cells.size()) {
+    return false;
+  }
+
+  for (size_t i = 0; i < m_cells.size(); ++i) {
+    m_cells[i].count -= other.m_cells[i].count;
+    xorHash(m_cells[i].keySum, other.m_cells[i].keySum);
+    m_cells[i].checksumSum ^= other.m_cells[i].checksumSum;
+  }
+
+  return true;
+}
+
+bool TransactionPoolSketch::decode(std::vector<Crypto::Hash>& insertedHashes, std::vector<Crypto::Hash>& subtractedHashes) const {
+  std::vector<Cell> cells = m_cells;
+  std::vector<size_t> pureCells;
+  for (size_t i = 0; i < cells.size(); ++i) {
+    if (isPure(cells[i])) {
+      pureCells.push_back(i);
+    }
+  }
+
+  // Every peeled key empties a cell, a sketch made up by a peer can't make it loop longer
+  size_t peeledCount = 0;
+  while (!pureCells.empty() && peeledCount <= cells.size()) {
+    size_t index = pureCells.back();
+    pureCells.pop_back();
+    if (!isPure(cells[index])) {
+      continue;
+    }
+
+    Crypto::Hash key = cells[index].keySum;
+    int32_t count = cells[index].count;
+    if (count > 0) {
+      insertedHashes.push_back(key);
+    } else {
+      subtractedHashes.push_back(key);
+    }
+
+    update(cells, key, -count);
+    ++peeledCount;
+
+    uint64_t words[HASH_FUNCTIONS_COUNT + 1];
+    hashKey(key, words);
+    size_t partitionSize = cells.size() / HASH_FUNCTIONS_COUNT;
+    for (size_t i = 0; i < HASH_FUNCTIONS_COUNT; ++i) {
+      size_t cellIndex = i * partitionSize + words[i] % partitionSize;
+      if (isPure(cells[cellIndex])) {
+        pureCells.push_back(cellIndex);
+      }
+    }
+  }
+
+  for (const auto& cell : cells) {
+    if (cell.count != 0 || cell.checksumSum != 0 || cell.keySum != Crypto::Hash()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+size_t TransactionPoolSketch::getCellsCount() const {
+  return m_cells.size();
+}
+
+void TransactionPoolSketch::serialize(ISerializer& s) {
+  std::vector<int32_t> counts;
+  std::vector<Crypto::Hash> keySums;
+  std::vector<uint64_t> checksumSums;
+  if (s.type() == ISerializer::OUTPUT) {
+    for (const auto& cell : m_cells) {
+      counts.push_back(cell.count);
+      keySums.push_back(cell.keySum);
+      checksumSums.push_back(cell.checksumSum);
+    }
+  }
+
+  serializeAsBinary(counts, "counts", s);
+  serializeAsBinary(keySums, "key_sums", s);
+  serializeAsBinary(checksumSums, "checksum_sums", s);
+
+  if (s.type() == ISerializer::INPUT) {
+    // A malformed sketch is left empty, it has no cells to match
+    m_cells.clear();
+    if (counts.size() != keySums.size() || counts.size() != checksumSums.size() || counts.size() % HASH_FUNCTIONS_COUNT != 0) {
+      return;
+    }
+
+    for (size_t i = 0; i < counts.size(); ++i) {
+      m_cells.push_back(Cell{counts[i], keySums[i], checksumSums[i]});
+    }
+  }
+}
+
+void TransactionPoolSketch::update(std::vector<Cell>& cells, const Crypto::Hash& transactionHash, int32_t count) const {
+  if (cells.empty()) {
+    return;
+  }
+
+  uint64_t words[HASH_FUNCTIONS_COUNT + 1];
+  hashKey(transactionHash, words);
+
+  // Each hash function has its own partition of cells, so a key always gets distinct cells
+  size_t partitionSize = cells.size() / HASH_FUNCTIONS_COUNT;
+  for (size_t i = 0; i < HASH_FUNCTIONS_COUNT; ++i) {
+    Cell& cell = cells[i * partitionSize + words[i] % partitionSize];
+    cell.count += count;
+    xorHash(cell.keySum, transactionHash);
+    cell.checksumSum ^= words[HASH_FUNCTIONS_COUNT];
+  }
+}
+
+bool TransactionPoolSketch::isPure(const Cell& cell) const {
+  if (cell.count != 1 && cell.count != -1) {
+    return false;
+  }
+
+  uint64_t words[HASH_FUNCTIONS_COUNT + 1];
+  hashKey(cell.keySum, words);
+  return cell.checksumSum == words[HASH_FUNCTIONS_COUNT];
+}
+
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Serialization/ISerializer.h"
+#include "crypto/hash.h"
+
+namespace CryptoNote {
+
+// Invertible Bloom lookup table of transaction hashes. Two peers find the differences of their pools by subtracting
+// their sketches, the traffic is proportional to the difference rather than to the pool size.
+// Decoding succeeds with high probability while the difference is below about two thirds of the cells count.
+class TransactionPoolSketch {
+public:
+  static const size_t HASH_FUNCTIONS_COUNT = 3;
+  // Serialized size of one cell: count, key sum and checksum sum
+  static const size_t CELL_SIZE = sizeof(int32_t) + sizeof(Crypto::Hash) + sizeof(uint64_t);
+
+  TransactionPoolSketch();
+  // The cells count is rounded up to a multiple of HASH_FUNCTIONS_COUNT
+  explicit TransactionPoolSketch(size_t cellsCount);
+
+  void insert(const Crypto::Hash& transactionHash);
+  // Removes the transactions of the other sketch, returns false if the sketches have different sizes
+  bool subtract(const TransactionPoolSketch& other);
+  // Lists the transactions inserted but not subtracted and the ones subtracted but not inserted.
+  // Returns false if the difference is too large to decode, the lists are incomplete then.
+  bool decode(std::vector<Crypto::Hash>& insertedHashes, std::vector<Crypto::Hash>& subtractedHashes) const;
+
+  size_t getCellsCount() const;
+
+  void serialize(ISerializer& s);
+
+private:
+  struct Cell {
+    int32_t count;
+    Crypto::Hash keySum;
+    uint64_t checksumSum;
+  };
+
+  void update(std::vector<Cell>& cells, const Crypto::Hash& transactionHash, int32_t count) const;
+  bool isPure(const Cell& cell) const;
+
+  std::vector<Cell> m_cells;
+};
+
+}
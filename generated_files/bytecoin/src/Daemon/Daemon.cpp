@@ -15,6 +15,7 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <chrono>
 #include <fstream>
 
 #include <boost/filesystem.hpp>
@@ -31,9 +32,11 @@
 #include "crypto/hash.h"
 #include "CryptoNoteCore/CryptoNoteTools.h"
 #include "CryptoNoteCore/Core.h"
+#include "CryptoNoteCore/CoreConfig.h"
 #include "CryptoNoteCore/Currency.h"
 #include "CryptoNoteCore/DatabaseBlockchainCache.h"
 #include "CryptoNoteCore/DatabaseBlockchainCacheFactory.h"
+#include "CryptoNoteCore/DatabaseMainChainStorage.h"
 #include "CryptoNoteCore/MainChainStorage.h"
 #include "CryptoNoteCore/MinerConfig.h"
 #include "CryptoNoteCore/RocksDBWrapper.h"
@@ -69,11 +72,13 @@ namespace
   const command_line::arg_descriptor<bool> arg_blockexplorer_on = {"enable-blockexplorer", "Enable blockchain explorer RPC", false};
   const command_line::arg_descriptor<std::vector<std::string>>        arg_enable_cors = { "enable-cors", "Adds header 'Access-Control-Allow-Origin' to the daemon's RPC responses. Uses the value as domain. Use * for all" };
   const command_line::arg_descriptor<std::vector<std::string>> arg_genesis_block_reward_address = { "genesis-block-reward-address", "" };
+  const command_line::arg_descriptor<bool>        arg_migrate_blocks_storage = { "migrate-blocks-storage", "Moves main chain blocks to the storage set by --blocks-storage and exits" };
   const command_line::arg_descriptor<bool>        arg_testnet_on  = {"testnet", "Used to deploy test nets. Checkpoints and hardcoded seeds are ignored, "
     "network id is changed. Use it with --data-dir flag. The wallet must be launched with --testnet flag.", false};
 }
 
 bool command_line_preprocessor(const boost::program_options::variables_map& vm, LoggerRef& logger);
+void copyBlocks(const IMainChainStorage& from, IMainChainStorage& to);
 void print_genesis_tx_hex(const po::variables_map& vm, LoggerManager& logManager) {
   /*std::vector<CryptoNote::AccountPublicAddress> targets;
   auto genesis_block_reward_addresses = command_line::get_arg(vm, arg_genesis_block_reward_address);
@@ -154,10 +159,12 @@ command_line::add_arg(desc_cmd_sett, arg_enable_cors);
     command_line::add_arg(desc_cmd_sett, arg_blockexplorer_on);
 command_line::add_arg(desc_cmd_sett, arg_print_genesis_tx);
   command_line::add_arg(desc_cmd_sett, arg_genesis_block_reward_address);
+    command_line::add_arg(desc_cmd_sett, arg_migrate_blocks_storage);
 
     RpcServerConfig::initOptions(desc_cmd_sett);
     NetNodeConfig::initOptions(desc_cmd_sett);
     DataBaseConfig::initOptions(desc_cmd_sett);
+    CoreConfig::initOptions(desc_cmd_sett);
 
     po::options_description desc_options("Allowed options");
     desc_options.add(desc_cmd_only).add(desc_cmd_sett);
@@ -258,7 +265,10 @@ currencyBuilder.isBlockexplorer(blockexplorer_mode);
     rpcConfig.init(vm);
 
     DataBaseConfig dbConfig;
-    dbConfig.init(vm);
+    if (!dbConfig.init(vm)) {
+      logger(ERROR, BRIGHT_RED) << "Invalid data base options";
+      return 1;
+    }
 
     if (dbConfig.isConfigFolderDefaulted()) {
       if (!Tools::create_directories_if_necessary(dbConfig.getDataDir())) {
@@ -270,12 +280,33 @@ currencyBuilder.isBlockexplorer(blockexplorer_mode);
       }
     }
 
+    CoreConfig coreConfig;
+    if (!coreConfig.init(vm)) {
+      logger(ERROR, BRIGHT_RED) << "Invalid core options";
+      return 1;
+    }
+
+    bool migrateBlocksStorage = command_line::get_arg(vm, arg_migrate_blocks_storage);
+    bool blocksInDataBase = coreConfig.getBlocksStorage() == CoreConfig::BlocksStorage::DATABASE;
+    //when migrating, core is loaded from the storage the blocks are moved from
+    bool loadBlocksFromDataBase = blocksInDataBase != migrateBlocksStorage;
+    if (blocksInDataBase && !migrateBlocksStorage && mainChainStorageExists(data_dir_path.string(), currency)) {
+      logger(WARNING, BRIGHT_YELLOW) << "Blocks are stored in the DB, but " << currency.blocksFileName() << " files still exist. "
+        "Launch with --" << arg_migrate_blocks_storage.name << " --blocks-storage=db to move missing blocks to the DB and remove it";
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+
     RocksDBWrapper database(logManager);
     database.init(dbConfig);
     Tools::ScopeExit dbShutdownOnExit([&database] () { database.shutdown(); });
 
     if (!DatabaseBlockchainCache::checkDBSchemeVersion(database, logManager))
     {
+      if (loadBlocksFromDataBase) {
+        logger(WARNING, BRIGHT_YELLOW) << "Blocks are stored in the DB only, all of them will be downloaded again";
+      }
+
       dbShutdownOnExit.cancel();
       database.shutdown();
 
@@ -285,6 +316,11 @@ currencyBuilder.isBlockexplorer(blockexplorer_mode);
       dbShutdownOnExit.resume();
     }
 
+    if (migrateBlocksStorage && !blocksInDataBase) {
+      //blocks files are written from scratch
+      removeMainChainStorage(data_dir_path.string(), currency);
+    }
+
     System::Dispatcher dispatcher;
     logger(INFO) << "Initializing core...";
     CryptoNote::Core ccore(
@@ -292,13 +328,29 @@ currencyBuilder.isBlockexplorer(blockexplorer_mode);
       logManager,
       std::move(checkpoints),
       dispatcher,
-      std::unique_ptr<IBlockchainCacheFactory>(new DatabaseBlockchainCacheFactory(database, logger.getLogger())),
-      createSwappedMainChainStorage(data_dir_path.string(), currency));
+      std::unique_ptr<IBlockchainCacheFactory>(new DatabaseBlockchainCacheFactory(database, logger.getLogger(), dbConfig.getSpentKeyImagesFilterSize())),
+      loadBlocksFromDataBase ? createDatabaseMainChainStorage(database) : createSwappedMainChainStorage(data_dir_path.string(), currency),
+      coreConfig);
 
     ccore.load();
-    logger(INFO) << "Core initialized OK";
+    logger(INFO) << "Core initialized OK in " <<
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count() << " ms";
+
+    if (migrateBlocksStorage) {
+      if (blocksInDataBase) {
+        //core has imported to the DB the blocks it missed
+        ccore.save();
+        removeMainChainStorage(data_dir_path.string(), currency);
+      } else {
+        auto fileStorage = createSwappedMainChainStorage(data_dir_path.string(), currency);
+        copyBlocks(*createDatabaseMainChainStorage(database), *fileStorage);
+      }
 
-    CryptoNote::CryptoNoteProtocolHandler cprotocol(currency, dispatcher, ccore, nullptr, logManager);
+      logger(INFO) << "Blocks moved to " << (blocksInDataBase ? "the DB" : currency.blocksFileName());
+      return 0;
+    }
+
+    CryptoNote::CryptoNoteProtocolHandler cprotocol(currency, dispatcher, ccore, nullptr, logManager, coreConfig.getProofOfWorkThreadsCount());
     CryptoNote::NodeServer p2psrv(dispatcher, cprotocol, logManager);
     CryptoNote::RpcServer rpcServer(dispatcher, logManager, ccore, p2psrv, cprotocol);
 
@@ -370,3 +422,10 @@ bool command_line_preprocessor(const boost::program_options::variables_map &vm,
 
   return false;
 }
+
+void copyBlocks(const IMainChainStorage& from, IMainChainStorage& to) {
+  //genesis block is already in every storage
+  for (uint32_t index = to.getBlockCount(); index < from.getBlockCount(); ++index) {
+    to.pushBlock(from.getBlockByIndex(index));
+  }
+}
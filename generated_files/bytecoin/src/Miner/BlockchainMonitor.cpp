@@ -18,6 +18,7 @@
 #include "BlockchainMonitor.h"
 
 #include "Common/StringTools.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
 
 #include <System/EventLock.h>
 #include <System/Timer.h>
@@ -27,10 +28,12 @@
 #include "Rpc/JsonRpc.h"
 #include "Rpc/HttpClient.h"
 
-BlockchainMonitor::BlockchainMonitor(System::Dispatcher& dispatcher, const std::string& daemonHost, uint16_t daemonPort, size_t pollingInterval, Logging::ILogger& logger):
+BlockchainMonitor::BlockchainMonitor(System::Dispatcher& dispatcher, const std::string& daemonHost, uint16_t daemonPort, const std::string& miningAddress, size_t pollingInterval, Logging::ILogger& logger):
   m_dispatcher(dispatcher),
   m_daemonHost(daemonHost),
   m_daemonPort(daemonPort),
+  m_miningAddress(miningAddress),
+  m_hasLongPollParameters(false),
   m_pollingInterval(pollingInterval),
   m_stopped(false),
   m_httpEvent(dispatcher),
@@ -40,22 +43,47 @@ BlockchainMonitor::BlockchainMonitor(System::Dispatcher& dispatcher, const std::
   m_httpEvent.set();
 }
 
+void BlockchainMonitor::setLongPollId(const std::string& longPollId) {
+  m_longPollId = longPollId;
+}
+
 void BlockchainMonitor::waitBlockchainUpdate() {
   m_logger(Logging::DEBUGGING) << "Waiting for blockchain updates";
   m_stopped = false;
+  m_hasLongPollParameters = false;
 
-  Crypto::Hash lastBlockHash = requestLastBlockHash();
+  Crypto::Hash lastBlockHash = m_longPollId.empty() ? requestLastBlockHash() : Crypto::Hash();
 
   while(!m_stopped) {
-    m_sleepingContext.spawn([this] () {
-      System::Timer timer(m_dispatcher);
-      timer.sleep(std::chrono::seconds(m_pollingInterval));
+    std::string longPollId;
+    CryptoNote::BlockMiningParameters params;
+    m_sleepingContext.spawn([this, &longPollId, &params] () {
+      if (!m_longPollId.empty()) {
+        longPollId = requestLongPollId(params);
+      }
+
+      // daemon doesn't support long polling or is unreachable
+      if (longPollId.empty()) {
+        System::Timer timer(m_dispatcher);
+        timer.sleep(std::chrono::seconds(m_pollingInterval));
+      }
     });
 
     m_sleepingContext.wait();
 
-    if (lastBlockHash != requestLastBlockHash()) {
+    if (m_stopped) {
+      break;
+    }
+
+    if (!longPollId.empty() ? longPollId != m_longPollId : lastBlockHash != requestLastBlockHash()) {
       m_logger(Logging::DEBUGGING) << "Blockchain has been updated";
+      if (!longPollId.empty()) {
+        // the long poll response carries the new template, no need to request it again
+        m_longPollId = longPollId;
+        m_longPollParameters = std::move(params);
+        m_hasLongPollParameters = true;
+      }
+
       break;
     }
   }
@@ -66,6 +94,16 @@ void BlockchainMonitor::waitBlockchainUpdate() {
   }
 }
 
+bool BlockchainMonitor::takeMiningParameters(CryptoNote::BlockMiningParameters& params) {
+  if (!m_hasLongPollParameters) {
+    return false;
+  }
+
+  params = std::move(m_longPollParameters);
+  m_hasLongPollParameters = false;
+  return true;
+}
+
 void BlockchainMonitor::stop() {
   m_logger(Logging::DEBUGGING) << "Sending stop signal to blockchain monitor";
   m_stopped = true;
@@ -74,6 +112,43 @@ void BlockchainMonitor::stop() {
   m_sleepingContext.wait();
 }
 
+std::string BlockchainMonitor::requestLongPollId(CryptoNote::BlockMiningParameters& params) {
+  m_logger(Logging::DEBUGGING) << "Waiting for block template change, long poll id " << m_longPollId;
+
+  try {
+    CryptoNote::HttpClient client(m_dispatcher, m_daemonHost, m_daemonPort);
+
+    CryptoNote::COMMAND_RPC_GETBLOCKTEMPLATE::request request;
+    request.reserve_size = 0;
+    request.wallet_address = m_miningAddress;
+    request.uptime = 0;
+    request.numberOfsubmit = 0;
+    request.numberOfreject = 0;
+    request.longpoll_id = m_longPollId;
+
+    CryptoNote::COMMAND_RPC_GETBLOCKTEMPLATE::response response;
+
+    System::EventLock lk(m_httpEvent);
+    CryptoNote::JsonRpc::invokeJsonRpcCommand(client, "getblocktemplate", request, response);
+
+    if (response.status != CORE_RPC_STATUS_OK) {
+      throw std::runtime_error("Core responded with wrong status: " + response.status);
+    }
+
+    params.difficulty = response.difficulty;
+    if (!CryptoNote::fromBinaryArray(params.blockTemplate, Common::fromHex(response.blocktemplate_blob))) {
+      throw std::runtime_error("Couldn't deserialize block template");
+    }
+
+    return response.longpoll_id;
+  } catch (System::InterruptedException&) {
+    throw;
+  } catch (std::exception& e) {
+    m_logger(Logging::DEBUGGING) << "Failed to long poll block template: " << e.what();
+    return std::string();
+  }
+}
+
 Crypto::Hash BlockchainMonitor::requestLastBlockHash() {
   m_logger(Logging::DEBUGGING) << "Requesting last block hash";
 
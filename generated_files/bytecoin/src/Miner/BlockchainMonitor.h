@@ -24,17 +24,26 @@
 #include <System/Event.h>
 
 #include "Logging/LoggerRef.h"
+#include "Miner.h"
 
 class BlockchainMonitor {
 public:
-  BlockchainMonitor(System::Dispatcher& dispatcher, const std::string& daemonHost, uint16_t daemonPort, size_t pollingInterval, Logging::ILogger& logger);
+  BlockchainMonitor(System::Dispatcher& dispatcher, const std::string& daemonHost, uint16_t daemonPort, const std::string& miningAddress, size_t pollingInterval, Logging::ILogger& logger);
 
+  // Long poll id of the last requested block template, daemon is polled on a timer while it is empty
+  void setLongPollId(const std::string& longPollId);
   void waitBlockchainUpdate();
+  // Mining parameters returned by the long poll which saw the last update, false if it was seen by polling
+  bool takeMiningParameters(CryptoNote::BlockMiningParameters& params);
   void stop();
 private:
   System::Dispatcher& m_dispatcher;
   std::string m_daemonHost;
   uint16_t m_daemonPort;
+  std::string m_miningAddress;
+  std::string m_longPollId;
+  CryptoNote::BlockMiningParameters m_longPollParameters;
+  bool m_hasLongPollParameters;
   size_t m_pollingInterval;
   bool m_stopped;
   System::Event m_httpEvent;
@@ -43,4 +52,5 @@ private:
   Logging::LoggerRef m_logger;
 
   Crypto::Hash requestLastBlockHash();
+  std::string requestLongPollId(CryptoNote::BlockMiningParameters& params);
 };
@@ -81,7 +81,7 @@ MinerManager::MinerManager(System::Dispatcher& dispatcher, const CryptoNote::Min
   m_contextGroup(dispatcher),
   m_config(config),
   m_miner(dispatcher, logger),
-  m_blockchainMonitor(dispatcher, m_config.daemonHost, m_config.daemonPort, m_config.scanPeriod, logger),
+  m_blockchainMonitor(dispatcher, m_config.daemonHost, m_config.daemonPort, m_config.miningAddress, m_config.scanPeriod, logger),
   m_eventOccurred(dispatcher),
   m_httpEvent(dispatcher),
   m_lastBlockTimestamp(0),
@@ -161,7 +161,13 @@ void MinerManager::eventLoop() {
         m_logger(Logging::DEBUGGING) << "got BLOCKCHAIN_UPDATED event";
         stopMining();
         stopBlockchainMonitoring();
-        BlockMiningParameters params = requestMiningParameters(m_dispatcher, m_config.daemonHost, m_config.daemonPort, m_config.miningAddress);
+        BlockMiningParameters params;
+        if (m_blockchainMonitor.takeMiningParameters(params)) {
+          m_logger(Logging::DEBUGGING) << "Block template with previous block hash " << Common::podToHex(params.blockTemplate.previousBlockHash) << " came with the update";
+        } else {
+          params = requestMiningParameters(m_dispatcher, m_config.daemonHost, m_config.daemonPort, m_config.miningAddress);
+        }
+
         if (params.difficulty==0){
         	startBlockchainMonitoring();
         	 break;
@@ -287,6 +293,7 @@ BlockMiningParameters MinerManager::requestMiningParameters(System::Dispatcher&
 
     BlockMiningParameters params;
     params.difficulty = response.difficulty;
+    m_blockchainMonitor.setLongPollId(response.longpoll_id);
 
     if(!fromBinaryArray(params.blockTemplate, Common::fromHex(response.blocktemplate_blob))) {
       throw std::runtime_error("Couldn't deserialize block template");
@@ -0,0 +1,117 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BlockRequestSizer.h"
+
+#include <algorithm>
+
+#include "CryptoNoteConfig.h"
+
+namespace CryptoNote {
+
+namespace {
+
+// Weight of the last measurement in the moving averages
+const double MEASUREMENT_WEIGHT = 0.3;
+
+double updateAverage(double average, double measurement) {
+  return average == 0 ? measurement : average + MEASUREMENT_WEIGHT * (measurement - average);
+}
+
+}
+
+BlockRequestSizer::BlockRequestSizer() :
+  BlockRequestSizer(BLOCKS_SYNCHRONIZING_DEFAULT_COUNT, BLOCKS_SYNCHRONIZING_MAX_COUNT, BLOCKS_SYNCHRONIZING_TARGET_RESPONSE_SIZE,
+                    std::chrono::milliseconds(BLOCKS_DOWNLOAD_STALL_TIMEOUT / 2)) {
+}
+
+BlockRequestSizer::BlockRequestSizer(size_t defaultBlocksCount, size_t maxBlocksCount, size_t targetResponseSize, std::chrono::milliseconds maxResponseDuration) :
+  m_defaultBlocksCount(defaultBlocksCount),
+  m_maxBlocksCount(maxBlocksCount),
+  m_targetResponseSize(targetResponseSize),
+  m_maxResponseSeconds(std::chrono::duration<double>(maxResponseDuration).count()),
+  m_chainRequested(false),
+  m_blocksRequested(false),
+  m_latencySeconds(0),
+  m_bytesPerSecond(0),
+  m_averageBlockSize(0) {
+}
+
+void BlockRequestSizer::onChainRequested(Clock::time_point now) {
+  m_chainRequested = true;
+  m_chainRequestTime = now;
+}
+
+void BlockRequestSizer::onChainReceived(Clock::time_point now) {
+  if (!m_chainRequested) {
+    return;
+  }
+
+  m_chainRequested = false;
+  m_latencySeconds = updateAverage(m_latencySeconds, std::chrono::duration<double>(now - m_chainRequestTime).count());
+}
+
+void BlockRequestSizer::onBlocksRequested(Clock::time_point now) {
+  m_blocksRequested = true;
+  m_blocksRequestTime = now;
+}
+
+void BlockRequestSizer::onBlocksReceived(size_t blocksCount, size_t bytesCount, Clock::time_point now) {
+  if (!m_blocksRequested || blocksCount == 0) {
+    return;
+  }
+
+  m_blocksRequested = false;
+  double seconds = std::chrono::duration<double>(now - m_blocksRequestTime).count();
+  // Half of the time is taken for the transfer at least, in case the latency was measured on a slow moment
+  double transferSeconds = std::max(seconds - m_latencySeconds, seconds / 2);
+  if (transferSeconds > 0) {
+    m_bytesPerSecond = updateAverage(m_bytesPerSecond, bytesCount / transferSeconds);
+  }
+
+  m_averageBlockSize = updateAverage(m_averageBlockSize, static_cast<double>(bytesCount) / blocksCount);
+}
+
+size_t BlockRequestSizer::getBlocksCount() const {
+  if (m_averageBlockSize == 0 || m_bytesPerSecond == 0) {
+    return m_defaultBlocksCount;
+  }
+
+  double responseSize = std::max(static_cast<double>(m_targetResponseSize), m_bytesPerSecond * m_latencySeconds);
+  responseSize = std::min(responseSize, m_bytesPerSecond * m_maxResponseSeconds);
+
+  double blocksCount = responseSize / m_averageBlockSize;
+  if (blocksCount < 1) {
+    return 1;
+  }
+
+  return std::min(static_cast<size_t>(blocksCount), m_maxBlocksCount);
+}
+
+uint64_t BlockRequestSizer::getBytesPerSecond() const {
+  return static_cast<uint64_t>(m_bytesPerSecond);
+}
+
+std::chrono::milliseconds BlockRequestSizer::getLatency() const {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::duration<double>(m_latencySeconds));
+}
+
+size_t BlockRequestSizer::getAverageBlockSize() const {
+  return static_cast<size_t>(m_averageBlockSize);
+}
+
+}
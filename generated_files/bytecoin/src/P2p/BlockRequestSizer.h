@@ -0,0 +1,66 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace CryptoNote {
+
+// Sizes the block requests to one peer from the throughput and the latency measured on its responses.
+// A response is aimed at the target size, or at the bytes the link carries in a round trip if that's more,
+// but not at more than the peer sends in maxResponseDuration, so large blocks over a slow link aren't taken for a stall.
+class BlockRequestSizer {
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  BlockRequestSizer();
+  BlockRequestSizer(size_t defaultBlocksCount, size_t maxBlocksCount, size_t targetResponseSize, std::chrono::milliseconds maxResponseDuration);
+
+  // Chain entries are small, the time they take is the latency
+  void onChainRequested(Clock::time_point now);
+  void onChainReceived(Clock::time_point now);
+  void onBlocksRequested(Clock::time_point now);
+  void onBlocksReceived(size_t blocksCount, size_t bytesCount, Clock::time_point now);
+
+  // Blocks count of the next request, the default one until a response is measured
+  size_t getBlocksCount() const;
+
+  uint64_t getBytesPerSecond() const;
+  std::chrono::milliseconds getLatency() const;
+  size_t getAverageBlockSize() const;
+
+private:
+  size_t m_defaultBlocksCount;
+  size_t m_maxBlocksCount;
+  size_t m_targetResponseSize;
+  double m_maxResponseSeconds;
+
+  bool m_chainRequested;
+  Clock::time_point m_chainRequestTime;
+  bool m_blocksRequested;
+  Clock::time_point m_blocksRequestTime;
+
+  // Exponential moving averages, zero until measured
+  double m_latencySeconds;
+  double m_bytesPerSecond;
+  double m_averageBlockSize;
+};
+
+}
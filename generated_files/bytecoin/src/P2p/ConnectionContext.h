@@ -23,6 +23,7 @@
 
 #include <boost/uuid/uuid.hpp>
 #include "Common/StringTools.h"
+#include "P2p/BlockRequestSizer.h"
 #include "crypto/hash.h"
 
 namespace CryptoNote {
@@ -46,10 +47,15 @@ struct CryptoNoteConnectionContext {
   };
 
   state m_state = state_befor_handshake;
-  std::list<Crypto::Hash> m_needed_objects;
   std::unordered_set<Crypto::Hash> m_requested_objects;
+  // Changes when m_requested_objects is replaced, a response to an older request is stale
+  uint64_t m_request_generation = 0;
   uint32_t m_remote_blockchain_height = 0;
   uint32_t m_last_response_height = 0;
+  BlockRequestSizer m_request_sizer;
+  // Cells of the pool sketch sent to the peer and not answered yet, 0 if none, and the sketches sent after the first one
+  size_t m_pool_sketch_cells = 0;
+  size_t m_pool_sketch_retries = 0;
 };
 
 inline std::string get_protocol_state_string(CryptoNoteConnectionContext::state s) {
@@ -978,6 +978,7 @@ void  NodeServer::drop_connection(CryptoNoteConnectionContext& context, bool add
     try {
       m_connections_maker_interval.call(std::bind(&NodeServer::connections_maker, this));
       m_peerlist_store_interval.call(std::bind(&NodeServer::store_config, this));
+      m_payload_handler.onIdle();
     } catch (std::exception& e) {
       logger(DEBUGGING) << "exception in idle_worker: " << e.what();
     }
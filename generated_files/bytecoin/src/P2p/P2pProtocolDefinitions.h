@@ -55,7 +55,10 @@ namespace CryptoNote
   enum P2PProtocolVersion : uint8_t {
     V0 = 0,
     V1 = 1,
-    CURRENT = V1
+    V2 = 2,
+    V3 = 3,
+    V4 = 4,
+    CURRENT = V4
   };
 
   struct basic_node_data
@@ -47,6 +47,9 @@ public:
   void flush(uint8_t* data, uint64_t size, std::error_code& ec);
   void flush(uint8_t* data, uint64_t size);
 
+  // Hints the OS to read the range ahead, errors are ignored
+  void prefetch(const uint8_t* data, uint64_t size) const;
+
   void swap(MemoryMappedFile& other);
 
 private:
@@ -282,6 +282,12 @@ void MemoryMappedFile::flush(uint8_t* data, uint64_t size) {
   }
 }
 
+void MemoryMappedFile::prefetch(const uint8_t* data, uint64_t size) const {
+  assert(isOpened());
+
+  // PrefetchVirtualMemory isn't available before Windows 8, views are read on demand
+}
+
 void MemoryMappedFile::swap(MemoryMappedFile& other) {
   std::swap(m_fileHandle, other.m_fileHandle);
   std::swap(m_mappingHandle, other.m_mappingHandle);
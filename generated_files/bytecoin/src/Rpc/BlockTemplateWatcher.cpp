@@ -0,0 +1,161 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BlockTemplateWatcher.h"
+
+#include <System/InterruptedException.h>
+#include <System/Timer.h>
+
+#include "Common/ScopeExit.h"
+#include "Common/StringTools.h"
+#include "CryptoNoteCore/ICore.h"
+#include "CryptoNoteConfig.h"
+
+using namespace Logging;
+
+namespace CryptoNote {
+
+BlockTemplateWatcher::BlockTemplateWatcher(System::Dispatcher& dispatcher, ICore& core, Logging::ILogger& log) :
+  dispatcher(dispatcher),
+  core(core),
+  logger(log, "BlockTemplateWatcher"),
+  messageQueue(dispatcher),
+  contextGroup(dispatcher),
+  changedEvent(dispatcher),
+  started(false),
+  topBlockHash(),
+  templateVersion(0),
+  poolChanged(false),
+  waitersCount(0) {
+}
+
+void BlockTemplateWatcher::start() {
+  if (started) {
+    return;
+  }
+
+  started = true;
+  topBlockHash = core.getTopBlockHash();
+  lastChangeTime = std::chrono::steady_clock::now();
+
+  core.addMessageQueue(messageQueue);
+  contextGroup.spawn(std::bind(&BlockTemplateWatcher::watchMessages, this));
+  contextGroup.spawn(std::bind(&BlockTemplateWatcher::tick, this));
+}
+
+void BlockTemplateWatcher::stop() {
+  if (!started) {
+    return;
+  }
+
+  started = false;
+  core.removeMessageQueue(messageQueue);
+  messageQueue.stop();
+  contextGroup.interrupt();
+  contextGroup.wait();
+
+  // release the waiters, they see the watcher is stopped
+  changedEvent.set();
+  changedEvent.clear();
+}
+
+std::string BlockTemplateWatcher::getLongPollId() const {
+  return Common::podToHex(topBlockHash) + std::to_string(templateVersion);
+}
+
+void BlockTemplateWatcher::wait(const std::string& longPollId, std::chrono::seconds timeout) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+
+  ++waitersCount;
+  Tools::ScopeExit guard([this] () {
+    --waitersCount;
+  });
+
+  while (started && getLongPollId() == longPollId && std::chrono::steady_clock::now() < deadline) {
+    changedEvent.wait();
+  }
+}
+
+size_t BlockTemplateWatcher::getWaitersCount() const {
+  return waitersCount;
+}
+
+void BlockTemplateWatcher::watchMessages() {
+  using namespace Messages;
+
+  try {
+    for (;;) {
+      messageQueue.front().match(
+        [this](const NewBlock& msg) {
+          topBlockHash = msg.blockHash;
+          publishChange();
+        },
+        [](const NewAlternativeBlock&) {
+        },
+        [this](const ChainSwitch& msg) {
+          assert(!msg.blocksFromCommonRoot.empty());
+          topBlockHash = msg.blocksFromCommonRoot.back();
+          publishChange();
+        },
+        [this](const AddTransaction&) {
+          poolChanged = true;
+        },
+        [this](const DeleteTransaction& msg) {
+          // transactions included into a block come together with the new tip
+          if (msg.reason != DeleteTransaction::Reason::InBlock) {
+            poolChanged = true;
+          }
+        }
+      );
+
+      messageQueue.pop();
+    }
+  } catch (System::InterruptedException&) {
+  }
+}
+
+void BlockTemplateWatcher::tick() {
+  try {
+    System::Timer timer(dispatcher);
+    for (;;) {
+      timer.sleep(std::chrono::seconds(1));
+
+      auto now = std::chrono::steady_clock::now();
+      if (poolChanged && now - lastChangeTime >= std::chrono::seconds(RPC_LONG_POLL_POOL_UPDATE_INTERVAL)) {
+        publishChange();
+      } else if (waitersCount > 0) {
+        // let the waiters check their deadlines
+        changedEvent.set();
+        changedEvent.clear();
+      }
+    }
+  } catch (System::InterruptedException&) {
+  }
+}
+
+void BlockTemplateWatcher::publishChange() {
+  ++templateVersion;
+  poolChanged = false;
+  lastChangeTime = std::chrono::steady_clock::now();
+
+  logger(DEBUGGING) << "Block template changed, top block " << Common::podToHex(topBlockHash) << ", " << waitersCount << " long poll waiters";
+
+  changedEvent.set();
+  changedEvent.clear();
+}
+
+}
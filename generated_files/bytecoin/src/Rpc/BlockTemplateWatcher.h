@@ -0,0 +1,72 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <chrono>
+#include <string>
+
+#include <System/ContextGroup.h>
+#include <System/Dispatcher.h>
+#include <System/Event.h>
+
+#include "CryptoNoteCore/BlockchainMessages.h"
+#include "CryptoNoteCore/MessageQueue.h"
+#include <Logging/LoggerRef.h>
+
+namespace CryptoNote {
+
+class ICore;
+
+// Tracks changes of the block template for long polling getblocktemplate.
+// Tip changes are published at once, pool changes are coalesced to at most one per pool update interval.
+// The watcher runs two contexts no matter how many clients wait. A waiter parks on the shared event in the context
+// HttpServer runs for its connection, which exists between requests anyway. So a waiter doesn't cost a context of
+// its own, though it keeps the stack of its connection one busy: HttpServer writes responses only from there.
+class BlockTemplateWatcher {
+public:
+  BlockTemplateWatcher(System::Dispatcher& dispatcher, ICore& core, Logging::ILogger& log);
+
+  void start();
+  void stop();
+
+  std::string getLongPollId() const;
+  // Returns when the long poll id differs from longPollId, the timeout expires or the watcher is stopped
+  void wait(const std::string& longPollId, std::chrono::seconds timeout);
+  size_t getWaitersCount() const;
+
+private:
+  void watchMessages();
+  void tick();
+  void publishChange();
+
+  System::Dispatcher& dispatcher;
+  ICore& core;
+  Logging::LoggerRef logger;
+  MessageQueue<BlockchainMessage> messageQueue;
+  System::ContextGroup contextGroup;
+  System::Event changedEvent;
+
+  bool started;
+  Crypto::Hash topBlockHash;
+  uint64_t templateVersion;
+  bool poolChanged;
+  std::chrono::steady_clock::time_point lastChangeTime;
+  size_t waitersCount;
+};
+
+}
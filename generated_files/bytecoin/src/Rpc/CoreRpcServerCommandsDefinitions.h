@@ -302,6 +302,10 @@ struct COMMAND_RPC_GET_INFO {
     uint64_t white_peerlist_size;
     uint64_t grey_peerlist_size;
     uint32_t last_known_block_index;
+    uint64_t signature_cache_hits;
+    uint64_t signature_cache_misses;
+    uint64_t block_cache_hits;
+    uint64_t block_cache_misses;
 
     void serialize(ISerializer &s) {
       KV_MEMBER(status)
@@ -315,6 +319,10 @@ struct COMMAND_RPC_GET_INFO {
       KV_MEMBER(white_peerlist_size)
       KV_MEMBER(grey_peerlist_size)
       KV_MEMBER(last_known_block_index)
+      KV_MEMBER(signature_cache_hits)
+      KV_MEMBER(signature_cache_misses)
+      KV_MEMBER(block_cache_hits)
+      KV_MEMBER(block_cache_misses)
     }
   };
 };
@@ -372,6 +380,36 @@ struct COMMAND_RPC_GETBLOCKADDRESS {
 	};
 };
 
+struct COMMAND_RPC_GET_ACCOUNT_ADDRESSES {
+	struct request {
+		std::vector<std::string> AccountNumbers;
+
+		void serialize(ISerializer &s) {
+			KV_MEMBER(AccountNumbers)
+		}
+	};
+	struct account_entry {
+		std::string AccountNumber;
+		std::string AccountAddress;
+		bool found;
+
+		void serialize(ISerializer &s) {
+			KV_MEMBER(AccountNumber)
+			KV_MEMBER(AccountAddress)
+			KV_MEMBER(found)
+		}
+	};
+	struct response {
+		std::vector<account_entry> Accounts;
+		std::string status;
+
+		void serialize(ISerializer &s) {
+			KV_MEMBER(Accounts)
+			KV_MEMBER(status)
+		}
+	};
+};
+
 struct COMMAND_RPC_GETBLOCKHASH_BM {
 	struct request {
 		std::string AccountNumber;
@@ -404,6 +442,7 @@ struct COMMAND_RPC_GETBLOCKTEMPLATE {
     std::string hashRate;
     std::uint64_t numberOfsubmit;
     std::uint64_t numberOfreject;
+    std::string longpoll_id; // when set, the response is held until the template differs from this one
 
     void serialize(ISerializer &s) {
       KV_MEMBER(reserve_size)
@@ -414,6 +453,7 @@ struct COMMAND_RPC_GETBLOCKTEMPLATE {
 	  KV_MEMBER(hashRate)
 	  KV_MEMBER(numberOfsubmit)
 	  KV_MEMBER(numberOfreject)
+      KV_MEMBER(longpoll_id)
     }
   };
   struct HTTP_RPC_request{
@@ -427,6 +467,7 @@ struct COMMAND_RPC_GETBLOCKTEMPLATE {
     uint32_t height;
     uint64_t reserved_offset;
     std::string blocktemplate_blob;
+    std::string longpoll_id;
     std::string status;
 
     void serialize(ISerializer &s) {
@@ -434,6 +475,7 @@ struct COMMAND_RPC_GETBLOCKTEMPLATE {
       KV_MEMBER(height)
       KV_MEMBER(reserved_offset)
       KV_MEMBER(blocktemplate_blob)
+      KV_MEMBER(longpoll_id)
       KV_MEMBER(status)
     }
   };
@@ -485,6 +527,36 @@ struct COMMAND_RPC_PUSHBLOCK {
 	};
 };
 
+struct COMMAND_RPC_PUSHBLOCKS {
+	struct request {
+		std::vector<COMMAND_RPC_PUSHBLOCK::request> Accounts;
+
+		void serialize(ISerializer &s) {
+			KV_MEMBER(Accounts)
+		}
+	};
+	struct account_result {
+		std::string AccountNumber;
+		bool added;
+		std::string Status;
+
+		void serialize(ISerializer &s) {
+			KV_MEMBER(AccountNumber)
+			KV_MEMBER(added)
+			KV_MEMBER(Status)
+		}
+	};
+	struct response {
+		std::vector<account_result> Accounts;
+		std::string status;
+
+		void serialize(ISerializer &s) {
+			KV_MEMBER(Accounts)
+			KV_MEMBER(status)
+		}
+	};
+};
+
 struct COMMAND_RPC_GET_STATDISTIC_MINER {
 	struct request {
 		std::uint64_t line;
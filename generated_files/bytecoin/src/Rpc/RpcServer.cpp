@@ -18,8 +18,10 @@
 #include "RpcServer.h"
 
 #include <future>
+#include <thread>
 #include <unordered_map>
 
+#include "Common/ScopeExit.h"
 #include "Common/StringTools.h"
 #include "CryptoNoteCore/CryptoNoteTools.h"
 #include "CryptoNoteCore/Core.h"
@@ -34,6 +36,8 @@
 #include "HttpClient.h"
 #include <mutex>
 
+#include <System/RemoteContext.h>
+
 #undef ERROR
 
 using namespace Logging;
@@ -131,13 +135,16 @@ std::unordered_map<std::string, RpcServer::RpcHandler<RpcServer::HandlerFunction
   { "/sendrawtransaction", { jsonMethod<COMMAND_RPC_SEND_RAW_TX>(&RpcServer::on_send_raw_tx), false } },
   { "/stop_daemon", { jsonMethod<COMMAND_RPC_STOP_DAEMON>(&RpcServer::on_stop_daemon), true } },
   { "/getblockaddress",{ jsonMethod<COMMAND_RPC_GETBLOCKADDRESS>(&RpcServer::on_getblockblankaddress), false } },
+  { "/getaccountaddresses",{ jsonMethod<COMMAND_RPC_GET_ACCOUNT_ADDRESSES>(&RpcServer::on_get_account_addresses), false } },
 
   // json rpc
   { "/json_rpc", { std::bind(&RpcServer::processJsonRpcRequest, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3), true } }
 };
 
 RpcServer::RpcServer(System::Dispatcher& dispatcher, Logging::ILogger& log, Core& c, NodeServer& p2p, ICryptoNoteProtocolHandler& protocol) :
-HttpServer(dispatcher, log), logger(log, "RpcServer"), m_core(c), m_p2p(p2p), m_protocol(protocol),m_dispatcher(dispatcher)
+HttpServer(dispatcher, log), logger(log, "RpcServer"), m_core(c), m_p2p(p2p), m_protocol(protocol),m_dispatcher(dispatcher),
+m_templateWatcher(dispatcher, c, log), m_maxSnapshotQueriesCount(std::max<size_t>(std::thread::hardware_concurrency(), 1)),
+m_snapshotQueriesCount(0)
 /*,m_socket(socketIP,socketPort)*/{
 /*	
 	std::vector<std::string>* data_sokect= &m_stadistic;
@@ -198,7 +205,9 @@ bool RpcServer::processJsonRpcRequest(const HttpRequest& request, HttpResponse&
       { "getcurrencyid", { makeMemberMethod(&RpcServer::on_get_currency_id), true } },
       { "submitblock", { makeMemberMethod(&RpcServer::on_submitblock), false } },
 	  { "pushblock",{ makeMemberMethod(&RpcServer::on_pushblock), false } },
+	  { "pushblocks",{ makeMemberMethod(&RpcServer::on_pushblocks), false } },
 	  { "/getblockaddress",{ makeMemberMethod(&RpcServer::on_getblockblankaddress), false } },
+	  { "getaccountaddresses",{ makeMemberMethod(&RpcServer::on_get_account_addresses), false } },
       { "getlastblockheader", { makeMemberMethod(&RpcServer::on_get_last_block_header), false } },
       { "getblockheaderbyhash", { makeMemberMethod(&RpcServer::on_get_block_header_by_hash), false } },
       { "getblockheaderbyheight", { makeMemberMethod(&RpcServer::on_get_block_header_by_height), false } }, //on_get_block_hash_block_manager
@@ -227,6 +236,16 @@ bool RpcServer::processJsonRpcRequest(const HttpRequest& request, HttpResponse&
   return true;
 }
 
+void RpcServer::start(const std::string& address, uint16_t port) {
+  m_templateWatcher.start();
+  HttpServer::start(address, port);
+}
+
+void RpcServer::stop() {
+  m_templateWatcher.stop();
+  HttpServer::stop();
+}
+
 bool RpcServer::enableCors(const std::vector<std::string> domains) {
   m_cors_domains = domains;
   return true;
@@ -370,12 +389,7 @@ bool RpcServer::onGetPoolChangesLite(const COMMAND_RPC_GET_POOL_CHANGES_LITE::re
 
 bool RpcServer::onGetBlocksDetailsByHashes(const COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HASHES::request& req, COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HASHES::response& rsp) {
   try {
-    std::vector<BlockDetails> blockDetails;
-    for (const Crypto::Hash& hash : req.blockHashes) {
-      blockDetails.push_back(m_core.getBlockDetails(hash));
-    }
-
-    rsp.blocks = std::move(blockDetails);
+    rsp.blocks = getBlocksDetails(req.blockHashes);
   } catch (std::system_error& e) {
     rsp.status = e.what();
     return false;
@@ -426,14 +440,7 @@ bool RpcServer::onGetKeyOutputKeys(const COMMAND_RPC_GET_KEY_OUTPUT_KEYS::reques
 
 bool RpcServer::onGetTransactionDetailsByHashes(const COMMAND_RPC_GET_TRANSACTION_DETAILS_BY_HASHES::request& req, COMMAND_RPC_GET_TRANSACTION_DETAILS_BY_HASHES::response& rsp) {
   try {
-    std::vector<TransactionDetails> transactionDetails;
-    transactionDetails.reserve(req.transactionHashes.size());
-
-    for (const auto& hash: req.transactionHashes) {
-      transactionDetails.push_back(m_core.getTransactionDetails(hash));
-    }
-
-    rsp.transactions = std::move(transactionDetails);
+    rsp.transactions = getTransactionsDetails(req.transactionHashes);
   } catch (std::system_error& e) {
     rsp.status = e.what();
     return false;
@@ -477,6 +484,10 @@ bool RpcServer::on_get_info(const COMMAND_RPC_GET_INFO::request& req, COMMAND_RP
   res.white_peerlist_size = m_p2p.getPeerlistManager().get_white_peers_count();
   res.grey_peerlist_size = m_p2p.getPeerlistManager().get_gray_peers_count();
   res.last_known_block_index = std::max(static_cast<uint32_t>(1), m_protocol.getObservedHeight()) - 1;
+  res.signature_cache_hits = m_core.getRingSignatureCache().getHitsCount();
+  res.signature_cache_misses = m_core.getRingSignatureCache().getMissesCount();
+  res.block_cache_hits = m_core.getRawBlockCache().getHitsCount();
+  res.block_cache_misses = m_core.getRawBlockCache().getMissesCount();
   res.status = CORE_RPC_STATUS_OK;
   return true;
 }
@@ -626,7 +637,7 @@ bool RpcServer::f_on_block_json(const F_COMMAND_RPC_GET_BLOCK_DETAILS::request&
       "Internal error: can't get block by hash. Hash = " + req.hash + '.' };
   }
   BlockTemplate blk = m_core.getBlockByHash(hash);
-  BlockDetails blkDetails = m_core.getBlockDetails(hash);
+  BlockDetails blkDetails = getBlocksDetails({ hash }).front();
 
   if (blk.baseTransaction.inputs.front().type() != typeid(BaseInput)) {
     throw JsonRpc::JsonRpcError{
@@ -732,7 +743,7 @@ bool RpcServer::f_on_transaction_json(const F_COMMAND_RPC_GET_TRANSACTION_DETAIL
       CORE_RPC_ERROR_CODE_WRONG_PARAM,
       "transaction wasn't found. Hash = " + req.hash + '.' };
   }
-  TransactionDetails transactionDetails = m_core.getTransactionDetails(hash);
+  TransactionDetails transactionDetails = getTransactionsDetails({ hash }).front();
 
   Crypto::Hash blockHash;
   if (transactionDetails.inBlockchain) {
@@ -744,7 +755,7 @@ bool RpcServer::f_on_transaction_json(const F_COMMAND_RPC_GET_TRANSACTION_DETAIL
     }
     blockHash = m_core.getBlockHashByIndex(blockHeight);
     BlockTemplate blk = m_core.getBlockByHash(blockHash);
-    BlockDetails blkDetails = m_core.getBlockDetails(blockHash);
+    BlockDetails blkDetails = getBlocksDetails({ blockHash }).front();
 
     f_block_short_response block_short;
 
@@ -807,6 +818,99 @@ bool RpcServer::f_on_transactions_pool_json(const F_COMMAND_RPC_GET_POOL::reques
   return true;
 }
 
+std::vector<BlockDetails> RpcServer::getBlocksDetails(const std::vector<Crypto::Hash>& blockHashes) {
+  std::vector<BlockDetails> blocksDetails;
+  std::unique_ptr<BlockchainSnapshot> snapshot = createSnapshot();
+
+  if (snapshot) {
+    ++m_snapshotQueriesCount;
+    Tools::ScopeExit queryFinished([this] { --m_snapshotQueriesCount; });
+
+    //stops at the first block missing in the snapshot or failing to read, the rest are read from the core
+    std::string error;
+    blocksDetails = System::RemoteContext<std::vector<BlockDetails>>(m_dispatcher, [&blockHashes, &snapshot, &error] {
+      std::vector<BlockDetails> snapshotBlocksDetails;
+      try {
+        for (const Crypto::Hash& hash : blockHashes) {
+          if (!snapshot->hasBlock(hash)) {
+            break;
+          }
+
+          snapshotBlocksDetails.push_back(snapshot->getBlockDetails(hash));
+        }
+      } catch (std::runtime_error& e) {
+        error = e.what();
+      }
+
+      return snapshotBlocksDetails;
+    }).get();
+
+    if (!error.empty()) {
+      logger(WARNING) << "Failed to read block details from blockchain snapshot: " << error;
+    }
+  }
+
+  for (size_t i = blocksDetails.size(); i < blockHashes.size(); ++i) {
+    blocksDetails.push_back(m_core.getBlockDetails(blockHashes[i]));
+  }
+
+  return blocksDetails;
+}
+
+std::vector<TransactionDetails> RpcServer::getTransactionsDetails(const std::vector<Crypto::Hash>& transactionHashes) {
+  std::vector<TransactionDetails> transactionsDetails;
+  std::unique_ptr<BlockchainSnapshot> snapshot = createSnapshot();
+
+  if (snapshot) {
+    ++m_snapshotQueriesCount;
+    Tools::ScopeExit queryFinished([this] { --m_snapshotQueriesCount; });
+
+    //stops at the first transaction missing in the snapshot or failing to read, pool transactions are read from the core
+    std::string error;
+    transactionsDetails = System::RemoteContext<std::vector<TransactionDetails>>(m_dispatcher, [&transactionHashes, &snapshot, &error] {
+      std::vector<TransactionDetails> snapshotTransactionsDetails;
+      try {
+        for (const Crypto::Hash& hash : transactionHashes) {
+          if (!snapshot->hasTransaction(hash)) {
+            break;
+          }
+
+          snapshotTransactionsDetails.push_back(snapshot->getTransactionDetails(hash));
+        }
+      } catch (std::runtime_error& e) {
+        error = e.what();
+      }
+
+      return snapshotTransactionsDetails;
+    }).get();
+
+    if (!error.empty()) {
+      logger(WARNING) << "Failed to read transaction details from blockchain snapshot: " << error;
+    }
+  }
+
+  transactionsDetails.reserve(transactionHashes.size());
+  for (size_t i = transactionsDetails.size(); i < transactionHashes.size(); ++i) {
+    transactionsDetails.push_back(m_core.getTransactionDetails(transactionHashes[i]));
+  }
+
+  return transactionsDetails;
+}
+
+std::unique_ptr<BlockchainSnapshot> RpcServer::createSnapshot() {
+  if (m_snapshotQueriesCount >= m_maxSnapshotQueriesCount) {
+    return nullptr;
+  }
+
+  // std::system_error of the DB included
+  try {
+    return m_core.createSnapshot();
+  } catch (std::runtime_error& e) {
+    logger(WARNING) << "Failed to create blockchain snapshot: " << e.what();
+    return nullptr;
+  }
+}
+
 bool RpcServer::f_getMixin(const Transaction& transaction, uint64_t& mixin) {
   mixin = 0;
   for (const TransactionInput& txin : transaction.inputs) {
@@ -880,18 +984,41 @@ bool RpcServer::on_getblockblankaddress(const COMMAND_RPC_GETBLOCKADDRESS::reque
 			std::string("The Account Number: " + reqs)
 		};
 	}
-	try {
-		res.AccountAddress = m_core.getBlockByHash(blockHash).accountAddress;
-		res.hash= Common::podToHex(blockHash);
-	}
-	catch (const std::exception& e) {
+	std::vector<AccountAddressRequest> requests{ AccountAddressRequest{ reqs, {}, false } };
+	m_core.getAccountAddresses(requests);
+	if (!requests[0].found) {
 		res.Status = "Not found";
 		return false;
 	}
+	res.AccountAddress = requests[0].accountAddress;
+	res.hash = Common::podToHex(blockHash);
 	res.Status = "Sucessful";
 	return true;
 }
 
+bool RpcServer::on_get_account_addresses(const COMMAND_RPC_GET_ACCOUNT_ADDRESSES::request& req, COMMAND_RPC_GET_ACCOUNT_ADDRESSES::response& res) {
+	if (req.AccountNumbers.size() > COMMAND_RPC_GET_ACCOUNT_ADDRESSES_MAX_COUNT) {
+		throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_WRONG_SIZE_PARAM,
+			"Too many account numbers, maximum " + std::to_string(COMMAND_RPC_GET_ACCOUNT_ADDRESSES_MAX_COUNT) };
+	}
+
+	std::vector<AccountAddressRequest> requests;
+	requests.reserve(req.AccountNumbers.size());
+	for (const auto& accountNumber : req.AccountNumbers) {
+		requests.push_back(AccountAddressRequest{ accountNumber, {}, false });
+	}
+
+	m_core.getAccountAddresses(requests);
+
+	res.Accounts.reserve(requests.size());
+	for (auto& request : requests) {
+		res.Accounts.push_back({ std::move(request.accountNumber), std::move(request.accountAddress), request.found });
+	}
+
+	res.status = CORE_RPC_STATUS_OK;
+	return true;
+}
+
 
 namespace {
   uint64_t slow_memmem(void* start_buff, size_t buflen, void* pat, size_t patlen)
@@ -967,6 +1094,14 @@ bool RpcServer::on_getblocktemplate(const COMMAND_RPC_GETBLOCKTEMPLATE::request&
     throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_WRONG_WALLET_ADDRESS, "Failed to parse wallet address" };
   }
 
+  if (!req.longpoll_id.empty()) {
+    // hold the request until the template changes, the id of the template the client has is compared
+    m_templateWatcher.wait(req.longpoll_id, std::chrono::seconds(RPC_LONG_POLL_TIMEOUT));
+  }
+
+  // taken before the template is built, so a change racing with building is reported by the next long poll
+  res.longpoll_id = m_templateWatcher.getLongPollId();
+
   BlockTemplate blockTemplate = boost::value_initialized<BlockTemplate>();
   CryptoNote::BinaryArray blob_reserve;
   blob_reserve.resize(req.reserve_size, 0);
@@ -1070,26 +1205,7 @@ bool RpcServer::on_pushblock(const COMMAND_RPC_PUSHBLOCK::request & req, COMMAND
 		res.status = "Wrong param";
 	}
 
-	CryptoNote::BlockTemplate block = boost::value_initialized<CryptoNote::BlockTemplate>();
-
-	Transaction tx;
-	uint32_t index= m_core.getTopBlockIndex();
-	BaseInput in;
-	in.blockIndex= index+1;
-	tx.inputs.push_back(in);
-	tx.version=1;
-	in.blockIndex = index;
-
-	block.typeBlock= ACCOUNT_BLOCK;
-	block.previousBlockHash = m_core.getBlockHashByIndex(index);
-	block.parentBlock.transactionCount = 1;
-	block.majorVersion = 5;
-	block.minorVersion = 4;
-	block.accountAddress = req.AccountAddress;
-	block.baseTransaction = tx;
-	block.minedBy = "";
-	block.accountNumber = req.AccountNumber;
-	block.timestamp = std::time(nullptr);
+	CryptoNote::BlockTemplate block = m_core.makeAccountBlock(req.AccountNumber, req.AccountAddress);
 	BinaryArray blockblob=toBinaryArray(block);
 	
 
@@ -1111,6 +1227,43 @@ bool RpcServer::on_pushblock(const COMMAND_RPC_PUSHBLOCK::request & req, COMMAND
 	 
 }
 
+bool RpcServer::on_pushblocks(const COMMAND_RPC_PUSHBLOCKS::request& req, COMMAND_RPC_PUSHBLOCKS::response& res) {
+	if (req.Accounts.size() > COMMAND_RPC_PUSH_BLOCKS_MAX_COUNT) {
+		throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_WRONG_SIZE_PARAM,
+			"Too many accounts, maximum " + std::to_string(COMMAND_RPC_PUSH_BLOCKS_MAX_COUNT) };
+	}
+
+	std::vector<AccountRegistration> registrations;
+	registrations.reserve(req.Accounts.size());
+	for (const auto& account : req.Accounts) {
+		registrations.push_back(AccountRegistration{ account.AccountNumber, account.AccountAddress, {} });
+	}
+
+	auto addedBlocks = m_core.addAccountBlocks(registrations);
+
+	res.Accounts.reserve(registrations.size());
+	for (const auto& registration : registrations) {
+		bool added = registration.result == error::AddBlockErrorCode::ADDED_TO_MAIN;
+		res.Accounts.push_back({ registration.accountNumber, added, registration.result.message() });
+	}
+
+	// Whole batch goes to peers in one message instead of a NOTIFY_NEW_BLOCK per account
+	if (!addedBlocks.empty()) {
+		NOTIFY_NEW_BLOCKS::request newBlocksMessage;
+		newBlocksMessage.blocks.reserve(addedBlocks.size());
+		for (auto& block : addedBlocks) {
+			newBlocksMessage.blocks.push_back(RawBlockLegacy{ std::move(block.block), std::move(block.transactions) });
+		}
+
+		newBlocksMessage.hop = 0;
+		newBlocksMessage.current_blockchain_height = m_core.getTopBlockIndex() + 1;
+		m_protocol.relayBlocks(newBlocksMessage);
+	}
+
+	res.status = CORE_RPC_STATUS_OK;
+	return true;
+}
+
 RawBlockLegacy RpcServer::prepareRawBlockLegacy(BinaryArray&& blockBlob) {
   BlockTemplate blockTemplate;
   bool result = fromBinaryArray(blockTemplate, blockBlob);
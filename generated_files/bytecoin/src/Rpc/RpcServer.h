@@ -16,6 +16,7 @@
 // along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "HttpServer.h"
+#include "BlockTemplateWatcher.h"
 
 #include <functional>
 #include <unordered_map>
@@ -27,6 +28,7 @@
 #include <Logging/LoggerManager.h>
 
 namespace CryptoNote {
+class BlockchainSnapshot;
 class Core;
 class NodeServer;
 struct ICryptoNoteProtocolHandler;
@@ -36,6 +38,8 @@ public:
   RpcServer(System::Dispatcher& dispatcher, Logging::ILogger& log, Core& c, NodeServer& p2p, ICryptoNoteProtocolHandler& protocol);
 
   typedef std::function<bool(RpcServer*, const HttpRequest& request, HttpResponse& response)> HandlerFunction;
+  void start(const std::string& address, uint16_t port);
+  void stop();
   bool enableCors(const std::vector<std::string>  domains);
 
 private:
@@ -78,10 +82,12 @@ private:
   bool on_getblockcount(const COMMAND_RPC_GETBLOCKCOUNT::request& req, COMMAND_RPC_GETBLOCKCOUNT::response& res);
   bool on_getblockhash(const COMMAND_RPC_GETBLOCKHASH::request& req, COMMAND_RPC_GETBLOCKHASH::response& res);
   bool on_getblockblankaddress(const COMMAND_RPC_GETBLOCKADDRESS::request & req, COMMAND_RPC_GETBLOCKADDRESS::response & res);
+  bool on_get_account_addresses(const COMMAND_RPC_GET_ACCOUNT_ADDRESSES::request& req, COMMAND_RPC_GET_ACCOUNT_ADDRESSES::response& res);
   bool on_getblocktemplate(const COMMAND_RPC_GETBLOCKTEMPLATE::request& req, COMMAND_RPC_GETBLOCKTEMPLATE::response& res);
   bool on_get_currency_id(const COMMAND_RPC_GET_CURRENCY_ID::request& req, COMMAND_RPC_GET_CURRENCY_ID::response& res);
   bool on_submitblock(const COMMAND_RPC_SUBMITBLOCK::request& req, COMMAND_RPC_SUBMITBLOCK::response& res);
   bool on_pushblock(const COMMAND_RPC_PUSHBLOCK::request& req, COMMAND_RPC_PUSHBLOCK::response& res);
+  bool on_pushblocks(const COMMAND_RPC_PUSHBLOCKS::request& req, COMMAND_RPC_PUSHBLOCKS::response& res);
   bool get_statistics_miner(const COMMAND_RPC_GET_STATDISTIC_MINER::request& req, COMMAND_RPC_GET_STATDISTIC_MINER::response& res);
   bool on_get_last_block_header(const COMMAND_RPC_GET_LAST_BLOCK_HEADER::request& req, COMMAND_RPC_GET_LAST_BLOCK_HEADER::response& res);
   bool on_get_block_header_by_hash(const COMMAND_RPC_GET_BLOCK_HEADER_BY_HASH::request& req, COMMAND_RPC_GET_BLOCK_HEADER_BY_HASH::response& res);
@@ -102,6 +108,13 @@ private:
 
   void sockectCommand( );
 
+  // Blocks and transactions committed to the DB are read from a snapshot on a query thread, so that
+  // heavy queries and block import don't wait for each other. The rest are read from the core
+  std::vector<BlockDetails> getBlocksDetails(const std::vector<Crypto::Hash>& blockHashes);
+  std::vector<TransactionDetails> getTransactionsDetails(const std::vector<Crypto::Hash>& transactionHashes);
+  // Null when the query limit is reached or the snapshot couldn't be taken
+  std::unique_ptr<BlockchainSnapshot> createSnapshot();
+
   Logging::LoggerRef logger;
   Core& m_core;
   NodeServer& m_p2p;
@@ -109,6 +122,10 @@ private:
   int socketPort = 9898;
   std::string socketIP = "10.10.6.9";
   ICryptoNoteProtocolHandler& m_protocol;
+  BlockTemplateWatcher m_templateWatcher;
+  // queries over the limit are read from the core on the dispatcher thread
+  const size_t m_maxSnapshotQueriesCount;
+  size_t m_snapshotQueriesCount;
 std::vector<std::string> m_cors_domains;
 public:
 std::vector<std::string> m_stadistic;
@@ -113,7 +113,7 @@ struct EllipticCurveScalar {
   public:
     typedef T result_type;
 
-#ifdef __clang__
+#if defined(__clang__) || defined(__GNUC__)
     constexpr static T min() {
       return (std::numeric_limits<T>::min)();
     }
@@ -0,0 +1,81 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "CryptoNoteCore/CachedBlock.h"
+#include "CryptoNoteCore/LongHashCalculator.h"
+#include "CryptoNoteConfig.h"
+
+// Proof of work stage of block import: long hashes of a_blocks_count blocks computed on a_threads_count threads
+template<size_t a_blocks_count, size_t a_threads_count>
+class test_calculate_block_long_hashes
+{
+  static_assert(0 < a_blocks_count, "blocks_count must be greater than 0");
+  static_assert(0 < a_threads_count, "threads_count must be greater than 0");
+
+public:
+  static const size_t loop_count = 10;
+
+  test_calculate_block_long_hashes() : m_calculator(a_threads_count)
+  {
+  }
+
+  bool init()
+  {
+    using namespace CryptoNote;
+
+    m_blocks.resize(a_blocks_count);
+    for (size_t i = 0; i < a_blocks_count; ++i)
+    {
+      m_blocks[i].majorVersion = BLOCK_MAJOR_VERSION_1;
+      m_blocks[i].minorVersion = BLOCK_MINOR_VERSION_0;
+      m_blocks[i].nonce = static_cast<uint32_t>(i);
+      m_blocks[i].timestamp = 0;
+      m_blocks[i].previousBlockHash = Crypto::Hash();
+
+      BaseInput input;
+      input.blockIndex = static_cast<uint32_t>(i);
+      m_blocks[i].baseTransaction.version = CURRENT_TRANSACTION_VERSION;
+      m_blocks[i].baseTransaction.unlockTime = 0;
+      m_blocks[i].baseTransaction.inputs.push_back(input);
+    }
+
+    return true;
+  }
+
+  bool test()
+  {
+    // Long hashes are kept in CachedBlock, so every run starts from fresh objects
+    std::vector<std::unique_ptr<CryptoNote::CachedBlock>> cachedBlocks;
+    std::vector<const CryptoNote::CachedBlock*> blocks;
+    for (const auto& block : m_blocks)
+    {
+      cachedBlocks.emplace_back(new CryptoNote::CachedBlock(block));
+      blocks.push_back(cachedBlocks.back().get());
+    }
+
+    return m_calculator.calculate(blocks);
+  }
+
+private:
+  std::vector<CryptoNote::BlockTemplate> m_blocks;
+  CryptoNote::LongHashCalculator m_calculator;
+};
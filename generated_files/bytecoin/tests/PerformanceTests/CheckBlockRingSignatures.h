@@ -0,0 +1,89 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <vector>
+
+#include "CryptoNoteCore/Account.h"
+#include "CryptoNoteCore/CryptoNoteBasic.h"
+#include "CryptoNoteCore/CryptoNoteFormatUtils.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "CryptoNoteCore/RingSignatureVerifier.h"
+#include "crypto/crypto.h"
+
+#include "MultiTransactionTestBase.h"
+
+// Signature verification stage of block import: a_inputs_count inputs with ring size a_ring_size checked on a_threads_count threads
+template<size_t a_ring_size, size_t a_inputs_count, size_t a_threads_count>
+class test_check_block_ring_signatures : private multi_tx_test_base<a_ring_size>
+{
+  static_assert(0 < a_inputs_count, "inputs_count must be greater than 0");
+  static_assert(0 < a_threads_count, "threads_count must be greater than 0");
+
+public:
+  static const size_t loop_count = 10;
+
+  typedef multi_tx_test_base<a_ring_size> base_class;
+
+  test_check_block_ring_signatures() : m_verifier(a_threads_count)
+  {
+  }
+
+  bool init()
+  {
+    using namespace CryptoNote;
+
+    if (!base_class::init())
+      return false;
+
+    m_alice.generate();
+
+    std::vector<TransactionDestinationEntry> destinations;
+    destinations.push_back(TransactionDestinationEntry(this->m_source_amount, m_alice.getAccountKeys().address));
+
+    if (!constructTransaction(this->m_miners[this->real_source_idx].getAccountKeys(), this->m_sources, destinations, std::vector<uint8_t>(), m_tx, 0, this->m_logger))
+      return false;
+
+    RingSignatureCheck check;
+    getObjectHash(*static_cast<TransactionPrefix*>(&m_tx), check.prefixHash);
+    check.keyImage = boost::get<KeyInput>(m_tx.inputs[0]).keyImage;
+    check.outputKeys.assign(this->m_public_keys, this->m_public_keys + a_ring_size);
+    check.signatures = &m_tx.signatures[0];
+    check.checkKeyImage = true;
+
+    for (size_t i = 0; i < a_inputs_count; ++i)
+    {
+      check.transactionIndex = i;
+      check.inputIndex = 0;
+      m_checks.push_back(check);
+    }
+
+    return true;
+  }
+
+  bool test()
+  {
+    return m_verifier.verify(m_checks) == m_checks.size();
+  }
+
+private:
+  CryptoNote::AccountBase m_alice;
+  CryptoNote::Transaction m_tx;
+  std::vector<CryptoNote::RingSignatureCheck> m_checks;
+  CryptoNote::RingSignatureVerifier m_verifier;
+};
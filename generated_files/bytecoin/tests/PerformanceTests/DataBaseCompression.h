@@ -0,0 +1,261 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/utility/value_init.hpp>
+
+#include "CryptoNoteCore/BlockchainReadBatch.h"
+#include "CryptoNoteCore/BlockchainWriteBatch.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "CryptoNoteCore/DataBaseConfig.h"
+#include "CryptoNoteCore/RocksDBWrapper.h"
+#include "CryptoNoteConfig.h"
+#include "Logging/ConsoleLogger.h"
+#include "crypto/crypto.h"
+
+#include "PerformanceTests.h"
+
+// Syncs a_blocks_count raw blocks into a DB with every level of every index compressed by a_compression
+// and reports sync throughput and on-disk size. Each call then reads reads_count random raw blocks
+// without the read cache, so time per call in ms is the latency of one read in us.
+template<size_t a_blocks_count, CryptoNote::DataBaseCompression a_compression>
+class test_db_compression
+{
+  static_assert(0 < a_blocks_count, "blocks_count must be greater than 0");
+
+public:
+  static const size_t loop_count = 10;
+  static const size_t reads_count = 1000;
+  static const size_t transactions_count = 20;
+  static const size_t sync_batch_size = 100;
+
+  test_db_compression() : m_logger(Logging::ERROR), m_database(m_logger), m_random(0)
+  {
+  }
+
+  ~test_db_compression()
+  {
+    if (m_dataDir.empty())
+    {
+      return;
+    }
+
+    try
+    {
+      m_database.shutdown();
+      m_database.destoy(m_config);
+    }
+    catch (std::exception&)
+    {
+    }
+
+    boost::system::error_code ec;
+    boost::filesystem::remove_all(m_dataDir, ec);
+  }
+
+  bool init()
+  {
+    if (!CryptoNote::RocksDBWrapper::isCompressionSupported(a_compression))
+    {
+      std::cout << "  compression:   " << CryptoNote::DataBaseConfig::compressionPerLevelToString({ a_compression }) << " isn't linked with the build" << std::endl;
+      return false;
+    }
+
+    m_dataDir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(m_dataDir);
+
+    m_config.setDataDir(m_dataDir.string());
+    // small memtables, so the most of blocks are flushed to compressed tables
+    m_config.setWriteBufferSize(16 * 1024 * 1024);
+    m_config.setReadCacheSize(0);
+    for (size_t i = 0; i < static_cast<size_t>(CryptoNote::DataBaseAccessPattern::COUNT); ++i)
+    {
+      auto pattern = static_cast<CryptoNote::DataBaseAccessPattern>(i);
+      CryptoNote::DataBaseColumnFamilyConfig familyConfig = m_config.getColumnFamilyConfig(pattern);
+      familyConfig.compressionPerLevel = { a_compression };
+      m_config.setColumnFamilyConfig(pattern, familyConfig);
+    }
+
+    std::vector<CryptoNote::RawBlock> rawBlocks;
+    uint64_t rawSize = 0;
+    for (uint32_t blockIndex = 0; blockIndex < a_blocks_count; ++blockIndex)
+    {
+      rawBlocks.push_back(makeRawBlock(blockIndex));
+      rawSize += rawBlocks.back().block.size();
+      for (const auto& transaction : rawBlocks.back().transactions)
+      {
+        rawSize += transaction.size();
+      }
+    }
+
+    try
+    {
+      m_database.init(m_config);
+
+      performance_timer timer;
+      timer.start();
+      for (uint32_t batchStart = 0; batchStart < a_blocks_count; batchStart += sync_batch_size)
+      {
+        CryptoNote::BlockchainWriteBatch batch;
+        for (uint32_t blockIndex = batchStart; blockIndex < std::min<size_t>(a_blocks_count, batchStart + sync_batch_size); ++blockIndex)
+        {
+          batch.insertRawBlock(blockIndex, rawBlocks[blockIndex]);
+        }
+
+        if (m_database.write(batch))
+        {
+          return false;
+        }
+      }
+
+      // flushes all memtables
+      m_database.shutdown();
+      int syncTime = std::max(timer.elapsed_ms(), 1);
+
+      std::cout << "  compression:   " << CryptoNote::DataBaseConfig::compressionPerLevelToString({ a_compression }) << '\n';
+      std::cout << "  sync:          " << a_blocks_count * 1000 / syncTime << " blocks/s, " << rawSize * 1000 / syncTime / 1024 << " KB/s\n";
+      std::cout << "  raw size:      " << rawSize / 1024 << " KB\n";
+      std::cout << "  on-disk size:  " << getTablesSize() / 1024 << " KB" << std::endl;
+
+      m_database.init(m_config);
+    }
+    catch (std::exception& e)
+    {
+      std::cout << "  DB error: " << e.what() << std::endl;
+      return false;
+    }
+
+    return true;
+  }
+
+  bool test()
+  {
+    std::uniform_int_distribution<uint32_t> blockIndexes(0, static_cast<uint32_t>(a_blocks_count - 1));
+    for (size_t i = 0; i < reads_count; ++i)
+    {
+      uint32_t blockIndex = blockIndexes(m_random);
+      CryptoNote::BlockchainReadBatch batch;
+      batch.requestRawBlock(blockIndex);
+      if (m_database.read(batch))
+      {
+        return false;
+      }
+
+      if (batch.extractResult().getRawBlocks().count(blockIndex) == 0)
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+private:
+  // transactions spending a single input of ring size 4 to two outputs, like the most of the chain
+  CryptoNote::RawBlock makeRawBlock(uint32_t blockIndex)
+  {
+    CryptoNote::RawBlock rawBlock;
+
+    CryptoNote::BlockTemplate block = boost::value_initialized<CryptoNote::BlockTemplate>();
+    block.majorVersion = CryptoNote::BLOCK_MAJOR_VERSION_1;
+    block.timestamp = 1500000000 + blockIndex * CryptoNote::parameters::DIFFICULTY_TARGET;
+    block.previousBlockHash = Crypto::rand<Crypto::Hash>();
+    block.nonce = Crypto::rand<uint32_t>();
+
+    CryptoNote::BaseInput baseInput;
+    baseInput.blockIndex = blockIndex;
+    block.baseTransaction.version = CryptoNote::CURRENT_TRANSACTION_VERSION;
+    block.baseTransaction.unlockTime = blockIndex + CryptoNote::parameters::CRYPTONOTE_MINED_MONEY_UNLOCK_WINDOW;
+    block.baseTransaction.inputs.push_back(baseInput);
+    block.baseTransaction.outputs.push_back(makeOutput(7000000000));
+    block.baseTransaction.extra = makeExtra();
+
+    for (size_t i = 0; i < transactions_count; ++i)
+    {
+      CryptoNote::Transaction transaction;
+      transaction.version = CryptoNote::CURRENT_TRANSACTION_VERSION;
+      transaction.unlockTime = 0;
+
+      CryptoNote::KeyInput input;
+      input.amount = 100000000;
+      for (size_t j = 0; j < 4; ++j)
+      {
+        input.outputIndexes.push_back(Crypto::rand<uint16_t>());
+      }
+
+      input.keyImage = Crypto::rand<Crypto::KeyImage>();
+      transaction.inputs.push_back(input);
+      transaction.outputs.push_back(makeOutput(90000000));
+      transaction.outputs.push_back(makeOutput(9000000));
+      transaction.extra = makeExtra();
+      transaction.signatures.resize(1);
+      for (size_t j = 0; j < 4; ++j)
+      {
+        transaction.signatures[0].push_back(Crypto::rand<Crypto::Signature>());
+      }
+
+      rawBlock.transactions.push_back(CryptoNote::toBinaryArray(transaction));
+      block.transactionHashes.push_back(CryptoNote::getBinaryArrayHash(rawBlock.transactions.back()));
+    }
+
+    rawBlock.block = CryptoNote::toBinaryArray(block);
+    return rawBlock;
+  }
+
+  static CryptoNote::TransactionOutput makeOutput(uint64_t amount)
+  {
+    CryptoNote::TransactionOutput output;
+    output.amount = amount;
+    output.target = CryptoNote::KeyOutput{ Crypto::rand<Crypto::PublicKey>() };
+    return output;
+  }
+
+  // transaction public key
+  static std::vector<uint8_t> makeExtra()
+  {
+    Crypto::PublicKey publicKey = Crypto::rand<Crypto::PublicKey>();
+    std::vector<uint8_t> extra(1, 1);
+    extra.insert(extra.end(), publicKey.data, publicKey.data + sizeof(publicKey.data));
+    return extra;
+  }
+
+  uint64_t getTablesSize() const
+  {
+    uint64_t size = 0;
+    for (boost::filesystem::recursive_directory_iterator it(m_dataDir), end; it != end; ++it)
+    {
+      if (boost::filesystem::is_regular_file(it->path()) && it->path().extension() == ".sst")
+      {
+        size += boost::filesystem::file_size(it->path());
+      }
+    }
+
+    return size;
+  }
+
+  Logging::ConsoleLogger m_logger;
+  CryptoNote::RocksDBWrapper m_database;
+  CryptoNote::DataBaseConfig m_config;
+  boost::filesystem::path m_dataDir;
+  std::mt19937 m_random;
+};
@@ -0,0 +1,139 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "Common/StdInputStream.h"
+#include "Common/StdOutputStream.h"
+#include "CryptoNoteCore/BlockchainCache.h"
+#include "CryptoNoteCore/DatabaseCacheData.h"
+#include "CryptoNoteCore/DBUtils.h"
+#include "Serialization/KVBinaryInputStreamSerializer.h"
+#include "Serialization/KVBinaryOutputStreamSerializer.h"
+#include "crypto/crypto.h"
+
+#include "PerformanceTests.h"
+
+// Encodes and decodes records_count records of each of the most frequently written indexes:
+// block info by block index, block index by key image and key output by amount and global index.
+// a_kv_binary selects the previous encoding, where keys and values were KV binary documents.
+template<bool a_kv_binary>
+class test_db_encoding
+{
+public:
+  static const size_t loop_count = 100;
+  static const size_t records_count = 1000;
+
+  bool init()
+  {
+    for (uint32_t i = 0; i < records_count; ++i)
+    {
+      m_blockInfos.push_back({ Crypto::rand<Crypto::Hash>(), 1500000000 + i * 120, 1000000ULL * i, 1000000000000ULL * i, i * 10, 20000 });
+      m_keyImages.push_back(Crypto::rand<Crypto::KeyImage>());
+      m_keyOutputs.push_back({ Crypto::rand<Crypto::PublicKey>(), Crypto::rand<Crypto::Hash>(), 0, static_cast<uint16_t>(i % 4) });
+    }
+
+    size_t keysSize = 0;
+    size_t valuesSize = 0;
+    for (uint32_t i = 0; i < records_count; ++i)
+    {
+      auto blockInfo = encode(CryptoNote::DB::BLOCK_INDEX_TO_BLOCK_INFO_PREFIX, i, m_blockInfos[i]);
+      auto keyImage = encode(CryptoNote::DB::KEY_IMAGE_TO_BLOCK_INDEX_PREFIX, m_keyImages[i], i);
+      auto keyOutput = encode(CryptoNote::DB::KEY_OUTPUT_KEY_PREFIX, std::make_pair(uint64_t(100000000), i), m_keyOutputs[i]);
+      keysSize += blockInfo.first.size() + keyImage.first.size() + keyOutput.first.size();
+      valuesSize += blockInfo.second.size() + keyImage.second.size() + keyOutput.second.size();
+    }
+
+    std::cout << "  encoding:      " << (a_kv_binary ? "kv binary" : "fixed width keys, binary values") << '\n';
+    std::cout << "  keys size:     " << keysSize << " bytes\n";
+    std::cout << "  values size:   " << valuesSize << " bytes" << std::endl;
+    return true;
+  }
+
+  bool test()
+  {
+    for (uint32_t i = 0; i < records_count; ++i)
+    {
+      auto blockInfo = encode(CryptoNote::DB::BLOCK_INDEX_TO_BLOCK_INFO_PREFIX, i, m_blockInfos[i]);
+      CryptoNote::CachedBlockInfo readBlockInfo;
+      decode(blockInfo.second, readBlockInfo, CryptoNote::DB::BLOCK_INDEX_TO_BLOCK_INFO_PREFIX);
+
+      auto keyImage = encode(CryptoNote::DB::KEY_IMAGE_TO_BLOCK_INDEX_PREFIX, m_keyImages[i], i);
+      uint32_t readBlockIndex;
+      decode(keyImage.second, readBlockIndex, CryptoNote::DB::KEY_IMAGE_TO_BLOCK_INDEX_PREFIX);
+
+      auto keyOutput = encode(CryptoNote::DB::KEY_OUTPUT_KEY_PREFIX, std::make_pair(uint64_t(100000000), i), m_keyOutputs[i]);
+      CryptoNote::KeyOutputInfo readKeyOutput;
+      decode(keyOutput.second, readKeyOutput, CryptoNote::DB::KEY_OUTPUT_KEY_PREFIX);
+
+      if (readBlockInfo.blockHash != m_blockInfos[i].blockHash || readBlockIndex != i || readKeyOutput.publicKey != m_keyOutputs[i].publicKey)
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+private:
+  template <class Value>
+  static std::string kvSerialize(const Value& value, const std::string& name)
+  {
+    CryptoNote::KVBinaryOutputStreamSerializer serializer;
+    std::stringstream ss;
+    Common::StdOutputStream stream(ss);
+
+    serializer(const_cast<Value&>(value), name);
+    serializer.dump(stream);
+
+    return ss.str();
+  }
+
+  template <class Key, class Value>
+  static std::pair<std::string, std::string> encode(const std::string& keyPrefix, const Key& key, const Value& value)
+  {
+    if (a_kv_binary)
+    {
+      return { kvSerialize(std::make_pair(keyPrefix, key), keyPrefix), kvSerialize(value, keyPrefix) };
+    }
+
+    return CryptoNote::DB::serialize(keyPrefix, key, value);
+  }
+
+  template <class Value>
+  static void decode(const std::string& serialized, Value& value, const std::string& name)
+  {
+    if (a_kv_binary)
+    {
+      std::stringstream ss(serialized);
+      Common::StdInputStream stream(ss);
+      CryptoNote::KVBinaryInputStreamSerializer serializer(stream);
+      serializer(value, name);
+      return;
+    }
+
+    CryptoNote::DB::deserialize(serialized, value, name);
+  }
+
+  std::vector<CryptoNote::CachedBlockInfo> m_blockInfos;
+  std::vector<Crypto::KeyImage> m_keyImages;
+  std::vector<CryptoNote::KeyOutputInfo> m_keyOutputs;
+};
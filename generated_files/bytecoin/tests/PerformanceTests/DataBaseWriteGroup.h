@@ -0,0 +1,216 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <iostream>
+#include <unordered_set>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "CryptoNoteCore/BlockchainReadBatch.h"
+#include "CryptoNoteCore/BlockchainWriteBatch.h"
+#include "CryptoNoteCore/DataBaseConfig.h"
+#include "CryptoNoteCore/RocksDBWrapper.h"
+#include "Logging/ConsoleLogger.h"
+#include "crypto/crypto.h"
+
+#include "PerformanceTests.h"
+
+// Pushes blocks_per_call blocks to a DB the way DatabaseBlockchainCache::pushBlock does during sync:
+// a few reads of the top state, then one write of the block's records. Writes are committed
+// in groups of a_write_group_size, so time per call in ms is the time of 1000 blocks in us.
+template<size_t a_blocks_per_call, uint32_t a_write_group_size>
+class test_db_write_group
+{
+public:
+  static const size_t loop_count = 10;
+  static const size_t transactions_count = 20;
+  static const size_t amounts_count = 16;
+
+  test_db_write_group() : m_logger(Logging::ERROR), m_database(m_logger), m_topBlockIndex(0)
+  {
+  }
+
+  ~test_db_write_group()
+  {
+    if (m_dataDir.empty())
+    {
+      return;
+    }
+
+    try
+    {
+      m_database.shutdown();
+      m_database.destoy(m_config);
+    }
+    catch (std::exception&)
+    {
+    }
+
+    boost::system::error_code ec;
+    boost::filesystem::remove_all(m_dataDir, ec);
+  }
+
+  bool init()
+  {
+    m_dataDir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(m_dataDir);
+
+    m_config.setDataDir(m_dataDir.string());
+    m_config.setWriteGroupSize(a_write_group_size);
+
+    // random values are slow to generate, every call pushes the same blocks at new indexes
+    m_rawBlock = makeRawBlock();
+    for (size_t i = 0; i < a_blocks_per_call; ++i)
+    {
+      m_blockHashes.push_back(Crypto::rand<Crypto::Hash>());
+      for (size_t j = 0; j < transactions_count; ++j)
+      {
+        m_keyImages.push_back(Crypto::rand<Crypto::KeyImage>());
+        m_transactionHashes.push_back(Crypto::rand<Crypto::Hash>());
+        m_outputKeys.push_back(Crypto::rand<Crypto::PublicKey>());
+      }
+    }
+
+    try
+    {
+      m_database.init(m_config);
+      CryptoNote::BlockchainWriteBatch batch;
+      batch.insertCachedBlock(CryptoNote::CachedBlockInfo{ Crypto::rand<Crypto::Hash>(), 0, 1, 0, 1, 0 }, 0, {});
+      if (m_database.writeSync(batch))
+      {
+        return false;
+      }
+    }
+    catch (std::exception& e)
+    {
+      std::cout << "  DB error: " << e.what() << std::endl;
+      return false;
+    }
+
+    std::cout << "  write group:   " << a_write_group_size << " blocks" << std::endl;
+    return true;
+  }
+
+  bool test()
+  {
+    for (size_t i = 0; i < a_blocks_per_call; ++i)
+    {
+      if (!pushBlock(i))
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+private:
+  bool pushBlock(size_t blockNumber)
+  {
+    uint32_t blockIndex = m_topBlockIndex + 1;
+    CryptoNote::IBlockchainCache::Amount amount = blockIndex % amounts_count;
+
+    CryptoNote::BlockchainReadBatch readBatch;
+    readBatch.requestCachedBlock(m_topBlockIndex);
+    readBatch.requestKeyOutputGlobalIndexesCountForAmount(amount);
+    readBatch.requestBlockHashesByTimestamp(blockIndex);
+    if (m_database.read(readBatch))
+    {
+      return false;
+    }
+
+    auto readResult = readBatch.extractResult();
+    if (readResult.getCachedBlocks().count(m_topBlockIndex) == 0)
+    {
+      return false;
+    }
+
+    const CryptoNote::CachedBlockInfo& topBlockInfo = readResult.getCachedBlocks().at(m_topBlockIndex);
+    uint32_t outputsCount = 0;
+    if (readResult.getKeyOutputGlobalIndexesCountForAmounts().count(amount) != 0)
+    {
+      outputsCount = readResult.getKeyOutputGlobalIndexesCountForAmounts().at(amount);
+    }
+
+    CryptoNote::CachedBlockInfo blockInfo = topBlockInfo;
+    blockInfo.blockHash = m_blockHashes[blockNumber];
+    blockInfo.timestamp = blockIndex;
+    blockInfo.alreadyGeneratedTransactions += transactions_count + 1;
+
+    std::unordered_set<Crypto::KeyImage> keyImages;
+    std::vector<Crypto::Hash> transactionHashes;
+    std::vector<CryptoNote::PackedOutIndex> outputs;
+    CryptoNote::BlockchainWriteBatch batch;
+    for (uint16_t i = 0; i < transactions_count; ++i)
+    {
+      // key images must be unique in the whole chain
+      Crypto::KeyImage keyImage = m_keyImages[blockNumber * transactions_count + i];
+      *reinterpret_cast<uint32_t*>(keyImage.data) = blockIndex;
+      keyImages.insert(keyImage);
+      transactionHashes.push_back(m_transactionHashes[blockNumber * transactions_count + i]);
+
+      CryptoNote::PackedOutIndex output;
+      output.blockIndex = blockIndex;
+      output.transactionIndex = i;
+      output.outputIndex = 0;
+      outputs.push_back(output);
+
+      CryptoNote::KeyOutputInfo outputInfo{ m_outputKeys[blockNumber * transactions_count + i], transactionHashes.back(), 0, 0 };
+      batch.insertKeyOutputInfo(amount, outputsCount + i, outputInfo);
+    }
+
+    batch.insertSpentKeyImages(blockIndex, keyImages);
+    batch.insertCachedBlock(blockInfo, blockIndex, transactionHashes);
+    batch.insertRawBlock(blockIndex, m_rawBlock);
+    batch.insertKeyOutputGlobalIndexes(amount, outputs, outputsCount + static_cast<uint32_t>(outputs.size()));
+    batch.insertTimestamp(blockIndex, { blockInfo.blockHash });
+    if (m_database.write(batch))
+    {
+      return false;
+    }
+
+    m_topBlockIndex = blockIndex;
+    return true;
+  }
+
+  // sizes of a block with transactions_count transactions of one input and two outputs
+  static CryptoNote::RawBlock makeRawBlock()
+  {
+    CryptoNote::RawBlock rawBlock;
+    rawBlock.block.resize(transactions_count * sizeof(Crypto::Hash) + 200);
+    for (size_t i = 0; i < transactions_count; ++i)
+    {
+      rawBlock.transactions.emplace_back(550);
+    }
+
+    return rawBlock;
+  }
+
+  Logging::ConsoleLogger m_logger;
+  CryptoNote::RocksDBWrapper m_database;
+  CryptoNote::DataBaseConfig m_config;
+  boost::filesystem::path m_dataDir;
+  CryptoNote::RawBlock m_rawBlock;
+  std::vector<Crypto::Hash> m_blockHashes;
+  std::vector<Crypto::KeyImage> m_keyImages;
+  std::vector<Crypto::Hash> m_transactionHashes;
+  std::vector<Crypto::PublicKey> m_outputKeys;
+  uint32_t m_topBlockIndex;
+};
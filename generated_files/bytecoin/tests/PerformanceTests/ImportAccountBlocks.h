@@ -0,0 +1,93 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <vector>
+
+#include <boost/utility/value_init.hpp>
+
+#include "CryptoNoteCore/CachedBlock.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "CryptoNoteConfig.h"
+#include "crypto/hash.h"
+
+// Hashing stage of importing a_blocks_count downloaded account blocks of the given minor version:
+// parsing, block hash and long hash, so ACCOUNT_BLOCK_MINOR_VERSION_1 and ACCOUNT_BLOCK_MINOR_VERSION_2 can be compared
+template<size_t a_blocks_count, uint8_t a_minor_version>
+class test_import_account_blocks
+{
+  static_assert(0 < a_blocks_count, "blocks_count must be greater than 0");
+
+public:
+  static const size_t loop_count = 10;
+
+  bool init()
+  {
+    using namespace CryptoNote;
+
+    m_rawBlocks.resize(a_blocks_count);
+    for (size_t i = 0; i < a_blocks_count; ++i)
+    {
+      BlockTemplate block = boost::value_initialized<BlockTemplate>();
+      block.majorVersion = BLOCK_MAJOR_VERSION_5;
+      block.minorVersion = a_minor_version;
+      block.parentBlock.transactionCount = 1;
+      block.accountNumber = std::to_string(1000000000 + i);
+      block.accountAddress = std::string(ACCOUNT_ADDRESS_SIZE, 'A');
+
+      BaseInput input;
+      input.blockIndex = static_cast<uint32_t>(i + 1);
+      block.baseTransaction.version = CURRENT_TRANSACTION_VERSION;
+      block.baseTransaction.inputs.push_back(input);
+
+      if (!toBinaryArray(block, m_rawBlocks[i]))
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  bool test()
+  {
+    for (const auto& rawBlock : m_rawBlocks)
+    {
+      CryptoNote::BlockTemplate block;
+      if (!CryptoNote::fromBinaryArray(block, rawBlock))
+      {
+        return false;
+      }
+
+      CryptoNote::CachedBlock cachedBlock(block);
+      if (cachedBlock.getTypeOfBlock() != CryptoNote::ACCOUNT_BLOCK)
+      {
+        return false;
+      }
+
+      cachedBlock.getBlockHash();
+      cachedBlock.getBlockLongHash(m_context);
+    }
+
+    return true;
+  }
+
+private:
+  std::vector<CryptoNote::BinaryArray> m_rawBlocks;
+  Crypto::cn_context m_context;
+};
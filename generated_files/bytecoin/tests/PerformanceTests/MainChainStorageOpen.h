@@ -0,0 +1,156 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <iostream>
+#include <memory>
+
+#include <boost/filesystem.hpp>
+
+#include "CryptoNoteCore/BlockchainCache.h"
+#include "CryptoNoteCore/BlockchainWriteBatch.h"
+#include "CryptoNoteCore/DataBaseConfig.h"
+#include "CryptoNoteCore/DatabaseMainChainStorage.h"
+#include "CryptoNoteCore/MainChainStorage.h"
+#include "CryptoNoteCore/RocksDBWrapper.h"
+#include "Logging/ConsoleLogger.h"
+
+#include "PerformanceTests.h"
+
+// Opens the main chain storage of a_blocks_count blocks the way the daemon does on start and reads
+// its top block. a_database selects the storage that only reads blocks from the already opened DB.
+template<uint32_t a_blocks_count, bool a_database>
+class test_main_chain_storage_open
+{
+public:
+  static const size_t loop_count = 10;
+  static const uint32_t blocks_per_batch = 1000;
+
+  test_main_chain_storage_open() : m_logger(Logging::ERROR), m_database(m_logger)
+  {
+  }
+
+  ~test_main_chain_storage_open()
+  {
+    if (m_dataDir.empty())
+    {
+      return;
+    }
+
+    try
+    {
+      if (a_database)
+      {
+        m_database.shutdown();
+        m_database.destoy(m_config);
+      }
+    }
+    catch (std::exception&)
+    {
+    }
+
+    boost::system::error_code ec;
+    boost::filesystem::remove_all(m_dataDir, ec);
+  }
+
+  bool init()
+  {
+    m_dataDir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(m_dataDir);
+
+    CryptoNote::RawBlock rawBlock;
+    rawBlock.block.resize(200);
+
+    try
+    {
+      if (!a_database)
+      {
+        CryptoNote::MainChainStorage storage(blocksFileName(), indexesFileName());
+        for (uint32_t i = 0; i < a_blocks_count; ++i)
+        {
+          storage.pushBlock(rawBlock);
+        }
+      }
+      else if (!initDataBase(rawBlock))
+      {
+        return false;
+      }
+    }
+    catch (std::exception& e)
+    {
+      std::cout << "  storage error: " << e.what() << std::endl;
+      return false;
+    }
+
+    std::cout << "  blocks storage: " << (a_database ? "db" : "file") << std::endl;
+    return true;
+  }
+
+  bool test()
+  {
+    std::unique_ptr<CryptoNote::IMainChainStorage> storage;
+    if (a_database)
+    {
+      storage = CryptoNote::createDatabaseMainChainStorage(m_database);
+    }
+    else
+    {
+      storage.reset(new CryptoNote::MainChainStorage(blocksFileName(), indexesFileName()));
+    }
+
+    return storage->getBlockCount() == a_blocks_count && storage->getBlockByIndex(a_blocks_count - 1).block.size() == 200;
+  }
+
+private:
+  bool initDataBase(const CryptoNote::RawBlock& rawBlock)
+  {
+    m_config.setDataDir(m_dataDir.string());
+    m_database.init(m_config);
+    for (uint32_t i = 0; i < a_blocks_count; i += blocks_per_batch)
+    {
+      CryptoNote::BlockchainWriteBatch batch;
+      for (uint32_t j = i; j < std::min(i + blocks_per_batch, a_blocks_count); ++j)
+      {
+        batch.insertCachedBlock(CryptoNote::CachedBlockInfo{ Crypto::Hash(), j, 0, 0, 0, 0 }, j, {});
+        batch.insertRawBlock(j, rawBlock);
+      }
+
+      if (m_database.write(batch))
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  std::string blocksFileName() const
+  {
+    return (m_dataDir / "blocks.bin").string();
+  }
+
+  std::string indexesFileName() const
+  {
+    return (m_dataDir / "blockindexes.bin").string();
+  }
+
+  Logging::ConsoleLogger m_logger;
+  CryptoNote::RocksDBWrapper m_database;
+  CryptoNote::DataBaseConfig m_config;
+  boost::filesystem::path m_dataDir;
+};
@@ -0,0 +1,124 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "CryptoNoteCore/CryptoNoteSerialization.h"
+#include "CryptoNoteCore/MainChainStorage.h"
+#include "CryptoNoteCore/SwappedVector.h"
+
+#include "PerformanceTests.h"
+
+// Reads reads_per_call blocks from a main chain storage of blocks_count blocks, one after another or
+// at random indexes. a_mapped selects the segmented mapped storage, otherwise the previous SwappedVector
+// storage with its cache of 100 blocks is read.
+template<bool a_mapped, bool a_sequential>
+class test_main_chain_storage_read
+{
+public:
+  static const size_t loop_count = 20;
+  static const uint32_t blocks_count = 20000;
+  static const uint32_t reads_per_call = 1000;
+  static const size_t transactions_count = 5;
+
+  ~test_main_chain_storage_read()
+  {
+    m_mappedStorage.reset();
+    m_swappedStorage.reset();
+
+    boost::system::error_code ec;
+    boost::filesystem::remove_all(m_dataDir, ec);
+  }
+
+  bool init()
+  {
+    m_dataDir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(m_dataDir);
+    std::string blocksFilename = (m_dataDir / "blocks.bin").string();
+    std::string indexesFilename = (m_dataDir / "blockindexes.bin").string();
+
+    CryptoNote::RawBlock rawBlock;
+    rawBlock.block.resize(transactions_count * sizeof(Crypto::Hash) + 200);
+    for (size_t i = 0; i < transactions_count; ++i)
+    {
+      rawBlock.transactions.emplace_back(500);
+    }
+
+    if (a_mapped)
+    {
+      m_mappedStorage.reset(new CryptoNote::MainChainStorage(blocksFilename, indexesFilename));
+    }
+    else
+    {
+      m_swappedStorage.reset(new SwappedVector<CryptoNote::RawBlock>());
+      if (!m_swappedStorage->open(blocksFilename, indexesFilename, 100))
+      {
+        return false;
+      }
+    }
+
+    std::mt19937 random(0);
+    for (uint32_t i = 0; i < blocks_count; ++i)
+    {
+      if (a_mapped)
+      {
+        m_mappedStorage->pushBlock(rawBlock);
+      }
+      else
+      {
+        m_swappedStorage->push_back(rawBlock);
+      }
+
+      m_indexes.push_back(a_sequential ? i : static_cast<uint32_t>(random() % blocks_count));
+    }
+
+    m_nextIndex = 0;
+    std::cout << "  storage:       " << (a_mapped ? "segmented mapped" : "swapped vector") << '\n';
+    std::cout << "  reads:         " << (a_sequential ? "sequential" : "random") << std::endl;
+    return true;
+  }
+
+  bool test()
+  {
+    for (uint32_t i = 0; i < reads_per_call; ++i)
+    {
+      uint32_t index = m_indexes[m_nextIndex];
+      m_nextIndex = (m_nextIndex + 1) % blocks_count;
+
+      CryptoNote::RawBlock rawBlock = a_mapped ? m_mappedStorage->getBlockByIndex(index) : (*m_swappedStorage)[index];
+      if (rawBlock.transactions.size() != transactions_count)
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+private:
+  boost::filesystem::path m_dataDir;
+  std::unique_ptr<CryptoNote::MainChainStorage> m_mappedStorage;
+  std::unique_ptr<SwappedVector<CryptoNote::RawBlock>> m_swappedStorage;
+  std::vector<uint32_t> m_indexes;
+  uint32_t m_nextIndex;
+};
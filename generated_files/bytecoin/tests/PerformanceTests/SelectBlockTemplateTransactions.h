@@ -0,0 +1,135 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <memory>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+#include "CryptoNoteCore/TransactionPool.h"
+#include "CryptoNoteCore/TransactionValidatiorState.h"
+#include "CryptoNoteConfig.h"
+#include "Logging/LoggerGroup.h"
+#include "crypto/crypto.h"
+
+// Block template transaction selection from a pool of a_pool_size transactions with random fees and sizes.
+// a_prefix_walk = false copies the whole pool and walks every transaction as Core::fillBlockTemplate used to,
+// a_prefix_walk = true walks the pool in place and stops once the smallest pool transaction can't fit anymore
+template<size_t a_pool_size, bool a_prefix_walk>
+class test_select_block_template_transactions
+{
+  static_assert(0 < a_pool_size, "pool_size must be greater than 0");
+
+public:
+  static const size_t loop_count = 10;
+  static const size_t median_size = CryptoNote::parameters::CRYPTONOTE_BLOCK_GRANTED_FULL_REWARD_ZONE;
+  static const size_t max_total_size = (125 * median_size) / 100;
+
+  bool init()
+  {
+    using namespace CryptoNote;
+
+    m_pool.reset(new TransactionPool(m_logger));
+
+    std::mt19937_64 random(0);
+    std::uniform_int_distribution<uint64_t> feeDistribution(1, 1000000);
+    std::uniform_int_distribution<size_t> extraSizeDistribution(100, 2000);
+    for (size_t i = 0; i < a_pool_size; ++i)
+    {
+      Crypto::KeyImage keyImage = Crypto::rand<Crypto::KeyImage>();
+      uint64_t fee = feeDistribution(random);
+
+      KeyInput input;
+      input.amount = 1000000 + fee;
+      input.keyImage = keyImage;
+      input.outputIndexes.push_back(0);
+
+      TransactionOutput output;
+      output.amount = 1000000;
+      output.target = KeyOutput{Crypto::rand<Crypto::PublicKey>()};
+
+      Transaction transaction;
+      transaction.version = CURRENT_TRANSACTION_VERSION;
+      transaction.unlockTime = 0;
+      transaction.inputs.push_back(input);
+      transaction.outputs.push_back(output);
+      transaction.extra.resize(extraSizeDistribution(random), static_cast<uint8_t>(i));
+      transaction.signatures.resize(1, std::vector<Crypto::Signature>(1));
+
+      TransactionValidatorState state;
+      state.spentKeyImages.insert(keyImage);
+      if (!m_pool->pushTransaction(CachedTransaction(std::move(transaction)), std::move(state)))
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  bool test()
+  {
+    std::vector<Crypto::Hash> transactionHashes;
+    std::unordered_set<Crypto::KeyImage> spentKeyImages;
+    size_t transactionsSize = 0;
+
+    auto include = [&](const CryptoNote::CachedTransaction& transaction) {
+      size_t transactionSize = transaction.getTransactionBinaryArray().size();
+      if (max_total_size < transactionsSize + transactionSize)
+      {
+        return;
+      }
+
+      const auto& input = boost::get<CryptoNote::KeyInput>(transaction.getTransaction().inputs.front());
+      if (spentKeyImages.insert(input.keyImage).second)
+      {
+        transactionsSize += transactionSize;
+        transactionHashes.push_back(transaction.getTransactionHash());
+      }
+    };
+
+    if (a_prefix_walk)
+    {
+      const size_t minTransactionSize = m_pool->getMinTransactionSize();
+      m_pool->forEachTransaction([&](const CryptoNote::CachedTransaction& transaction) {
+        if (max_total_size < transactionsSize + minTransactionSize)
+        {
+          return false;
+        }
+
+        include(transaction);
+        return true;
+      });
+    }
+    else
+    {
+      std::vector<CryptoNote::CachedTransaction> poolTransactions = m_pool->getPoolTransactions();
+      for (const auto& transaction : poolTransactions)
+      {
+        include(transaction);
+      }
+    }
+
+    return !transactionHashes.empty();
+  }
+
+private:
+  Logging::LoggerGroup m_logger;
+  std::unique_ptr<CryptoNote::TransactionPool> m_pool;
+};
@@ -20,14 +20,23 @@
 
 // tests
 #include "ConstructTransaction.h"
+#include "DataBaseCompression.h"
+#include "DataBaseEncoding.h"
+#include "DataBaseWriteGroup.h"
 #include "CheckRingSignature.h"
+#include "CalculateBlockLongHashes.h"
+#include "CheckBlockRingSignatures.h"
 #include "CryptoNoteSlowHash.h"
 #include "DerivePublicKey.h"
 #include "DeriveSecretKey.h"
 #include "GenerateKeyDerivation.h"
 #include "GenerateKeyImage.h"
 #include "GenerateKeyImageHelper.h"
+#include "ImportAccountBlocks.h"
+#include "MainChainStorageOpen.h"
+#include "MainChainStorageRead.h"
 #include "IsOutToAccount.h"
+#include "SelectBlockTemplateTransactions.h"
 
 int main(int argc, char** argv)
 {
@@ -72,6 +81,50 @@ int main(int argc, char** argv)
 
   TEST_PERFORMANCE0(test_cn_slow_hash);
 
+  TEST_PERFORMANCE2(test_import_account_blocks, 1000, CryptoNote::ACCOUNT_BLOCK_MINOR_VERSION_1);
+  TEST_PERFORMANCE2(test_import_account_blocks, 1000, CryptoNote::ACCOUNT_BLOCK_MINOR_VERSION_2);
+
+  TEST_PERFORMANCE2(test_select_block_template_transactions, 50000, false);
+  TEST_PERFORMANCE2(test_select_block_template_transactions, 50000, true);
+
+  TEST_PERFORMANCE2(test_db_compression, 5000, CryptoNote::DataBaseCompression::NONE);
+  TEST_PERFORMANCE2(test_db_compression, 5000, CryptoNote::DataBaseCompression::SNAPPY);
+  TEST_PERFORMANCE2(test_db_compression, 5000, CryptoNote::DataBaseCompression::LZ4);
+  TEST_PERFORMANCE2(test_db_compression, 5000, CryptoNote::DataBaseCompression::LZ4HC);
+  TEST_PERFORMANCE2(test_db_compression, 5000, CryptoNote::DataBaseCompression::ZLIB);
+  TEST_PERFORMANCE2(test_db_compression, 5000, CryptoNote::DataBaseCompression::BZIP2);
+
+  TEST_PERFORMANCE1(test_db_encoding, true);
+  TEST_PERFORMANCE1(test_db_encoding, false);
+
+  TEST_PERFORMANCE2(test_db_write_group, 1000, 1);
+  TEST_PERFORMANCE2(test_db_write_group, 1000, 100);
+
+  TEST_PERFORMANCE2(test_main_chain_storage_open, 100000, false);
+  TEST_PERFORMANCE2(test_main_chain_storage_open, 100000, true);
+
+  TEST_PERFORMANCE2(test_main_chain_storage_read, false, true);
+  TEST_PERFORMANCE2(test_main_chain_storage_read, true, true);
+  TEST_PERFORMANCE2(test_main_chain_storage_read, false, false);
+  TEST_PERFORMANCE2(test_main_chain_storage_read, true, false);
+
+  // multithreaded tests must not be pinned to a single core
+  reset_process_affinity();
+
+  TEST_PERFORMANCE3(test_check_block_ring_signatures, 4, 128, 1);
+  TEST_PERFORMANCE3(test_check_block_ring_signatures, 4, 128, 2);
+  TEST_PERFORMANCE3(test_check_block_ring_signatures, 4, 128, 4);
+  TEST_PERFORMANCE3(test_check_block_ring_signatures, 4, 128, 8);
+  TEST_PERFORMANCE3(test_check_block_ring_signatures, 4, 128, 16);
+  TEST_PERFORMANCE3(test_check_block_ring_signatures, 4, 128, 32);
+
+  TEST_PERFORMANCE2(test_calculate_block_long_hashes, 64, 1);
+  TEST_PERFORMANCE2(test_calculate_block_long_hashes, 64, 2);
+  TEST_PERFORMANCE2(test_calculate_block_long_hashes, 64, 4);
+  TEST_PERFORMANCE2(test_calculate_block_long_hashes, 64, 8);
+  TEST_PERFORMANCE2(test_calculate_block_long_hashes, 64, 16);
+  TEST_PERFORMANCE2(test_calculate_block_long_hashes, 64, 32);
+
   std::cout << "Tests finished. Elapsed time: " << timer.elapsed_ms() / 1000 << " sec" << std::endl;
 
   return 0;
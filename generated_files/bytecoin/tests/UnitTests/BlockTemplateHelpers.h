@@ -0,0 +1,55 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <string>
+
+#include <boost/utility/value_init.hpp>
+
+#include "CryptoNoteConfig.h"
+#include "CryptoNoteCore/CryptoNoteBasic.h"
+
+namespace unit_test {
+
+// smallest block template that passes CachedBlock: a coinbase with a single base input
+inline CryptoNote::BlockTemplate makeBlockTemplate(uint8_t majorVersion, uint32_t blockIndex,
+  const Crypto::Hash& previousBlockHash = Crypto::Hash()) {
+  CryptoNote::BlockTemplate block = boost::value_initialized<CryptoNote::BlockTemplate>();
+  block.majorVersion = majorVersion;
+  block.previousBlockHash = previousBlockHash;
+  block.parentBlock.transactionCount = 1;
+
+  CryptoNote::BaseInput input;
+  input.blockIndex = blockIndex;
+  block.baseTransaction.version = CryptoNote::CURRENT_TRANSACTION_VERSION;
+  block.baseTransaction.inputs.push_back(input);
+  return block;
+}
+
+inline CryptoNote::BlockTemplate makeAccountBlockTemplate(uint8_t minorVersion, uint32_t blockIndex,
+  const std::string& accountNumber, const std::string& accountAddress = std::string(),
+  const Crypto::Hash& previousBlockHash = Crypto::Hash()) {
+  auto block = makeBlockTemplate(CryptoNote::BLOCK_MAJOR_VERSION_5, blockIndex, previousBlockHash);
+  block.minorVersion = minorVersion;
+  block.accountNumber = accountNumber;
+  block.accountAddress = accountAddress;
+  return block;
+}
+
+}
@@ -24,6 +24,7 @@ DataBaseMock::~DataBaseMock() {
 }
 
 std::error_code DataBaseMock::write(IWriteBatch& batch) {
+  ++writeCount;
   auto append = batch.extractRawDataToInsert();
   for (auto pr : append) {
     baseState[pr.first] = pr.second;
@@ -39,7 +40,12 @@ std::error_code DataBaseMock::writeSync(IWriteBatch& batch) {
   return write(batch);
 }
 
+std::error_code DataBaseMock::flush() {
+  return{};
+}
+
 std::error_code DataBaseMock::read(IReadBatch& batch) {
+  ++readCount;
   auto keys = batch.getRawKeys();
   std::vector<std::string> kvs;
   std::vector<bool> states;
@@ -58,6 +64,12 @@ std::error_code DataBaseMock::read(IReadBatch& batch) {
   return{};
 }
 
+std::unique_ptr<IDataBase> DataBaseMock::createSnapshot() {
+  std::unique_ptr<DataBaseMock> snapshot(new DataBaseMock());
+  snapshot->baseState = baseState;
+  return std::move(snapshot);
+}
+
 std::unordered_map<uint32_t, RawBlock> DataBaseMock::blocks() {
   BlockchainReadBatch req;
   for (int i = 0; i < 30; ++i) {
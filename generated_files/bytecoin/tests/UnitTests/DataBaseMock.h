@@ -33,9 +33,13 @@ public:
 
   std::error_code write(IWriteBatch& batch) override;
   std::error_code writeSync(IWriteBatch& batch) override;
+  std::error_code flush() override;
   std::error_code read(IReadBatch& batch) override;
+  std::unique_ptr<IDataBase> createSnapshot() override;
   std::unordered_map<uint32_t, RawBlock> blocks();
 
   std::map<std::string, std::string> baseState;
+  size_t readCount = 0;
+  size_t writeCount = 0;
 };
 }
@@ -282,6 +282,10 @@ bool ICoreStub::getRandomOutputs(uint64_t amount, uint16_t count, std::vector<ui
   return randomOutsResult;
 }
 
+void ICoreStub::extractKeyOutputKeys(const uint64_t amount, const std::vector<uint32_t>& absolute_offsets, std::vector<Crypto::PublicKey>& mixin_outputs) const {
+  mixin_outputs.clear();
+}
+
 bool ICoreStub::addTransactionToPool(const CryptoNote::BinaryArray& transactionBinaryArray) {
   transactionPool.emplace(CryptoNote::getBinaryArrayHash(transactionBinaryArray), transactionBinaryArray);
   return true;
@@ -292,6 +296,16 @@ std::vector<Crypto::Hash> ICoreStub::getPoolTransactionHashes() const {
   return {};
 }
 
+bool ICoreStub::getPoolTransaction(const Crypto::Hash& transactionHash, CryptoNote::BinaryArray& transaction) const {
+  auto iter = transactionPool.find(transactionHash);
+  if (iter == transactionPool.end()) {
+    return false;
+  }
+
+  transaction = iter->second;
+  return true;
+}
+
 bool ICoreStub::getBlockTemplate(CryptoNote::BlockTemplate& b, const CryptoNote::AccountPublicAddress& adr, const CryptoNote::BinaryArray& extraNonce, CryptoNote::Difficulty& difficulty, uint32_t& height) const {
   assert(false);
   return false;
@@ -320,6 +334,12 @@ std::error_code ICoreStub::addBlock(const CryptoNote::CachedBlock& cachedBlock,
   return {};
 }
 
+std::error_code ICoreStub::addBlock(const CryptoNote::CachedBlock& cachedBlock, std::vector<CryptoNote::CachedTransaction>&& transactions,
+                                    CryptoNote::RawBlock&& rawBlock) {
+  assert(false);
+  return {};
+}
+
 std::error_code ICoreStub::addBlock(CryptoNote::RawBlock&& rawBlock) {
   assert(false);
   return {};
@@ -50,14 +50,18 @@ public:
   
   virtual CryptoNote::Difficulty getDifficultyForNextBlock() const override;
   virtual std::error_code addBlock(const CryptoNote::CachedBlock& cachedBlock, CryptoNote::RawBlock&& rawBlock) override;
+  virtual std::error_code addBlock(const CryptoNote::CachedBlock& cachedBlock, std::vector<CryptoNote::CachedTransaction>&& transactions,
+                                   CryptoNote::RawBlock&& rawBlock) override;
   virtual std::error_code addBlock(CryptoNote::RawBlock&& rawBlock) override;
   virtual std::error_code submitBlock(CryptoNote::BinaryArray&& rawBlockTemplate) override;
   
   virtual std::vector<CryptoNote::RawBlock> getBlocks(uint32_t startIndex, uint32_t count) const override;
   virtual void getBlocks(const std::vector<Crypto::Hash>& blockHashes, std::vector<CryptoNote::RawBlock>& blocks, std::vector<Crypto::Hash>& missedHashes) const override;
   virtual bool getRandomOutputs(uint64_t amount, uint16_t count, std::vector<uint32_t>& globalIndexes, std::vector<Crypto::PublicKey>& publicKeys) const override;
+  virtual void extractKeyOutputKeys(const uint64_t amount, const std::vector<uint32_t>& absolute_offsets, std::vector<Crypto::PublicKey>& mixin_outputs) const override;
   virtual bool addTransactionToPool(const CryptoNote::BinaryArray& transactionBinaryArray) override;
   virtual std::vector<Crypto::Hash> getPoolTransactionHashes() const override;
+  virtual bool getPoolTransaction(const Crypto::Hash& transactionHash, CryptoNote::BinaryArray& transaction) const override;
   virtual bool getBlockTemplate(CryptoNote::BlockTemplate& b, const CryptoNote::AccountPublicAddress& adr, const CryptoNote::BinaryArray& extraNonce, CryptoNote::Difficulty& difficulty, uint32_t& height) const override;
 
   virtual CryptoNote::CoreStatistics getCoreStatistics() const override;
@@ -39,6 +39,7 @@ public:
 
   void setSynchronizedStatus(bool status);
   virtual void relayBlock(CryptoNote::NOTIFY_NEW_BLOCK_request& arg) override{};
+  virtual void relayBlocks(CryptoNote::NOTIFY_NEW_BLOCKS_request& arg) override{};
   virtual void relayTransactions(const std::vector<CryptoNote::BinaryArray>& transactions) override{};
 
 
@@ -0,0 +1,368 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <boost/uuid/uuid_generators.hpp>
+
+#include "CryptoNoteProtocol/BlockDownloadScheduler.h"
+#include "crypto/crypto.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const uint32_t WINDOW_SIZE = 40;
+const std::chrono::milliseconds STALL_TIMEOUT(1000);
+const BlockDownloadScheduler::SpanCompletion ADDED = BlockDownloadScheduler::SpanCompletion::ADDED;
+const BlockDownloadScheduler::SpanCompletion NOT_NEEDED = BlockDownloadScheduler::SpanCompletion::NOT_NEEDED;
+const BlockDownloadScheduler::SpanCompletion WRONG_BLOCKS = BlockDownloadScheduler::SpanCompletion::WRONG_BLOCKS;
+
+class BlockDownloadSchedulerTest : public ::testing::Test {
+public:
+  BlockDownloadSchedulerTest() : scheduler(WINDOW_SIZE, STALL_TIMEOUT), now(BlockDownloadScheduler::Clock::now()) {
+    boost::uuids::random_generator generator;
+    for (size_t i = 0; i < 3; ++i) {
+      peers.push_back(generator());
+    }
+
+    // the block at index 0 is known to the core
+    for (uint32_t i = 0; i <= 100; ++i) {
+      chain.push_back(Crypto::rand<Crypto::Hash>());
+    }
+  }
+
+  std::vector<Crypto::Hash> entry(uint32_t startIndex, uint32_t lastIndex) const {
+    return std::vector<Crypto::Hash>(chain.begin() + startIndex, chain.begin() + lastIndex + 1);
+  }
+
+  static BlockDownloadScheduler::DownloadedSpan download(const BlockDownloadScheduler::Span& span) {
+    BlockDownloadScheduler::DownloadedSpan downloaded;
+    downloaded.rawBlocks.resize(span.blockHashes.size());
+    downloaded.blockTemplates.resize(span.blockHashes.size());
+    downloaded.blockHashes = span.blockHashes;
+
+    return downloaded;
+  }
+
+protected:
+  BlockDownloadScheduler scheduler;
+  BlockDownloadScheduler::Clock::time_point now;
+  std::vector<BlockDownloadScheduler::PeerId> peers;
+  std::vector<Crypto::Hash> chain;
+};
+
+}
+
+TEST_F(BlockDownloadSchedulerTest, assignsConsecutiveSpansToPeers) {
+  ASSERT_TRUE(scheduler.addChainEntry(peers[0], 0, entry(0, 30)));
+  ASSERT_TRUE(scheduler.addChainEntry(peers[1], 0, entry(0, 30)));
+
+  BlockDownloadScheduler::Span first;
+  BlockDownloadScheduler::Span second;
+  ASSERT_TRUE(scheduler.assignSpan(peers[0], 10, now, first));
+  ASSERT_TRUE(scheduler.assignSpan(peers[1], 10, now, second));
+
+  ASSERT_EQ(1, first.startIndex);
+  ASSERT_EQ(entry(1, 10), first.blockHashes);
+  ASSERT_EQ(11, second.startIndex);
+  ASSERT_EQ(entry(11, 20), second.blockHashes);
+  ASSERT_TRUE(scheduler.isPeerBusy(peers[0]));
+  ASSERT_TRUE(scheduler.isPeerBusy(peers[1]));
+}
+
+TEST_F(BlockDownloadSchedulerTest, doesNotAssignSecondSpanToBusyPeer) {
+  ASSERT_TRUE(scheduler.addChainEntry(peers[0], 0, entry(0, 30)));
+
+  BlockDownloadScheduler::Span span;
+  ASSERT_TRUE(scheduler.assignSpan(peers[0], 10, now, span));
+  ASSERT_FALSE(scheduler.assignSpan(peers[0], 10, now, span));
+}
+
+TEST_F(BlockDownloadSchedulerTest, assignsOnlyBlocksPeerKnows) {
+  ASSERT_TRUE(scheduler.addChainEntry(peers[0], 0, entry(0, 30)));
+  ASSERT_TRUE(scheduler.addChainEntry(peers[1], 0, entry(0, 5)));
+
+  BlockDownloadScheduler::Span span;
+  ASSERT_TRUE(scheduler.assignSpan(peers[1], 10, now, span));
+  ASSERT_EQ(entry(1, 5), span.blockHashes);
+
+  ASSERT_EQ(ADDED, scheduler.completeSpan(peers[1], download(span)));
+  ASSERT_FALSE(scheduler.assignSpan(peers[1], 10, now, span));
+}
+
+TEST_F(BlockDownloadSchedulerTest, handsSpansOutInOrder) {
+  ASSERT_TRUE(scheduler.addChainEntry(peers[0], 0, entry(0, 30)));
+  ASSERT_TRUE(scheduler.addChainEntry(peers[1], 0, entry(0, 30)));
+
+  BlockDownloadScheduler::Span first;
+  BlockDownloadScheduler::Span second;
+  ASSERT_TRUE(scheduler.assignSpan(peers[0], 10, now, first));
+  ASSERT_TRUE(scheduler.assignSpan(peers[1], 10, now, second));
+
+  BlockDownloadScheduler::DownloadedSpan downloaded;
+  ASSERT_EQ(ADDED, scheduler.completeSpan(peers[1], download(second)));
+  ASSERT_FALSE(scheduler.popDownloadedSpan(downloaded));
+
+  ASSERT_EQ(ADDED, scheduler.completeSpan(peers[0], download(first)));
+  ASSERT_TRUE(scheduler.popDownloadedSpan(downloaded));
+  ASSERT_EQ(1, downloaded.startIndex);
+  ASSERT_EQ(peers[0], downloaded.peerId);
+  ASSERT_EQ(entry(1, 10), downloaded.blockHashes);
+
+  // the next span waits until the taken one is added
+  ASSERT_FALSE(scheduler.popDownloadedSpan(downloaded));
+  scheduler.releaseDownloadedSpan(10);
+
+  ASSERT_TRUE(scheduler.popDownloadedSpan(downloaded));
+  ASSERT_EQ(11, downloaded.startIndex);
+  ASSERT_EQ(peers[1], downloaded.peerId);
+  scheduler.releaseDownloadedSpan(10);
+  ASSERT_FALSE(scheduler.popDownloadedSpan(downloaded));
+}
+
+TEST_F(BlockDownloadSchedulerTest, doesNotAssignBlocksBeyondWindow) {
+  ASSERT_TRUE(scheduler.addChainEntry(peers[0], 0, entry(0, 100)));
+  ASSERT_FALSE(scheduler.canExtendChain());
+
+  std::vector<BlockDownloadScheduler::Span> spans(2);
+  ASSERT_TRUE(scheduler.assignSpan(peers[0], 30, now, spans[0]));
+  ASSERT_EQ(ADDED, scheduler.completeSpan(peers[0], download(spans[0])));
+  ASSERT_TRUE(scheduler.assignSpan(peers[0], 30, now, spans[1]));
+  ASSERT_EQ(10, spans[1].blockHashes.size());
+
+  BlockDownloadScheduler::Span span;
+  ASSERT_EQ(ADDED, scheduler.completeSpan(peers[0], download(spans[1])));
+  ASSERT_FALSE(scheduler.assignSpan(peers[0], 30, now, span));
+
+  BlockDownloadScheduler::DownloadedSpan downloaded;
+  ASSERT_TRUE(scheduler.popDownloadedSpan(downloaded));
+  ASSERT_FALSE(scheduler.assignSpan(peers[0], 30, now, span));
+
+  scheduler.releaseDownloadedSpan(30);
+  ASSERT_TRUE(scheduler.assignSpan(peers[0], 30, now, span));
+  ASSERT_EQ(41, span.startIndex);
+}
+
+TEST_F(BlockDownloadSchedulerTest, reassignsSpanOfStalledPeer) {
+  ASSERT_TRUE(scheduler.addChainEntry(peers[0], 0, entry(0, 30)));
+  ASSERT_TRUE(scheduler.addChainEntry(peers[1], 0, entry(0, 30)));
+
+  BlockDownloadScheduler::Span stalled;
+  ASSERT_TRUE(scheduler.assignSpan(peers[0], 10, now, stalled));
+  ASSERT_TRUE(scheduler.reassignStalledSpans(now + STALL_TIMEOUT / 2).empty());
+
+  auto stalledPeers = scheduler.reassignStalledSpans(now + STALL_TIMEOUT * 2);
+  ASSERT_EQ(1, stalledPeers.size());
+  ASSERT_EQ(peers[0], stalledPeers.front());
+
+  BlockDownloadScheduler::Span span;
+  ASSERT_TRUE(scheduler.assignSpan(peers[1], 10, now, span));
+  ASSERT_EQ(stalled.startIndex, span.startIndex);
+  ASSERT_EQ(stalled.blockHashes, span.blockHashes);
+
+  // the copy that comes first is used
+  ASSERT_EQ(ADDED, scheduler.completeSpan(peers[1], download(span)));
+  ASSERT_EQ(NOT_NEEDED, scheduler.completeSpan(peers[0], download(stalled)));
+  ASSERT_FALSE(scheduler.isPeerBusy(peers[0]));
+
+  BlockDownloadScheduler::DownloadedSpan downloaded;
+  ASSERT_TRUE(scheduler.popDownloadedSpan(downloaded));
+  ASSERT_EQ(peers[1], downloaded.peerId);
+}
+
+TEST_F(BlockDownloadSchedulerTest, usesLateResponseOfStalledPeer) {
+  ASSERT_TRUE(scheduler.addChainEntry(peers[0], 0, entry(0, 30)));
+  ASSERT_TRUE(scheduler.addChainEntry(peers[1], 0, entry(0, 30)));
+
+  BlockDownloadScheduler::Span stalled;
+  ASSERT_TRUE(scheduler.assignSpan(peers[0], 10, now, stalled));
+  scheduler.reassignStalledSpans(now + STALL_TIMEOUT * 2);
+  ASSERT_EQ(ADDED, scheduler.completeSpan(peers[0], download(stalled)));
+
+  BlockDownloadScheduler::Span span;
+  ASSERT_TRUE(scheduler.assignSpan(peers[1], 10, now, span));
+  ASSERT_EQ(11, span.startIndex);
+}
+
+TEST_F(BlockDownloadSchedulerTest, splitsReassignedSpan) {
+  ASSERT_TRUE(scheduler.addChainEntry(peers[0], 0, entry(0, 30)));
+  ASSERT_TRUE(scheduler.addChainEntry(peers[1], 0, entry(0, 30)));
+  ASSERT_TRUE(scheduler.addChainEntry(peers[2], 0, entry(0, 30)));
+
+  BlockDownloadScheduler::Span stalled;
+  ASSERT_TRUE(scheduler.assignSpan(peers[0], 10, now, stalled));
+  scheduler.reassignStalledSpans(now + STALL_TIMEOUT * 2);
+
+  std::vector<BlockDownloadScheduler::Span> spans(2);
+  ASSERT_TRUE(scheduler.assignSpan(peers[1], 4, now, spans[0]));
+  ASSERT_TRUE(scheduler.assignSpan(peers[2], 10, now, spans[1]));
+  ASSERT_EQ(entry(1, 4), spans[0].blockHashes);
+  ASSERT_EQ(entry(5, 10), spans[1].blockHashes);
+
+  // a copy of blocks that were taken already is skipped
+  ASSERT_EQ(ADDED, scheduler.completeSpan(peers[2], download(spans[1])));
+  ASSERT_EQ(ADDED, scheduler.completeSpan(peers[0], download(stalled)));
+  ASSERT_EQ(NOT_NEEDED, scheduler.completeSpan(peers[1], download(spans[0])));
+
+  BlockDownloadScheduler::DownloadedSpan downloaded;
+  ASSERT_TRUE(scheduler.popDownloadedSpan(downloaded));
+  ASSERT_EQ(1, downloaded.startIndex);
+  ASSERT_EQ(10, downloaded.rawBlocks.size());
+  ASSERT_FALSE(scheduler.popDownloadedSpan(downloaded));
+}
+
+TEST_F(BlockDownloadSchedulerTest, returnsSpanOfRemovedPeer) {
+  ASSERT_TRUE(scheduler.addChainEntry(peers[0], 0, entry(0, 30)));
+  ASSERT_TRUE(scheduler.addChainEntry(peers[1], 0, entry(0, 30)));
+
+  BlockDownloadScheduler::Span removed;
+  ASSERT_TRUE(scheduler.assignSpan(peers[0], 10, now, removed));
+  scheduler.removePeer(peers[0]);
+
+  BlockDownloadScheduler::Span span;
+  ASSERT_TRUE(scheduler.assignSpan(peers[1], 10, now, span));
+  ASSERT_EQ(removed.blockHashes, span.blockHashes);
+}
+
+TEST_F(BlockDownloadSchedulerTest, extendsChainWithMatchingEntry) {
+  ASSERT_TRUE(scheduler.addChainEntry(peers[0], 0, entry(0, 20)));
+  ASSERT_TRUE(scheduler.addChainEntry(peers[1], 10, entry(10, 30)));
+
+  uint32_t topIndex;
+  Crypto::Hash topHash;
+  ASSERT_TRUE(scheduler.getTopBlock(topIndex, topHash));
+  ASSERT_EQ(30, topIndex);
+  ASSERT_EQ(chain[30], topHash);
+  ASSERT_TRUE(scheduler.hasBlock(25, chain[25]));
+}
+
+TEST_F(BlockDownloadSchedulerTest, rejectsConflictingEntry) {
+  ASSERT_TRUE(scheduler.addChainEntry(peers[0], 0, entry(0, 20)));
+
+  auto conflicting = entry(5, 30);
+  conflicting[10] = Crypto::rand<Crypto::Hash>();
+  ASSERT_FALSE(scheduler.addChainEntry(peers[1], 5, conflicting));
+  ASSERT_FALSE(scheduler.hasPeer(peers[1]));
+  ASSERT_FALSE(scheduler.isPeerChainDownloaded(peers[1]));
+
+  BlockDownloadScheduler::Span span;
+  ASSERT_FALSE(scheduler.assignSpan(peers[1], 10, now, span));
+
+  uint32_t topIndex;
+  Crypto::Hash topHash;
+  ASSERT_TRUE(scheduler.getTopBlock(topIndex, topHash));
+  ASSERT_EQ(20, topIndex);
+}
+
+TEST_F(BlockDownloadSchedulerTest, peerChainIsDownloadedWhenItsBlocksAreAdded) {
+  ASSERT_TRUE(scheduler.addChainEntry(peers[0], 0, entry(0, 10)));
+  ASSERT_TRUE(scheduler.addChainEntry(peers[1], 0, entry(0, 20)));
+
+  BlockDownloadScheduler::Span span;
+  ASSERT_TRUE(scheduler.assignSpan(peers[0], 10, now, span));
+  ASSERT_EQ(ADDED, scheduler.completeSpan(peers[0], download(span)));
+  ASSERT_FALSE(scheduler.isPeerChainDownloaded(peers[0]));
+
+  BlockDownloadScheduler::DownloadedSpan downloaded;
+  ASSERT_TRUE(scheduler.popDownloadedSpan(downloaded));
+  ASSERT_FALSE(scheduler.isPeerChainDownloaded(peers[0]));
+
+  scheduler.releaseDownloadedSpan(10);
+  ASSERT_TRUE(scheduler.isPeerChainDownloaded(peers[0]));
+  ASSERT_FALSE(scheduler.isPeerChainDownloaded(peers[1]));
+  ASSERT_FALSE(scheduler.isEmpty());
+}
+
+TEST_F(BlockDownloadSchedulerTest, downloadsBlocksNotAddedAgain) {
+  ASSERT_TRUE(scheduler.addChainEntry(peers[0], 0, entry(0, 20)));
+  ASSERT_TRUE(scheduler.addChainEntry(peers[1], 0, entry(0, 20)));
+
+  BlockDownloadScheduler::Span span;
+  ASSERT_TRUE(scheduler.assignSpan(peers[0], 10, now, span));
+  ASSERT_EQ(ADDED, scheduler.completeSpan(peers[0], download(span)));
+
+  BlockDownloadScheduler::DownloadedSpan downloaded;
+  ASSERT_TRUE(scheduler.popDownloadedSpan(downloaded));
+  scheduler.releaseDownloadedSpan(4);
+  scheduler.removePeer(peers[0]);
+
+  ASSERT_FALSE(scheduler.hasBlock(4, chain[4]));
+  ASSERT_TRUE(scheduler.assignSpan(peers[1], 20, now, span));
+  ASSERT_EQ(entry(5, 10), span.blockHashes);
+}
+
+TEST_F(BlockDownloadSchedulerTest, rejectsBlocksInOtherOrder) {
+  ASSERT_TRUE(scheduler.addChainEntry(peers[0], 0, entry(0, 20)));
+  ASSERT_TRUE(scheduler.addChainEntry(peers[1], 0, entry(0, 20)));
+
+  BlockDownloadScheduler::Span span;
+  ASSERT_TRUE(scheduler.assignSpan(peers[0], 10, now, span));
+  auto reordered = download(span);
+  std::swap(reordered.blockHashes[2], reordered.blockHashes[3]);
+  ASSERT_EQ(WRONG_BLOCKS, scheduler.completeSpan(peers[0], std::move(reordered)));
+
+  BlockDownloadScheduler::DownloadedSpan downloaded;
+  ASSERT_FALSE(scheduler.popDownloadedSpan(downloaded));
+
+  BlockDownloadScheduler::Span returned;
+  ASSERT_TRUE(scheduler.assignSpan(peers[1], 10, now, returned));
+  ASSERT_EQ(span.blockHashes, returned.blockHashes);
+}
+
+TEST_F(BlockDownloadSchedulerTest, cannotDownloadNextSpanWithoutPeersKnowingIt) {
+  ASSERT_TRUE(scheduler.addChainEntry(peers[0], 0, entry(0, 20)));
+  ASSERT_TRUE(scheduler.canDownloadNextSpan());
+
+  scheduler.removePeer(peers[0]);
+  ASSERT_FALSE(scheduler.canDownloadNextSpan());
+
+  scheduler.reset();
+  ASSERT_TRUE(scheduler.isEmpty());
+  ASSERT_TRUE(scheduler.canDownloadNextSpan());
+}
+
+TEST_F(BlockDownloadSchedulerTest, resetDropsDownloadedBlocks) {
+  ASSERT_TRUE(scheduler.addChainEntry(peers[0], 0, entry(0, 20)));
+
+  BlockDownloadScheduler::Span span;
+  ASSERT_TRUE(scheduler.assignSpan(peers[0], 10, now, span));
+  scheduler.reset();
+  ASSERT_EQ(NOT_NEEDED, scheduler.completeSpan(peers[0], download(span)));
+  ASSERT_FALSE(scheduler.hasPeer(peers[0]));
+
+  BlockDownloadScheduler::DownloadedSpan downloaded;
+  ASSERT_FALSE(scheduler.popDownloadedSpan(downloaded));
+}
+
+TEST_F(BlockDownloadSchedulerTest, resetWhileSpanIsAddedIgnoresRelease) {
+  ASSERT_TRUE(scheduler.addChainEntry(peers[0], 0, entry(0, 20)));
+
+  BlockDownloadScheduler::Span span;
+  ASSERT_TRUE(scheduler.assignSpan(peers[0], 10, now, span));
+  ASSERT_EQ(ADDED, scheduler.completeSpan(peers[0], download(span)));
+
+  BlockDownloadScheduler::DownloadedSpan downloaded;
+  ASSERT_TRUE(scheduler.popDownloadedSpan(downloaded));
+  scheduler.reset();
+  scheduler.releaseDownloadedSpan(10);
+  ASSERT_TRUE(scheduler.isEmpty());
+
+  ASSERT_TRUE(scheduler.addChainEntry(peers[0], 10, entry(10, 20)));
+  ASSERT_TRUE(scheduler.assignSpan(peers[0], 10, now, span));
+  ASSERT_EQ(entry(11, 20), span.blockHashes);
+}
@@ -0,0 +1,113 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "P2p/BlockRequestSizer.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const size_t DEFAULT_BLOCKS_COUNT = 100;
+const size_t MAX_BLOCKS_COUNT = 1000;
+const size_t TARGET_RESPONSE_SIZE = 1000000;
+const std::chrono::milliseconds MAX_RESPONSE_DURATION(10000);
+
+class BlockRequestSizerTest : public ::testing::Test {
+public:
+  BlockRequestSizerTest() :
+    sizer(DEFAULT_BLOCKS_COUNT, MAX_BLOCKS_COUNT, TARGET_RESPONSE_SIZE, MAX_RESPONSE_DURATION),
+    now(BlockRequestSizer::Clock::now()) {
+  }
+
+  void measureLatency(std::chrono::milliseconds latency) {
+    sizer.onChainRequested(now);
+    now += latency;
+    sizer.onChainReceived(now);
+  }
+
+  void measureBlocks(size_t blocksCount, size_t blockSize, std::chrono::milliseconds duration) {
+    sizer.onBlocksRequested(now);
+    now += duration;
+    sizer.onBlocksReceived(blocksCount, blocksCount * blockSize, now);
+  }
+
+protected:
+  BlockRequestSizer sizer;
+  BlockRequestSizer::Clock::time_point now;
+};
+
+}
+
+TEST_F(BlockRequestSizerTest, requestsDefaultCountBeforeMeasurement) {
+  ASSERT_EQ(DEFAULT_BLOCKS_COUNT, sizer.getBlocksCount());
+  ASSERT_EQ(0, sizer.getBytesPerSecond());
+  ASSERT_EQ(0, sizer.getLatency().count());
+}
+
+TEST_F(BlockRequestSizerTest, measuresLatencyOnChainEntries) {
+  measureLatency(std::chrono::milliseconds(200));
+  ASSERT_EQ(200, sizer.getLatency().count());
+}
+
+TEST_F(BlockRequestSizerTest, measuresThroughputWithoutLatency) {
+  measureLatency(std::chrono::milliseconds(100));
+  measureBlocks(100, 1000, std::chrono::milliseconds(1100));
+
+  ASSERT_EQ(100000, sizer.getBytesPerSecond());
+  ASSERT_EQ(1000, sizer.getAverageBlockSize());
+}
+
+TEST_F(BlockRequestSizerTest, aimsAtTargetResponseSize) {
+  measureBlocks(100, 10000, std::chrono::milliseconds(100));
+  ASSERT_EQ(TARGET_RESPONSE_SIZE / 10000, sizer.getBlocksCount());
+}
+
+TEST_F(BlockRequestSizerTest, capsBlocksCountOfSmallBlocks) {
+  measureBlocks(100, 100, std::chrono::milliseconds(100));
+  ASSERT_EQ(MAX_BLOCKS_COUNT, sizer.getBlocksCount());
+}
+
+TEST_F(BlockRequestSizerTest, fillsRoundTripOfSlowLink) {
+  // 10 MB/s over a link with 1 s latency carries more than the target size in a round trip
+  measureLatency(std::chrono::milliseconds(1000));
+  measureBlocks(100, 100000, std::chrono::milliseconds(2000));
+
+  ASSERT_EQ(100, sizer.getBlocksCount());
+}
+
+TEST_F(BlockRequestSizerTest, limitsResponseDurationOfLowThroughput) {
+  // 10 kB/s gets 100 kB in the max response duration
+  measureBlocks(10, 1000, std::chrono::milliseconds(1000));
+  ASSERT_EQ(100, sizer.getBlocksCount());
+
+  // blocks larger than that are requested one by one, once the averages settle
+  for (size_t i = 0; i < 20; ++i) {
+    measureBlocks(1, 200000, std::chrono::milliseconds(20000));
+  }
+
+  ASSERT_EQ(1, sizer.getBlocksCount());
+}
+
+TEST_F(BlockRequestSizerTest, ignoresUnrequestedResponses) {
+  sizer.onBlocksReceived(100, 1000000, now);
+  sizer.onChainReceived(now);
+
+  ASSERT_EQ(DEFAULT_BLOCKS_COUNT, sizer.getBlocksCount());
+  ASSERT_EQ(0, sizer.getLatency().count());
+}
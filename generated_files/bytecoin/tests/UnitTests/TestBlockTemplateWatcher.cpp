@@ -0,0 +1,128 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <System/Context.h>
+#include <System/Dispatcher.h>
+#include <System/Timer.h>
+
+#include "CryptoNoteConfig.h"
+#include "Logging/LoggerGroup.h"
+#include "Rpc/BlockTemplateWatcher.h"
+
+#include "BlockTemplateHelpers.h"
+#include "ICoreStub.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+class BlockTemplateWatcherTest : public ::testing::Test {
+public:
+  BlockTemplateWatcherTest() : watcher(dispatcher, coreStub, logger) {
+  }
+
+  void SetUp() override {
+    addBlock(0);
+    watcher.start();
+  }
+
+  void TearDown() override {
+    watcher.stop();
+  }
+
+protected:
+  void addBlock(uint32_t blockIndex) {
+    coreStub.addBlock(unit_test::makeBlockTemplate(BLOCK_MAJOR_VERSION_1, blockIndex));
+  }
+
+  System::Dispatcher dispatcher;
+  Logging::LoggerGroup logger;
+  ICoreStub coreStub;
+  BlockTemplateWatcher watcher;
+};
+
+}
+
+TEST_F(BlockTemplateWatcherTest, newBlockReleasesAllWaiters) {
+  const std::string longPollId = watcher.getLongPollId();
+  const size_t waitersCount = 100;
+
+  size_t released = 0;
+  std::vector<std::unique_ptr<System::Context<>>> waiters;
+  for (size_t i = 0; i < waitersCount; ++i) {
+    waiters.emplace_back(new System::Context<>(dispatcher, [&] {
+      watcher.wait(longPollId, std::chrono::seconds(30));
+      ++released;
+    }));
+  }
+
+  dispatcher.yield();
+  ASSERT_EQ(waitersCount, watcher.getWaitersCount());
+  ASSERT_EQ(0, released);
+
+  auto start = std::chrono::steady_clock::now();
+  addBlock(1);
+  for (auto& waiter : waiters) {
+    waiter->get();
+  }
+
+  ASSERT_EQ(waitersCount, released);
+  ASSERT_EQ(0, watcher.getWaitersCount());
+  ASSERT_NE(longPollId, watcher.getLongPollId());
+  ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+
+TEST_F(BlockTemplateWatcherTest, changedIdIsNotHeld) {
+  const std::string longPollId = watcher.getLongPollId();
+  addBlock(1);
+
+  System::Timer(dispatcher).sleep(std::chrono::milliseconds(10));
+  ASSERT_NE(longPollId, watcher.getLongPollId());
+
+  auto start = std::chrono::steady_clock::now();
+  watcher.wait(longPollId, std::chrono::seconds(30));
+  ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+}
+
+TEST_F(BlockTemplateWatcherTest, waitReturnsOnTimeout) {
+  const std::string longPollId = watcher.getLongPollId();
+
+  auto start = std::chrono::steady_clock::now();
+  watcher.wait(longPollId, std::chrono::seconds(1));
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  ASSERT_GE(elapsed, std::chrono::seconds(1));
+  ASSERT_LT(elapsed, std::chrono::seconds(5));
+  ASSERT_EQ(longPollId, watcher.getLongPollId());
+}
+
+TEST_F(BlockTemplateWatcherTest, stopReleasesWaiters) {
+  bool released = false;
+  System::Context<> waiter(dispatcher, [&] {
+    watcher.wait(watcher.getLongPollId(), std::chrono::seconds(30));
+    released = true;
+  });
+
+  dispatcher.yield();
+  ASSERT_FALSE(released);
+
+  watcher.stop();
+  waiter.get();
+  ASSERT_TRUE(released);
+}
@@ -0,0 +1,187 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "gtest/gtest.h"
+
+#include <System/Dispatcher.h>
+
+#include "CryptoNoteCore/Account.h"
+#include "CryptoNoteCore/BlockchainSnapshot.h"
+#include "CryptoNoteCore/AccountRegistrationErrors.h"
+#include "CryptoNoteCore/Checkpoints.h"
+#include "CryptoNoteCore/Core.h"
+#include "CryptoNoteCore/CoreErrors.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "CryptoNoteCore/DatabaseBlockchainCacheFactory.h"
+#include "CryptoNoteCore/DatabaseMainChainStorage.h"
+#include "Logging/LoggerGroup.h"
+
+#include "DataBaseMock.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+class CoreTest : public ::testing::Test {
+public:
+  CoreTest()
+      : currency(CurrencyBuilder(logger).currency()),
+        core(currency, logger, Checkpoints(logger), dispatcher,
+             std::unique_ptr<IBlockchainCacheFactory>(new DatabaseBlockchainCacheFactory(database, logger)),
+             createDatabaseMainChainStorage(database)) {
+  }
+
+  void SetUp() override {
+    core.load();
+  }
+
+protected:
+  std::string makeAccountAddress() {
+    AccountBase account;
+    account.generate();
+    return currency.accountAddressAsString(account);
+  }
+
+  AccountRegistration makeRegistration(const std::string& accountNumber) {
+    return AccountRegistration{accountNumber, makeAccountAddress(), {}};
+  }
+
+  Logging::LoggerGroup logger;
+  Currency currency;
+  System::Dispatcher dispatcher;
+  // the main chain storage reads blocks written by the root segment, the genesis one is added by it
+  DataBaseMock database;
+  Core core;
+};
+
+}
+
+TEST_F(CoreTest, addAccountBlocksAddsBlockForEveryRegistration) {
+  std::vector<AccountRegistration> registrations{makeRegistration("0000000001"), makeRegistration("0000000002")};
+
+  auto addedBlocks = core.addAccountBlocks(registrations);
+
+  ASSERT_EQ(2, addedBlocks.size());
+  ASSERT_EQ(2, core.getTopBlockIndex());
+  for (uint32_t i = 0; i < registrations.size(); ++i) {
+    ASSERT_EQ(error::AddBlockErrorCode::ADDED_TO_MAIN, registrations[i].result);
+    ASSERT_EQ(CachedBlock(fromBinaryArray<BlockTemplate>(addedBlocks[i].block)).getBlockHash(), core.getBlockHashByIndex(i + 1));
+  }
+
+  std::vector<AccountAddressRequest> requests{{"0000000001", {}, false}, {"0000000002", {}, false}};
+  core.getAccountAddresses(requests);
+  ASSERT_TRUE(requests[0].found);
+  ASSERT_TRUE(requests[1].found);
+}
+
+TEST_F(CoreTest, addAccountBlocksWritesEveryBlockToDataBase) {
+  std::vector<AccountRegistration> registrations;
+  for (size_t i = 0; i < 5; ++i) {
+    registrations.push_back(makeRegistration("000000000" + std::to_string(i)));
+  }
+
+  auto writeCount = database.writeCount;
+  auto addedBlocks = core.addAccountBlocks(registrations);
+
+  ASSERT_EQ(5, addedBlocks.size());
+  ASSERT_EQ(writeCount + 5, database.writeCount);
+}
+
+TEST_F(CoreTest, addAccountBlocksRejectsDuplicatedNumberOfBatch) {
+  std::vector<AccountRegistration> registrations{makeRegistration("0000000001"), makeRegistration("0000000001")};
+
+  auto addedBlocks = core.addAccountBlocks(registrations);
+
+  ASSERT_EQ(1, addedBlocks.size());
+  ASSERT_EQ(error::AddBlockErrorCode::ADDED_TO_MAIN, registrations[0].result);
+  ASSERT_EQ(error::AccountRegistrationErrorCode::DUPLICATED_ACCOUNT_NUMBER, registrations[1].result);
+  ASSERT_EQ(1, core.getTopBlockIndex());
+}
+
+TEST_F(CoreTest, addAccountBlocksRejectsRegisteredNumber) {
+  std::vector<AccountRegistration> registrations{makeRegistration("0000000001")};
+  core.addAccountBlocks(registrations);
+
+  registrations = {makeRegistration("0000000001"), makeRegistration("0000000002")};
+  auto addedBlocks = core.addAccountBlocks(registrations);
+
+  ASSERT_EQ(1, addedBlocks.size());
+  ASSERT_EQ(error::AccountRegistrationErrorCode::ALREADY_REGISTERED, registrations[0].result);
+  ASSERT_EQ(error::AddBlockErrorCode::ADDED_TO_MAIN, registrations[1].result);
+}
+
+TEST_F(CoreTest, addAccountBlocksReportsResultOfEveryAccount) {
+  std::vector<AccountRegistration> registrations{
+    makeRegistration("123"),
+    AccountRegistration{"0000000002", "not an address", {}},
+    makeRegistration("0000000003")
+  };
+  registrations[1].accountAddress.resize(ACCOUNT_ADDRESS_SIZE, '1');
+
+  auto addedBlocks = core.addAccountBlocks(registrations);
+
+  ASSERT_EQ(1, addedBlocks.size());
+  ASSERT_EQ(error::AccountRegistrationErrorCode::INVALID_ACCOUNT_NUMBER, registrations[0].result);
+  ASSERT_EQ(error::AccountRegistrationErrorCode::INVALID_ACCOUNT_ADDRESS, registrations[1].result);
+  ASSERT_EQ(error::AddBlockErrorCode::ADDED_TO_MAIN, registrations[2].result);
+  ASSERT_EQ(1, core.getTopBlockIndex());
+}
+
+TEST_F(CoreTest, makeAccountBlockBuildsBlockOnTopOfMainChain) {
+  auto block = core.makeAccountBlock("0000000001", makeAccountAddress());
+
+  ASSERT_EQ(ACCOUNT_BLOCK, block.typeBlock);
+  ASSERT_EQ(core.getTopBlockHash(), block.previousBlockHash);
+  ASSERT_EQ(BLOCK_MAJOR_VERSION_5, block.majorVersion);
+  ASSERT_EQ(core.getAccountBlockMinorVersionForHeight(1), block.minorVersion);
+  ASSERT_EQ(1, boost::get<BaseInput>(block.baseTransaction.inputs[0]).blockIndex);
+}
+
+TEST_F(CoreTest, createSnapshotReturnsNullWithGenesisBlockOnly) {
+  ASSERT_EQ(nullptr, core.createSnapshot());
+}
+
+TEST_F(CoreTest, snapshotHasMainChainBlocksAddedBeforeIt) {
+  std::vector<AccountRegistration> registrations{makeRegistration("0000000001"), makeRegistration("0000000002")};
+  core.addAccountBlocks(registrations);
+
+  auto snapshot = core.createSnapshot();
+  ASSERT_NE(nullptr, snapshot);
+  ASSERT_EQ(core.getTopBlockIndex(), snapshot->getTopBlockIndex());
+
+  auto blockHash = core.getBlockHashByIndex(1);
+  BlockDetails snapshotDetails = snapshot->getBlockDetails(blockHash);
+  BlockDetails coreDetails = core.getBlockDetails(blockHash);
+  ASSERT_EQ(coreDetails.index, snapshotDetails.index);
+  ASSERT_EQ(coreDetails.hash, snapshotDetails.hash);
+  ASSERT_EQ(coreDetails.prevBlockHash, snapshotDetails.prevBlockHash);
+  ASSERT_EQ(coreDetails.transactions.size(), snapshotDetails.transactions.size());
+}
+
+TEST_F(CoreTest, snapshotDoesNotSeeBlocksAddedAfterIt) {
+  std::vector<AccountRegistration> registrations{makeRegistration("0000000001")};
+  core.addAccountBlocks(registrations);
+  auto snapshot = core.createSnapshot();
+
+  registrations = {makeRegistration("0000000002")};
+  core.addAccountBlocks(registrations);
+
+  ASSERT_EQ(1, snapshot->getTopBlockIndex());
+  ASSERT_FALSE(snapshot->hasBlock(core.getTopBlockHash()));
+  ASSERT_THROW(snapshot->getBlockDetails(core.getTopBlockHash()), std::runtime_error);
+}
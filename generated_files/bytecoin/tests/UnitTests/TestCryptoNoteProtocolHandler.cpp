@@ -0,0 +1,310 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "gtest/gtest.h"
+
+#include <boost/uuid/uuid_generators.hpp>
+
+#include <System/Dispatcher.h>
+
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteProtocol/CryptoNoteProtocolHandler.h"
+#include "Logging/LoggerGroup.h"
+#include "P2p/LevinProtocol.h"
+
+#include "BlockTemplateHelpers.h"
+#include "ICoreStub.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+class CoreStub : public ICoreStub {
+public:
+  CoreStub(const BlockTemplate& genesisBlock) : ICoreStub(genesisBlock) {
+  }
+
+  virtual std::error_code addBlock(RawBlock&& rawBlock) override {
+    addedBlocks.push_back(std::move(rawBlock));
+    return error::AddBlockErrorCode::ADDED_TO_MAIN;
+  }
+
+  using ICoreStub::addBlock;
+
+  std::vector<RawBlock> addedBlocks;
+};
+
+class P2pEndpointStub : public IP2pEndpoint {
+public:
+  virtual void relay_notify_to_all(int command, const BinaryArray& data_buff, const net_connection_id* excludeConnection) override {}
+  virtual bool invoke_notify_to_peer(int command, const BinaryArray& req_buff, const CryptoNoteConnectionContext& context) override {
+    notifications.push_back({ command, req_buff, context.m_connection_id });
+    return true;
+  }
+
+  virtual uint64_t get_connections_count() override { return connections.size(); }
+  virtual void drop_connection(CryptoNoteConnectionContext& context, bool add_fail) override {}
+  virtual void for_each_connection(std::function<void(CryptoNoteConnectionContext&, PeerIdType)> f) override {
+    for (auto connection : connections) {
+      f(*connection, 1);
+    }
+  }
+
+  virtual void externalRelayNotifyToAll(int command, const BinaryArray& data_buff) override {}
+
+  struct Notification {
+    int command;
+    BinaryArray data;
+    net_connection_id connectionId;
+  };
+
+  std::vector<CryptoNoteConnectionContext*> connections;
+  std::vector<Notification> notifications;
+};
+
+class CryptoNoteProtocolHandlerTest : public ::testing::Test {
+public:
+  CryptoNoteProtocolHandlerTest() :
+    currency(CurrencyBuilder(logger).currency()),
+    core(currency.genesisBlock()) {
+    for (size_t i = 0; i < 2; ++i) {
+      peers[i].version = P2PProtocolVersion::V2;
+      peers[i].m_connection_id = generator();
+      peers[i].m_state = CryptoNoteConnectionContext::state_normal;
+      p2p.connections.push_back(&peers[i]);
+    }
+
+    block = unit_test::makeBlockTemplate(BLOCK_MAJOR_VERSION_1, 1, currency.genesisBlockHash());
+    for (uint8_t i = 0; i < 3; ++i) {
+      transactions.push_back(BinaryArray(100, i));
+      block.transactionHashes.push_back(getBinaryArrayHash(transactions.back()));
+    }
+  }
+
+protected:
+  std::unique_ptr<CryptoNoteProtocolHandler> createHandler(std::chrono::milliseconds timeout = std::chrono::milliseconds(P2P_COMPACT_BLOCK_TRANSACTIONS_TIMEOUT)) {
+    return std::unique_ptr<CryptoNoteProtocolHandler>(new CryptoNoteProtocolHandler(currency, dispatcher, core, &p2p, logger, 1, timeout));
+  }
+
+  template <class Command>
+  void notify(CryptoNoteProtocolHandler& handler, const typename Command::request& request, CryptoNoteConnectionContext& context) {
+    BinaryArray out;
+    bool handled = false;
+    handler.handleCommand(true, Command::ID, LevinProtocol::encode(request), out, context, handled);
+    ASSERT_TRUE(handled);
+  }
+
+  NOTIFY_NEW_COMPACT_BLOCK::request compactBlock() const {
+    return NOTIFY_NEW_COMPACT_BLOCK::request{ toBinaryArray(block), 1, 1 };
+  }
+
+  template <class Command>
+  size_t countSent(const CryptoNoteConnectionContext& context) const {
+    return std::count_if(p2p.notifications.begin(), p2p.notifications.end(), [&context](const P2pEndpointStub::Notification& notification) {
+      return notification.command == Command::ID && notification.connectionId == context.m_connection_id;
+    });
+  }
+
+  template <class Command>
+  typename Command::request lastSent() const {
+    auto it = std::find_if(p2p.notifications.rbegin(), p2p.notifications.rend(), [](const P2pEndpointStub::Notification& notification) {
+      return notification.command == Command::ID;
+    });
+
+    typename Command::request request;
+    EXPECT_NE(p2p.notifications.rend(), it);
+    if (it != p2p.notifications.rend()) {
+      EXPECT_TRUE(LevinProtocol::decode(it->data, request));
+    }
+
+    return request;
+  }
+
+  Logging::LoggerGroup logger;
+  Currency currency;
+  System::Dispatcher dispatcher;
+  CoreStub core;
+  P2pEndpointStub p2p;
+  boost::uuids::random_generator generator;
+  CryptoNoteConnectionContext peers[2];
+  BlockTemplate block;
+  std::vector<BinaryArray> transactions;
+};
+
+}
+
+TEST_F(CryptoNoteProtocolHandlerTest, compactBlockIsRebuiltFromPool) {
+  for (const auto& transaction : transactions) {
+    core.addTransactionToPool(transaction);
+  }
+
+  auto handler = createHandler();
+  notify<NOTIFY_NEW_COMPACT_BLOCK>(*handler, compactBlock(), peers[0]);
+
+  ASSERT_EQ(1, core.addedBlocks.size());
+  ASSERT_EQ(toBinaryArray(block), core.addedBlocks[0].block);
+  ASSERT_EQ(transactions, core.addedBlocks[0].transactions);
+  ASSERT_EQ(0, countSent<NOTIFY_REQUEST_BLOCK_TRANSACTIONS>(peers[0]));
+  ASSERT_EQ(CryptoNoteConnectionContext::state_normal, peers[0].m_state);
+}
+
+TEST_F(CryptoNoteProtocolHandlerTest, compactBlockRequestsTransactionsMissingInPool) {
+  core.addTransactionToPool(transactions[1]);
+
+  auto handler = createHandler();
+  notify<NOTIFY_NEW_COMPACT_BLOCK>(*handler, compactBlock(), peers[0]);
+
+  ASSERT_TRUE(core.addedBlocks.empty());
+  ASSERT_EQ(1, countSent<NOTIFY_REQUEST_BLOCK_TRANSACTIONS>(peers[0]));
+
+  auto request = lastSent<NOTIFY_REQUEST_BLOCK_TRANSACTIONS>();
+  ASSERT_EQ(CachedBlock(block).getBlockHash(), request.block_hash);
+  ASSERT_EQ((std::vector<Crypto::Hash>{ block.transactionHashes[0], block.transactionHashes[2] }), request.txs);
+}
+
+TEST_F(CryptoNoteProtocolHandlerTest, compactBlockTransactionsAreRequestedFromOnePeerAtATime) {
+  auto handler = createHandler();
+  notify<NOTIFY_NEW_COMPACT_BLOCK>(*handler, compactBlock(), peers[0]);
+  notify<NOTIFY_NEW_COMPACT_BLOCK>(*handler, compactBlock(), peers[1]);
+
+  ASSERT_EQ(1, countSent<NOTIFY_REQUEST_BLOCK_TRANSACTIONS>(peers[0]));
+  ASSERT_EQ(0, countSent<NOTIFY_REQUEST_BLOCK_TRANSACTIONS>(peers[1]));
+}
+
+TEST_F(CryptoNoteProtocolHandlerTest, responseCompletesPendingCompactBlock) {
+  core.addTransactionToPool(transactions[1]);
+
+  auto handler = createHandler();
+  notify<NOTIFY_NEW_COMPACT_BLOCK>(*handler, compactBlock(), peers[0]);
+
+  // the response is matched by transaction hashes, not by order
+  NOTIFY_RESPONSE_BLOCK_TRANSACTIONS::request response;
+  response.block_hash = CachedBlock(block).getBlockHash();
+  response.txs = { transactions[2], transactions[0] };
+  notify<NOTIFY_RESPONSE_BLOCK_TRANSACTIONS>(*handler, response, peers[0]);
+
+  ASSERT_EQ(1, core.addedBlocks.size());
+  ASSERT_EQ(toBinaryArray(block), core.addedBlocks[0].block);
+  ASSERT_EQ(transactions, core.addedBlocks[0].transactions);
+  ASSERT_EQ(CryptoNoteConnectionContext::state_normal, peers[0].m_state);
+}
+
+TEST_F(CryptoNoteProtocolHandlerTest, responseForAnotherBlockIsIgnored) {
+  auto handler = createHandler();
+  notify<NOTIFY_NEW_COMPACT_BLOCK>(*handler, compactBlock(), peers[0]);
+
+  NOTIFY_RESPONSE_BLOCK_TRANSACTIONS::request response;
+  response.block_hash = Crypto::rand<Crypto::Hash>();
+  response.txs = transactions;
+  notify<NOTIFY_RESPONSE_BLOCK_TRANSACTIONS>(*handler, response, peers[0]);
+  ASSERT_TRUE(core.addedBlocks.empty());
+
+  // the block is still pending
+  response.block_hash = CachedBlock(block).getBlockHash();
+  notify<NOTIFY_RESPONSE_BLOCK_TRANSACTIONS>(*handler, response, peers[0]);
+  ASSERT_EQ(1, core.addedBlocks.size());
+}
+
+TEST_F(CryptoNoteProtocolHandlerTest, responseFromAnotherPeerIsIgnored) {
+  auto handler = createHandler();
+  notify<NOTIFY_NEW_COMPACT_BLOCK>(*handler, compactBlock(), peers[0]);
+
+  NOTIFY_RESPONSE_BLOCK_TRANSACTIONS::request response;
+  response.block_hash = CachedBlock(block).getBlockHash();
+  response.txs = transactions;
+  notify<NOTIFY_RESPONSE_BLOCK_TRANSACTIONS>(*handler, response, peers[1]);
+
+  ASSERT_TRUE(core.addedBlocks.empty());
+}
+
+TEST_F(CryptoNoteProtocolHandlerTest, incompleteResponseDropsPeer) {
+  auto handler = createHandler();
+  notify<NOTIFY_NEW_COMPACT_BLOCK>(*handler, compactBlock(), peers[0]);
+
+  NOTIFY_RESPONSE_BLOCK_TRANSACTIONS::request response;
+  response.block_hash = CachedBlock(block).getBlockHash();
+  response.txs = { transactions[0], transactions[1] };
+  notify<NOTIFY_RESPONSE_BLOCK_TRANSACTIONS>(*handler, response, peers[0]);
+
+  ASSERT_TRUE(core.addedBlocks.empty());
+  ASSERT_EQ(CryptoNoteConnectionContext::state_shutdown, peers[0].m_state);
+}
+
+TEST_F(CryptoNoteProtocolHandlerTest, pendingCompactBlockSynchronizesAfterTimeout) {
+  auto handler = createHandler(std::chrono::milliseconds(0));
+  notify<NOTIFY_NEW_COMPACT_BLOCK>(*handler, compactBlock(), peers[0]);
+  ASSERT_EQ(1, countSent<NOTIFY_REQUEST_BLOCK_TRANSACTIONS>(peers[0]));
+
+  handler->onIdle();
+
+  ASSERT_EQ(CryptoNoteConnectionContext::state_synchronizing, peers[0].m_state);
+  ASSERT_EQ(1, countSent<NOTIFY_REQUEST_CHAIN>(peers[0]));
+  ASSERT_EQ(CryptoNoteConnectionContext::state_normal, peers[1].m_state);
+
+  // the late response isn't applied
+  NOTIFY_RESPONSE_BLOCK_TRANSACTIONS::request response;
+  response.block_hash = CachedBlock(block).getBlockHash();
+  response.txs = transactions;
+  notify<NOTIFY_RESPONSE_BLOCK_TRANSACTIONS>(*handler, response, peers[0]);
+  ASSERT_TRUE(core.addedBlocks.empty());
+}
+
+TEST_F(CryptoNoteProtocolHandlerTest, pendingCompactBlockWaitsUntilTimeout) {
+  auto handler = createHandler();
+  notify<NOTIFY_NEW_COMPACT_BLOCK>(*handler, compactBlock(), peers[0]);
+
+  handler->onIdle();
+
+  ASSERT_EQ(CryptoNoteConnectionContext::state_normal, peers[0].m_state);
+  ASSERT_EQ(0, countSent<NOTIFY_REQUEST_CHAIN>(peers[0]));
+}
+
+TEST_F(CryptoNoteProtocolHandlerTest, requestForBlockTransactionsIsAnsweredWithBlockTransactionsOnly) {
+  core.addBlock(block);
+  for (const auto& transaction : transactions) {
+    core.addTransactionToPool(transaction);
+  }
+
+  BinaryArray otherTransaction(100, 0xff);
+  core.addTransactionToPool(otherTransaction);
+
+  auto handler = createHandler();
+  NOTIFY_REQUEST_BLOCK_TRANSACTIONS::request request;
+  request.block_hash = CachedBlock(block).getBlockHash();
+  request.txs = { block.transactionHashes[2], getBinaryArrayHash(otherTransaction), block.transactionHashes[0] };
+  notify<NOTIFY_REQUEST_BLOCK_TRANSACTIONS>(*handler, request, peers[0]);
+
+  ASSERT_EQ(1, countSent<NOTIFY_RESPONSE_BLOCK_TRANSACTIONS>(peers[0]));
+  auto response = lastSent<NOTIFY_RESPONSE_BLOCK_TRANSACTIONS>();
+  ASSERT_EQ(request.block_hash, response.block_hash);
+  ASSERT_EQ((std::vector<BinaryArray>{ transactions[2], transactions[0] }), response.txs);
+}
+
+TEST_F(CryptoNoteProtocolHandlerTest, requestForUnknownBlockIsNotAnswered) {
+  core.addTransactionToPool(transactions[0]);
+
+  auto handler = createHandler();
+  NOTIFY_REQUEST_BLOCK_TRANSACTIONS::request request;
+  request.block_hash = CachedBlock(block).getBlockHash();
+  request.txs = { block.transactionHashes[0] };
+  notify<NOTIFY_REQUEST_BLOCK_TRANSACTIONS>(*handler, request, peers[0]);
+
+  ASSERT_EQ(0, countSent<NOTIFY_RESPONSE_BLOCK_TRANSACTIONS>(peers[0]));
+  ASSERT_EQ(CryptoNoteConnectionContext::state_normal, peers[0].m_state);
+}
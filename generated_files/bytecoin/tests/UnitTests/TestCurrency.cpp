@@ -129,3 +129,20 @@ TEST_F(Currency_isFusionTransactionTest, failsIfTransactionHasInputLessThanDustT
   auto tx = builder.buildTx();
   ASSERT_FALSE(m_currency.isFusionTransaction(tx));
 }
+
+TEST(Currency_accountBlockMinorVersionTest, switchesToSecondVersionAfterUpgradeHeight) {
+  Logging::ConsoleLogger logger;
+  Currency currency = CurrencyBuilder(logger).upgradeHeightAccountBlockV2(100).currency();
+
+  ASSERT_EQ(ACCOUNT_BLOCK_MINOR_VERSION_1, currency.accountBlockMinorVersion(0));
+  ASSERT_EQ(ACCOUNT_BLOCK_MINOR_VERSION_1, currency.accountBlockMinorVersion(100));
+  ASSERT_EQ(ACCOUNT_BLOCK_MINOR_VERSION_2, currency.accountBlockMinorVersion(101));
+}
+
+TEST(Currency_accountBlockMinorVersionTest, staysAtFirstVersionUntilUpgradeIsScheduled) {
+  Logging::ConsoleLogger logger;
+  Currency currency = CurrencyBuilder(logger).currency();
+
+  ASSERT_EQ(ACCOUNT_BLOCK_MINOR_VERSION_1, currency.accountBlockMinorVersion(0));
+  ASSERT_EQ(ACCOUNT_BLOCK_MINOR_VERSION_1, currency.accountBlockMinorVersion(static_cast<uint32_t>(-1)));
+}
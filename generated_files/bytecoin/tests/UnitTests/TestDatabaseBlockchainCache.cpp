@@ -20,9 +20,12 @@
 #include "crypto/crypto.h"
 
 #include "CryptoNoteCore/BlockchainCache.h"
+#include "CryptoNoteCore/BlockchainSnapshot.h"
 #include <CryptoNoteCore/DatabaseBlockchainCache.h>
+#include "CryptoNoteCore/DatabaseBlockchainCacheFactory.h"
 #include "CryptoNoteCore/CryptoNoteTools.h"
 #include "CryptoNoteCore/TransactionValidatiorState.h"
+#include "BlockTemplateHelpers.h"
 #include "DataBaseMock.h"
 #include <CryptoNoteCore/DBUtils.h>
 #include "CryptoNoteCore/MemoryBlockchainCacheFactory.h"
@@ -74,6 +77,21 @@ public:
     return cnt;
   }
 
+  void pushAccountBlock(const std::string& accountNumber, const std::string& accountAddress) {
+    auto block = unit_test::makeAccountBlockTemplate(ACCOUNT_BLOCK_MINOR_VERSION_1, blockchain.getTopBlockIndex() + 1,
+      accountNumber, accountAddress, blockchain.getTopBlockHash());
+    TransactionValidatorState state;
+    blockchain.pushBlock(CachedBlock(block), {}, state, 1, 1, 1, { toBinaryArray(block), {} });
+  }
+
+  void pushBlockSpending(DatabaseBlockchainCache& cache, const KeyImage& keyImage) {
+    auto block = unit_test::makeBlockTemplate(BLOCK_MAJOR_VERSION_1, cache.getTopBlockIndex() + 1, cache.getTopBlockHash());
+
+    TransactionValidatorState state;
+    state.spentKeyImages.insert(keyImage);
+    cache.pushBlock(CachedBlock(block), {}, state, 1, 1, 1, { toBinaryArray(block), {} });
+  }
+
   Currency currency;
   DataBaseMock database;
   Logging::FileLogger logger;
@@ -186,3 +204,224 @@ TEST_F(DatabaseBlockchainCacheTests, RawBlocksWithTxsSerialization) {
   ASSERT_EQ(deserializedRawBlock.block, rawBlock.block);
   ASSERT_EQ(deserializedRawBlock.transactions, rawBlock.transactions);
 }
+
+TEST_F(DatabaseBlockchainCacheTests, BatchedKeyOutputKeysMatchSingleRequests) {
+  std::vector<KeyOutputKeysRequest> requests;
+  for (const auto& amountCount : countOutputsForAmount()) {
+    KeyOutputKeysRequest request;
+    request.amount = amountCount.first;
+    for (uint32_t i = 0; i < amountCount.second; ++i) {
+      request.globalIndexes.push_back(i);
+    }
+
+    requests.push_back(std::move(request));
+  }
+
+  ASSERT_FALSE(requests.empty());
+
+  auto readCount = database.readCount;
+  blockchain.extractKeyOutputKeys(blockchain.getTopBlockIndex(), requests);
+  ASSERT_EQ(readCount + 1, database.readCount);
+
+  for (const auto& request : requests) {
+    std::vector<PublicKey> publicKeys;
+    auto result = blockchain.extractKeyOutputKeys(request.amount, blockchain.getTopBlockIndex(),
+      {request.globalIndexes.data(), request.globalIndexes.size()}, publicKeys);
+
+    ASSERT_EQ(result, request.result);
+    if (result == ExtractOutputKeysResult::SUCCESS) {
+      ASSERT_EQ(publicKeys, request.publicKeys);
+    }
+  }
+}
+
+TEST_F(DatabaseBlockchainCacheTests, BatchedKeyOutputKeysReportsMissingOutput) {
+  auto outputsCount = countOutputsForAmount();
+  ASSERT_FALSE(outputsCount.empty());
+
+  std::vector<KeyOutputKeysRequest> requests(1);
+  requests[0].amount = outputsCount.begin()->first;
+  requests[0].globalIndexes = { 0, outputsCount.begin()->second };
+
+  blockchain.extractKeyOutputKeys(blockchain.getTopBlockIndex() + currency.minedMoneyUnlockWindow(), requests);
+  ASSERT_EQ(ExtractOutputKeysResult::INVALID_GLOBAL_INDEX, requests[0].result);
+
+  std::vector<PublicKey> publicKeys;
+  ASSERT_EQ(ExtractOutputKeysResult::INVALID_GLOBAL_INDEX, blockchain.extractKeyOutputKeys(requests[0].amount,
+    blockchain.getTopBlockIndex() + currency.minedMoneyUnlockWindow(), {requests[0].globalIndexes.data(), requests[0].globalIndexes.size()}, publicKeys));
+}
+
+TEST_F(DatabaseBlockchainCacheTests, BatchedKeyOutputKeysWalkParentSegments) {
+  auto parentBlocksCount = generator.getBlockchain().size();
+  generator.generateEmptyBlocks(currency.minedMoneyUnlockWindow());
+  auto blocks = generator.getBlockchainCopy();
+
+  BlockchainCache child("", currency, logger, &blockchain, CachedBlock(blocks[parentBlocksCount]).getBlockIndex());
+  for (size_t i = parentBlocksCount; i < blocks.size(); ++i) {
+    child.pushBlock(CachedBlock(blocks[i]), {}, TransactionValidatorState(), 1, 1, 1, { toBinaryArray(blocks[i]), {} });
+  }
+
+  std::vector<KeyOutputKeysRequest> requests;
+  for (const auto& amountCount : countOutputsForAmount()) {
+    KeyOutputKeysRequest request;
+    request.amount = amountCount.first;
+    for (uint32_t i = 0; i < amountCount.second; ++i) {
+      request.globalIndexes.push_back(i);
+    }
+
+    requests.push_back(std::move(request));
+  }
+
+  auto readCount = database.readCount;
+  child.extractKeyOutputKeys(child.getTopBlockIndex(), requests);
+  ASSERT_EQ(readCount + 1, database.readCount);
+
+  for (const auto& request : requests) {
+    std::vector<PublicKey> publicKeys;
+    auto result = child.extractKeyOutputKeys(request.amount, child.getTopBlockIndex(),
+      {request.globalIndexes.data(), request.globalIndexes.size()}, publicKeys);
+
+    ASSERT_EQ(result, request.result);
+    if (result == ExtractOutputKeysResult::SUCCESS) {
+      ASSERT_EQ(publicKeys, request.publicKeys);
+    }
+  }
+}
+
+TEST_F(DatabaseBlockchainCacheTests, AccountsAreResolvedInOneRead) {
+  pushAccountBlock("0000000001", "address1");
+  pushAccountBlock("0000000002", "address2");
+
+  std::vector<AccountAddressRequest> requests{ { "0000000002", {}, false }, { "0000000003", {}, false }, { "0000000001", {}, false } };
+
+  auto readCount = database.readCount;
+  blockchain.getAccountAddresses(blockchain.getTopBlockIndex(), requests);
+  ASSERT_EQ(readCount + 1, database.readCount);
+
+  ASSERT_TRUE(requests[0].found);
+  ASSERT_EQ("address2", requests[0].accountAddress);
+  ASSERT_FALSE(requests[1].found);
+  ASSERT_TRUE(requests[2].found);
+  ASSERT_EQ("address1", requests[2].accountAddress);
+}
+
+TEST_F(DatabaseBlockchainCacheTests, AccountIsNotVisibleBeforeItsBlock) {
+  pushAccountBlock("0000000001", "address1");
+
+  std::vector<AccountAddressRequest> requests{ { "0000000001", {}, false } };
+  blockchain.getAccountAddresses(blockchain.getTopBlockIndex() - 1, requests);
+  ASSERT_FALSE(requests[0].found);
+}
+
+TEST_F(DatabaseBlockchainCacheTests, SplitMovesAccountsToChild) {
+  pushAccountBlock("0000000001", "address1");
+  auto splitBlockIndex = blockchain.getTopBlockIndex() + 1;
+  pushAccountBlock("0000000002", "address2");
+  pushAccountBlock("0000000003", "address3");
+
+  auto child = blockchain.split(splitBlockIndex);
+
+  std::vector<AccountAddressRequest> requests{ { "0000000001", {}, false }, { "0000000002", {}, false }, { "0000000003", {}, false } };
+  blockchain.getAccountAddresses(std::numeric_limits<uint32_t>::max(), requests);
+  ASSERT_TRUE(requests[0].found);
+  ASSERT_FALSE(requests[1].found);
+  ASSERT_FALSE(requests[2].found);
+
+  child->getAccountAddresses(child->getTopBlockIndex(), requests);
+  ASSERT_TRUE(requests[0].found);
+  ASSERT_EQ("address1", requests[0].accountAddress);
+  ASSERT_TRUE(requests[1].found);
+  ASSERT_EQ("address2", requests[1].accountAddress);
+  ASSERT_TRUE(requests[2].found);
+  ASSERT_EQ("address3", requests[2].accountAddress);
+}
+
+TEST_F(DatabaseBlockchainCacheTests, SpentKeyImagesFilterIsLoadedFromDatabase) {
+  auto keyImage = Crypto::rand<KeyImage>();
+  pushBlockSpending(blockchain, keyImage);
+
+  DatabaseBlockchainCache filtered(currency, database, blockchainCacheFactory, logger, 1024);
+  ASSERT_TRUE(filtered.checkIfSpent(keyImage));
+  ASSERT_FALSE(filtered.checkIfSpent(keyImage, filtered.getTopBlockIndex() - 1));
+}
+
+TEST_F(DatabaseBlockchainCacheTests, SpentKeyImagesFilterFollowsPushedBlocks) {
+  DatabaseBlockchainCache filtered(currency, database, blockchainCacheFactory, logger, 1024);
+
+  auto keyImage = Crypto::rand<KeyImage>();
+  ASSERT_FALSE(filtered.checkIfSpent(keyImage));
+  pushBlockSpending(filtered, keyImage);
+  ASSERT_TRUE(filtered.checkIfSpent(keyImage));
+}
+
+TEST_F(DatabaseBlockchainCacheTests, SpentKeyImagesFilterAnswersUnspentWithoutDatabase) {
+  DatabaseBlockchainCache filtered(currency, database, blockchainCacheFactory, logger, 1024);
+  pushBlockSpending(filtered, Crypto::rand<KeyImage>());
+
+  auto readCount = database.readCount;
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_FALSE(filtered.checkIfSpent(Crypto::rand<KeyImage>()));
+  }
+
+  // 1 KB filter with one key image has almost no false positives
+  ASSERT_GE(readCount + 1, database.readCount);
+}
+
+TEST_F(DatabaseBlockchainCacheTests, SnapshotDoesNotSeeLaterBlocks) {
+  DatabaseBlockchainCacheFactory factory(database, logger);
+  auto snapshot = factory.createRootBlockchainCacheSnapshot(currency);
+  ASSERT_NE(nullptr, snapshot);
+
+  uint32_t topBlockIndex = blockchain.getTopBlockIndex();
+  pushBlockSpending(blockchain, Crypto::rand<KeyImage>());
+
+  ASSERT_EQ(topBlockIndex, snapshot->getTopBlockIndex());
+  ASSERT_TRUE(snapshot->hasBlock(generatedBlockHashes.back()));
+  ASSERT_FALSE(snapshot->hasBlock(blockchain.getTopBlockHash()));
+  ASSERT_EQ(topBlockIndex + 1, blockchain.getTopBlockIndex());
+}
+
+TEST_F(DatabaseBlockchainCacheTests, SnapshotOfGenesisBlockOnlyIsNotCreated) {
+  DataBaseMock emptyDatabase;
+  DatabaseBlockchainCache cache(currency, emptyDatabase, blockchainCacheFactory, logger);
+  DatabaseBlockchainCacheFactory factory(emptyDatabase, logger);
+
+  ASSERT_EQ(nullptr, factory.createRootBlockchainCacheSnapshot(currency));
+}
+
+TEST_F(DatabaseBlockchainCacheTests, SnapshotBlockDetailsMatchBlocks) {
+  DatabaseBlockchainCacheFactory factory(database, logger);
+  BlockchainSnapshot snapshot(currency, factory.createRootBlockchainCacheSnapshot(currency));
+
+  const BlockTemplate& block = generator.getBlockchain()[1];
+  uint32_t blockIndex = blockchain.getBlockIndex(generatedBlockHashes[1]);
+  BlockDetails details = snapshot.getBlockDetails(generatedBlockHashes[1]);
+  ASSERT_EQ(blockIndex, details.index);
+  ASSERT_EQ(generatedBlockHashes[1], details.hash);
+  ASSERT_EQ(block.previousBlockHash, details.prevBlockHash);
+  ASSERT_FALSE(details.isAlternative);
+  ASSERT_EQ(1, details.transactions.size());
+
+  Crypto::Hash baseTransactionHash = getObjectHash(block.baseTransaction);
+  ASSERT_EQ(baseTransactionHash, details.transactions[0].hash);
+  ASSERT_TRUE(snapshot.hasTransaction(baseTransactionHash));
+  TransactionDetails transactionDetails = snapshot.getTransactionDetails(baseTransactionHash);
+  ASSERT_EQ(blockIndex, transactionDetails.blockIndex);
+  ASSERT_TRUE(transactionDetails.inBlockchain);
+
+  ASSERT_THROW(snapshot.getBlockDetails(randomBlockHash()), std::runtime_error);
+}
+
+TEST_F(DatabaseBlockchainCacheTests, SnapshotKeepsTopBlockOfItsTime) {
+  DatabaseBlockchainCacheFactory factory(database, logger);
+  BlockchainSnapshot snapshot(currency, factory.createRootBlockchainCacheSnapshot(currency));
+  auto topBlockIndex = blockchain.getTopBlockIndex();
+
+  pushAccountBlock("0000000001", std::string(ACCOUNT_ADDRESS_SIZE, '1'));
+
+  ASSERT_EQ(topBlockIndex, snapshot.getTopBlockIndex());
+  ASSERT_TRUE(snapshot.hasBlock(generatedBlockHashes.back()));
+  ASSERT_FALSE(snapshot.hasBlock(blockchain.getTopBlockHash()));
+  ASSERT_THROW(snapshot.getBlockDetails(blockchain.getTopBlockHash()), std::runtime_error);
+  ASSERT_THROW(snapshot.getTransactionDetails(randomBlockHash()), std::runtime_error);
+}
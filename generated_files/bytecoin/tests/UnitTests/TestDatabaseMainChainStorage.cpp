@@ -0,0 +1,104 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "crypto/crypto.h"
+
+#include "CryptoNoteCore/BlockchainCache.h"
+#include "CryptoNoteCore/DatabaseMainChainStorage.h"
+#include "DataBaseMock.h"
+
+using namespace CryptoNote;
+
+class DatabaseMainChainStorageTests : public ::testing::Test {
+public:
+  // writes the records DatabaseBlockchainCache writes for a pushed block
+  void insertBlock(uint32_t blockIndex) {
+    RawBlock rawBlock;
+    rawBlock.block.push_back(static_cast<uint8_t>(blockIndex));
+
+    BlockchainWriteBatch batch;
+    batch.insertCachedBlock(CachedBlockInfo{ Crypto::rand<Crypto::Hash>(), blockIndex, 0, 0, 0, 0 }, blockIndex, {});
+    batch.insertRawBlock(blockIndex, rawBlock);
+    database.write(batch);
+  }
+
+protected:
+  DataBaseMock database;
+};
+
+TEST_F(DatabaseMainChainStorageTests, emptyDataBaseHasNoBlocks) {
+  DatabaseMainChainStorage storage(database);
+  ASSERT_EQ(0, storage.getBlockCount());
+  ASSERT_THROW(storage.getBlockByIndex(0), std::out_of_range);
+}
+
+TEST_F(DatabaseMainChainStorageTests, blockCountIsReadFromDataBase) {
+  insertBlock(0);
+  insertBlock(1);
+  insertBlock(2);
+
+  DatabaseMainChainStorage storage(database);
+  ASSERT_EQ(3, storage.getBlockCount());
+  ASSERT_EQ(1, storage.getBlockByIndex(1).block.size());
+  ASSERT_EQ(2, storage.getBlockByIndex(2).block[0]);
+  ASSERT_THROW(storage.getBlockByIndex(3), std::out_of_range);
+}
+
+TEST_F(DatabaseMainChainStorageTests, blockCountIsReadOnce) {
+  insertBlock(0);
+
+  DatabaseMainChainStorage storage(database);
+  ASSERT_EQ(1, storage.getBlockCount());
+  size_t readCount = database.readCount;
+  ASSERT_EQ(1, storage.getBlockCount());
+  ASSERT_EQ(readCount, database.readCount);
+}
+
+TEST_F(DatabaseMainChainStorageTests, pushAndPopOnlyCountBlocks) {
+  insertBlock(0);
+
+  DatabaseMainChainStorage storage(database);
+  storage.pushBlock(RawBlock());
+  storage.pushBlock(RawBlock());
+  ASSERT_EQ(3, storage.getBlockCount());
+  ASSERT_EQ(1, database.blocks().size());
+
+  storage.popBlock();
+  ASSERT_EQ(2, storage.getBlockCount());
+}
+
+TEST_F(DatabaseMainChainStorageTests, pushedBlockIsReadFromDataBase) {
+  insertBlock(0);
+
+  DatabaseMainChainStorage storage(database);
+  storage.pushBlock(RawBlock());
+  ASSERT_THROW(storage.getBlockByIndex(1), std::out_of_range);
+
+  insertBlock(1);
+  ASSERT_EQ(1, storage.getBlockByIndex(1).block[0]);
+}
+
+TEST_F(DatabaseMainChainStorageTests, clearRemovesAllBlocks) {
+  insertBlock(0);
+  insertBlock(1);
+
+  DatabaseMainChainStorage storage(database);
+  storage.clear();
+  ASSERT_EQ(0, storage.getBlockCount());
+}
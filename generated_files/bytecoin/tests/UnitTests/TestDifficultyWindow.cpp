@@ -0,0 +1,150 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "CryptoNoteCore/BlockchainCache.h"
+#include "CryptoNoteCore/CachedBlock.h"
+#include "CryptoNoteCore/DifficultyWindow.h"
+#include "CryptoNoteCore/TransactionValidatiorState.h"
+#include "CryptoNoteCore/UpgradeManager.h"
+#include "CryptoNoteConfig.h"
+#include "Logging/ConsoleLogger.h"
+
+#include "BlockTemplateHelpers.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const size_t CHAIN_LENGTH = 3000;
+
+class DifficultyWindowTest : public ::testing::Test {
+public:
+  DifficultyWindowTest() :
+    logger(Logging::ERROR),
+    // Small window, so both the growing and the sliding window are crossed many times
+    currency(CurrencyBuilder(logger).difficultyWindow(24).difficultyCut(5).difficultyLag(4).currency()),
+    generator(42) {
+    // Same schedule the segments use
+    upgradeManager.addMajorBlockVersion(BLOCK_MAJOR_VERSION_2, currency.upgradeHeight(BLOCK_MAJOR_VERSION_2));
+    upgradeManager.addMajorBlockVersion(BLOCK_MAJOR_VERSION_3, currency.upgradeHeight(BLOCK_MAJOR_VERSION_3));
+    upgradeManager.addMajorBlockVersion(BLOCK_MAJOR_VERSION_4, currency.upgradeHeight(BLOCK_MAJOR_VERSION_4));
+  }
+
+  // Noisy timestamps: out of order and repeated ones are usual for real chains
+  uint64_t nextTimestamp(uint64_t previousTimestamp) {
+    std::uniform_int_distribution<int64_t> jitter(-3 * static_cast<int64_t>(currency.difficultyTarget()), 3 * static_cast<int64_t>(currency.difficultyTarget()));
+    return static_cast<uint64_t>(static_cast<int64_t>(previousTimestamp + currency.difficultyTarget()) + jitter(generator));
+  }
+
+  Difficulty nextBlockDifficulty() {
+    return std::uniform_int_distribution<Difficulty>(1, 1000000)(generator);
+  }
+
+  Difficulty expectedDifficulty(const IBlockchainCache& cache) {
+    auto blockIndex = cache.getTopBlockIndex();
+    auto version = upgradeManager.getBlockMajorVersion(blockIndex + 1);
+    auto count = currency.difficultyBlocksCountByBlockVersion(version);
+    return currency.nextDifficulty(version, blockIndex, cache.getLastTimestamps(count, blockIndex, UseGenesis{false}),
+      cache.getLastCumulativeDifficulties(count, blockIndex, UseGenesis{false}));
+  }
+
+  void pushBlock(BlockchainCache& cache, uint64_t timestamp) {
+    auto block = unit_test::makeBlockTemplate(BLOCK_MAJOR_VERSION_1, cache.getTopBlockIndex() + 1, cache.getTopBlockHash());
+    block.timestamp = timestamp;
+    blocks.push_back(block);
+
+    cache.pushBlock(CachedBlock(blocks.back()), {}, TransactionValidatorState(), 1, 1, nextBlockDifficulty(), RawBlock());
+  }
+
+protected:
+  Logging::ConsoleLogger logger;
+  Currency currency;
+  UpgradeManager upgradeManager;
+  std::mt19937_64 generator;
+  std::deque<BlockTemplate> blocks;
+};
+
+}
+
+TEST_F(DifficultyWindowTest, matchesCurrencyOverLongSyntheticChain) {
+  DifficultyWindow window(currency, BLOCK_MAJOR_VERSION_3);
+  auto blocksCount = currency.difficultyBlocksCountByBlockVersion(BLOCK_MAJOR_VERSION_3);
+
+  std::vector<uint64_t> timestamps;
+  std::vector<Difficulty> cumulativeDifficulties;
+  uint64_t timestamp = 1000000;
+  Difficulty cumulativeDifficulty = 1;
+  for (size_t i = 0; i < CHAIN_LENGTH; ++i) {
+    timestamp = nextTimestamp(timestamp);
+    cumulativeDifficulty += nextBlockDifficulty();
+    timestamps.push_back(timestamp);
+    cumulativeDifficulties.push_back(cumulativeDifficulty);
+    window.pushBack(timestamp, cumulativeDifficulty);
+
+    auto first = timestamps.size() > blocksCount ? timestamps.size() - blocksCount : 0;
+    auto expected = currency.nextDifficulty(BLOCK_MAJOR_VERSION_3, static_cast<uint32_t>(i + 1),
+      std::vector<uint64_t>(timestamps.begin() + first, timestamps.end()),
+      std::vector<Difficulty>(cumulativeDifficulties.begin() + first, cumulativeDifficulties.end()));
+    ASSERT_EQ(expected, window.nextDifficulty()) << "after block " << i;
+    ASSERT_EQ(std::min(timestamps.size(), blocksCount), window.getBlocksCount());
+  }
+}
+
+TEST_F(DifficultyWindowTest, handlesEqualTimestamps) {
+  DifficultyWindow window(currency, BLOCK_MAJOR_VERSION_3);
+  auto blocksCount = currency.difficultyBlocksCountByBlockVersion(BLOCK_MAJOR_VERSION_3);
+
+  std::vector<uint64_t> timestamps;
+  std::vector<Difficulty> cumulativeDifficulties;
+  for (size_t i = 0; i < 200; ++i) {
+    timestamps.push_back(1000 + (i / 7) * 3);
+    cumulativeDifficulties.push_back(100 * (i + 1));
+    window.pushBack(timestamps.back(), cumulativeDifficulties.back());
+
+    auto first = timestamps.size() > blocksCount ? timestamps.size() - blocksCount : 0;
+    auto expected = currency.nextDifficulty(BLOCK_MAJOR_VERSION_3, static_cast<uint32_t>(i + 1),
+      std::vector<uint64_t>(timestamps.begin() + first, timestamps.end()),
+      std::vector<Difficulty>(cumulativeDifficulties.begin() + first, cumulativeDifficulties.end()));
+    ASSERT_EQ(expected, window.nextDifficulty()) << "after block " << i;
+  }
+}
+
+TEST_F(DifficultyWindowTest, cacheFollowsPushesAndSplits) {
+  BlockchainCache cache("cache", currency, logger, nullptr);
+  uint64_t timestamp = currency.genesisBlock().timestamp;
+
+  std::vector<std::unique_ptr<IBlockchainCache>> children;
+  for (size_t i = 1; i < CHAIN_LENGTH; ++i) {
+    timestamp = nextTimestamp(timestamp);
+    pushBlock(cache, timestamp);
+    ASSERT_EQ(expectedDifficulty(cache), cache.getDifficultyForNextBlock()) << "after block " << i;
+
+    // Splits pop from a few up to more than the whole window off the lower part, the upper part keeps the top
+    if (i % 97 == 0) {
+      auto splitBlockIndex = cache.getTopBlockIndex() + 1 - static_cast<uint32_t>(i % 41);
+      children.push_back(cache.split(splitBlockIndex));
+
+      ASSERT_EQ(expectedDifficulty(*children.back()), children.back()->getDifficultyForNextBlock());
+      ASSERT_EQ(expectedDifficulty(cache), cache.getDifficultyForNextBlock()) << "after split at " << splitBlockIndex;
+    }
+  }
+}
@@ -0,0 +1,143 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "CryptoNoteCore/LongHashCalculator.h"
+#include "CryptoNoteConfig.h"
+#include "crypto/hash.h"
+#include "BlockTemplateHelpers.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const size_t BLOCKS_COUNT = 8;
+
+class LongHashCalculatorTest : public ::testing::Test {
+public:
+  void SetUp() override {
+    blocks.resize(BLOCKS_COUNT);
+    for (size_t i = 0; i < BLOCKS_COUNT; ++i) {
+      blocks[i].majorVersion = BLOCK_MAJOR_VERSION_1;
+      blocks[i].minorVersion = BLOCK_MINOR_VERSION_0;
+      blocks[i].nonce = static_cast<uint32_t>(i);
+      blocks[i].timestamp = 0;
+      blocks[i].previousBlockHash = Crypto::Hash();
+
+      BaseInput input;
+      input.blockIndex = static_cast<uint32_t>(i);
+      blocks[i].baseTransaction.version = CURRENT_TRANSACTION_VERSION;
+      blocks[i].baseTransaction.unlockTime = 0;
+      blocks[i].baseTransaction.inputs.push_back(input);
+    }
+  }
+
+  std::vector<std::unique_ptr<CachedBlock>> makeCachedBlocks() {
+    std::vector<std::unique_ptr<CachedBlock>> cachedBlocks;
+    for (const auto& block : blocks) {
+      cachedBlocks.emplace_back(new CachedBlock(block));
+    }
+
+    return cachedBlocks;
+  }
+
+protected:
+  std::vector<BlockTemplate> blocks;
+};
+
+}
+
+TEST_F(LongHashCalculatorTest, matchesSerialHashingWithAnyThreadsCount) {
+  Crypto::cn_context context;
+  std::vector<Crypto::Hash> expectedHashes;
+  for (const auto& cachedBlock : makeCachedBlocks()) {
+    expectedHashes.push_back(cachedBlock->getBlockLongHash(context));
+  }
+
+  for (size_t threads : {1, 3, 8}) {
+    LongHashCalculator calculator(threads);
+    ASSERT_EQ(threads, calculator.getThreadsCount());
+
+    auto cachedBlocks = makeCachedBlocks();
+    std::vector<const CachedBlock*> blockPointers;
+    for (const auto& cachedBlock : cachedBlocks) {
+      blockPointers.push_back(cachedBlock.get());
+    }
+
+    ASSERT_TRUE(calculator.calculate(blockPointers));
+    for (size_t i = 0; i < BLOCKS_COUNT; ++i) {
+      ASSERT_EQ(expectedHashes[i], cachedBlocks[i]->getBlockLongHash(context));
+    }
+  }
+}
+
+TEST_F(LongHashCalculatorTest, reportsBlockOfUnknownVersion) {
+  blocks[BLOCKS_COUNT / 2].majorVersion = 0;
+
+  LongHashCalculator calculator(4);
+  auto cachedBlocks = makeCachedBlocks();
+  std::vector<const CachedBlock*> blockPointers;
+  for (const auto& cachedBlock : cachedBlocks) {
+    blockPointers.push_back(cachedBlock.get());
+  }
+
+  ASSERT_FALSE(calculator.calculate(blockPointers));
+}
+
+namespace {
+
+BlockTemplate makeAccountBlock(uint8_t minorVersion) {
+  return unit_test::makeAccountBlockTemplate(minorVersion, 1, "1234567890");
+}
+
+}
+
+TEST(AccountBlockLongHashTest, firstVersionCommitsWithSlowHash) {
+  auto block = makeAccountBlock(ACCOUNT_BLOCK_MINOR_VERSION_1);
+  CachedBlock cachedBlock(block);
+  ASSERT_EQ(ACCOUNT_BLOCK, cachedBlock.getTypeOfBlock());
+
+  Crypto::cn_context context;
+  Crypto::Hash expectedHash;
+  Crypto::cn_slow_hash(context, block.accountNumber.data(), block.accountNumber.size(), expectedHash);
+  ASSERT_EQ(expectedHash, cachedBlock.getBlockLongHash(context));
+}
+
+TEST(AccountBlockLongHashTest, secondVersionCommitsWithFastHash) {
+  auto block = makeAccountBlock(ACCOUNT_BLOCK_MINOR_VERSION_2);
+  CachedBlock cachedBlock(block);
+  ASSERT_EQ(ACCOUNT_BLOCK, cachedBlock.getTypeOfBlock());
+
+  Crypto::cn_context context;
+  Crypto::Hash expectedHash;
+  Crypto::cn_fast_hash(block.accountNumber.data(), block.accountNumber.size(), expectedHash);
+  ASSERT_EQ(expectedHash, cachedBlock.getBlockLongHash(context));
+}
+
+TEST(AccountBlockLongHashTest, secondVersionSurvivesSerialization) {
+  auto block = makeAccountBlock(ACCOUNT_BLOCK_MINOR_VERSION_2);
+  BlockTemplate parsedBlock;
+  ASSERT_TRUE(fromBinaryArray(parsedBlock, toBinaryArray(block)));
+  ASSERT_EQ(ACCOUNT_BLOCK_MINOR_VERSION_2, parsedBlock.minorVersion);
+  ASSERT_EQ(block.accountNumber, parsedBlock.accountNumber);
+  ASSERT_EQ(CachedBlock(block).getBlockHash(), CachedBlock(parsedBlock).getBlockHash());
+}
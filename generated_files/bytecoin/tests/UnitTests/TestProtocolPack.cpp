@@ -20,6 +20,7 @@
 #include "gtest/gtest.h"
 #include "CryptoNoteProtocol/CryptoNoteProtocolDefinitions.h"
 #include "Serialization/SerializationTools.h"
+#include "crypto/crypto.h"
 
 TEST(protocol_pack, protocol_pack_command) 
 {
@@ -38,3 +39,35 @@ TEST(protocol_pack, protocol_pack_command)
     ASSERT_TRUE(r.total_height == 3);
   }
 }
+
+TEST(protocol_pack, compact_block_round_trip)
+{
+  CryptoNote::NOTIFY_NEW_COMPACT_BLOCK::request block;
+  block.block = { 1, 2, 3, 0, 255 };
+  block.current_blockchain_height = 100;
+  block.hop = 2;
+
+  CryptoNote::NOTIFY_NEW_COMPACT_BLOCK::request loadedBlock;
+  ASSERT_TRUE(CryptoNote::loadFromBinaryKeyValue(loadedBlock, CryptoNote::storeToBinaryKeyValue(block)));
+  ASSERT_EQ(block.block, loadedBlock.block);
+  ASSERT_EQ(100, loadedBlock.current_blockchain_height);
+  ASSERT_EQ(2, loadedBlock.hop);
+
+  CryptoNote::NOTIFY_REQUEST_BLOCK_TRANSACTIONS::request request;
+  request.block_hash = Crypto::rand<Crypto::Hash>();
+  request.txs = { Crypto::rand<Crypto::Hash>(), Crypto::rand<Crypto::Hash>() };
+
+  CryptoNote::NOTIFY_REQUEST_BLOCK_TRANSACTIONS::request loadedRequest;
+  ASSERT_TRUE(CryptoNote::loadFromBinaryKeyValue(loadedRequest, CryptoNote::storeToBinaryKeyValue(request)));
+  ASSERT_EQ(request.block_hash, loadedRequest.block_hash);
+  ASSERT_EQ(request.txs, loadedRequest.txs);
+
+  CryptoNote::NOTIFY_RESPONSE_BLOCK_TRANSACTIONS::request response;
+  response.block_hash = request.block_hash;
+  response.txs = { { 4, 5, 6 }, { 0, 7 }, {} };
+
+  CryptoNote::NOTIFY_RESPONSE_BLOCK_TRANSACTIONS::request loadedResponse;
+  ASSERT_TRUE(CryptoNote::loadFromBinaryKeyValue(loadedResponse, CryptoNote::storeToBinaryKeyValue(response)));
+  ASSERT_EQ(response.block_hash, loadedResponse.block_hash);
+  ASSERT_EQ(response.txs, loadedResponse.txs);
+}
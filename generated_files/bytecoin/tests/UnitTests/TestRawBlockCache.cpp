@@ -0,0 +1,179 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "gtest/gtest.h"
+
+#include "CryptoNoteCore/RawBlockCache.h"
+#include "crypto/crypto.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const size_t BLOCK_SIZE = 100;
+
+// a block of BLOCK_SIZE bytes in total, tagged with its index
+RawBlock makeRawBlock(uint32_t blockIndex) {
+  RawBlock rawBlock;
+  rawBlock.block.assign(BLOCK_SIZE / 2, static_cast<uint8_t>(blockIndex));
+  rawBlock.transactions.emplace_back(BLOCK_SIZE / 2, static_cast<uint8_t>(blockIndex));
+  return rawBlock;
+}
+
+class RawBlockCacheTest : public ::testing::Test {
+public:
+  void SetUp() override {
+    for (uint32_t i = 0; i < 8; ++i) {
+      hashes.push_back(Crypto::rand<Crypto::Hash>());
+    }
+  }
+
+  void insert(RawBlockCache& cache, uint32_t blockIndex) {
+    cache.insert(blockIndex, hashes[blockIndex], makeRawBlock(blockIndex));
+  }
+
+protected:
+  std::vector<Crypto::Hash> hashes;
+};
+
+}
+
+TEST_F(RawBlockCacheTest, findsInsertedBlocksByIndexAndHash) {
+  RawBlockCache cache(4 * BLOCK_SIZE);
+  insert(cache, 1);
+
+  auto block = cache.find(1);
+  ASSERT_NE(nullptr, block);
+  ASSERT_EQ(1, block->block[0]);
+  ASSERT_EQ(1, block->transactions.size());
+
+  block = cache.find(hashes[1]);
+  ASSERT_NE(nullptr, block);
+  ASSERT_EQ(1, block->block[0]);
+
+  ASSERT_EQ(nullptr, cache.find(2));
+  ASSERT_EQ(nullptr, cache.find(hashes[2]));
+  ASSERT_EQ(BLOCK_SIZE, cache.getSize());
+}
+
+TEST_F(RawBlockCacheTest, countsMissesOnlyForIndexLookups) {
+  RawBlockCache cache(4 * BLOCK_SIZE);
+  insert(cache, 1);
+
+  cache.find(1);
+  cache.find(hashes[1]);
+  cache.find(2);
+  cache.find(hashes[2]);
+  cache.findTemplate(2);
+
+  ASSERT_EQ(2, cache.getHitsCount());
+  ASSERT_EQ(1, cache.getMissesCount());
+}
+
+TEST_F(RawBlockCacheTest, evictsLeastRecentlyUsedBlocks) {
+  RawBlockCache cache(3 * BLOCK_SIZE);
+  insert(cache, 0);
+  insert(cache, 1);
+  insert(cache, 2);
+
+  cache.find(0);
+  insert(cache, 3);
+
+  ASSERT_NE(nullptr, cache.find(0));
+  ASSERT_EQ(nullptr, cache.find(1));
+  ASSERT_EQ(nullptr, cache.find(hashes[1]));
+  ASSERT_NE(nullptr, cache.find(2));
+  ASSERT_NE(nullptr, cache.find(3));
+  ASSERT_EQ(3 * BLOCK_SIZE, cache.getSize());
+}
+
+TEST_F(RawBlockCacheTest, replacesBlockWithTheSameIndex) {
+  RawBlockCache cache(3 * BLOCK_SIZE);
+  insert(cache, 1);
+  cache.insert(1, hashes[2], makeRawBlock(2));
+
+  ASSERT_EQ(nullptr, cache.find(hashes[1]));
+  ASSERT_EQ(2, cache.find(1)->block[0]);
+  ASSERT_EQ(BLOCK_SIZE, cache.getSize());
+}
+
+TEST_F(RawBlockCacheTest, doesNotCacheBlocksLargerThanCapacity) {
+  RawBlockCache cache(BLOCK_SIZE - 1);
+  insert(cache, 1);
+
+  ASSERT_EQ(nullptr, cache.find(1));
+  ASSERT_EQ(0, cache.getSize());
+}
+
+TEST_F(RawBlockCacheTest, zeroCapacityDisablesCache) {
+  RawBlockCache cache(0);
+  insert(cache, 1);
+  cache.insertTemplate(1, BlockTemplate());
+
+  ASSERT_EQ(nullptr, cache.find(1));
+  ASSERT_EQ(nullptr, cache.findTemplate(1));
+  ASSERT_EQ(0, cache.getMissesCount());
+}
+
+TEST_F(RawBlockCacheTest, removeFromDropsBlocksStartingAtIndex) {
+  RawBlockCache cache(8 * BLOCK_SIZE);
+  for (uint32_t i = 0; i < 5; ++i) {
+    insert(cache, i);
+  }
+
+  cache.removeFrom(3);
+
+  ASSERT_NE(nullptr, cache.find(2));
+  ASSERT_EQ(nullptr, cache.find(3));
+  ASSERT_EQ(nullptr, cache.find(hashes[4]));
+  ASSERT_EQ(3 * BLOCK_SIZE, cache.getSize());
+
+  insert(cache, 3);
+  ASSERT_NE(nullptr, cache.find(3));
+}
+
+TEST_F(RawBlockCacheTest, keepsTemplatesOnlyForCachedBlocks) {
+  RawBlockCache cache(2 * BLOCK_SIZE);
+  BlockTemplate blockTemplate;
+  blockTemplate.timestamp = 12345;
+
+  cache.insertTemplate(1, blockTemplate);
+  ASSERT_EQ(nullptr, cache.findTemplate(1));
+
+  insert(cache, 1);
+  cache.insertTemplate(1, blockTemplate);
+  auto cachedTemplate = cache.findTemplate(1);
+  ASSERT_NE(nullptr, cachedTemplate);
+  ASSERT_EQ(12345, cachedTemplate->timestamp);
+
+  insert(cache, 2);
+  insert(cache, 3);
+  ASSERT_EQ(nullptr, cache.findTemplate(1));
+}
+
+TEST_F(RawBlockCacheTest, clearRemovesAllBlocks) {
+  RawBlockCache cache(4 * BLOCK_SIZE);
+  insert(cache, 1);
+  insert(cache, 2);
+
+  cache.clear();
+
+  ASSERT_EQ(nullptr, cache.find(1));
+  ASSERT_EQ(nullptr, cache.find(hashes[2]));
+  ASSERT_EQ(0, cache.getSize());
+}
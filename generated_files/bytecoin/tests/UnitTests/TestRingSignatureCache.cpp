@@ -0,0 +1,135 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "CryptoNoteCore/RingSignatureCache.h"
+#include "crypto/crypto.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const size_t RING_SIZE = 3;
+const size_t CHECKS_COUNT = 8;
+
+class RingSignatureCacheTest : public ::testing::Test {
+public:
+  void SetUp() override {
+    signatures.resize(CHECKS_COUNT);
+    for (size_t i = 0; i < CHECKS_COUNT; ++i) {
+      RingSignatureCheck check;
+      check.prefixHash = Crypto::rand<Crypto::Hash>();
+      check.keyImage = Crypto::rand<Crypto::KeyImage>();
+      for (size_t j = 0; j < RING_SIZE; ++j) {
+        check.outputKeys.push_back(Crypto::rand<Crypto::PublicKey>());
+        signatures[i].push_back(Crypto::rand<Crypto::Signature>());
+      }
+
+      check.signatures = &signatures[i];
+      check.checkKeyImage = true;
+      check.transactionIndex = 0;
+      check.inputIndex = 0;
+      checks.push_back(std::move(check));
+    }
+  }
+
+protected:
+  std::vector<std::vector<Crypto::Signature>> signatures;
+  std::vector<RingSignatureCheck> checks;
+};
+
+}
+
+TEST_F(RingSignatureCacheTest, findsInsertedChecksAndCountsHits) {
+  RingSignatureCache cache(CHECKS_COUNT);
+  ASSERT_FALSE(cache.contains(checks[0]));
+
+  cache.insert(checks[0]);
+  ASSERT_TRUE(cache.contains(checks[0]));
+  ASSERT_FALSE(cache.contains(checks[1]));
+
+  ASSERT_EQ(1, cache.getHitsCount());
+  ASSERT_EQ(2, cache.getMissesCount());
+  ASSERT_EQ(1, cache.getSize());
+}
+
+TEST_F(RingSignatureCacheTest, distinguishesEverythingSignatureDependsOn) {
+  RingSignatureCache cache(CHECKS_COUNT);
+  cache.insert(checks[0]);
+
+  auto check = checks[0];
+  check.inputIndex = 1;
+  ASSERT_FALSE(cache.contains(check));
+
+  check = checks[0];
+  check.outputKeys[RING_SIZE - 1] = Crypto::rand<Crypto::PublicKey>();
+  ASSERT_FALSE(cache.contains(check));
+
+  check = checks[0];
+  check.keyImage = Crypto::rand<Crypto::KeyImage>();
+  ASSERT_FALSE(cache.contains(check));
+
+  check = checks[0];
+  check.checkKeyImage = false;
+  ASSERT_FALSE(cache.contains(check));
+
+  auto otherSignatures = signatures[0];
+  otherSignatures[0] = Crypto::rand<Crypto::Signature>();
+  check = checks[0];
+  check.signatures = &otherSignatures;
+  ASSERT_FALSE(cache.contains(check));
+
+  check = checks[0];
+  check.transactionIndex = 5;
+  ASSERT_TRUE(cache.contains(check));
+}
+
+TEST_F(RingSignatureCacheTest, evictsLeastRecentlyUsedCheck) {
+  RingSignatureCache cache(2);
+  cache.insert(checks[0]);
+  cache.insert(checks[1]);
+  ASSERT_TRUE(cache.contains(checks[0]));
+
+  cache.insert(checks[2]);
+  ASSERT_EQ(2, cache.getSize());
+  ASSERT_TRUE(cache.contains(checks[0]));
+  ASSERT_FALSE(cache.contains(checks[1]));
+  ASSERT_TRUE(cache.contains(checks[2]));
+}
+
+TEST_F(RingSignatureCacheTest, zeroCapacityDisablesCache) {
+  RingSignatureCache cache(0);
+  cache.insert(checks[0]);
+  ASSERT_FALSE(cache.contains(checks[0]));
+  ASSERT_EQ(0, cache.getSize());
+}
+
+TEST_F(RingSignatureCacheTest, clearRemovesAllChecks) {
+  RingSignatureCache cache(CHECKS_COUNT);
+  for (const auto& check : checks) {
+    cache.insert(check);
+  }
+
+  cache.clear();
+  ASSERT_EQ(0, cache.getSize());
+  for (const auto& check : checks) {
+    ASSERT_FALSE(cache.contains(check));
+  }
+}
@@ -0,0 +1,104 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "CryptoNoteCore/RingSignatureVerifier.h"
+#include "crypto/crypto.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const size_t RING_SIZE = 3;
+const size_t CHECKS_COUNT = 64;
+
+class RingSignatureVerifierTest : public ::testing::Test {
+public:
+  void SetUp() override {
+    std::vector<Crypto::SecretKey> secretKeys(RING_SIZE);
+    std::vector<Crypto::PublicKey> publicKeys(RING_SIZE);
+    for (size_t i = 0; i < RING_SIZE; ++i) {
+      Crypto::generate_keys(publicKeys[i], secretKeys[i]);
+    }
+
+    std::vector<const Crypto::PublicKey*> publicKeyPointers;
+    for (const auto& key : publicKeys) {
+      publicKeyPointers.push_back(&key);
+    }
+
+    signatures.resize(CHECKS_COUNT);
+    for (size_t i = 0; i < CHECKS_COUNT; ++i) {
+      RingSignatureCheck check;
+      check.prefixHash = Crypto::rand<Crypto::Hash>();
+      Crypto::generate_key_image(publicKeys[i % RING_SIZE], secretKeys[i % RING_SIZE], check.keyImage);
+      check.outputKeys = publicKeys;
+      check.checkKeyImage = true;
+      check.transactionIndex = i;
+      check.inputIndex = 0;
+
+      signatures[i].resize(RING_SIZE);
+      Crypto::generate_ring_signature(check.prefixHash, check.keyImage, publicKeyPointers.data(), RING_SIZE, secretKeys[i % RING_SIZE],
+                                      i % RING_SIZE, signatures[i].data());
+      check.signatures = &signatures[i];
+
+      checks.push_back(std::move(check));
+    }
+  }
+
+  void corruptSignature(size_t index) {
+    checks[index].prefixHash = Crypto::rand<Crypto::Hash>();
+  }
+
+protected:
+  std::vector<std::vector<Crypto::Signature>> signatures;
+  std::vector<RingSignatureCheck> checks;
+};
+
+}
+
+TEST_F(RingSignatureVerifierTest, acceptsValidSignaturesWithAnyThreadsCount) {
+  for (size_t threads : {1, 2, 4, 7}) {
+    RingSignatureVerifier verifier(threads);
+    ASSERT_EQ(threads, verifier.getThreadsCount());
+    ASSERT_EQ(checks.size(), verifier.verify(checks));
+  }
+}
+
+TEST_F(RingSignatureVerifierTest, reportsFirstFailedCheckWithAnyThreadsCount) {
+  corruptSignature(CHECKS_COUNT - 1);
+  corruptSignature(37);
+  corruptSignature(11);
+
+  for (size_t threads : {1, 2, 4, 7}) {
+    RingSignatureVerifier verifier(threads);
+    for (size_t i = 0; i < 10; ++i) {
+      ASSERT_EQ(11, verifier.verify(checks));
+    }
+  }
+}
+
+TEST_F(RingSignatureVerifierTest, handlesEmptyAndConsecutiveBatches) {
+  RingSignatureVerifier verifier(4);
+  ASSERT_EQ(0, verifier.verify(std::vector<RingSignatureCheck>()));
+  ASSERT_EQ(checks.size(), verifier.verify(checks));
+
+  corruptSignature(0);
+  ASSERT_EQ(0, verifier.verify(checks));
+}
@@ -0,0 +1,581 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <unordered_set>
+
+#include <boost/filesystem.hpp>
+
+#include "rocksdb/db.h"
+
+#include "Common/CommandLine.h"
+#include "CryptoNoteCore/BlockchainCache.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "CryptoNoteCore/DatabaseBlockchainCache.h"
+#include "CryptoNoteCore/DatabaseCacheData.h"
+#include "CryptoNoteCore/DBUtils.h"
+#include "CryptoNoteCore/RocksDBWrapper.h"
+#include "Logging/LoggerGroup.h"
+#include "Serialization/KVBinaryOutputStreamSerializer.h"
+
+#include "BlockTemplateHelpers.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const std::string SCHEME_VERSION_KEY = "db_scheme_version";
+
+class TestWriteBatch : public IWriteBatch {
+public:
+  explicit TestWriteBatch(const std::vector<std::pair<std::string, std::string>>& rawData, const std::vector<std::string>& rawKeysToRemove = {}) :
+    rawData(rawData), rawKeysToRemove(rawKeysToRemove) {
+  }
+
+  virtual std::vector<std::pair<std::string, std::string>> extractRawDataToInsert() override {
+    return rawData;
+  }
+
+  virtual std::vector<std::string> extractRawKeysToRemove() override {
+    return rawKeysToRemove;
+  }
+
+private:
+  std::vector<std::pair<std::string, std::string>> rawData;
+  std::vector<std::string> rawKeysToRemove;
+};
+
+class TestReadBatch : public IReadBatch {
+public:
+  explicit TestReadBatch(const std::vector<std::string>& rawKeys) : rawKeys(rawKeys) {
+  }
+
+  virtual std::vector<std::string> getRawKeys() const override {
+    return rawKeys;
+  }
+
+  virtual void submitRawResult(const std::vector<std::string>& values, const std::vector<bool>& resultStates) override {
+    this->values = values;
+    this->resultStates = resultStates;
+  }
+
+  std::vector<std::string> rawKeys;
+  std::vector<std::string> values;
+  std::vector<bool> resultStates;
+};
+
+// records of DB schemes before version 4 were KV binary documents, keys were (prefix, key) pairs
+template <class Value>
+std::string serializeKVBinary(const Value& value, const std::string& name) {
+  KVBinaryOutputStreamSerializer serializer;
+  std::string serialized;
+  Common::StringOutputStream stream(serialized);
+  serializer(const_cast<Value&>(value), name);
+  serializer.dump(stream);
+  return serialized;
+}
+
+template <class Key>
+std::string serializeKVBinaryKey(const std::string& keyPrefix, const Key& key) {
+  return serializeKVBinary(std::make_pair(keyPrefix, key), keyPrefix);
+}
+
+template <class Key, class Value>
+std::pair<std::string, std::string> serializeKVBinary(const std::string& keyPrefix, const Key& key, const Value& value) {
+  return { serializeKVBinaryKey(keyPrefix, key), serializeKVBinary(value, keyPrefix) };
+}
+
+class RocksDBWrapperTest : public ::testing::Test {
+public:
+  RocksDBWrapperTest() : database(logger) {
+  }
+
+  void SetUp() override {
+    dataDir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(dataDir);
+    config.setDataDir(dataDir.string());
+    config.setWriteBufferSize(4 * 1024 * 1024);
+    config.setReadCacheSize(1024 * 1024);
+
+    rawData = {
+      DB::serialize(DB::KEY_IMAGE_TO_BLOCK_INDEX_PREFIX, Crypto::rand<Crypto::KeyImage>(), uint32_t(1)),
+      DB::serialize(DB::BLOCK_INDEX_TO_BLOCK_HASH_PREFIX, uint32_t(1), Crypto::rand<Crypto::Hash>()),
+      DB::serialize(DB::BLOCK_INDEX_TO_BLOCK_HASH_PREFIX, DB::LAST_BLOCK_INDEX_KEY, uint32_t(1)),
+      DB::serialize(DB::PAYMENT_ID_TO_TX_HASH_PREFIX, Crypto::rand<Crypto::Hash>(), Crypto::rand<Crypto::Hash>()),
+      { SCHEME_VERSION_KEY, "3" }
+    };
+  }
+
+  void TearDown() override {
+    boost::filesystem::remove_all(dataDir);
+  }
+
+protected:
+  std::string getDBPath() const {
+    return (dataDir / "DB").string();
+  }
+
+  std::vector<std::string> getKeys() const {
+    std::vector<std::string> keys;
+    for (const auto& kv : rawData) {
+      keys.push_back(kv.first);
+    }
+
+    return keys;
+  }
+
+  // what a restart after a crash would read, writes held in the open group are lost
+  bool isCommitted(const std::string& key) const {
+    std::vector<std::string> families;
+    EXPECT_TRUE(rocksdb::DB::ListColumnFamilies(rocksdb::DBOptions(), getDBPath(), &families).ok());
+    std::vector<rocksdb::ColumnFamilyDescriptor> descriptors;
+    for (const std::string& name : families) {
+      descriptors.emplace_back(name, rocksdb::ColumnFamilyOptions());
+    }
+
+    rocksdb::DB* db;
+    std::vector<rocksdb::ColumnFamilyHandle*> handles;
+    EXPECT_TRUE(rocksdb::DB::OpenForReadOnly(rocksdb::DBOptions(), getDBPath(), descriptors, &handles, &db).ok());
+
+    bool found = false;
+    for (rocksdb::ColumnFamilyHandle* handle : handles) {
+      std::string value;
+      found = found || db->Get(rocksdb::ReadOptions(), handle, key, &value).ok();
+      delete handle;
+    }
+
+    delete db;
+    return found;
+  }
+
+  void checkAllRead() {
+    TestReadBatch readBatch(getKeys());
+    ASSERT_FALSE(database.read(readBatch));
+    ASSERT_EQ(rawData.size(), readBatch.values.size());
+    for (size_t i = 0; i < rawData.size(); ++i) {
+      ASSERT_TRUE(readBatch.resultStates[i]);
+      ASSERT_EQ(rawData[i].second, readBatch.values[i]);
+    }
+  }
+
+  Logging::LoggerGroup logger;
+  boost::filesystem::path dataDir;
+  DataBaseConfig config;
+  RocksDBWrapper database;
+  std::vector<std::pair<std::string, std::string>> rawData;
+};
+
+}
+
+TEST(DBUtilsTest, getKeyPrefixReturnsIndexPrefix) {
+  ASSERT_EQ('7', DB::getKeyPrefix(DB::serializeKey(DB::KEY_IMAGE_TO_BLOCK_INDEX_PREFIX, Crypto::KeyImage())));
+  ASSERT_EQ('4', DB::getKeyPrefix(DB::serializeKey(DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX, uint32_t(5))));
+  ASSERT_EQ('8', DB::getKeyPrefix(DB::serializeKey(DB::BLOCK_INDEX_TO_BLOCK_HASH_PREFIX, DB::LAST_BLOCK_INDEX_KEY)));
+  ASSERT_EQ('j', DB::getKeyPrefix(DB::serializeKey(DB::KEY_OUTPUT_KEY_PREFIX, std::make_pair(uint64_t(7), uint32_t(3)))));
+  ASSERT_EQ(0, DB::getKeyPrefix(SCHEME_VERSION_KEY));
+  ASSERT_EQ(0, DB::getKeyPrefix(""));
+}
+
+TEST(DBUtilsTest, keysAreFixedWidth) {
+  ASSERT_EQ(1 + 4, DB::serializeKey(DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX, uint32_t(5)).size());
+  ASSERT_EQ(1 + 32, DB::serializeKey(DB::KEY_IMAGE_TO_BLOCK_INDEX_PREFIX, Crypto::KeyImage()).size());
+  ASSERT_EQ(1 + 8 + 4, DB::serializeKey(DB::KEY_OUTPUT_KEY_PREFIX, std::make_pair(uint64_t(7), uint32_t(3))).size());
+  ASSERT_EQ(std::string("4") + '\x00' + '\x01' + '\x02' + '\x03', DB::serializeKey(DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX, uint32_t(0x00010203)));
+}
+
+TEST(DBUtilsTest, keysSortByNumbers) {
+  ASSERT_LT(DB::serializeKey(DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX, uint32_t(255)), DB::serializeKey(DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX, uint32_t(256)));
+  ASSERT_LT(DB::serializeKey(DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX, uint32_t(0x7fffffff)), DB::serializeKey(DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX, uint32_t(0x80000000)));
+  ASSERT_LT(DB::serializeKey(DB::KEY_OUTPUT_KEY_PREFIX, std::make_pair(uint64_t(1), uint32_t(0xffffffff))),
+            DB::serializeKey(DB::KEY_OUTPUT_KEY_PREFIX, std::make_pair(uint64_t(2), uint32_t(0))));
+}
+
+TEST(DBUtilsTest, valuesRoundTrip) {
+  CachedBlockInfo blockInfo{ Crypto::rand<Crypto::Hash>(), 1500000000, 123456789, 1000000000000, 300, 100000 };
+  CachedBlockInfo readBlockInfo;
+  DB::deserialize(DB::serialize(blockInfo, DB::BLOCK_INDEX_TO_BLOCK_INFO_PREFIX), readBlockInfo, DB::BLOCK_INDEX_TO_BLOCK_INFO_PREFIX);
+  ASSERT_EQ(blockInfo.blockHash, readBlockInfo.blockHash);
+  ASSERT_EQ(blockInfo.timestamp, readBlockInfo.timestamp);
+  ASSERT_EQ(blockInfo.cumulativeDifficulty, readBlockInfo.cumulativeDifficulty);
+  ASSERT_EQ(blockInfo.alreadyGeneratedCoins, readBlockInfo.alreadyGeneratedCoins);
+  ASSERT_EQ(blockInfo.alreadyGeneratedTransactions, readBlockInfo.alreadyGeneratedTransactions);
+  ASSERT_EQ(blockInfo.blockSize, readBlockInfo.blockSize);
+
+  std::unordered_set<Crypto::KeyImage> keyImages{ Crypto::rand<Crypto::KeyImage>(), Crypto::rand<Crypto::KeyImage>() };
+  std::vector<Crypto::KeyImage> readKeyImages;
+  DB::deserialize(DB::serialize(keyImages, DB::BLOCK_INDEX_TO_KEY_IMAGE_PREFIX), readKeyImages, DB::BLOCK_INDEX_TO_KEY_IMAGE_PREFIX);
+  ASSERT_EQ(keyImages, std::unordered_set<Crypto::KeyImage>(readKeyImages.begin(), readKeyImages.end()));
+
+  RawBlock rawBlock{ { 1, 2, 3 }, { { 4, 5 }, { 6 } } };
+  RawBlock readRawBlock;
+  DB::deserialize(DB::serialize(rawBlock, DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX), readRawBlock, DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX);
+  ASSERT_EQ(rawBlock.block, readRawBlock.block);
+  ASSERT_EQ(rawBlock.transactions, readRawBlock.transactions);
+}
+
+TEST(DBUtilsTest, convertsRecordsOfOlderSchemes) {
+  auto keyImage = Crypto::rand<Crypto::KeyImage>();
+  std::vector<std::pair<std::string, std::string>> records;
+  ASSERT_TRUE(DB::convertRecord(3, serializeKVBinaryKey(DB::KEY_IMAGE_TO_BLOCK_INDEX_PREFIX, keyImage), serializeKVBinary(uint32_t(5), DB::KEY_IMAGE_TO_BLOCK_INDEX_PREFIX), records));
+  ASSERT_EQ(1, records.size());
+  ASSERT_EQ(DB::serialize(DB::KEY_IMAGE_TO_BLOCK_INDEX_PREFIX, keyImage, uint32_t(5)), records[0]);
+
+  // counters share indexes with records of other key types
+  records.clear();
+  ASSERT_TRUE(DB::convertRecord(3, serializeKVBinaryKey(DB::TRANSACTION_HASH_TO_TRANSACTION_INFO_PREFIX, DB::TRANSACTIONS_COUNT_KEY), serializeKVBinary(uint64_t(7), DB::TRANSACTION_HASH_TO_TRANSACTION_INFO_PREFIX), records));
+  ASSERT_EQ(1, records.size());
+  ASSERT_EQ(DB::serialize(DB::TRANSACTION_HASH_TO_TRANSACTION_INFO_PREFIX, DB::TRANSACTIONS_COUNT_KEY, uint64_t(7)), records[0]);
+
+  // version 2 had no account numbers index, account blocks fill it
+  auto accountBlock = unit_test::makeAccountBlockTemplate(ACCOUNT_BLOCK_MINOR_VERSION_1, 2, "1234567890", "address");
+  std::string rawBlock = DB::serialize(RawBlock{ toBinaryArray(accountBlock), {} }, DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX);
+  auto accountRecord = DB::serialize(DB::ACCOUNT_NUMBER_TO_ACCOUNT_INFO_PREFIX, accountBlock.accountNumber, AccountInfo{ accountBlock.accountAddress, 2 });
+  records.clear();
+  ASSERT_TRUE(DB::convertRecord(2, serializeKVBinaryKey(DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX, uint32_t(2)), rawBlock, records));
+  ASSERT_EQ(2, records.size());
+  ASSERT_EQ(std::make_pair(DB::serializeKey(DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX, uint32_t(2)), rawBlock), records[0]);
+  ASSERT_EQ(accountRecord, records[1]);
+
+  records.clear();
+  ASSERT_TRUE(DB::convertRecord(3, serializeKVBinaryKey(DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX, uint32_t(2)), rawBlock, records));
+  ASSERT_EQ(1, records.size());
+
+  records.clear();
+  ASSERT_FALSE(DB::convertRecord(3, SCHEME_VERSION_KEY, "3", records));
+  ASSERT_FALSE(DB::convertRecord(3, DB::serializeKey(DB::KEY_IMAGE_TO_BLOCK_INDEX_PREFIX, keyImage), "", records));
+  ASSERT_THROW(DB::convertRecord(3, serializeKVBinaryKey(DB::KEY_IMAGE_TO_BLOCK_INDEX_PREFIX, keyImage), "broken", records), std::runtime_error);
+  ASSERT_TRUE(records.empty());
+}
+
+TEST(DataBaseConfigTest, parsesCompressionPerLevel) {
+  std::vector<DataBaseCompression> compressionPerLevel;
+  ASSERT_TRUE(DataBaseConfig::parseCompressionPerLevel("none,none,lz4", compressionPerLevel));
+  ASSERT_EQ(std::vector<DataBaseCompression>({ DataBaseCompression::NONE, DataBaseCompression::NONE, DataBaseCompression::LZ4 }), compressionPerLevel);
+  ASSERT_EQ("none,none,lz4", DataBaseConfig::compressionPerLevelToString(compressionPerLevel));
+
+  ASSERT_TRUE(DataBaseConfig::parseCompressionPerLevel("lz4hc", compressionPerLevel));
+  ASSERT_EQ(std::vector<DataBaseCompression>({ DataBaseCompression::LZ4HC }), compressionPerLevel);
+
+  ASSERT_FALSE(DataBaseConfig::parseCompressionPerLevel("", compressionPerLevel));
+  ASSERT_FALSE(DataBaseConfig::parseCompressionPerLevel("none,,zlib", compressionPerLevel));
+  ASSERT_FALSE(DataBaseConfig::parseCompressionPerLevel("none,lz5", compressionPerLevel));
+  ASSERT_FALSE(DataBaseConfig::parseCompressionPerLevel("zstd", compressionPerLevel));
+  ASSERT_EQ(std::vector<DataBaseCompression>({ DataBaseCompression::LZ4HC }), compressionPerLevel);
+}
+
+TEST(DataBaseConfigTest, acceptsOnlyCompressionsOfTheBuild) {
+  ASSERT_TRUE(RocksDBWrapper::isCompressionSupported(DataBaseCompression::NONE));
+
+  boost::program_options::options_description desc;
+  DataBaseConfig::initOptions(desc);
+  command_line::add_arg(desc, command_line::arg_data_dir);
+
+  for (uint8_t i = 0; i < DATA_BASE_COMPRESSIONS_COUNT; ++i) {
+    auto compression = static_cast<DataBaseCompression>(i);
+    std::string arg = "--db-records-compression=none," + DataBaseConfig::compressionPerLevelToString({ compression });
+    const char* argv[] = { "test", arg.c_str() };
+
+    boost::program_options::variables_map vm;
+    boost::program_options::store(boost::program_options::parse_command_line(2, argv, desc), vm);
+    boost::program_options::notify(vm);
+
+    DataBaseConfig config;
+    ASSERT_EQ(RocksDBWrapper::isCompressionSupported(compression), config.init(vm)) << arg;
+  }
+}
+
+TEST_F(RocksDBWrapperTest, opensWithEverySupportedCompression) {
+  for (uint8_t i = 0; i < DATA_BASE_COMPRESSIONS_COUNT; ++i) {
+    auto compression = static_cast<DataBaseCompression>(i);
+    if (!RocksDBWrapper::isCompressionSupported(compression)) {
+      continue;
+    }
+
+    for (size_t j = 0; j < static_cast<size_t>(DataBaseAccessPattern::COUNT); ++j) {
+      auto pattern = static_cast<DataBaseAccessPattern>(j);
+      DataBaseColumnFamilyConfig familyConfig = config.getColumnFamilyConfig(pattern);
+      familyConfig.compressionPerLevel = { compression };
+      config.setColumnFamilyConfig(pattern, familyConfig);
+    }
+
+    ASSERT_NO_THROW(database.init(config));
+    TestWriteBatch writeBatch(rawData);
+    ASSERT_FALSE(database.write(writeBatch));
+    database.shutdown();
+
+    ASSERT_NO_THROW(database.init(config));
+    checkAllRead();
+    database.shutdown();
+  }
+}
+
+TEST_F(RocksDBWrapperTest, writesAndReadsAllIndexes) {
+  database.init(config);
+
+  TestWriteBatch writeBatch(rawData);
+  ASSERT_FALSE(database.write(writeBatch));
+  checkAllRead();
+
+  TestWriteBatch removeBatch({}, { rawData[0].first });
+  ASSERT_FALSE(database.write(removeBatch));
+
+  TestReadBatch readBatch({ rawData[0].first });
+  ASSERT_FALSE(database.read(readBatch));
+  ASSERT_FALSE(readBatch.resultStates[0]);
+
+  database.shutdown();
+  database.init(config);
+  rawData.erase(rawData.begin());
+  checkAllRead();
+  database.shutdown();
+}
+
+TEST_F(RocksDBWrapperTest, groupsWritesUntilGroupIsFull) {
+  config.setWriteGroupSize(3);
+  database.init(config);
+
+  TestWriteBatch writeBatch({ rawData[0], rawData[1] });
+  ASSERT_FALSE(database.write(writeBatch));
+  TestWriteBatch removeBatch({ rawData[2] }, { rawData[0].first });
+  ASSERT_FALSE(database.write(removeBatch));
+
+  // reads see the open group
+  TestReadBatch readBatch({ rawData[0].first, rawData[1].first, rawData[2].first });
+  ASSERT_FALSE(database.read(readBatch));
+  ASSERT_EQ(std::vector<bool>({ false, true, true }), readBatch.resultStates);
+  ASSERT_EQ(rawData[1].second, readBatch.values[1]);
+  ASSERT_EQ(rawData[2].second, readBatch.values[2]);
+  ASSERT_FALSE(isCommitted(rawData[1].first));
+
+  TestWriteBatch lastBatch({ rawData[3] });
+  ASSERT_FALSE(database.write(lastBatch));
+  ASSERT_TRUE(isCommitted(rawData[1].first));
+  ASSERT_TRUE(isCommitted(rawData[3].first));
+  ASSERT_FALSE(isCommitted(rawData[0].first));
+
+  database.shutdown();
+}
+
+TEST_F(RocksDBWrapperTest, flushCommitsOpenGroup) {
+  config.setWriteGroupSize(100);
+  database.init(config);
+
+  TestWriteBatch writeBatch(rawData);
+  ASSERT_FALSE(database.write(writeBatch));
+  ASSERT_FALSE(isCommitted(rawData[0].first));
+
+  ASSERT_FALSE(database.flush());
+  for (const auto& kv : rawData) {
+    ASSERT_TRUE(isCommitted(kv.first));
+  }
+
+  checkAllRead();
+  database.shutdown();
+}
+
+TEST_F(RocksDBWrapperTest, shutdownCommitsOpenGroup) {
+  config.setWriteGroupSize(100);
+  database.init(config);
+
+  TestWriteBatch writeBatch(rawData);
+  ASSERT_FALSE(database.write(writeBatch));
+  database.shutdown();
+
+  database.init(config);
+  checkAllRead();
+  database.shutdown();
+}
+
+TEST_F(RocksDBWrapperTest, snapshotDoesNotSeeLaterWrites) {
+  database.init(config);
+
+  TestWriteBatch writeBatch({ rawData[0], rawData[1] });
+  ASSERT_FALSE(database.write(writeBatch));
+
+  {
+    std::unique_ptr<IDataBase> snapshot = database.createSnapshot();
+    TestWriteBatch removeBatch({ rawData[2] }, { rawData[0].first });
+    ASSERT_FALSE(database.write(removeBatch));
+
+    TestReadBatch readBatch({ rawData[0].first, rawData[1].first, rawData[2].first });
+    ASSERT_FALSE(snapshot->read(readBatch));
+    ASSERT_EQ(std::vector<bool>({ true, true, false }), readBatch.resultStates);
+    ASSERT_EQ(rawData[0].second, readBatch.values[0]);
+
+    // a snapshot of a snapshot reads the same data
+    std::unique_ptr<IDataBase> copy = snapshot->createSnapshot();
+    snapshot.reset();
+    TestReadBatch copyReadBatch({ rawData[0].first, rawData[2].first });
+    ASSERT_FALSE(copy->read(copyReadBatch));
+    ASSERT_EQ(std::vector<bool>({ true, false }), copyReadBatch.resultStates);
+
+    TestWriteBatch snapshotWriteBatch({ rawData[3] });
+    ASSERT_TRUE(static_cast<bool>(copy->write(snapshotWriteBatch)));
+  }
+
+  TestReadBatch readBatch({ rawData[0].first, rawData[2].first, rawData[3].first });
+  ASSERT_FALSE(database.read(readBatch));
+  ASSERT_EQ(std::vector<bool>({ false, true, false }), readBatch.resultStates);
+
+  database.shutdown();
+}
+
+TEST_F(RocksDBWrapperTest, snapshotCommitsOpenGroup) {
+  config.setWriteGroupSize(100);
+  database.init(config);
+
+  TestWriteBatch writeBatch({ rawData[0] });
+  ASSERT_FALSE(database.write(writeBatch));
+
+  std::unique_ptr<IDataBase> snapshot = database.createSnapshot();
+  ASSERT_TRUE(isCommitted(rawData[0].first));
+
+  TestReadBatch readBatch({ rawData[0].first });
+  ASSERT_FALSE(snapshot->read(readBatch));
+  ASSERT_EQ(std::vector<bool>({ true }), readBatch.resultStates);
+
+  snapshot.reset();
+  database.shutdown();
+}
+
+TEST_F(RocksDBWrapperTest, migratesSingleFamilyLayoutOfOlderScheme) {
+  auto keyImage = Crypto::rand<Crypto::KeyImage>();
+  auto paymentId = Crypto::rand<Crypto::Hash>();
+  auto transactionHash = Crypto::rand<Crypto::Hash>();
+  PackedOutIndex outIndex;
+  outIndex.packedValue = 0x0001000200000003;
+  auto accountBlock = unit_test::makeAccountBlockTemplate(ACCOUNT_BLOCK_MINOR_VERSION_1, 2, "1234567890", "address");
+  RawBlock rawBlock{ toBinaryArray(accountBlock), {} };
+  CachedBlockInfo blockInfo{ Crypto::rand<Crypto::Hash>(), 1500000000, 123456789, 1000000000000, 300, 100000 };
+  ExtendedTransactionInfo transactionInfo;
+  transactionInfo.blockIndex = 1;
+  transactionInfo.transactionIndex = 0;
+  transactionInfo.transactionHash = transactionHash;
+  transactionInfo.unlockTime = 10;
+  transactionInfo.outputs.push_back(KeyOutput{ Crypto::rand<Crypto::PublicKey>() });
+  transactionInfo.globalIndexes = { 0 };
+  transactionInfo.amountToKeyIndexes[100] = { 0 };
+  KeyOutputInfo outputInfo{ Crypto::rand<Crypto::PublicKey>(), transactionHash, 10, 0 };
+
+  // records as scheme version 2 wrote them, before column families and the account numbers index
+  {
+    rocksdb::Options options;
+    options.create_if_missing = true;
+    rocksdb::DB* db;
+    ASSERT_TRUE(rocksdb::DB::Open(options, getDBPath(), &db).ok());
+    std::unique_ptr<rocksdb::DB> dbGuard(db);
+
+    std::vector<std::pair<std::string, std::string>> records = {
+      serializeKVBinary(DB::KEY_IMAGE_TO_BLOCK_INDEX_PREFIX, keyImage, uint32_t(1)),
+      serializeKVBinary(DB::BLOCK_INDEX_TO_KEY_IMAGE_PREFIX, uint32_t(1), std::unordered_set<Crypto::KeyImage>{ keyImage }),
+      serializeKVBinary(DB::BLOCK_INDEX_TO_BLOCK_HASH_PREFIX, DB::LAST_BLOCK_INDEX_KEY, uint32_t(2)),
+      serializeKVBinary(DB::TRANSACTION_HASH_TO_TRANSACTION_INFO_PREFIX, DB::TRANSACTIONS_COUNT_KEY, uint64_t(3)),
+      serializeKVBinary(DB::PAYMENT_ID_TO_TX_HASH_PREFIX, paymentId, uint32_t(1)),
+      serializeKVBinary(DB::PAYMENT_ID_TO_TX_HASH_PREFIX, std::make_pair(paymentId, uint32_t(0)), transactionHash),
+      serializeKVBinary(DB::KEY_OUTPUT_AMOUNT_PREFIX, std::make_pair(uint64_t(100), uint32_t(0)), outIndex),
+      serializeKVBinary(DB::BLOCK_INDEX_TO_BLOCK_INFO_PREFIX, uint32_t(1), blockInfo),
+      serializeKVBinary(DB::BLOCK_INDEX_TO_TX_HASHES_PREFIX, uint32_t(1), std::vector<Crypto::Hash>{ transactionHash }),
+      serializeKVBinary(DB::TRANSACTION_HASH_TO_TRANSACTION_INFO_PREFIX, transactionHash, transactionInfo),
+      serializeKVBinary(DB::KEY_OUTPUT_KEY_PREFIX, std::make_pair(uint64_t(100), uint32_t(0)), outputInfo),
+      { serializeKVBinaryKey(DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX, uint32_t(2)), DB::serialize(rawBlock, DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX) },
+      { SCHEME_VERSION_KEY, "2" }
+    };
+
+    for (const auto& kv : records) {
+      ASSERT_TRUE(db->Put(rocksdb::WriteOptions(), kv.first, kv.second).ok());
+    }
+  }
+
+  rawData = {
+    DB::serialize(DB::KEY_IMAGE_TO_BLOCK_INDEX_PREFIX, keyImage, uint32_t(1)),
+    DB::serialize(DB::BLOCK_INDEX_TO_KEY_IMAGE_PREFIX, uint32_t(1), std::unordered_set<Crypto::KeyImage>{ keyImage }),
+    DB::serialize(DB::BLOCK_INDEX_TO_BLOCK_HASH_PREFIX, DB::LAST_BLOCK_INDEX_KEY, uint32_t(2)),
+    DB::serialize(DB::TRANSACTION_HASH_TO_TRANSACTION_INFO_PREFIX, DB::TRANSACTIONS_COUNT_KEY, uint64_t(3)),
+    DB::serialize(DB::PAYMENT_ID_TO_TX_HASH_PREFIX, paymentId, uint32_t(1)),
+    DB::serialize(DB::PAYMENT_ID_TO_TX_HASH_PREFIX, std::make_pair(paymentId, uint32_t(0)), transactionHash),
+    DB::serialize(DB::KEY_OUTPUT_AMOUNT_PREFIX, std::make_pair(uint64_t(100), uint32_t(0)), outIndex),
+    DB::serialize(DB::BLOCK_INDEX_TO_BLOCK_INFO_PREFIX, uint32_t(1), blockInfo),
+    DB::serialize(DB::BLOCK_INDEX_TO_TX_HASHES_PREFIX, uint32_t(1), std::vector<Crypto::Hash>{ transactionHash }),
+    DB::serialize(DB::TRANSACTION_HASH_TO_TRANSACTION_INFO_PREFIX, transactionHash, transactionInfo),
+    DB::serialize(DB::KEY_OUTPUT_KEY_PREFIX, std::make_pair(uint64_t(100), uint32_t(0)), outputInfo),
+    DB::serialize(DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX, uint32_t(2), rawBlock),
+    DB::serialize(DB::ACCOUNT_NUMBER_TO_ACCOUNT_INFO_PREFIX, accountBlock.accountNumber, AccountInfo{ accountBlock.accountAddress, 2 }),
+    { SCHEME_VERSION_KEY, std::to_string(DB::SCHEME_VERSION) }
+  };
+
+  database.init(config);
+  checkAllRead();
+  ASSERT_TRUE(DatabaseBlockchainCache::checkDBSchemeVersion(database, logger));
+  database.shutdown();
+
+  // default family keeps only keys without an index prefix
+  std::vector<std::string> families;
+  ASSERT_TRUE(rocksdb::DB::ListColumnFamilies(rocksdb::DBOptions(), getDBPath(), &families).ok());
+  ASSERT_LT(1, families.size());
+
+  std::vector<rocksdb::ColumnFamilyDescriptor> descriptors;
+  for (const std::string& name : families) {
+    descriptors.emplace_back(name, rocksdb::ColumnFamilyOptions());
+  }
+
+  rocksdb::DB* db;
+  std::vector<rocksdb::ColumnFamilyHandle*> handles;
+  ASSERT_TRUE(rocksdb::DB::Open(rocksdb::DBOptions(), getDBPath(), descriptors, &handles, &db).ok());
+
+  std::vector<std::string> defaultKeys;
+  {
+    std::unique_ptr<rocksdb::Iterator> it(db->NewIterator(rocksdb::ReadOptions(), db->DefaultColumnFamily()));
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+      defaultKeys.push_back(it->key().ToString());
+    }
+  }
+
+  for (rocksdb::ColumnFamilyHandle* handle : handles) {
+    delete handle;
+  }
+
+  delete db;
+
+  ASSERT_EQ(2, defaultKeys.size());
+  for (const std::string& key : defaultKeys) {
+    ASSERT_EQ(0, DB::getKeyPrefix(key));
+  }
+
+  // migrated DB opens without moving anything again
+  database.init(config);
+  checkAllRead();
+  database.shutdown();
+}
+
+TEST_F(RocksDBWrapperTest, leavesUnconvertibleSchemeToBeRecreated) {
+  {
+    rocksdb::Options options;
+    options.create_if_missing = true;
+    rocksdb::DB* db;
+    ASSERT_TRUE(rocksdb::DB::Open(options, getDBPath(), &db).ok());
+    std::unique_ptr<rocksdb::DB> dbGuard(db);
+
+    auto record = serializeKVBinary(DB::BLOCK_INDEX_TO_BLOCK_HASH_PREFIX, DB::LAST_BLOCK_INDEX_KEY, uint32_t(2));
+    ASSERT_TRUE(db->Put(rocksdb::WriteOptions(), record.first, record.second).ok());
+    ASSERT_TRUE(db->Put(rocksdb::WriteOptions(), SCHEME_VERSION_KEY, "1").ok());
+  }
+
+  database.init(config);
+  ASSERT_FALSE(DatabaseBlockchainCache::checkDBSchemeVersion(database, logger));
+  database.shutdown();
+}
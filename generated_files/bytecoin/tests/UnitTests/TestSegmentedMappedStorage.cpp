@@ -0,0 +1,225 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+
+#include "gtest/gtest.h"
+
+#include "CryptoNoteCore/CryptoNoteSerialization.h"
+#include "CryptoNoteCore/MainChainStorage.h"
+#include "CryptoNoteCore/SegmentedMappedStorage.h"
+#include "CryptoNoteCore/SwappedVector.h"
+
+using namespace CryptoNote;
+
+class SegmentedMappedStorageTests : public ::testing::Test {
+public:
+  void SetUp() override {
+    m_dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("test_data_dir_%%%%%%%%%%%%");
+    boost::filesystem::create_directory(m_dir);
+    m_path = (m_dir / "items").string();
+  }
+
+  void TearDown() override {
+    boost::system::error_code ignoredErrorCode;
+    boost::filesystem::remove_all(m_dir, ignoredErrorCode);
+  }
+
+  static std::string item(uint8_t value, size_t size = 20) {
+    return std::string(size, static_cast<char>(value));
+  }
+
+  static void push(SegmentedMappedStorage& storage, const std::string& value) {
+    storage.push_back(Common::ArrayView<uint8_t>(reinterpret_cast<const uint8_t*>(value.data()), value.size()));
+  }
+
+  static std::string get(const SegmentedMappedStorage& storage, uint64_t index) {
+    Common::ArrayView<uint8_t> view = storage[index];
+    return std::string(reinterpret_cast<const char*>(view.getData()), view.getSize());
+  }
+
+  // copies files of an opened storage as they would be left by a crash
+  std::string snapshot() {
+    std::string snapshotPath = (m_dir / "snapshot").string();
+    boost::filesystem::copy_file(m_path + ".index", snapshotPath + ".index");
+    for (std::string suffix : { ".0000", ".0001", ".0002", ".0003" }) {
+      if (boost::filesystem::exists(m_path + suffix)) {
+        boost::filesystem::copy_file(m_path + suffix, snapshotPath + suffix);
+      }
+    }
+
+    return snapshotPath;
+  }
+
+protected:
+  boost::filesystem::path m_dir;
+  std::string m_path;
+};
+
+TEST_F(SegmentedMappedStorageTests, pushedItemsAreRead) {
+  SegmentedMappedStorage storage;
+  storage.open(m_path);
+  ASSERT_TRUE(storage.empty());
+
+  push(storage, item(1));
+  push(storage, item(2, 100));
+  ASSERT_EQ(2, storage.size());
+  ASSERT_EQ(item(1), get(storage, 0));
+  ASSERT_EQ(item(2, 100), get(storage, 1));
+}
+
+TEST_F(SegmentedMappedStorageTests, itemsAreKeptAfterReopen) {
+  {
+    SegmentedMappedStorage storage;
+    storage.open(m_path);
+    push(storage, item(1));
+    push(storage, item(2));
+  }
+
+  SegmentedMappedStorage storage;
+  storage.open(m_path);
+  ASSERT_EQ(2, storage.size());
+  ASSERT_EQ(item(2), get(storage, 1));
+}
+
+TEST_F(SegmentedMappedStorageTests, itemsAreSplitToSegments) {
+  {
+    SegmentedMappedStorage storage;
+    storage.open(m_path, 64);
+    for (uint8_t i = 0; i < 10; ++i) {
+      push(storage, item(i));
+    }
+  }
+
+  ASSERT_TRUE(boost::filesystem::exists(m_path + ".0003"));
+
+  SegmentedMappedStorage storage;
+  storage.open(m_path, 64);
+  ASSERT_EQ(10, storage.size());
+  for (uint8_t i = 0; i < 10; ++i) {
+    ASSERT_EQ(item(i), get(storage, i));
+  }
+}
+
+TEST_F(SegmentedMappedStorageTests, itemLargerThanSegmentHasOwnSegment) {
+  SegmentedMappedStorage storage;
+  storage.open(m_path, 64);
+  push(storage, item(1));
+  push(storage, item(2, 1000));
+  push(storage, item(3));
+
+  ASSERT_EQ(item(1), get(storage, 0));
+  ASSERT_EQ(item(2, 1000), get(storage, 1));
+  ASSERT_EQ(item(3), get(storage, 2));
+}
+
+TEST_F(SegmentedMappedStorageTests, popBackRemovesLastItem) {
+  SegmentedMappedStorage storage;
+  storage.open(m_path, 64);
+  for (uint8_t i = 0; i < 5; ++i) {
+    push(storage, item(i));
+  }
+
+  storage.pop_back();
+  storage.pop_back();
+  push(storage, item(7, 30));
+  ASSERT_EQ(4, storage.size());
+  ASSERT_EQ(item(2), get(storage, 2));
+  ASSERT_EQ(item(7, 30), get(storage, 3));
+}
+
+TEST_F(SegmentedMappedStorageTests, clearRemovesSegments) {
+  SegmentedMappedStorage storage;
+  storage.open(m_path, 64);
+  for (uint8_t i = 0; i < 5; ++i) {
+    push(storage, item(i));
+  }
+
+  storage.clear();
+  ASSERT_TRUE(storage.empty());
+  ASSERT_FALSE(boost::filesystem::exists(m_path + ".0000"));
+
+  push(storage, item(9));
+  ASSERT_EQ(item(9), get(storage, 0));
+}
+
+TEST_F(SegmentedMappedStorageTests, unflushedItemsAreKeptAfterCrash) {
+  SegmentedMappedStorage storage;
+  storage.open(m_path);
+  push(storage, item(1));
+  storage.flush();
+  push(storage, item(2));
+  push(storage, item(3));
+
+  SegmentedMappedStorage recovered;
+  recovered.open(snapshot());
+  ASSERT_EQ(3, recovered.size());
+  ASSERT_EQ(item(3), get(recovered, 2));
+}
+
+TEST_F(SegmentedMappedStorageTests, crashTruncatesToLastCompleteItem) {
+  SegmentedMappedStorage storage;
+  storage.open(m_path);
+  push(storage, item(1));
+  storage.flush();
+  push(storage, item(2));
+  push(storage, item(3));
+
+  std::string snapshotPath = snapshot();
+  {
+    std::fstream segment(snapshotPath + ".0000", std::ios::in | std::ios::out | std::ios::binary);
+    segment.seekp(25);
+    segment.put(0);
+  }
+
+  SegmentedMappedStorage recovered;
+  recovered.open(snapshotPath);
+  ASSERT_EQ(1, recovered.size());
+
+  push(recovered, item(4));
+  ASSERT_EQ(item(4), get(recovered, 1));
+}
+
+TEST_F(SegmentedMappedStorageTests, mainChainStorageImportsPreviousFormat) {
+  std::string blocksFilename = (m_dir / "blocks.bin").string();
+  std::string indexesFilename = (m_dir / "blockindexes.bin").string();
+  std::vector<RawBlock> blocks(3);
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    blocks[i].block.assign(10 + i, static_cast<uint8_t>(i));
+    blocks[i].transactions.push_back(BinaryArray(5, static_cast<uint8_t>(i)));
+  }
+
+  {
+    SwappedVector<RawBlock> swappedStorage;
+    ASSERT_TRUE(swappedStorage.open(blocksFilename, indexesFilename, 1));
+    for (auto& block : blocks) {
+      swappedStorage.push_back(block);
+    }
+  }
+
+  MainChainStorage storage(blocksFilename, indexesFilename);
+  ASSERT_EQ(3, storage.getBlockCount());
+  for (uint32_t i = 0; i < blocks.size(); ++i) {
+    ASSERT_EQ(blocks[i].block, storage.getBlockByIndex(i).block);
+    ASSERT_EQ(blocks[i].transactions, storage.getBlockByIndex(i).transactions);
+  }
+
+  ASSERT_FALSE(boost::filesystem::exists(blocksFilename));
+  ASSERT_FALSE(boost::filesystem::exists(indexesFilename));
+}
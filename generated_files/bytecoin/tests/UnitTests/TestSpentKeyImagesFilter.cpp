@@ -0,0 +1,59 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "CryptoNoteCore/SpentKeyImagesFilter.h"
+
+using namespace CryptoNote;
+
+TEST(SpentKeyImagesFilterTest, containsAddedKeyImages) {
+  SpentKeyImagesFilter filter(64 * 1024);
+
+  std::vector<Crypto::KeyImage> keyImages;
+  for (int i = 0; i < 10000; ++i) {
+    keyImages.push_back(Crypto::rand<Crypto::KeyImage>());
+    filter.add(keyImages.back());
+  }
+
+  ASSERT_EQ(keyImages.size(), filter.getKeyImagesCount());
+  for (const auto& keyImage : keyImages) {
+    ASSERT_TRUE(filter.mayContain(keyImage));
+  }
+}
+
+TEST(SpentKeyImagesFilterTest, rarelyContainsOtherKeyImages) {
+  // 52 bits per key image
+  SpentKeyImagesFilter filter(64 * 1024);
+  for (int i = 0; i < 10000; ++i) {
+    filter.add(Crypto::rand<Crypto::KeyImage>());
+  }
+
+  size_t falsePositives = 0;
+  for (int i = 0; i < 100000; ++i) {
+    if (filter.mayContain(Crypto::rand<Crypto::KeyImage>())) {
+      ++falsePositives;
+    }
+  }
+
+  ASSERT_LT(falsePositives, 100);
+}
+
+TEST(SpentKeyImagesFilterTest, sizeIsRoundedToWords) {
+  ASSERT_EQ(8, SpentKeyImagesFilter(0).getSize());
+  ASSERT_EQ(1024, SpentKeyImagesFilter(1027).getSize());
+}
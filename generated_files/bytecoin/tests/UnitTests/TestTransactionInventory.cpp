@@ -0,0 +1,218 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "gtest/gtest.h"
+
+#include <boost/uuid/uuid_generators.hpp>
+
+#include "CryptoNoteProtocol/TransactionInventory.h"
+#include "crypto/crypto.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const size_t KNOWN_HASHES_COUNT = 10;
+const size_t MAX_REQUESTED_COUNT = 5;
+const std::chrono::milliseconds REQUEST_TIMEOUT(1000);
+const size_t MAX_REQUEST_ATTEMPTS = 2;
+
+class TransactionInventoryTest : public ::testing::Test {
+public:
+  TransactionInventoryTest() : inventory(KNOWN_HASHES_COUNT, MAX_REQUESTED_COUNT, REQUEST_TIMEOUT, MAX_REQUEST_ATTEMPTS), now(TransactionInventory::Clock::now()) {
+    boost::uuids::random_generator generator;
+    for (size_t i = 0; i < 3; ++i) {
+      peers.push_back(generator());
+    }
+
+    for (size_t i = 0; i < 20; ++i) {
+      hashes.push_back(Crypto::rand<Crypto::Hash>());
+    }
+  }
+
+  std::vector<Crypto::Hash> range(size_t begin, size_t end) const {
+    return std::vector<Crypto::Hash>(hashes.begin() + begin, hashes.begin() + end);
+  }
+
+protected:
+  TransactionInventory inventory;
+  TransactionInventory::Clock::time_point now;
+  std::vector<TransactionInventory::PeerId> peers;
+  std::vector<Crypto::Hash> hashes;
+};
+
+}
+
+TEST_F(TransactionInventoryTest, announcesHashOnceToPeer) {
+  inventory.addAnnouncement(peers[0], hashes[0]);
+  inventory.addAnnouncement(peers[0], hashes[1]);
+  inventory.addAnnouncement(peers[0], hashes[0]);
+
+  ASSERT_EQ(range(0, 2), inventory.takeAnnouncements(peers[0]));
+  ASSERT_TRUE(inventory.takeAnnouncements(peers[0]).empty());
+
+  inventory.addAnnouncement(peers[0], hashes[1]);
+  ASSERT_TRUE(inventory.takeAnnouncements(peers[0]).empty());
+}
+
+TEST_F(TransactionInventoryTest, doesNotAnnounceTransactionsPeerSent) {
+  inventory.addReceived(peers[0], hashes[0]);
+  inventory.addAnnounced(peers[0], { hashes[1] }, now);
+
+  inventory.addAnnouncement(peers[0], hashes[0]);
+  inventory.addAnnouncement(peers[0], hashes[1]);
+  inventory.addAnnouncement(peers[1], hashes[0]);
+
+  ASSERT_TRUE(inventory.takeAnnouncements(peers[0]).empty());
+  ASSERT_EQ(range(0, 1), inventory.takeAnnouncements(peers[1]));
+}
+
+TEST_F(TransactionInventoryTest, forgetsOldestKnownHashes) {
+  for (size_t i = 0; i <= KNOWN_HASHES_COUNT; ++i) {
+    inventory.addReceived(peers[0], hashes[i]);
+  }
+
+  ASSERT_FALSE(inventory.isKnown(peers[0], hashes[0]));
+  ASSERT_TRUE(inventory.isKnown(peers[0], hashes[1]));
+  ASSERT_TRUE(inventory.isKnown(peers[0], hashes[KNOWN_HASHES_COUNT]));
+}
+
+TEST_F(TransactionInventoryTest, requestsTransactionFromOnePeer) {
+  ASSERT_EQ(range(0, 2), inventory.addAnnounced(peers[0], range(0, 2), now));
+  ASSERT_EQ(range(2, 3), inventory.addAnnounced(peers[1], range(0, 3), now));
+
+  ASSERT_EQ(2, inventory.getRequestedCount(peers[0]));
+  ASSERT_EQ(1, inventory.getRequestedCount(peers[1]));
+}
+
+TEST_F(TransactionInventoryTest, limitsRequestsToPeer) {
+  ASSERT_EQ(range(0, MAX_REQUESTED_COUNT), inventory.addAnnounced(peers[0], range(0, MAX_REQUESTED_COUNT + 2), now));
+  ASSERT_EQ(range(MAX_REQUESTED_COUNT, MAX_REQUESTED_COUNT + 2), inventory.addAnnounced(peers[1], range(0, MAX_REQUESTED_COUNT + 2), now));
+
+  inventory.addReceived(peers[0], hashes[0]);
+  ASSERT_EQ(MAX_REQUESTED_COUNT - 1, inventory.getRequestedCount(peers[0]));
+  ASSERT_EQ(range(MAX_REQUESTED_COUNT + 2, MAX_REQUESTED_COUNT + 3),
+            inventory.addAnnounced(peers[0], range(MAX_REQUESTED_COUNT + 2, MAX_REQUESTED_COUNT + 3), now));
+}
+
+TEST_F(TransactionInventoryTest, receivedTransactionIsNotRequested) {
+  inventory.addAnnounced(peers[0], range(0, 1), now);
+  inventory.addReceived(peers[1], hashes[0]);
+
+  ASSERT_FALSE(inventory.isRequested(hashes[0]));
+  ASSERT_EQ(0, inventory.getRequestedCount(peers[0]));
+  ASSERT_TRUE(inventory.expireRequests(now + REQUEST_TIMEOUT).empty());
+}
+
+TEST_F(TransactionInventoryTest, expiredRequestMovesToAnotherAnnouncer) {
+  inventory.addAnnounced(peers[0], range(0, 2), now);
+  inventory.addAnnounced(peers[2], range(0, 1), now);
+
+  ASSERT_TRUE(inventory.expireRequests(now + REQUEST_TIMEOUT / 2).empty());
+
+  auto requests = inventory.expireRequests(now + REQUEST_TIMEOUT);
+  ASSERT_EQ(1, requests.size());
+  ASSERT_EQ(range(0, 1), requests[peers[2]]);
+  ASSERT_EQ(0, inventory.getRequestedCount(peers[0]));
+  ASSERT_EQ(1, inventory.getRequestedCount(peers[2]));
+
+  // nobody else announced the second transaction
+  ASSERT_FALSE(inventory.isRequested(hashes[1]));
+  ASSERT_TRUE(inventory.isRequested(hashes[0]));
+}
+
+TEST_F(TransactionInventoryTest, requestsOfRemovedPeerMoveToAnotherAnnouncer) {
+  inventory.addAnnounced(peers[1], range(0, 1), now);
+  inventory.addAnnounced(peers[0], range(0, 1), now);
+  inventory.removePeer(peers[1]);
+
+  auto requests = inventory.expireRequests(now);
+  ASSERT_EQ(1, requests.size());
+  ASSERT_EQ(range(0, 1), requests[peers[0]]);
+  ASSERT_EQ(1, inventory.getRequestedCount(peers[0]));
+  ASSERT_FALSE(inventory.isKnown(peers[1], hashes[0]));
+}
+
+TEST_F(TransactionInventoryTest, requestsQueuedTransactionsWhenPeerAnswers) {
+  ASSERT_EQ(range(0, MAX_REQUESTED_COUNT), inventory.addAnnounced(peers[0], range(0, MAX_REQUESTED_COUNT + 2), now));
+  ASSERT_TRUE(inventory.isQueued(hashes[MAX_REQUESTED_COUNT]));
+  ASSERT_FALSE(inventory.isRequested(hashes[MAX_REQUESTED_COUNT]));
+  ASSERT_TRUE(inventory.expireRequests(now).empty());
+
+  inventory.addReceived(peers[0], hashes[0]);
+  inventory.addReceived(peers[0], hashes[1]);
+
+  auto requests = inventory.expireRequests(now);
+  ASSERT_EQ(1, requests.size());
+  ASSERT_EQ(range(MAX_REQUESTED_COUNT, MAX_REQUESTED_COUNT + 2), requests[peers[0]]);
+  ASSERT_EQ(MAX_REQUESTED_COUNT, inventory.getRequestedCount(peers[0]));
+  ASSERT_FALSE(inventory.isQueued(hashes[MAX_REQUESTED_COUNT]));
+}
+
+TEST_F(TransactionInventoryTest, doesNotRequestQueuedTransactionReceivedFromAnotherPeer) {
+  inventory.addAnnounced(peers[0], range(0, MAX_REQUESTED_COUNT + 2), now);
+  inventory.addReceived(peers[1], hashes[MAX_REQUESTED_COUNT]);
+  ASSERT_FALSE(inventory.isQueued(hashes[MAX_REQUESTED_COUNT]));
+
+  inventory.addReceived(peers[0], hashes[0]);
+  inventory.addReceived(peers[0], hashes[1]);
+
+  auto requests = inventory.expireRequests(now);
+  ASSERT_EQ(range(MAX_REQUESTED_COUNT + 1, MAX_REQUESTED_COUNT + 2), requests[peers[0]]);
+}
+
+TEST_F(TransactionInventoryTest, requestsTransactionQueuedAgainAfterItWasReceived) {
+  inventory.addAnnounced(peers[0], range(0, MAX_REQUESTED_COUNT + 2), now);
+  inventory.addReceived(peers[1], hashes[MAX_REQUESTED_COUNT]);
+
+  // the transaction left the pool and the peer announces it again
+  inventory.addAnnounced(peers[0], range(MAX_REQUESTED_COUNT, MAX_REQUESTED_COUNT + 1), now);
+  ASSERT_TRUE(inventory.isQueued(hashes[MAX_REQUESTED_COUNT]));
+
+  inventory.addReceived(peers[0], hashes[0]);
+  inventory.addReceived(peers[0], hashes[1]);
+
+  auto requests = inventory.expireRequests(now);
+  ASSERT_EQ(1, requests.size());
+  std::vector<Crypto::Hash> expected{ hashes[MAX_REQUESTED_COUNT + 1], hashes[MAX_REQUESTED_COUNT] };
+  ASSERT_EQ(expected, requests[peers[0]]);
+  ASSERT_FALSE(inventory.isQueued(hashes[MAX_REQUESTED_COUNT]));
+  ASSERT_EQ(MAX_REQUESTED_COUNT, inventory.getRequestedCount(peers[0]));
+}
+
+TEST_F(TransactionInventoryTest, removedPeerLeavesNoQueuedTransactions) {
+  inventory.addAnnounced(peers[0], range(0, MAX_REQUESTED_COUNT + 2), now);
+  inventory.removePeer(peers[0]);
+
+  ASSERT_FALSE(inventory.isQueued(hashes[MAX_REQUESTED_COUNT]));
+  ASSERT_FALSE(inventory.isQueued(hashes[MAX_REQUESTED_COUNT + 1]));
+}
+
+TEST_F(TransactionInventoryTest, givesUpTransactionNobodySends) {
+  inventory.addAnnounced(peers[0], range(0, 1), now);
+  inventory.addAnnounced(peers[1], range(0, 1), now);
+  inventory.addAnnounced(peers[2], range(0, 1), now);
+
+  auto requests = inventory.expireRequests(now + REQUEST_TIMEOUT);
+  ASSERT_EQ(1, requests.size());
+  ASSERT_TRUE(inventory.isRequested(hashes[0]));
+
+  ASSERT_TRUE(inventory.expireRequests(now + REQUEST_TIMEOUT * 2).empty());
+  ASSERT_FALSE(inventory.isRequested(hashes[0]));
+  ASSERT_EQ(0, inventory.getRequestedCount(peers[0]) + inventory.getRequestedCount(peers[1]) + inventory.getRequestedCount(peers[2]));
+}
@@ -0,0 +1,132 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "CryptoNoteCore/TransactionPool.h"
+#include "CryptoNoteCore/TransactionValidatiorState.h"
+#include "CryptoNoteConfig.h"
+#include "Logging/LoggerGroup.h"
+#include "crypto/crypto.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+class TransactionPoolOrderTest : public ::testing::Test {
+public:
+  TransactionPoolOrderTest() : pool(logger) {
+  }
+
+protected:
+  Crypto::Hash addTransaction(uint64_t fee, size_t extraSize) {
+    KeyInput input;
+    input.amount = 1000 + fee;
+    input.keyImage = Crypto::rand<Crypto::KeyImage>();
+    input.outputIndexes.push_back(0);
+
+    TransactionOutput output;
+    output.amount = 1000;
+    output.target = KeyOutput{Crypto::rand<Crypto::PublicKey>()};
+
+    Transaction transaction;
+    transaction.version = CURRENT_TRANSACTION_VERSION;
+    transaction.unlockTime = 0;
+    transaction.inputs.push_back(input);
+    transaction.outputs.push_back(output);
+    transaction.extra.resize(extraSize, 0);
+    transaction.signatures.resize(1, std::vector<Crypto::Signature>(1));
+
+    CachedTransaction cachedTransaction(std::move(transaction));
+    Crypto::Hash hash = cachedTransaction.getTransactionHash();
+
+    TransactionValidatorState state;
+    state.spentKeyImages.insert(input.keyImage);
+    EXPECT_TRUE(pool.pushTransaction(std::move(cachedTransaction), std::move(state)));
+
+    return hash;
+  }
+
+  std::vector<Crypto::Hash> walk(bool reversed, size_t maxCount = std::numeric_limits<size_t>::max()) {
+    std::vector<Crypto::Hash> hashes;
+    auto visitor = [&](const CachedTransaction& transaction) {
+      if (hashes.size() == maxCount) {
+        return false;
+      }
+
+      hashes.push_back(transaction.getTransactionHash());
+      return true;
+    };
+
+    if (reversed) {
+      pool.forEachTransactionReversed(visitor);
+    } else {
+      pool.forEachTransaction(visitor);
+    }
+
+    return hashes;
+  }
+
+  Logging::LoggerGroup logger;
+  TransactionPool pool;
+};
+
+std::vector<Crypto::Hash> getHashes(const std::vector<CachedTransaction>& transactions) {
+  std::vector<Crypto::Hash> hashes;
+  for (const auto& transaction : transactions) {
+    hashes.push_back(transaction.getTransactionHash());
+  }
+
+  return hashes;
+}
+
+}
+
+TEST_F(TransactionPoolOrderTest, walksInPriorityOrder) {
+  Crypto::Hash fusion = addTransaction(0, 10);
+  Crypto::Hash cheap = addTransaction(100, 1000);
+  Crypto::Hash small = addTransaction(100, 10);
+  Crypto::Hash large = addTransaction(10000, 1000);
+
+  std::vector<Crypto::Hash> expected{large, small, cheap, fusion};
+  ASSERT_EQ(expected, walk(false));
+  ASSERT_EQ(getHashes(pool.getPoolTransactions()), walk(false));
+  ASSERT_EQ(std::vector<Crypto::Hash>(expected.rbegin(), expected.rend()), walk(true));
+}
+
+TEST_F(TransactionPoolOrderTest, stopsWhenVisitorReturnsFalse) {
+  Crypto::Hash first = addTransaction(300, 10);
+  Crypto::Hash second = addTransaction(200, 10);
+  addTransaction(100, 10);
+
+  ASSERT_EQ((std::vector<Crypto::Hash>{first, second}), walk(false, 2));
+  ASSERT_TRUE(walk(true, 0).empty());
+}
+
+TEST_F(TransactionPoolOrderTest, tracksMinTransactionSize) {
+  ASSERT_EQ(0, pool.getMinTransactionSize());
+
+  addTransaction(100, 300);
+  Crypto::Hash small = addTransaction(100, 200);
+  size_t smallSize = pool.getTransaction(small).getTransactionBinaryArray().size();
+  ASSERT_EQ(smallSize, pool.getMinTransactionSize());
+
+  ASSERT_TRUE(pool.removeTransaction(small));
+  ASSERT_EQ(smallSize + 100, pool.getMinTransactionSize());
+}
@@ -0,0 +1,121 @@
+// Copyright (c) 2012-2017, The CryptoNote developers, The Bytecoin developers
+//
+// This file is part of Bytecoin.
+//
+// Bytecoin is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Bytecoin is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+
+#include "CryptoNoteProtocol/TransactionPoolSketch.h"
+#include "Serialization/SerializationTools.h"
+#include "crypto/crypto.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+class TransactionPoolSketchTest : public ::testing::Test {
+public:
+  TransactionPoolSketchTest() {
+    // decoding may fail with a small probability, fixed hashes keep the tests stable
+    for (uint32_t i = 0; i < 1000; ++i) {
+      hashes.push_back(Crypto::cn_fast_hash(&i, sizeof(i)));
+    }
+  }
+
+  TransactionPoolSketch makeSketch(size_t cellsCount, size_t begin, size_t end) const {
+    TransactionPoolSketch sketch(cellsCount);
+    for (size_t i = begin; i < end; ++i) {
+      sketch.insert(hashes[i]);
+    }
+
+    return sketch;
+  }
+
+  std::vector<Crypto::Hash> range(size_t begin, size_t end) const {
+    return std::vector<Crypto::Hash>(hashes.begin() + begin, hashes.begin() + end);
+  }
+
+  static std::vector<Crypto::Hash> sorted(std::vector<Crypto::Hash> hashes) {
+    std::sort(hashes.begin(), hashes.end(), [] (const Crypto::Hash& a, const Crypto::Hash& b) {
+      return std::lexicographical_compare(std::begin(a.data), std::end(a.data), std::begin(b.data), std::end(b.data));
+    });
+
+    return hashes;
+  }
+
+protected:
+  std::vector<Crypto::Hash> hashes;
+};
+
+}
+
+TEST_F(TransactionPoolSketchTest, roundsCellsCountUpToHashFunctionsCount) {
+  ASSERT_EQ(0, TransactionPoolSketch(0).getCellsCount());
+  ASSERT_EQ(TransactionPoolSketch::HASH_FUNCTIONS_COUNT, TransactionPoolSketch(1).getCellsCount());
+  ASSERT_EQ(99, TransactionPoolSketch(97).getCellsCount());
+}
+
+TEST_F(TransactionPoolSketchTest, equalPoolsHaveNoDifference) {
+  TransactionPoolSketch sketch = makeSketch(30, 0, 1000);
+  ASSERT_TRUE(sketch.subtract(makeSketch(30, 0, 1000)));
+
+  std::vector<Crypto::Hash> inserted;
+  std::vector<Crypto::Hash> subtracted;
+  ASSERT_TRUE(sketch.decode(inserted, subtracted));
+  ASSERT_TRUE(inserted.empty());
+  ASSERT_TRUE(subtracted.empty());
+}
+
+TEST_F(TransactionPoolSketchTest, decodesDifferenceOfLargePools) {
+  TransactionPoolSketch sketch = makeSketch(120, 0, 980);
+  ASSERT_TRUE(sketch.subtract(makeSketch(120, 20, 1000)));
+
+  std::vector<Crypto::Hash> inserted;
+  std::vector<Crypto::Hash> subtracted;
+  ASSERT_TRUE(sketch.decode(inserted, subtracted));
+  ASSERT_EQ(sorted(range(0, 20)), sorted(inserted));
+  ASSERT_EQ(sorted(range(980, 1000)), sorted(subtracted));
+}
+
+TEST_F(TransactionPoolSketchTest, failsToDecodeDifferenceLargerThanSketch) {
+  TransactionPoolSketch sketch = makeSketch(30, 0, 500);
+  ASSERT_TRUE(sketch.subtract(makeSketch(30, 100, 1000)));
+
+  std::vector<Crypto::Hash> inserted;
+  std::vector<Crypto::Hash> subtracted;
+  ASSERT_FALSE(sketch.decode(inserted, subtracted));
+}
+
+TEST_F(TransactionPoolSketchTest, sketchesOfDifferentSizesAreNotSubtracted) {
+  TransactionPoolSketch sketch = makeSketch(30, 0, 10);
+  ASSERT_FALSE(sketch.subtract(makeSketch(60, 0, 10)));
+}
+
+TEST_F(TransactionPoolSketchTest, serializedSketchDecodes) {
+  TransactionPoolSketch sketch = makeSketch(60, 0, 10);
+  TransactionPoolSketch loaded;
+  ASSERT_TRUE(loadFromBinaryKeyValue(loaded, storeToBinaryKeyValue(sketch)));
+  ASSERT_EQ(sketch.getCellsCount(), loaded.getCellsCount());
+
+  std::vector<Crypto::Hash> inserted;
+  std::vector<Crypto::Hash> subtracted;
+  ASSERT_TRUE(loaded.subtract(makeSketch(60, 5, 15)));
+  ASSERT_TRUE(loaded.decode(inserted, subtracted));
+  ASSERT_EQ(sorted(range(0, 5)), sorted(inserted));
+  ASSERT_EQ(sorted(range(10, 15)), sorted(subtracted));
+}